@@ -29,10 +29,63 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <map>
 #include <vector>
 #include <list>
+#include <algorithm>
 #include <ctime>
 #include <fstream>
 #include <cmath>
+#include <cstring>
 #include <string>
+#include <iomanip>
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+#include <limits>
+#include <chrono>
+#include <unordered_map>
+#include <memory>
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <poll.h>
+#endif
+
+// the reader for BAM files is only available on little-endian POSIX systems, because it decodes the records in place
+#if !defined(WIN32) && !defined(_WIN32) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define PINGPONGPRO_BLOCK_READER
+#include <zlib.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define PINGPONGPRO_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+#endif
+
+// hardware performance counters of the stages of the pipeline can only be measured on Linux (see <startHardwareCounters>)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#define PINGPONGPRO_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// CRAM files can only be read, if the program is linked against htslib (compile with -DPINGPONGPRO_HTSLIB and link with -lhts)
+#ifdef PINGPONGPRO_HTSLIB
+#include <htslib/sam.h>
+#endif
 
 using namespace std;
 using namespace seqan;
@@ -61,6 +114,29 @@ enum TCountMultiHits { multiHitsWeighted, multiHitsDiscard, multiHitsUnique };
 // constants for various output and input file formats
 enum TFileFormat { fileFormatBED, fileFormatCSV, fileFormatGFF, fileFormatGTF, fileFormatTSV };
 
+// relation between the strands of two stacks whose distance is counted (see <calculateDistanceHistograms>)
+enum TStrandRelation { sameStrand, oppositeStrand };
+
+// end of a read from which the distance to the 5' ends of other reads is measured (see <calculateDistanceHistograms>)
+enum TReadEnd { fivePrimeEnd, threePrimeEnd };
+
+// type to hold a histogram of the distances between read stacks along with the parameters it was requested with
+struct TDistanceHistogram
+{
+	TStrandRelation strands;
+	TReadEnd anchor;
+	int minDistance;
+	int maxDistance;
+	vector< double > pairs; // for every distance between <minDistance> and <maxDistance>, the number of pairs of stacks
+	vector< float > reads; // for every distance between <minDistance> and <maxDistance>, the sum of the reads of both stacks of all pairs
+
+	TDistanceHistogram(TStrandRelation strands, TReadEnd anchor, int minDistance, int maxDistance):
+		strands(strands), anchor(anchor), minDistance(minDistance), maxDistance(maxDistance)
+	{
+	}
+};
+typedef vector< TDistanceHistogram > TDistanceHistograms;
+
 // struct to store the options from the command line
 struct AppOptions
 {
@@ -69,12 +145,64 @@ struct AppOptions
 	unsigned int minAlignmentLength;
 	unsigned int maxAlignmentLength;
 	unsigned int minStackHeight;
+	float maxFDR; // ping-pong signatures with a higher FDR are omitted from the output
+	unsigned int topK; // if greater than 0, at most this many ping-pong signatures are written per contig
 	TCountMultiHits countMultiHits;
+	string referenceFile; // reference genome in FASTA format needed to decode CRAM files
+	bool blockReader; // read BAM files with <countReadsInBgzfFile> instead of SeqAn
+	string stackStore; // the name of the store of the read stacks of every contig (see <selectStackStores>)
+	TDistanceHistograms distanceHistograms; // histograms requested with --distance-histogram (without counts)
+	bool qcOnly; // only print the histogram of overlaps (see <calculatePingPongQC>) instead of finding ping-pong signatures
 	CharString output;
 	bool plot;
+	string batchManifest;
+	unsigned int threads;
+	unsigned int maxMemory;
 	TInputFiles transposonFiles;
+	string transposonAttribute;
+	bool transposonFamilies;
+	string transposonFamilyAttribute;
+	string annotationCache;
+	bool signatureIndex;
+	vector< unsigned int > activityWindows; // sizes of the windows of activity tracks
 	unsigned int predictTransposonsRange;
 	unsigned int verbosity;
+	bool hardwareCounters; // print hardware performance counters of every stage (see <stopwatch>)
+	string traceFile; // write a trace of the stages and threads to this file (see <traceBegin>)
+	unsigned int progressInterval; // seconds between two reports of the progress of reading the input files (0 = off)
+	string statusFile; // file to write the progress of reading the input files to (see <reportIngestProgress>)
+};
+
+// struct to store the options of the "serve" command
+struct TServeOptions
+{
+	string socket; // path of the Unix domain socket
+	vector< string > sampleNames;
+	vector< string > samplePaths; // signature files or output directories of the samples
+	unsigned int threads;
+	unsigned int verbosity;
+};
+
+// struct to store a region of the "query" command
+struct TQueryRegion
+{
+	string contig;
+	unsigned int start;
+	unsigned int end;
+
+	TQueryRegion():
+		start(0), end(numeric_limits< unsigned int >::max())
+	{
+	}
+};
+
+// struct to store the options of the "query" command
+struct TQueryOptions
+{
+	string indexFile; // signature index file or output directory of pingpongpro
+	vector< TQueryRegion > regions;
+	int overlap;
+	bool signatures; // write signatures instead of summaries
 };
 
 // types to store @SQ header lines of BAM/SAM files
@@ -98,11 +226,307 @@ struct TReadStack
 	{}
 };
 
+// type to hold the properties of an alignment that are needed to count reads (see <countAlignment>)
+struct TAlignment
+{
+	int contig;
+	int position; // leftmost position of the alignment on the contig
+	bool reverse; // whether the read maps to the minus strand
+	unsigned int alignmentLength; // number of bases on the contig covered by the alignment
+	bool AAtPosition10; // whether the 10th base from the 5' end of the read is adenine
+	unsigned int reads; // number of reads represented by the alignment (see <parseCollapsedReadCount>)
+	unsigned int multiHits; // number of alignments of the read as given by the NH tag
+
+	TAlignment():
+		contig(0), position(0), reverse(false), alignmentLength(0), AAtPosition10(false), reads(1), multiHits(1)
+	{
+	}
+};
+
+// the stacks of a contig and strand in a balanced tree, by position
+typedef map< unsigned int, TReadStack > TStackMap;
+
+// The following types are interchangeable stores of the read stacks of a contig and strand.
+// All of them support the same operations (see <addToStackStore>, <freezeStackStore> and <beginStacks>):
+// stacks are accumulated in arbitrary order during ingestion; after the store is frozen, the stacks can be iterated
+// in the order of their positions and windows of stacks can be probed by advancing a second cursor (see <advanceStackCursor>).
+// The stores differ in their memory consumption and speed, which can be measured with "pingpongpro benchmark".
+enum TStackStoreType { stackStoreMap, stackStoreFlat, stackStoreDense, stackStoreHash, stackStoreCompressed };
+
+// a stack and its position as stored by <TFlatStackStore>
+typedef pair< unsigned int, TReadStack > TStackEntry;
+
+// the legacy store: a balanced tree of stacks
+struct TMapStackCursor;
+struct TMapStackStore
+{
+	typedef TMapStackCursor TCursor;
+	TStackMap stacks;
+};
+struct TMapStackCursor
+{
+	TStackMap::const_iterator current;
+	TStackMap::const_iterator end;
+};
+
+// a store that appends the stacks to a vector, which is sorted and deduplicated when the store is frozen
+// consecutive reads of the same stack are merged right away, which is the common case for coordinate-sorted input files
+struct TFlatStackCursor;
+struct TFlatStackStore
+{
+	typedef TFlatStackCursor TCursor;
+	vector< TStackEntry > stacks;
+};
+struct TFlatStackCursor
+{
+	const TStackEntry *current;
+	const TStackEntry *end;
+};
+
+// a store with one slot per position between the first and the last stack; empty slots have 0 reads
+// it is the smallest store for contigs, which are densely covered by stacks (see <planRun>)
+struct TDenseStackCursor;
+struct TDenseStackStore
+{
+	typedef TDenseStackCursor TCursor;
+	unsigned int offset; // the position of the first used slot
+	size_t head; // the number of unused slots in front of the first used slot, which stacks preceding the first stack are prepended to
+	vector< TReadStack > stacks;
+
+	TDenseStackStore():
+		offset(0), head(0)
+	{
+	}
+};
+struct TDenseStackCursor
+{
+	unsigned int offset;
+	const TReadStack *first;
+	const TReadStack *current;
+	const TReadStack *end;
+};
+
+// a store that accumulates the stacks in a hash table, which is converted to a sorted vector when the store is frozen
+struct THashStackStore
+{
+	typedef TFlatStackCursor TCursor;
+	unordered_map< unsigned int, TReadStack > table;
+	TFlatStackStore frozen;
+};
+
+// a store that accumulates the stacks like <TFlatStackStore> and encodes them into a byte string when frozen:
+// for every stack, the distance to the previous stack and the reads are written as variable-length integers;
+// stacks with a fractional number of reads (multi-mapped reads) are followed by the number of reads as float
+struct TCompressedStackCursor;
+struct TCompressedStackStore
+{
+	typedef TCompressedStackCursor TCursor;
+	TFlatStackStore staging;
+	string encoded;
+};
+struct TCompressedStackCursor
+{
+	const char *next; // the next byte to decode
+	const char *end;
+	bool atEnd;
+	unsigned int position;
+	TReadStack stack;
+};
+
+// names of the stores on the command-line, indexed by <TStackStoreType>
+const char * const STACK_STORE_NAMES[] = { "map", "flat", "dense", "hash", "compressed" };
+
 // The following types define nested arrays to store the above stats for every position in the genome.
-// The stats are grouped by strand and contig/chromosome.
-typedef map< unsigned int, TReadStack > TReadStacksPerContig;
+// The stats are grouped by strand and contig/chromosome. The stacks of every contig are held in the type of store,
+// which is chosen for the contig before the input files are read (see <TStackStoreSelection>). Only the store of that type is allocated
+// and the operations of the stores are dispatched by the type at runtime (see <addToStackStore> and <beginStacks>).
+struct TStackCursor;
+struct TReadStacksPerContig
+{
+	typedef TStackCursor TCursor;
+	TStackStoreType type;
+	void *store; // the store of the given type, which is owned by this object
+
+	TReadStacksPerContig(TStackStoreType type = stackStoreMap):
+		type(type), store(newStackStore(type, NULL))
+	{
+	}
+	TReadStacksPerContig(const TReadStacksPerContig &other):
+		type(other.type), store(newStackStore(other.type, other.store))
+	{
+	}
+	TReadStacksPerContig(TReadStacksPerContig &&other):
+		type(other.type), store(other.store)
+	{
+		other.store = NULL;
+	}
+	TReadStacksPerContig &operator=(TReadStacksPerContig other)
+	{
+		swap(type, other.type);
+		swap(store, other.store);
+		return *this;
+	}
+	~TReadStacksPerContig()
+	{
+		deleteStackStore(type, store);
+	}
+
+	// accessors of the store; only the one matching <type> may be called
+	TMapStackStore &mapStore() { return *static_cast<TMapStackStore *>(store); }
+	const TMapStackStore &mapStore() const { return *static_cast<const TMapStackStore *>(store); }
+	TFlatStackStore &flatStore() { return *static_cast<TFlatStackStore *>(store); }
+	const TFlatStackStore &flatStore() const { return *static_cast<const TFlatStackStore *>(store); }
+	TDenseStackStore &denseStore() { return *static_cast<TDenseStackStore *>(store); }
+	const TDenseStackStore &denseStore() const { return *static_cast<const TDenseStackStore *>(store); }
+	THashStackStore &hashStore() { return *static_cast<THashStackStore *>(store); }
+	const THashStackStore &hashStore() const { return *static_cast<const THashStackStore *>(store); }
+	TCompressedStackStore &compressedStore() { return *static_cast<TCompressedStackStore *>(store); }
+	const TCompressedStackStore &compressedStore() const { return *static_cast<const TCompressedStackStore *>(store); }
+
+private:
+	// function to allocate a store of the given type, which is empty or a copy of the given store
+	static void *newStackStore(TStackStoreType type, const void *original)
+	{
+		switch (type)
+		{
+			case stackStoreFlat: return (original == NULL) ? new TFlatStackStore() : new TFlatStackStore(*static_cast<const TFlatStackStore *>(original));
+			case stackStoreDense: return (original == NULL) ? new TDenseStackStore() : new TDenseStackStore(*static_cast<const TDenseStackStore *>(original));
+			case stackStoreHash: return (original == NULL) ? new THashStackStore() : new THashStackStore(*static_cast<const THashStackStore *>(original));
+			case stackStoreCompressed: return (original == NULL) ? new TCompressedStackStore() : new TCompressedStackStore(*static_cast<const TCompressedStackStore *>(original));
+			default: return (original == NULL) ? new TMapStackStore() : new TMapStackStore(*static_cast<const TMapStackStore *>(original));
+		}
+	}
+	static void deleteStackStore(TStackStoreType type, void *store)
+	{
+		switch (type)
+		{
+			case stackStoreFlat: delete static_cast<TFlatStackStore *>(store); break;
+			case stackStoreDense: delete static_cast<TDenseStackStore *>(store); break;
+			case stackStoreHash: delete static_cast<THashStackStore *>(store); break;
+			case stackStoreCompressed: delete static_cast<TCompressedStackStore *>(store); break;
+			default: delete static_cast<TMapStackStore *>(store); break;
+		}
+	}
+};
+// a cursor over the stacks of a <TReadStacksPerContig>; only the cursor of the type of the store is used
+struct TStackCursor
+{
+	TStackStoreType type;
+	TMapStackCursor mapCursor;
+	TFlatStackCursor flatCursor; // also used for the hash store
+	TDenseStackCursor denseCursor;
+	TCompressedStackCursor compressedCursor;
+};
 typedef map< unsigned int, TReadStacksPerContig > TReadStacksPerStrand;
-typedef TReadStacksPerStrand TReadStacksPerGenome[2];
+
+// type to hold the store of every contig, which is chosen before the input files are read (see <selectStackStores>)
+struct TStackStoreSelection
+{
+	TStackStoreType defaultType; // the store of the contigs which have no store of their own
+	vector< TStackStoreType > contigs; // the store of every contig by ID
+
+	TStackStoreSelection():
+		defaultType(stackStoreMap)
+	{
+	}
+};
+
+// type to hold the stacks of both strands (indexed by STRAND_PLUS and STRAND_MINUS) and the stores chosen for the contigs
+struct TReadStacksPerGenome
+{
+	TReadStacksPerStrand strands[2];
+	TStackStoreSelection stores; // the stores in which the stacks of the contigs are created (see <getContigStacks>)
+
+	TReadStacksPerStrand &operator[](unsigned int strand)
+	{
+		return strands[strand];
+	}
+	const TReadStacksPerStrand &operator[](unsigned int strand) const
+	{
+		return strands[strand];
+	}
+};
+
+// struct to store the options of the "benchmark" command
+struct TBenchmarkOptions
+{
+	TInputFiles inputFiles; // if empty, a synthetic library is generated
+	string referenceFile;
+	unsigned int syntheticReads;
+	unsigned int minAlignmentLength;
+	unsigned int maxAlignmentLength;
+};
+
+// type to hold a read (or a fraction of a stack) that is added to a stack store by the benchmark (see <benchmarkStackStore>)
+struct TStackEvent
+{
+	unsigned int contig;
+	unsigned int position; // the key of the stack (see <countAlignment>)
+	float reads;
+	unsigned char strand;
+	bool AAtPosition10;
+
+	TStackEvent(unsigned int contig, unsigned int strand, unsigned int position, float reads, bool AAtPosition10):
+		contig(contig), position(position), reads(reads), strand(strand), AAtPosition10(AAtPosition10)
+	{
+	}
+};
+
+// struct to store the options of the "verify" command
+struct TVerifyOptions
+{
+	AppOptions analysis; // the options shared by the reference and the candidate configuration (see <runVerify>)
+	unsigned int stacksPerTile; // the size of the tiles of the candidate configuration; 0 = as planned (see <planRun>)
+	double absoluteTolerance;
+	double relativeTolerance;
+	unsigned int maxDivergences; // the number of divergences printed per comparison
+};
+
+// type to hold the statistics of one comparison of the "verify" command, e.g., of one output file
+struct TVerifyComparison
+{
+	string name;
+	uint64_t referenceRows;
+	uint64_t candidateRows;
+	uint64_t missingRows; // rows only found in the output of the reference configuration
+	uint64_t extraRows; // rows only found in the output of the candidate configuration
+	uint64_t values; // values compared in the rows found in both outputs
+	uint64_t divergentValues; // values which differ by more than the tolerance
+	double maxAbsoluteDifference;
+	double maxRelativeDifference;
+	uint64_t printed; // the number of divergences reported so far (see <reportVerifyDivergence>)
+
+	TVerifyComparison(const string &name):
+		name(name), referenceRows(0), candidateRows(0), missingRows(0), extraRows(0), values(0), divergentValues(0), maxAbsoluteDifference(0), maxRelativeDifference(0), printed(0)
+	{
+	}
+};
+
+// columns of an output file compared by the "verify" command (see <compareOutputTables>)
+struct TVerifyTable
+{
+	const char *fileName;
+	int contigColumn; // the rows are sorted by contig, start and end; -1, if the rows are compared in the order of the file
+	int startColumn;
+	int endColumn; // -1, if the rows have no end
+	bool contigsByName; // the contigs are sorted by name instead of the order of the input files (see <writeActivityTrackToFile>)
+};
+
+// type to hold the measurements of a stack store by <benchmarkStackStore>
+struct TStackStoreBenchmark
+{
+	double stacks;
+	double ingestSeconds; // time to add all events
+	double freezeSeconds;
+	double sweepSeconds; // time to sweep all stacks on the + strand and probe the stacks on the - strand in the range of the arbitrary overlaps
+	double bytes;
+	vector< double > pairs; // for every overlap, the number of pairs found by the sweep, which must be the same for all stores
+
+	TStackStoreBenchmark():
+		stacks(0), ingestSeconds(0), freezeSeconds(0), sweepSeconds(0), bytes(0)
+	{
+	}
+};
 
 // true ping-pong stacks overlap by this many nt
 const int PING_PONG_OVERLAP = 10;
@@ -121,16 +545,15 @@ typedef map< unsigned int, float > THeightScoreMap;
 struct TPingPongSignature
 {
 	unsigned int position: 32; // position on contig where the ping-pong overlap is located
-	unsigned int heightScoreBin: 30; // must be big enough to hold <HEIGHT_SCORE_BINS>
+	unsigned int heightScoreBin: 30; // must be big enough to hold <HEIGHT_SCORE_BINS>; the bin before collapsing (see <getFDR>)
 	unsigned int localHeightScoreBin: 1; // holds either <IS_ABOVE_COVERAGE> or <IS_BELOW_COVERAGE>
 	unsigned int baseBiasBin: 1; // holds either <HAS_BASE_BIAS> or <HAS_NO_BASE_BIAS>
 	float readsOnPlusStrand; // stack height on + strand
 	float readsOnMinusStrand; // stack height on - strand
-	float fdr; // chances of this putative ping-pong overlap being a false discovery
 
 	// constructor to initialize with values
 	TPingPongSignature(unsigned int position, unsigned int heightScoreBin, unsigned int localHeightScoreBin, unsigned int baseBiasBin, float readsOnPlusStrand, float readsOnMinusStrand):
-		position(position), heightScoreBin(heightScoreBin), localHeightScoreBin(localHeightScoreBin), baseBiasBin(baseBiasBin), readsOnPlusStrand(readsOnPlusStrand), readsOnMinusStrand(readsOnMinusStrand), fdr(0)
+		position(position), heightScoreBin(heightScoreBin), localHeightScoreBin(localHeightScoreBin), baseBiasBin(baseBiasBin), readsOnPlusStrand(readsOnPlusStrand), readsOnMinusStrand(readsOnMinusStrand)
 	{
 	}
 
@@ -143,7 +566,6 @@ struct TPingPongSignature
 		baseBiasBin = pingPongSignature.baseBiasBin;
 		readsOnPlusStrand = pingPongSignature.readsOnPlusStrand;
 		readsOnMinusStrand = pingPongSignature.readsOnMinusStrand;
-		fdr = pingPongSignature.fdr;
 	}
 };
 // type to store all ping-pong signatures of a single contig
@@ -165,1516 +587,9264 @@ const unsigned int HEIGHT_SCORE_BINS = 1000; // divide signatures by height into
 typedef vector< vector< vector< float > > > TGroupedStackCounts;
 typedef vector< TGroupedStackCounts > TGroupedStackCountsByOverlap;
 
-// types to plot histograms
-typedef vector< float > THistogram; // every vector element represents the height of a bar
-typedef vector< THistogram > THistograms; // a collection of histograms, which are printed into a single PDF
-
-// type to store attributes about transposons
-struct TTransposon
+// type to look up the chances of a ping-pong signature being a false discovery (FDR) by the bins assigned to it by <countStacksByGroup>
+// the table is indexed like <encodeActivityClass>, such that the signatures need not be rebinned, when bins are collapsed (see <buildFDRTable>)
+typedef vector< float > TFDRTable;
+
+// type to store the reads of the signatures within a window of the genome by class, i.e., by overlap, height score bin, base bias and local height
+// (see <encodeActivityClass>); the classes are stored sparsely, since a window contains few of the possible classes
+typedef vector< pair< unsigned int, float > > TActivityWindow;
+// type to store the windows of a contig, which have signatures, by their number in ascending order
+typedef vector< pair< unsigned int, TActivityWindow > > TActivityWindowsPerContig;
+// type to store a genome-wide track of ping-pong activity in windows of a given size
+struct TActivityTrack
 {
-	string identifier; // name of the transposon
-	unsigned int strand;
-	unsigned int start;
-	unsigned int end;
-	float pValue; // probability that there is ping-pong activity in the region of the transposon
-	float qValue; // multiple-testing corrected <pValue>
-	float readsOnPlusStrand;
-	float readsOnMinusStrand;
-	THistogram histogram; // number of ping-pong signatures within the transposon region for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+	unsigned int windowSize;
+	map< unsigned int, TActivityWindowsPerContig > contigs;
+	map< unsigned int, unsigned int > contigEnds; // position after the last signature of every contig
 
-	// constructor to initialize with values
-	TTransposon(string identifier, unsigned int strand, unsigned int start, unsigned int end):
-		identifier(identifier), strand(strand), start(start), end(end), pValue(1), qValue(1), readsOnPlusStrand(0), readsOnMinusStrand(0)
+	TActivityTrack(unsigned int windowSize):
+		windowSize(windowSize)
 	{
 	}
+};
+typedef vector< TActivityTrack > TActivityTracks;
 
-	// copy constructor (needed to add instance to a STL list)
-	TTransposon(const TTransposon &transposon)
+// type to sum up the reads of the signatures in the current window of an activity track while the stacks are swept (see <countStacksInTile>)
+// the reads are added to a dense array indexed by <encodeActivityClass>, which is only converted to a sparse <TActivityWindow>, when the sweep leaves the window
+struct TActivityAccumulator
+{
+	vector< float > reads; // the reads of every class in the current window
+	vector< unsigned int > classes; // the classes with reads in the current window
+	unsigned int contig;
+	unsigned int window;
+	unsigned int end; // position after the last signature in the current window
+
+	TActivityAccumulator():
+		contig(0), window(0), end(0)
 	{
-		identifier = transposon.identifier;
-		strand = transposon.strand;
-		start = transposon.start;
-		end = transposon.end;
-		pValue = transposon.pValue;
-		qValue = transposon.qValue;
-		histogram = transposon.histogram;
-		readsOnPlusStrand = transposon.readsOnPlusStrand;
-		readsOnMinusStrand = transposon.readsOnMinusStrand;
 	}
+};
 
-	// operator for sorting of a list of transposons by genomic position
-	inline bool operator<(const TTransposon &transposon)
+// large contigs are split into tiles of about this many stacks on the + strand and small contigs are combined into tiles of this size,
+// such that the stacks can be grouped in parallel, even if the genome consists of few huge contigs (see <countStacksByGroup>)
+const unsigned int STACKS_PER_TILE = 100000;
+// number of tiles that are grouped in parallel per thread, before the results are merged and the memory of the processed contigs is freed
+const unsigned int TILES_PER_THREAD = 4;
+
+// type to hold the stacks of a contig on the + strand from <plusStacks> up to <plusEnd> that are processed as part of a <TStackTile>
+// the stacks on the - strand are taken from the entire contig, such that the stacks which overlap the stacks at the end of the segment
+// by up to <MAX_ARBITRARY_OVERLAP> nt are included as a halo
+struct TStackTileSegment
+{
+	unsigned int contig;
+	TStackCursor plusStacks; // cursor to the first stack of the segment (see <beginStacks>)
+	int64_t plusEnd; // the stacks before this position belong to the segment
+	const TReadStacksPerContig *minusStacks;
+	vector< TPingPongSignaturesPerContig > pingPongSignaturesByOverlap; // the signatures found in the segment
+
+	TStackTileSegment(unsigned int contig, const TStackCursor &plusStacks, int64_t plusEnd, const TReadStacksPerContig *minusStacks):
+		contig(contig), plusStacks(plusStacks), plusEnd(plusEnd), minusStacks(minusStacks)
 	{
-		if (start == transposon.start)
-			return end < transposon.end;
-		else
-			return start < transposon.start;
 	}
 };
-// type to store all transposons of a single contig
-typedef list< TTransposon > TTransposonsPerContig;
-// type to store all transposons of the entire genome
-typedef map< unsigned int, TTransposonsPerContig > TTransposonsPerGenome;
 
-// parameters for transposon prediction based on ping-pong activity
-const unsigned int PREDICT_TRANSPOSONS_MIN_LENGTH = 30; // predicted transposons shorter than this are discarded
+// type to hold a unit of work of <countStacksByGroup> and its results
+struct TStackTile
+{
+	vector< TStackTileSegment > segments;
+	unsigned int stacks; // number of stacks on the + strand in all segments
+	vector< float > groupedStackCounts; // the number of stacks in every group, indexed by <encodeActivityClass>
+	TActivityTracks activityTracks; // the windows of the activity tracks covered by the tile
 
-// the calculation of p-values is based on integrals
-// the following constants are parameters for the precision of p-values calculation
-const double APPROXIMATION_ACCURACY = 0.01; // step size with which integrals are calculated; smaller means more accurate
-const double APPROXIMATION_RANGE = 5; // span of integral calculation; wider means more accurate
-const double MIN_STANDARD_DEVIATION = 1E-10; // if the STDDEV is smaller than this, assume this fixed value to avoid division by 0
+	TStackTile(const TActivityTracks *activityTracks):
+		stacks(0)
+	{
+		if (activityTracks != NULL)
+			for (TActivityTracks::const_iterator activityTrack = activityTracks->begin(); activityTrack != activityTracks->end(); ++activityTrack)
+				this->activityTracks.push_back(TActivityTrack(activityTrack->windowSize));
+	}
+};
 
-// ==========================================================================
-// Functions
-// ==========================================================================
+// types to plot histograms
+typedef vector< float > THistogram; // every vector element represents the height of a bar
+typedef vector< THistogram > THistograms; // a collection of histograms, which are printed into a single PDF
 
-// function to parse command-line arguments
-// Input parameters:
-//	argc: number of command-line arguments as passed to the function <main>
-//	argv: array of command-line arguments as passed to the function <main>
-// Output parameters:
-//	options: parsed options
-// Return value: status code about whether the command-line could be parsed
-ArgumentParser::ParseResult parseCommandLine(AppOptions &options, int argc, char const ** argv)
-{
-	ArgumentParser parser("pingpongpro");
+// number of overlaps between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>, i.e., the number of bars in a histogram
+const unsigned int ARBITRARY_OVERLAP_COUNT = MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1;
 
-	// define usage and description
-	addUsageLine(parser, "[\\fIOPTIONS\\fP] -i \\fISAM_INPUT_FILE\\fP [-o \\fIOUTPUT_DIRECTORY\\fP]");
-	setShortDescription(parser, "Find ping-pong signatures like a pro");
-	addDescription(parser, "PingPongPro scans piRNA-Seq data for signs of ping-pong cycle activity. The ping-pong cycle produces piRNA molecules with complementary 5'-ends. These molecules appear as stacks of aligned reads whose 5'-ends overlap with the 5'-ends of reads on the opposite strand by exactly 10 bases.");
-	setVersion(parser, "1.0");
-	setDate(parser, "Apr 2014");
+// global summary of a library for the quality control mode (see <calculatePingPongQC>)
+struct TPingPongQC
+{
+	float histogram[ARBITRARY_OVERLAP_COUNT]; // for every overlap, the sum of the reads of all pairs of opposite stacks with this overlap
+	double pairs[ARBITRARY_OVERLAP_COUNT]; // for every overlap, the number of pairs of opposite stacks with this overlap
+	double stacks; // number of read stacks on both strands
 
-	// define parameters
-	addOption(parser, ArgParseOption("b", "browserTracks", "Generate genome browser tracks for loci with ping-pong signature and (if -t or -T is specified) for transposons with ping-pong activity. Default: \\fIoff\\fP."));
+	TPingPongQC():
+		stacks(0)
+	{
+		fill(histogram, histogram + ARBITRARY_OVERLAP_COUNT, 0);
+		fill(pairs, pairs + ARBITRARY_OVERLAP_COUNT, 0);
+	}
+};
 
-	addOption(parser, ArgParseOption("s", "min-stack-height", "Omit stacks with fewer than the specified number of reads from the output.", ArgParseArgument::INTEGER, "NUMBER_OF_READS"));
-	setDefaultValue(parser, "min-stack-height", 0);
-	setMinValue(parser, "min-stack-height", "0");
+// Type to store many short strings (e.g., the identifiers of millions of transposons) in a single buffer.
+// Every distinct string is stored only once (interned) and is referred to by a numeric ID.
+struct TStringArena
+{
+	string characters; // all distinct strings, concatenated without separators
+	vector< size_t > offsets; // the string with ID i occupies the characters from offsets[i] to offsets[i+1]-1
+	vector< unsigned int > hashTable; // open addressing hash table of string IDs + 1 (0 marks an empty slot)
 
-	addOption(parser, ArgParseOption("i", "input", "Input file in SAM/BAM format.", ArgParseArgument::INPUTFILE, "PATH", true));
-	setValidValues(parser, "input", ".bam .sam");
-	setRequired(parser, "input");
+	TStringArena():
+		offsets(1, 0), hashTable(1024, 0)
+	{
+	}
+};
 
-	addOption(parser, ArgParseOption("l", "min-alignment-length", "Ignore alignments in the input file that are shorter than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
-	setDefaultValue(parser, "min-alignment-length", 24);
-	setMinValue(parser, "min-alignment-length", "1");
-	addOption(parser, ArgParseOption("L", "max-alignment-length", "Ignore alignments in the input file that are longer than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
-	setDefaultValue(parser, "max-alignment-length", 32);
-	setMinValue(parser, "max-alignment-length", "1");
+// type to refer to a range of rows in a table
+struct TRowRange
+{
+	unsigned int begin; // first row of the range
+	unsigned int end; // first row after the range
 
-	addOption(parser, ArgParseOption("m", "multi-hits", "How to count multi-mapping reads.", ArgParseArgument::STRING, "METHOD"));
-	setDefaultValue(parser, "multi-hits", "weighted");
-	setValidValues(parser, "multi-hits", "weighted discard unique");
+	TRowRange(unsigned int begin = 0, unsigned int end = 0):
+		begin(begin), end(end)
+	{
+	}
+};
 
-	addOption(parser, ArgParseOption("o", "output", "Write output to specified directory. Default: current working directory.", ArgParseArgument::OUTPUTFILE, "PATH"));
+// Type to store the genomic regions of transposons.
+// Transposons are stored column-wise, i.e., the i-th transposon is described by the i-th element of every column.
+// The table only holds the annotation. The results of the analysis are stored separately in <TTransposonScores>,
+// such that the same annotation can be scored against any number of samples.
+struct TTransposonTable
+{
+	TStringArena identifiers; // names of the transposons
+	vector< unsigned int > identifier; // ID of the name of the transposon in <identifiers>
+	TStringArena families; // names of the transposon families
+	vector< unsigned int > family; // ID of the family of the transposon in <families>
+	vector< unsigned int > contig;
+	vector< unsigned int > start;
+	vector< unsigned int > end;
+	vector< unsigned char > strand;
+	map< unsigned int, TRowRange > contigs; // rows belonging to each contig (only valid after calling <sortTransposonTable>)
+};
 
-	addOption(parser, ArgParseOption("p", "plot", "Generate R plots on how z-scores are calculated for ping-pong signatures and (if -t or -T is specified) for transposons. Requires Rscript. Default: \\fIoff\\fP."));
+// type to store the results of checking the transposons of a <TTransposonTable> for ping-pong activity
+// the i-th element of every column belongs to the i-th transposon of the table
+struct TTransposonScores
+{
+	vector< float > pValue; // probability that there is ping-pong activity in the region of the transposon
+	vector< float > qValue; // multiple-testing corrected <pValue>
+	vector< float > readsOnPlusStrand;
+	vector< float > readsOnMinusStrand;
+	vector< float > histograms; // for every transposon <ARBITRARY_OVERLAP_COUNT> consecutive elements, which hold the number of ping-pong signatures
+	                            // within the transposon region for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+};
 
-	addOption(parser, ArgParseOption("t", "transposons", "Check if the transposons given in the file \\fIPATH\\fP are suppressed through ping-pong activity.", ArgParseArgument::INPUTFILE, "PATH", true));
-	setValidValues(parser, "transposons", ".bed .csv .gff .gtf .tsv");
+// type to execute tasks in parallel on a fixed set of worker threads
+struct TThreadPool
+{
+	vector< thread > workers;
+	deque< function< void() > > tasks; // tasks waiting to be executed
+	unsigned int pendingTasks; // number of tasks that are waiting or being executed
+	bool stopping; // set to true to terminate the worker threads
+	mutex lock; // protects all of the above
+	condition_variable taskAvailable;
+	condition_variable tasksDone;
+};
 
-	addOption(parser, ArgParseOption("T", "predict-transposons", "Predict the location of suppressed transposons based on regions with high ping-pong activity. Consider adjacent ping-pong signatures within a range of \\fIRANGE\\fP to belong to the same transposon. Default: \\fIoff\\fP.", ArgParseArgument::INTEGER, "RANGE"));
-	stringstream ss;
-	ss << PREDICT_TRANSPOSONS_MIN_LENGTH;
-	setMinValue(parser, "predict-transposons", ss.str());
+// requests of clients of the query server must not be longer than this many bytes (see <runServer>)
+const size_t MAX_SERVER_REQUEST_LENGTH = 65536;
+// a response is abandoned, if the client does not accept data for this many seconds
+const unsigned int SERVER_SEND_TIMEOUT = 30;
 
-	addOption(parser, ArgParseOption("v", "verbose", "Print messages about the current progress to stderr. Default: \\fIoff\\fP."));
+// type to store a client connection of the query server (see <runServer>)
+struct TServerConnection
+{
+	int socket;
+	string buffer; // received data, which does not form a complete request yet
+	bool busy; // whether a worker thread is processing requests of the connection (see <serveRequests>)
+	bool closing; // whether the connection shall be closed as soon as it is not busy anymore
 
-	// parse command line
-	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
-	if (parserResult != ArgumentParser::PARSE_OK)
-		return parserResult;
+	TServerConnection():
+		socket(-1), busy(false), closing(false)
+	{
+	}
+};
 
-	// extract options, if parsing was successful
-	options.browserTracks = isSet(parser, "browserTracks");
+// type to hold the state the query server shares with its worker threads
+struct TServerState
+{
+	int wakeupPipe[2]; // workers write to the pipe to wake up the event loop of <runServer>
+	bool stopping; // set to true, when a client requests to stop the server
+	mutex lock; // protects <stopping> and the <busy> and <closing> flags of the connections
 
-	options.inputFiles.resize(getOptionValueCount(parser, "input")); // store input files in vector
-	if (options.inputFiles.size() > 0)
+	TServerState():
+		stopping(false)
 	{
-		for (vector< string >::size_type i = 0; i < options.inputFiles.size(); i++)
-			getOptionValue(options.inputFiles[i], parser, "input", i);
+		wakeupPipe[0] = wakeupPipe[1] = -1;
 	}
+};
 
-	string countMultiHits;
-	getOptionValue(countMultiHits, parser, "multi-hits");
-	if (countMultiHits == "unique")
+// An output sink receives the output files of an analysis (see <openOutputFile>).
+// The files are written to a directory or kept in memory. Since every analysis has its own sink,
+// several analyses can run concurrently in one process, e.g., the samples of <runBatch>.
+struct TOutputSink
+{
+	string directory; // the directory to write the files to (with trailing path delimiter) or an empty string for the current directory
+	bool inMemory; // if true, the files are stored in <files> instead of being written to <directory>
+	map< string, string > files; // contents of the files by name, if <inMemory> is true
+	mutex lock; // protects <files>
+
+	TOutputSink(const string &directory = "", bool inMemory = false):
+		directory(directory), inMemory(inMemory)
 	{
-		options.countMultiHits = multiHitsUnique;
 	}
-	else if (countMultiHits == "discard")
+};
+
+// type to hold a file of an output sink, which was opened with <openOutputFile>
+struct TOutputFile
+{
+	TOutputSink *sink;
+	string name; // the name of the file within the sink
+	ofstream file; // used for sinks that write to a directory
+	ostringstream buffer; // used for sinks that keep the files in memory
+	ostream *stream; // the stream to write the contents of the file to; NULL, if the file is not open
+
+	TOutputFile():
+		sink(NULL), stream(NULL)
 	{
-		options.countMultiHits = multiHitsDiscard;
 	}
-	else
-	{
-		options.countMultiHits = multiHitsWeighted;
+};
+
+// hardware performance counters measured by <stopwatch>, if the option --hardware-counters is given
+enum THardwareCounter { counterCycles, counterInstructions, counterCacheMisses, counterBranchMisses, counterPageFaults };
+const unsigned int HARDWARE_COUNTER_COUNT = 5;
+
+// type to hold the hardware counters of a stage (see <startHardwareCounters>)
+struct THardwareCounters
+{
+	int fileDescriptors[HARDWARE_COUNTER_COUNT]; // -1, if a counter is not running
+	bool available[HARDWARE_COUNTER_COUNT]; // whether a counter could be measured
+	double values[HARDWARE_COUNTER_COUNT];
+};
+
+// every thread keeps this many events for the trace written with --trace; if a thread records more events, its oldest events are overwritten
+const unsigned int TRACE_EVENTS_PER_THREAD = 65536;
+// names and details of events are truncated to this many characters (including the terminating null character)
+const unsigned int TRACE_NAME_LENGTH = 64;
+const unsigned int TRACE_DETAIL_LENGTH = 32;
+
+// type to hold the beginning or the end of a span of time in the trace (see <traceBegin> and <traceEnd>)
+struct TTraceEvent
+{
+	uint64_t timestamp; // nanoseconds since the trace was started
+	bool begin; // the beginning of a span, otherwise the end of the innermost open span
+	char name[TRACE_NAME_LENGTH];
+	char detail[TRACE_DETAIL_LENGTH]; // e.g., the number of the chunk or batch processed in the span
+};
+
+// Ring buffer of the events of a thread. Only the owning thread writes to the buffer,
+// so events are recorded without locking. The buffers are read after all threads have terminated (see <writeTraceFile>).
+struct TTraceBuffer
+{
+	unsigned int threadId; // the threads are numbered in the order in which they record their first event
+	vector< TTraceEvent > events;
+	uint64_t recorded; // number of events recorded so far; the last TRACE_EVENTS_PER_THREAD events are kept in <events>
+
+	TTraceBuffer(unsigned int threadId):
+		threadId(threadId), recorded(0)
+	{
 	}
+};
 
-	getOptionValue(options.minStackHeight, parser, "min-stack-height");
+// type to hold the state of the trace written with --trace
+struct TTraceRecorder
+{
+	bool enabled;
+	string fileName;
+	chrono::steady_clock::time_point start;
+	vector< unique_ptr< TTraceBuffer > > buffers; // the buffers of all threads, which ever recorded an event
+	mutex lock; // protects <buffers>; only taken, when a thread records its first event
+	bool written; // whether the trace file has been written (see <writeTraceFile>)
+
+	TTraceRecorder():
+		enabled(false), written(false)
+	{
+	}
+};
 
-	getOptionValue(options.minAlignmentLength, parser, "min-alignment-length");
-	getOptionValue(options.maxAlignmentLength, parser, "max-alignment-length");
+// type to hand over chunks of output from the threads that format them to the threads that write them (see <writeChunksInParallel>)
+struct TOrderedChunks
+{
+	vector< ostream * > files;
+	vector< vector< string > > chunks; // formatted text of every chunk of every file
+	vector< bool > formatted; // whether a chunk has been formatted
+	vector< unsigned int > written; // number of chunks written to every file
+	mutex lock; // protects all of the above
+	condition_variable chunkFormatted;
+	condition_variable chunkWritten;
+
+	TOrderedChunks(const vector< ostream * > &files, unsigned int chunkCount):
+		files(files), chunks(files.size(), vector< string >(chunkCount)), formatted(chunkCount, false), written(files.size(), 0)
+	{
+	}
+};
 
-	if (options.minAlignmentLength > options.maxAlignmentLength)
+// output files are formatted in chunks of this many lines (see <writeChunksInParallel>)
+const unsigned int OUTPUT_CHUNK_SIZE = 65536;
+
+// type to store a chunk of the ping-pong signatures of a contig for <writePingPongSignaturesToFile>
+struct TSignatureChunk
+{
+	unsigned int contig;
+	unsigned int begin; // first of the selected signatures in the chunk (see <selectPingPongSignatures>)
+	unsigned int end; // selected signature after the last one of the chunk
+};
+
+// type to store a chunk of the transposons of a contig for <writeTransposonsToFile>
+struct TTransposonChunk
+{
+	unsigned int contig;
+	unsigned int begin; // first row of the chunk
+	unsigned int end; // row after the last row of the chunk
+};
+
+// number of bins of the distributions of the ingestion metrics (see <TIngestMetrics>); larger values are counted in the last bin
+const unsigned int METRICS_LENGTH_BINS = 256;
+const unsigned int METRICS_MULTI_HIT_BINS = 256;
+const unsigned int METRICS_COLLAPSED_BINS = 32; // the number of collapsed reads is binned by powers of 2
+
+// Type to hold counters of the records read from the input files of a sample, which are written to ingestion_metrics.json (see <writeIngestMetricsFile>).
+// The counters are fixed arrays, such that counting a record costs only a few increments.
+struct TIngestMetrics
+{
+	uint64_t records;
+	uint64_t kept;
+	uint64_t unmapped;
+	uint64_t filteredByLength; // reads discarded, because they are shorter or longer than the limits
+	uint64_t filteredByMultiHits; // reads discarded by <countAlignment> (i.e., multi-hits with -m discard)
+	uint64_t alignmentLengths[METRICS_LENGTH_BINS]; // mapped records by the number of bases covered on the contig
+	// the following counters only cover the records which passed the length filter
+	uint64_t multiHits[METRICS_MULTI_HIT_BINS]; // records by the value of the NH tag
+	uint64_t collapsedReads[METRICS_COLLAPSED_BINS]; // records by the number of reads they represent (see <parseCollapsedReadCount>)
+	uint64_t softClippedAt5PrimeEnd;
+	uint64_t softClippedAt3PrimeEnd;
+	// the following counters only cover the kept records and are indexed by strand
+	uint64_t keptRecords[2];
+	uint64_t keptReads[2];
+	uint64_t AAtPosition10Records[2];
+	uint64_t AAtPosition10Reads[2];
+
+	TIngestMetrics():
+		records(0), kept(0), unmapped(0), filteredByLength(0), filteredByMultiHits(0), softClippedAt5PrimeEnd(0), softClippedAt3PrimeEnd(0)
 	{
-		cerr << getAppName(parser) << ": maximum alignment length (" << options.maxAlignmentLength << ") must not be lower than minimum alignment length (" << options.minAlignmentLength << ")" << endl;
-		return ArgumentParser::PARSE_ERROR;
+		fill(alignmentLengths, alignmentLengths + METRICS_LENGTH_BINS, 0);
+		fill(multiHits, multiHits + METRICS_MULTI_HIT_BINS, 0);
+		fill(collapsedReads, collapsedReads + METRICS_COLLAPSED_BINS, 0);
+		fill(keptRecords, keptRecords + 2, 0);
+		fill(keptReads, keptReads + 2, 0);
+		fill(AAtPosition10Records, AAtPosition10Records + 2, 0);
+		fill(AAtPosition10Reads, AAtPosition10Reads + 2, 0);
 	}
+};
 
-	getOptionValue(options.output, parser, "output");
-	if ((length(options.output) > 0) && (options.output[length(options.output)-1] != PATH_DELIMITER))
-		options.output += PATH_DELIMITER; // append slash to output path, if missing
+// the clock is checked every this many records to find out, if the progress is due to be reported (see <updateIngestProgress>)
+const unsigned int PROGRESS_CHECK_RECORDS = 16384;
+// seconds between two updates of the status file, if only --status-file is given
+const unsigned int STATUS_FILE_INTERVAL = 10;
 
-	options.plot = isSet(parser, "plot");
+// Type to hold the progress of reading the input files of a sample, which is reported by <reportIngestProgress>.
+// The counters are updated by the thread that parses the records.
+struct TIngestProgress
+{
+	unsigned int interval; // seconds between two reports; 0 disables the reports
+	bool messages; // whether to print the reports to stderr
+	bool lineOpen; // whether the next message must start a new line, because <stopwatch> left the line of the current file open
+	string statusFile; // if not empty, every report is also written to this file in JSON format
+	string fileName; // the input file being read
+	uint64_t totalBytes; // the size of all input files of the sample
+	uint64_t bytesDone; // the size of the input files that were read before the current one
+	uint64_t bytesConsumed; // the compressed bytes of the current file that were parsed; only known for the block reader (see <countReadsInBgzfFile>)
+	TIngestMetrics metrics; // the records read so far
+	int32_t contig; // the contig of the last record or -1
+	const TNameStore *nameStore; // the names of the contigs of the current file or NULL, if the header has not been read yet
+	chrono::steady_clock::time_point start;
+	chrono::steady_clock::time_point lastReport;
+
+	TIngestProgress():
+		interval(0), messages(false), lineOpen(false), totalBytes(0), bytesDone(0), bytesConsumed(0), contig(-1), nameStore(NULL)
+	{
+	}
+};
 
-	options.transposonFiles.resize(getOptionValueCount(parser, "transposons")); // store input files in vector
-	for (vector< string >::size_type i = 0; i < options.transposonFiles.size(); i++)
-		getOptionValue(options.transposonFiles[i], parser, "transposons", i);
+#ifdef PINGPONGPRO_BLOCK_READER
+// parameters of the reader for BAM files (see <countReadsInBgzfFile>)
+const size_t INPUT_BLOCK_SIZE = 4 * 1024 * 1024; // input files are read in blocks of this many bytes
+const unsigned int INPUT_BLOCKS_IN_FLIGHT = 4; // number of blocks that are read ahead of the consumer
+const size_t BGZF_BATCH_SIZE = 1024 * 1024; // compressed BGZF blocks are handed to the decompression threads in batches of about this many bytes
 
-	if (isSet(parser, "predict-transposons"))
+// counters to tell whether reading an input file is limited by I/O, decompression or parsing
+struct TInputCounters
+{
+	const char *backend; // "io_uring" or "threads"
+	uint64_t bytesRead;
+	double ioWaitSeconds; // time spent waiting for reads to complete
+	uint64_t bytesDecompressed;
+	double decompressionSeconds; // time spent decompressing, summed over all threads
+	double parserWaitSeconds; // time the parser spent waiting for decompressed data
+	uint64_t records;
+	double seconds; // total time to read the file
+
+	TInputCounters():
+		backend(""), bytesRead(0), ioWaitSeconds(0), bytesDecompressed(0), decompressionSeconds(0), parserWaitSeconds(0), records(0), seconds(0)
 	{
-		getOptionValue(options.predictTransposonsRange, parser, "predict-transposons");
 	}
-	else
+};
+
+// type to read a file in large blocks, which are requested ahead of time, such that the consumer rarely waits for I/O (see <readNextBlock>)
+// the reads are issued via io_uring, if the kernel supports it, or by a prefetching thread otherwise
+struct TBlockReader
+{
+	int fileDescriptor;
+	uint64_t fileSize;
+	vector< vector< char > > buffers; // block i is read into buffer i % INPUT_BLOCKS_IN_FLIGHT
+	vector< int64_t > results; // number of bytes read into every buffer, -1 while the read is pending
+	uint64_t blocksConsumed; // number of blocks handed out to the consumer
+	uint64_t blocksReleased; // number of blocks whose buffers may be reused
+	bool failed;
+	TInputCounters *counters;
+	#ifdef PINGPONGPRO_IO_URING
+	int ring; // file descriptor of the io_uring instance, -1 if the prefetching thread is used
+	unsigned int readsInFlight; // number of reads submitted to io_uring whose completion has not been reaped yet
+	void *submissionRing;
+	size_t submissionRingSize;
+	void *completionRing;
+	size_t completionRingSize;
+	struct io_uring_sqe *submissionEntries;
+	size_t submissionEntriesSize;
+	unsigned int *submissionTail;
+	unsigned int *submissionMask;
+	unsigned int *submissionArray;
+	unsigned int *completionHead;
+	unsigned int *completionTail;
+	unsigned int *completionMask;
+	struct io_uring_cqe *completionEntries;
+	vector< struct iovec > vectors; // one for every buffer
+	#endif
+	thread prefetcher;
+	bool stopping;
+	mutex lock; // protects <results>, <blocksReleased> and <stopping>, when the prefetching thread is used
+	condition_variable blockRead;
+	condition_variable blockReleased;
+
+	TBlockReader():
+		fileDescriptor(-1), fileSize(0), blocksConsumed(0), blocksReleased(0), failed(false), counters(NULL),
+		#ifdef PINGPONGPRO_IO_URING
+		ring(-1), readsInFlight(0), submissionRing(NULL), submissionRingSize(0), completionRing(NULL), completionRingSize(0), submissionEntries(NULL), submissionEntriesSize(0),
+		#endif
+		stopping(false)
 	{
-		options.predictTransposonsRange = 0;
 	}
+};
 
-	if (isSet(parser, "verbose"))
+// type to decompress the BGZF blocks of a BAM file with multiple threads, while a producer thread reads
+// and splits the compressed blocks and the consumer parses decompressed data (see <countReadsInBgzfFile>)
+struct TBgzfPipeline
+{
+	TBlockReader reader;
+	TThreadPool decompressors;
+	map< uint64_t, string > compressedBatches; // batches waiting to be decompressed by their number
+	map< uint64_t, string > decompressedBatches; // batches waiting to be parsed by their number
+	map< uint64_t, size_t > compressedSizes; // the compressed size of every batch waiting to be parsed
+	uint64_t batchesSubmitted;
+	uint64_t batchesConsumed;
+	uint64_t compressedBytesConsumed; // the compressed size of the batches parsed so far (see <TIngestProgress>)
+	unsigned int maxBatchesInFlight; // the producer waits, when this many batches are submitted, but not yet parsed
+	bool inputComplete; // set, when all batches have been submitted
+	bool failed; // set, when the pipeline must be stopped because of an error
+	string error;
+	mutex lock; // protects all of the above, except for <reader> and <decompressors>
+	condition_variable batchDecompressed;
+	condition_variable batchConsumed;
+	TInputCounters counters;
+
+	TBgzfPipeline():
+		batchesSubmitted(0), batchesConsumed(0), compressedBytesConsumed(0), maxBatchesInFlight(0), inputComplete(false), failed(false)
 	{
-		options.verbosity = 3;
 	}
-	else
+};
+#endif
+
+
+// type to limit the amount of memory used by tasks running in parallel (see <reserveMemory>)
+struct TMemoryBudget
+{
+	uint64_t limit; // maximum number of bytes that may be reserved at the same time (0 = unlimited)
+	uint64_t reserved; // number of bytes currently reserved
+	mutex lock;
+	condition_variable memoryReleased;
+
+	TMemoryBudget(uint64_t limit):
+		limit(limit), reserved(0)
 	{
-		options.verbosity = 0;
 	}
+};
 
-	return parserResult;
-}
+// rough estimate of the peak memory consumption of a sample relative to the size of its input files
+const double BATCH_MEMORY_PER_INPUT_BYTE = 4;
+
+// parameters of the memory model of the run planner (see <planRun>)
+const double STACKS_PER_MAPPED_READ = 0.3; // piRNA reads pile up, so there are considerably fewer stacks than reads
+// bytes per stack of the stores indexed by <TStackStoreType> while the input files are read, including the overhead of the allocator
+// and the unused capacity of vectors; the dense store needs BYTES_PER_DENSE_SLOT per position of a contig and strand instead
+const double BYTES_PER_STACK[] = {
+	64, // a node of a <TStackMap>
+	24, // a <TStackEntry> in a vector, which grows by a factor of 2
+	0, // see BYTES_PER_DENSE_SLOT
+	48, // a node and a bucket of an unordered_map
+	24 // the staging store, which is a flat store
+};
+const double BYTES_PER_DENSE_SLOT = 2 * sizeof(TReadStack); // a <TReadStack> in a vector, which grows by a factor of 2
+const double BYTES_PER_SIGNATURE = 48; // a node of a <TPingPongSignaturesPerContig>
+// tiles are not made smaller than this many stacks, even if there are too few stacks to keep all threads busy (see <countStacksByGroup>)
+const unsigned int MIN_STACKS_PER_TILE = 10000;
 
-// Function to measure time between the first and second invocation of the function.
-// Input parameters:
-//	operation: a description of the task being measured
-//	verbosity: if <operation> is not empty, the description is printed to stderr, if the verbosity level is >= INFO
-//	           if <operation is empty, the function prints the number of seconds since its last invocation
-// Return value: the number of seconds since the last invocation of the function
-unsigned int stopwatch(const string &operation, unsigned int verbosity)
+// type to hold the estimates of the run planner for a contig
+struct TContigPlan
 {
-	static time_t start = 0;
-	unsigned int elapsedSeconds = 0;
-	if (start != 0)
+	string name;
+	uint64_t length; // length of the contig according to the header of the BAM file
+	uint64_t mappedReads; // number of mapped reads according to the BAM index
+	unsigned int id; // ID of the contig, i.e., its index in the header of the BAM file
+	double stacks; // estimated number of read stacks on both strands
+	double signatures; // estimated number of ping-pong signatures that are kept in memory
+	TStackStoreType store; // the store of the read stacks of the contig (see <selectStackStores>)
+	uint64_t memory; // estimated memory consumption in bytes
+
+	TContigPlan():
+		length(0), mappedReads(0), id(0), stacks(0), signatures(0), store(stackStoreMap), memory(0)
 	{
-		elapsedSeconds = time(NULL) - start;
-		start = 0;
 	}
-	else
+};
+
+// type to hold the plan for analyzing a sample, which is derived from the indices of its BAM files (see <planRun>)
+struct TRunPlan
+{
+	bool available; // false, if not all input files are indexed BAM files; the defaults are used then
+	vector< TContigPlan > contigs; // sorted by estimated memory consumption, largest first
+	uint64_t peakMemory; // estimated peak memory consumption in bytes
+	unsigned int threads; // the number of threads that can be kept busy while grouping the stacks
+	unsigned int stacksPerTile; // the size of the tiles of <countStacksByGroup>
+
+	TRunPlan():
+		available(false), peakMemory(0), threads(1), stacksPerTile(STACKS_PER_TILE)
 	{
-		start = time(NULL);
 	}
-	if (verbosity >= 3)
+};
+
+// type to store a sample, which is analyzed in batch mode
+struct TBatchSample
+{
+	string name;
+	TInputFiles inputFiles;
+	string output; // output directory of the sample (with trailing path delimiter)
+	uint64_t estimatedMemory; // estimated memory consumption in bytes
+	bool failed;
+	double totalReadCount;
+	TRunPlan plan; // the plan of the sample for the threads it is given (see <planRun>)
+	TStackStoreSelection stackStores; // the stores of the read stacks of the contigs (see <selectStackStores>)
+	TTransposonScores transposonScores;
+	TPingPongQC qc; // only calculated in quality control mode
+
+	TBatchSample():
+		estimatedMemory(0), failed(false), totalReadCount(0)
 	{
-		if (operation != "")
-			cerr << operation << " ... ";
-		else
-			cerr << "done (" << elapsedSeconds << " seconds)" << endl;
 	}
-	cerr.flush();
-	return elapsedSeconds;
-}
-unsigned int stopwatch(unsigned int verbosity)
+};
+
+// type to answer queries about the ping-pong signatures of a contig with a given overlap in logarithmic time
+// the signatures are sorted by position and the scores are stored as prefix sums,
+// such that the sum of scores in any region is the difference of two elements
+struct TSignatureIndexPerContig
 {
-	return stopwatch("", verbosity);
-}
+	vector< unsigned int > positions; // sorted positions of the signatures
+	vector< float > fdr;
+	vector< float > readsOnPlusStrand;
+	vector< float > readsOnMinusStrand;
+	vector< double > scorePrefixSums; // element i holds the sum of the scores ((readsOnPlusStrand + readsOnMinusStrand) * (1 - FDR)) of signatures 0..i-1
+	vector< double > readsOnPlusStrandPrefixSums; // element i holds the sum of <readsOnPlusStrand> of signatures 0..i-1
+	vector< double > readsOnMinusStrandPrefixSums; // element i holds the sum of <readsOnMinusStrand> of signatures 0..i-1
+};
 
-//split string into list
-char **GetStrArray(char* s,const char* d)
-{
-    char* s_s=new char[strlen(s)];
-	strcpy(s_s,s);
-	//length of string
-	int rows=0;
-    char *p_str=strtok(s_s,d);
-	while(p_str)
-    {
-		rows+=1;
-        p_str=strtok(NULL,d);
-	}
-	//indicating array
-	char **strArray=new char*[rows+1];
-	for(int i=0;i<rows;i++)
-	{
-        strArray[i]=NULL;
-	}
-	strArray[0]=i2cp(rows);  //array_ length
-	//
-	int index=1;
-	s_s=new char[strlen(s)];
-	strcpy(s_s,s);
-    p_str=strtok(s_s,d);
-	while(p_str)
-    {
-        char* s_p=new char[strlen(p_str)];
-	    strcpy(s_p,p_str);
-		//add to array
-        strArray[index]=s_p;
-		//
-		index+=1;
-        p_str=strtok(NULL,d);
-	}
-	return strArray;
-}
-// Function which finds stacks of reads in a BAM file.
-// Input parameters:
-//	bamFile: the BAM/SAM file from where to load the reads
-//	minAlignmentLength: reads in the <bamFile> which are shorter than this are ignored
-//	maxAlignmentLength: reads in the <bamFile> which are longer than this are ignored
-//	countMultiHits: how to count multi-mapped reads (see declaration of TCountMultiHits)
-// Output parameters:
-//	readStacks: stacks of reads that were found by the function
-//	totalReadCount: the total number of reads that were not discarded
-// Return value: 1, if the <bamFile> could not be read; 0 otherwise
-int countReadsInBamFile(BamStream &bamFile, TReadStacksPerGenome &readStacks, const unsigned int minAlignmentLength, const unsigned int maxAlignmentLength, TCountMultiHits countMultiHits, double &totalReadCount)
+// function to sort row numbers by position, used by stable_sort
+struct TComparePositions
 {
-	TReadStack *position;
+	const vector< unsigned int > &positions;
 
-	BamAlignmentRecord record;
-	while (!atEnd(bamFile))
+	TComparePositions(const vector< unsigned int > &positions):
+		positions(positions)
 	{
-		if (readRecord(record, bamFile) != 0)
-		{
-			cerr << "Failed to read record" << endl;
-			return 1;
-		}
-
-		if ((record.beginPos != BamAlignmentRecord::INVALID_POS) && (record.beginPos != -1)) // skip unmapped reads
-		{
-			// calculate length of alignment using CIGAR string
-			size_t alignmentLength = 0;
-			for (unsigned int cigarIndex = 0; cigarIndex < length(record.cigar); ++cigarIndex)
-			{
-				if ((record.cigar[cigarIndex].operation == 'M') || (record.cigar[cigarIndex].operation == 'N') || (record.cigar[cigarIndex].operation == 'D') || (record.cigar[cigarIndex].operation == '=') || (record.cigar[cigarIndex].operation == 'X')) // these CIGAR elements indicate alignment
-					alignmentLength += record.cigar[cigarIndex].count;
-			}
+	}
 
-			// skip read, if alignment is too long or too short
-			if ((alignmentLength < minAlignmentLength) || (alignmentLength > maxAlignmentLength))
-				continue;
+	inline bool operator()(unsigned int row1, unsigned int row2) const
+	{
+		return positions[row1] < positions[row2];
+	}
+};
 
-			// the stack height is increased by the value of this variable (depends on how multi-hits are handled)
-			float readWeight;
-			int read_num = 0
-			char **strArray=GetStrArray(record.qName, "x");
-			read_num = atoi( strArray[2] )
-			if (countMultiHits == multiHitsUnique) // we do not distinguish between multi-hits and unique hits
-			{
-				// increase stack height by 1, regardless of whether it is a multi-hit or unique hit
-				// readWeight = 1;
-				readWeight = read_num;
-			}
-			else
-			{
-				// check if the record is a multi-hit by examining the optional tags
-				BamTagsDict tagsDictionary(record.tags);
-				unsigned int tagIndex;
-				unsigned int multiHits = 1;
-				if (findTagKey(tagIndex, tagsDictionary, "NH"))
-					extractTagValue(multiHits, tagsDictionary, tagIndex);
-
-				if (countMultiHits == multiHitsWeighted)
-				{
-					// increase stack height by fraction
-					// readWeight = 1.0 / multiHits;
-					readWeight = 1.0 * read_num / multiHits;
-				}
-				else /*if (countMultiHits == multiHitsDiscard)*/
-				{
-					// discard read (i.e., set readWeight to 0), if there is more than 1 instance in the SAM file
-					// readWeight = (multiHits == 1) ? 1 : 0;
-					readWeight = (multiHits == 1) ? read_num : 0;
-				}
-			}
+// type to index the signatures of a sample for every contig (by name) and every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+typedef map< string, vector< TSignatureIndexPerContig > > TSignatureIndex;
 
-			if (readWeight <= 0)
-				continue; // skip to next read, if read is to be discarded
+// type to hold the result of a region query on a <TSignatureIndex>
+struct TRegionSummary
+{
+	unsigned int signatures; // number of signatures in the region
+	double score; // sum of scores of the signatures in the region
+	double readsOnPlusStrand;
+	double readsOnMinusStrand;
 
-			if (hasFlagRC(record)) // read maps to minus strand
-			{
-				// get a pointer to counter of the position of the read
-				position = &(readStacks[STRAND_MINUS][record.rID][record.beginPos+alignmentLength]);
+	TRegionSummary():
+		signatures(0), score(0), readsOnPlusStrand(0), readsOnMinusStrand(0)
+	{
+	}
+};
 
-				// check if base at position 10 is adenine
-				size_t clippedBasesAt5PrimeEnd = 0;
-				if ((length(record.cigar) > 1) && (record.cigar[length(record.cigar)-1].operation == 'S'))
-					clippedBasesAt5PrimeEnd = record.cigar[length(record.cigar)-1].count;
-				if ((record.seq[length(record.seq)-clippedBasesAt5PrimeEnd-1-9] == 'T') || (record.seq[length(record.seq)-clippedBasesAt5PrimeEnd-1-9] == 't')) // check if 10th base is adenine (we check for uracil, because reads on the - strand are stored as the complement in SAM files
-					position->AAtPosition10 = true;
-			}
-			else // read maps to plus strand
-			{
-				// get a pointer to counter of the position of the read
-				position = &(readStacks[STRAND_PLUS][record.rID][record.beginPos]);
+// parameters for transposon prediction based on ping-pong activity
+const unsigned int PREDICT_TRANSPOSONS_MIN_LENGTH = 30; // predicted transposons shorter than this are discarded
 
-				// check if base at position 10 is adenine
-				size_t clippedBasesAt5PrimeEnd = 0;
-				if (record.cigar[0].operation == 'S')
-					clippedBasesAt5PrimeEnd = record.cigar[0].count;
-				if ((record.seq[clippedBasesAt5PrimeEnd+9] == 'A') || (record.seq[clippedBasesAt5PrimeEnd+9] == 'a'))
-					position->AAtPosition10 = true;
-			}
+// the calculation of p-values is based on integrals
+// the following constants are parameters for the precision of p-values calculation
+const double APPROXIMATION_ACCURACY = 0.01; // step size with which integrals are calculated; smaller means more accurate
+const double APPROXIMATION_RANGE = 5; // span of integral calculation; wider means more accurate
+const double MIN_STANDARD_DEVIATION = 1E-10; // if the STDDEV is smaller than this, assume this fixed value to avoid division by 0
 
-			// increase stack height
-			position->reads += readWeight;
-			totalReadCount += readWeight;
-		}
-	}
-	return 0;
-}
+// ==========================================================================
+// Functions
+// ==========================================================================
 
-// Function, which converts every stack height into a score.
-// The score is directly based on how often a stack with a certain height is found in the input files of the program.
-// Therefore, the score maps every stack height to the empirical frequency of encountering such a stack in the input dataset.
+// function to parse the specification of a distance histogram given with --distance-histogram
 // Input parameters:
-//	readStacks: the read stacks that were found by the function <countReadsInBamFile>
-// Output parameters:
-//	heightScoreMap: output of the function
-//	                a mapping of [stack height -> empirical frequency of stacks with this height]
-void mapHeightsToScores(TReadStacksPerGenome &readStacks, THeightScoreMap &heightScoreMap)
+//	spec: the specification in the form RELATION:END:MIN:MAX
+// Input/output parameters:
+//	distanceHistograms: the parsed histogram is appended to this list
+// Return value: 1, if the specification is malformed; 0 otherwise
+int parseDistanceHistogramSpec(const string &spec, TDistanceHistograms &distanceHistograms)
 {
-	// iterate through all strands, contigs and positions to count how many stacks there are of any given height
-	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
-		for (TReadStacksPerStrand::iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
-			for (TReadStacksPerContig::iterator position = contig->second.begin(); position != contig->second.end(); ++position)
-				heightScoreMap[0.5 + position->second.reads] += 1;
+	istringstream fields(spec);
+	string relation, end;
+	int minDistance, maxDistance;
+	char delimiter1, delimiter2;
+	if (!getline(fields, relation, ':') || !getline(fields, end, ':') || !(fields >> minDistance >> delimiter1 >> maxDistance) || (delimiter1 != ':') || (fields >> delimiter2))
+		return 1;
+	if (((relation != "same") && (relation != "opposite")) || ((end != "5") && (end != "3")) || (minDistance > maxDistance))
+		return 1;
+	distanceHistograms.push_back(TDistanceHistogram((relation == "same") ? sameStrand : oppositeStrand, (end == "5") ? fivePrimeEnd : threePrimeEnd, minDistance, maxDistance));
+	return 0;
 }
 
-// Function, which groups read stacks by all possible combinations of the following criteria:
-// - the height of the overlapping stacks
-// - whether the reads have adenine at position 10
-// - whether the height of the stacks are above or below the local coverage
-// For every group, the number of stacks falling into that particular group is counted.
+// function to parse command-line arguments
 // Input parameters:
-//	readStacks: the read stacks that were found by the function <countReadsInBamFile>
-//	            the variable is emptied by the function to conserve memory
-//	heightScoreMap: a mapping of [stack height -> empirical frequency of stacks with this height] as produced by the function <mapHeightsToScores>
+//	argc: number of command-line arguments as passed to the function <main>
+//	argv: array of command-line arguments as passed to the function <main>
 // Output parameters:
-//	groupedStackCountsByOverlap: for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>, the number of read stacks falling into all possible groups
-//	pingPongSignaturesByOverlap: for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>, the ping-pong signatures that were found
-void countStacksByGroup(TReadStacksPerGenome &readStacks, THeightScoreMap &heightScoreMap, TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap)
+//	options: parsed options
+// Return value: status code about whether the command-line could be parsed
+ArgumentParser::ParseResult parseCommandLine(AppOptions &options, int argc, char const ** argv)
 {
-	// the following loop initializes a multi-dimensional array of stack counts with the following boundaries:
-	// MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1 (one for each possible overlap)
-	// HEIGHT_SCORE_BINS (one of each bin of the height scores)
-	// 2 (one for reads with adenine at position 10 and one for those with a different base)
-	// 2 (one for stack heights below the local coverage and one for stack heights above)
-	groupedStackCountsByOverlap.resize(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1);
-	for (TGroupedStackCountsByOverlap::iterator i = groupedStackCountsByOverlap.begin(); i != groupedStackCountsByOverlap.end(); ++i)
-	{
-		i->resize(HEIGHT_SCORE_BINS);
-		for (TGroupedStackCounts::iterator j = i->begin(); j != i->end(); ++j)
-		{
-			j->resize(2);
-			for (vector< vector< float > >::iterator k = j->begin(); k != j->end(); ++k)
-			{
-				k->resize(2);
-			}
-		}
-	}
+	ArgumentParser parser("pingpongpro");
 
-	pingPongSignaturesByOverlap.resize(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1);
+	// define usage and description
+	addUsageLine(parser, "[\\fIOPTIONS\\fP] -i \\fISAM_INPUT_FILE\\fP [-o \\fIOUTPUT_DIRECTORY\\fP]");
+	setShortDescription(parser, "Find ping-pong signatures like a pro");
+	addDescription(parser, "PingPongPro scans piRNA-Seq data for signs of ping-pong cycle activity. The ping-pong cycle produces piRNA molecules with complementary 5'-ends. These molecules appear as stacks of aligned reads whose 5'-ends overlap with the 5'-ends of reads on the opposite strand by exactly 10 bases.");
+	setVersion(parser, "1.0");
+	setDate(parser, "Apr 2014");
 
-	// find the highest possible score that two overlapping stacks can get
-	float maxHeightScore = 0;
-	for (THeightScoreMap::iterator heightScore = heightScoreMap.begin(); heightScore != heightScoreMap.end(); ++heightScore)
-		if (heightScore->second > maxHeightScore)
-			maxHeightScore = heightScore->second;
-	maxHeightScore = log10(maxHeightScore * maxHeightScore);
+	// define parameters
+	addOption(parser, ArgParseOption("b", "browserTracks", "Generate genome browser tracks for loci with ping-pong signature and (if -t or -T is specified) for transposons with ping-pong activity. Default: \\fIoff\\fP."));
 
-	// iterate through all strands, contigs and positions to find those positions where a stack on the plus strand overlaps a stack on the minus strand by <overlap> nt
-	for (TReadStacksPerStrand::iterator contigPlusStrand = readStacks[STRAND_PLUS].begin(); contigPlusStrand != readStacks[STRAND_PLUS].end(); ++contigPlusStrand)
-	{
-		TReadStacksPerStrand::iterator contigMinusStrand = readStacks[STRAND_MINUS].find(contigPlusStrand->first);
-		if (contigMinusStrand != readStacks[STRAND_MINUS].end())
-		{
-			for (TReadStacksPerContig::iterator positionPlusStrand = contigPlusStrand->second.begin(); positionPlusStrand != contigPlusStrand->second.end(); ++positionPlusStrand)
-			{
-				vector< TReadStacksPerContig::iterator > stacksOnMinusStrand(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1, contigMinusStrand->second.end());
-				float meanStackHeightInVicinity = 0;
-				float maxStackHeightInVicinity = 0;
-				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-				{
-					TReadStacksPerContig::iterator positionMinusStrand = contigMinusStrand->second.find(positionPlusStrand->first + overlap);
-					if (positionMinusStrand != contigMinusStrand->second.end())
-					{
-						// calculate mean of stack heights in the vicinity
-						meanStackHeightInVicinity += positionMinusStrand->second.reads;
-						// find highest stacks height in the vicinity
-						if (positionMinusStrand->second.reads > maxStackHeightInVicinity)
-							maxStackHeightInVicinity = positionMinusStrand->second.reads;
-						// remember the stacks that we found, so we do not have to search them again
-						stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP] = positionMinusStrand;
-					}
-				}
-				meanStackHeightInVicinity /= stacksOnMinusStrand.size();
+	addOption(parser, ArgParseOption("s", "min-stack-height", "Omit stacks with fewer than the specified number of reads from the output.", ArgParseArgument::INTEGER, "NUMBER_OF_READS"));
+	setDefaultValue(parser, "min-stack-height", 0);
+	setMinValue(parser, "min-stack-height", "0");
 
-				if (maxStackHeightInVicinity > 0) // only continue, if there are any stacks in the vicinity at all
-				{
-					float heightScorePlus = heightScoreMap[0.5 + positionPlusStrand->second.reads];
+	addOption(parser, ArgParseOption("d", "max-fdr", "Omit ping-pong signatures with an FDR above \\fIFDR\\fP from the output. Transposons are still scored using all signatures.", ArgParseArgument::DOUBLE, "FDR"));
+	setDefaultValue(parser, "max-fdr", 1);
+	setMinValue(parser, "max-fdr", "0");
+	setMaxValue(parser, "max-fdr", "1");
 
-					for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-					{
-						if (stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP] != contigMinusStrand->second.end())
-						{
-							// calculate score based on heights of overlapping stacks
-							float heightScore = heightScorePlus * heightScoreMap[0.5 + stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->second.reads];
-							// find the bin for the score
-							unsigned int heightScoreBin =
-								static_cast<int>(0.5 // add 0.5 for arithmetic rounding when casting float to int
-								+ log10(heightScore) // take logarithm of score
-								/ maxHeightScore * (groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP].size() - 1)); // assign every score to a bin
-
-							// calculate score based on how much higher the stack is compared to the stacks in the vicinity
-							float localHeightScore = (stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->second.reads - (meanStackHeightInVicinity - stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->second.reads/stacksOnMinusStrand.size())) / maxStackHeightInVicinity;
-							// 0.2 seems to be the magical threshold that best segregates ping-pong overlaps from arbitrary overlaps
-							unsigned int localHeightScoreBin = (localHeightScore < 0.2) ? IS_BELOW_COVERAGE : IS_ABOVE_COVERAGE;
-
-							// calculate score based on whether the stack has adenine at position 10
-							unsigned int baseBiasBin = (positionPlusStrand->second.AAtPosition10 || stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->second.AAtPosition10) ? HAS_BASE_BIAS : HAS_NO_BASE_BIAS;
-
-							// increase bin counter
-							groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][heightScoreBin][baseBiasBin][localHeightScoreBin]++;
-
-							// keep a list of putative ping-pong signatures, so we can analyze later, which of them are (likely) true
-							pingPongSignaturesByOverlap[overlap - MIN_ARBITRARY_OVERLAP][contigPlusStrand->first].push_back(TPingPongSignature(positionPlusStrand->first, heightScoreBin, localHeightScoreBin, baseBiasBin, positionPlusStrand->second.reads, stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->second.reads));
-						}
-					}
-				}
-			}
+	addOption(parser, ArgParseOption("k", "top-k", "Write only the \\fINUMBER\\fP strongest ping-pong signatures of every contig, i.e., those with the highest score (sum of both stack heights * (1 - FDR)). Default: all.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "top-k", 0);
+	setMinValue(parser, "top-k", "0");
 
-			// free memory of contig on - strand
-			contigMinusStrand->second.clear();
-		}
-		// free memory of contig on + strand
-		contigPlusStrand->second.clear();
-	}
+	addOption(parser, ArgParseOption("i", "input", "Input file in SAM/BAM/CRAM format. Alternatively, a table of the number of reads per 5' end: either a TSV file with the columns contig, strand, position (1-based), number of reads and whether the 10th base is adenine (1/0), or a bedGraph file with positive values for reads on the + strand and negative values for reads on the - strand.", ArgParseArgument::INPUTFILE, "PATH", true));
+	setValidValues(parser, "input", ".bam .sam .cram .tsv .bedGraph .bg");
 
-	// free the rest of memory that might potentially not have been freed yet
-	for (TReadStacksPerStrand::iterator contigMinusStrand = readStacks[STRAND_MINUS].begin(); contigMinusStrand != readStacks[STRAND_MINUS].end(); ++contigMinusStrand)
-		contigMinusStrand->second.clear();
-}
+	addOption(parser, ArgParseOption("r", "reference", "Reference genome in FASTA format, which is needed to decode CRAM files. The FASTA file must be indexed with samtools faidx.", ArgParseArgument::INPUTFILE, "PATH"));
 
-// The groups of stacks as produced by the function <countStacksByGroup> may be empty.
-// This function merges adjacent groups until there are no empty groups left.
-// Input/output parameters:
-// 	groupedStackCountsByOverlap: the grouped stack counts as produced by the function <countStacksByGroup>
-//	pingPongSignaturesByOverlap: the ping-pong signatures found by the function <countStacksByGroup>
-void collapseBins(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap)
-{
-	// create a new container to hold the collapsed bin counts
-	TGroupedStackCountsByOverlap collapsed = groupedStackCountsByOverlap;
+	addOption(parser, ArgParseOption("B", "batch", "Analyze all samples listed in the manifest file \\fIPATH\\fP instead of the input files given by -i. Every line of the manifest holds the name of a sample, a comma-separated list of SAM/BAM/CRAM files and optionally an output directory, separated by tabs. The output of every sample is written to a sub-directory of the output directory and a matrix of the ping-pong activity of transposons in all samples is written to the output directory.", ArgParseArgument::INPUTFILE, "PATH"));
 
-	// keep track of which bins are mapped to which collapsed bins
-	vector< unsigned int > oldBinCollapsedBinMap(groupedStackCountsByOverlap.begin()->size());
+	addOption(parser, ArgParseOption("j", "threads", "Number of worker threads.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "threads", 1);
+	setMinValue(parser, "threads", "1");
 
-	unsigned int collapsedBin = 0;
-	unsigned int bin = 0;
-	while (bin < groupedStackCountsByOverlap.begin()->size()){
+	addOption(parser, ArgParseOption("M", "max-memory", "Refuse to analyze a sample if its predicted peak memory consumption exceeds \\fIMEGABYTES\\fP. The prediction is based on the number of mapped reads per contig in the BAM index (.bai) and is printed with -v. In batch mode, do not start a sample if the estimated memory consumption of all running samples would exceed \\fIMEGABYTES\\fP. Default: unlimited.", ArgParseArgument::INTEGER, "MEGABYTES"));
+	setDefaultValue(parser, "max-memory", 0);
+	setMinValue(parser, "max-memory", "0");
 
-		// initialize collapsed bin with 0
-		for (TGroupedStackCountsByOverlap::iterator i = collapsed.begin(); i != collapsed.end(); ++i)
-			for (vector< vector< float > >::iterator j = (*i)[collapsedBin].begin(); j != (*i)[collapsedBin].end(); ++j)
-				for (vector< float >::iterator k = j->begin(); k != j->end(); ++k)
-					*k = 0;
+	addOption(parser, ArgParseOption("l", "min-alignment-length", "Ignore alignments in the input file that are shorter than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "min-alignment-length", 24);
+	setMinValue(parser, "min-alignment-length", "1");
+	addOption(parser, ArgParseOption("L", "max-alignment-length", "Ignore alignments in the input file that are longer than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "max-alignment-length", 32);
+	setMinValue(parser, "max-alignment-length", "1");
 
-		unsigned int emptyBins;
-		do {
-			emptyBins = 0;
+	addOption(parser, ArgParseOption("m", "multi-hits", "How to count multi-mapping reads.", ArgParseArgument::STRING, "METHOD"));
+	setDefaultValue(parser, "multi-hits", "weighted");
+	setValidValues(parser, "multi-hits", "weighted discard unique");
 
-			// collapse bins
-			for (unsigned int overlap = 0; overlap < groupedStackCountsByOverlap.size(); overlap++)
-				for (unsigned int i = 0; i < groupedStackCountsByOverlap[overlap][bin].size(); i++)
-					for (unsigned int j = 0; j < groupedStackCountsByOverlap[overlap][bin][i].size(); j++)
-					{
-						collapsed[overlap][collapsedBin][i][j] += groupedStackCountsByOverlap[overlap][bin][i][j];
+	addOption(parser, ArgParseOption("R", "reader", "How to read BAM files. \\fIblock\\fP reads the file in large blocks ahead of time (via io_uring, if available) and decompresses it with as many threads as given by -j. \\fIseqan\\fP reads the file sequentially with the SeqAn library. SAM files are always read with SeqAn.", ArgParseArgument::STRING, "METHOD"));
+	setDefaultValue(parser, "reader", "block");
+	setValidValues(parser, "reader", "block seqan");
 
-						// check if collapsedBin is still empty to decide whether to collapse even more
-						if (collapsed[overlap][collapsedBin][i][j] <= 0)
-							emptyBins++;
-					}
+	addOption(parser, ArgParseOption("K", "stack-store", "How to keep the read stacks of every contig in memory. \\fImap\\fP is a balanced tree, \\fIflat\\fP a vector that is sorted after reading the input files, \\fIdense\\fP has a slot for every position between the first and the last stack, \\fIhash\\fP is a hash table and \\fIcompressed\\fP encodes the stacks as variable-length integers. The stores differ in memory consumption and speed, which can be compared with \\fBpingpongpro benchmark\\fP. \\fIauto\\fP chooses the dense store for contigs which are densely covered by stacks according to the BAM index and the flat store for the other contigs (printed with -v); contigs of input files other than indexed BAM files are kept in maps.", ArgParseArgument::STRING, "STORE"));
+	setDefaultValue(parser, "stack-store", "auto");
+	setValidValues(parser, "stack-store", "auto map flat dense hash compressed");
 
-			// remember with which new bin the current bin was merged
-			oldBinCollapsedBinMap[bin] = collapsedBin;
+	addOption(parser, ArgParseOption("D", "distance-histogram", "Write a histogram of the distances between read stacks to the file distance_histograms.tsv. \\fISPEC\\fP has the form \\fIRELATION\\fP:\\fIEND\\fP:\\fIMIN\\fP:\\fIMAX\\fP. \\fIRELATION\\fP is \\fIsame\\fP or \\fIopposite\\fP strand, \\fIEND\\fP is the end of the reads (\\fI5\\fP or \\fI3\\fP) from which the distance to the 5' ends of other reads is measured in the direction of the read and \\fIMIN\\fP and \\fIMAX\\fP are the range of distances. On the same strand, the distance is the offset of the 5' end of the other read, e.g., same:3:-5:30 shows the phasing of piRNAs (1 = directly adjacent). On opposite strands, the distance is the overlap, e.g., opposite:5:3:23 shows the ping-pong overlaps. The option may be given multiple times. All histograms are computed in a single pass over the read stacks.", ArgParseArgument::STRING, "SPEC", true));
 
-			bin++;
-		// stop collapsing bins, when there are no empty bins or when all bins have been merged
-		} while ((emptyBins > 0) && (bin < groupedStackCountsByOverlap.begin()->size()));
+	addOption(parser, ArgParseOption("q", "qc-only", "Quickly assess the ping-pong activity of the entire library: print the number of reads of all opposite stacks for every overlap between 3 and 23 nt as well as the z-score of the 10 nt overlap to stdout and exit. No ping-pong signatures are identified and no files are written. With -B, one line is printed per sample. Default: \\fIoff\\fP."));
 
-		collapsedBin++;
-	}
+	addOption(parser, ArgParseOption("o", "output", "Write output to specified directory. Default: current working directory.", ArgParseArgument::OUTPUTFILE, "PATH"));
 
-	// shrink container to new number of bins
-	for (TGroupedStackCountsByOverlap::iterator i = collapsed.begin(); i != collapsed.end(); ++i)
-		i->resize(collapsedBin);
+	addOption(parser, ArgParseOption("p", "plot", "Generate R plots on how z-scores are calculated for ping-pong signatures and (if -t or -T is specified) for transposons. Requires Rscript. Default: \\fIoff\\fP."));
 
-	for (TPingPongSignaturesByOverlap::iterator pingPongSignaturesPerGenome = pingPongSignaturesByOverlap.begin(); pingPongSignaturesPerGenome != pingPongSignaturesByOverlap.end(); ++pingPongSignaturesPerGenome)
-		for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesPerGenome->begin(); contig != pingPongSignaturesPerGenome->end(); ++contig)
-			for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
-				pingPongSignature->heightScoreBin = oldBinCollapsedBinMap[pingPongSignature->heightScoreBin];
+	addOption(parser, ArgParseOption("x", "signature-index", "Additionally write the ping-pong signatures of all overlaps to the file ping-pong_signatures.ppidx, which is indexed by position, such that regions can be queried quickly with \\fBpingpongpro query\\fP and \\fBpingpongpro serve\\fP. Default: \\fIoff\\fP."));
 
-	// return collapsed bins as result
-	groupedStackCountsByOverlap = collapsed;
-}
+	addOption(parser, ArgParseOption("w", "activity-window", "Write a genome-wide track of ping-pong activity in windows of \\fISIZE\\fP nt to the file ping-pong_activity_\\fISIZE\\fPbp.bedGraph. For every window, the score of the ping-pong signatures is z-scored against the scores of arbitrary overlaps, like for transposons. The option may be given multiple times for different window sizes.", ArgParseArgument::INTEGER, "SIZE", true));
 
-// This function assigns a FDR to every ping-pong stacks based on how often ping-pong stacks
-// with the properties of a given ping-pong stack occur by chance compared to how often they occur
-// when looking at overlaps of 10 nt.
-// Input paramters:
-// 	groupedStackCountsByOverlap: the collapsed grouped stack counts as modified by the function <collapseBins>
-// Input/output parameters:
-//	pingPongSignaturesByOverlap: the ping-pong signatures as modified by the function <collapseBins>
-void calculateFDRs(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap)
-{
-	TGroupedStackCountsByOverlap FDRs = groupedStackCountsByOverlap; // the assignment shall only ensure that <FDRs> has the same dimensions as <groupedStackCountsByOverlap>
+	addOption(parser, ArgParseOption("t", "transposons", "Check if the transposons given in the file \\fIPATH\\fP are suppressed through ping-pong activity.", ArgParseArgument::INPUTFILE, "PATH", true));
+	setValidValues(parser, "transposons", ".bed .csv .gff .gtf .tsv");
 
-	// estimate how many of the putative ping-pong signatures are random noise
-	for (unsigned int i = 0; i < groupedStackCountsByOverlap.begin()->size(); i++)
-		for (unsigned int j = 0; j < (*groupedStackCountsByOverlap.begin())[i].size(); j++)
-			for (unsigned int k = 0; k < (*groupedStackCountsByOverlap.begin())[i][j].size(); k++)
-			{
-				// calculate mean for all the bins of arbitrary overlaps
-				float meanOfArbitraryOverlaps = 0;
-				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-					if (overlap != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
-						meanOfArbitraryOverlaps += groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k];
-				meanOfArbitraryOverlaps = meanOfArbitraryOverlaps / (groupedStackCountsByOverlap.size() - 1 /* minus the one bin for ping-pong overlaps */);
+	addOption(parser, ArgParseOption("a", "attribute", "For transposon files in GFF/GTF format, use the value of the attribute \\fIKEY\\fP in column 9 as identifier of a transposon (e.g., gene_id, transcript_id, Name). Default: entire column 9.", ArgParseArgument::STRING, "KEY"));
 
-				// calculate standard deviation for all the bins of arbitrary overlaps
-				float stdDevOfArbitraryOverlaps = 0;
-				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-					if (overlap != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
-						stdDevOfArbitraryOverlaps += pow(groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] - meanOfArbitraryOverlaps, 2);
-				stdDevOfArbitraryOverlaps = sqrt(1.0 / (groupedStackCountsByOverlap.size() - 1 - 1 /* minus 1 for corrected sample STDDEV */) * stdDevOfArbitraryOverlaps);
-				if (stdDevOfArbitraryOverlaps <= MIN_STANDARD_DEVIATION)
-					stdDevOfArbitraryOverlaps = MIN_STANDARD_DEVIATION; // prevent division by 0, in case the STDDEV is 0
+	addOption(parser, ArgParseOption("c", "annotation-cache", "Cache parsed transposon files in the directory \\fIPATH\\fP. Subsequent runs load the cache instead of parsing the transposon files again, unless the files were modified. The cache may be shared by concurrent runs.", ArgParseArgument::STRING, "PATH"));
 
-				// calculate expected number of false positives among the putative ping-pong signatures
-				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-				{
-					double fdr = 0;
-					for (double x = -APPROXIMATION_RANGE; x <= +APPROXIMATION_RANGE; x += APPROXIMATION_ACCURACY)
-					{
-						if (x >= (groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] - meanOfArbitraryOverlaps) / stdDevOfArbitraryOverlaps)
-						{
-							fdr += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x) * 1;
-						}
-						else
-						{
-							fdr += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x) * (x * stdDevOfArbitraryOverlaps + meanOfArbitraryOverlaps) / groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k];
-						}
-					}
+	addOption(parser, ArgParseOption("F", "families", "Aggregate the ping-pong activity of all copies of a transposon family and check the families for ping-pong activity (requires -t). Transposons with the same identifier are considered to belong to the same family, unless -f is given. Default: \\fIoff\\fP."));
 
-					if (fdr < 0)
-					{
-						fdr = 0;
-					}
-					else if (fdr > 1)
-					{
-						fdr = 1;
-					}
+	addOption(parser, ArgParseOption("f", "family-attribute", "For transposon files in GFF/GTF format, use the value of the attribute \\fIKEY\\fP in column 9 as family of a transposon (e.g., gene_id, repName, family_id).", ArgParseArgument::STRING, "KEY"));
 
-					FDRs[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] = fdr;
-				}
-			}
+	addOption(parser, ArgParseOption("T", "predict-transposons", "Predict the location of suppressed transposons based on regions with high ping-pong activity. Consider adjacent ping-pong signatures within a range of \\fIRANGE\\fP to belong to the same transposon. Default: \\fIoff\\fP.", ArgParseArgument::INTEGER, "RANGE"));
+	stringstream ss;
+	ss << PREDICT_TRANSPOSONS_MIN_LENGTH;
+	setMinValue(parser, "predict-transposons", ss.str());
 
-	// assign a FDR to every putative ping-pong signature
-	for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
-		for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesByOverlap[overlap - MIN_ARBITRARY_OVERLAP].begin(); contig != pingPongSignaturesByOverlap[overlap - MIN_ARBITRARY_OVERLAP].end(); ++contig)
-			for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
-				pingPongSignature->fdr = FDRs[overlap - MIN_ARBITRARY_OVERLAP][pingPongSignature->heightScoreBin][pingPongSignature->baseBiasBin][pingPongSignature->localHeightScoreBin];
-}
+	addOption(parser, ArgParseOption("v", "verbose", "Print messages about the current progress to stderr. Default: \\fIoff\\fP."));
+	addOption(parser, ArgParseOption("H", "hardware-counters", "Print the CPU cycles, instructions per cycle, last-level cache misses, branch misses and page faults of every stage together with its running time. The counters of all threads of a stage are summed up. Counters which are not supported by the CPU or not permitted by the kernel (see /proc/sys/kernel/perf_event_paranoid) are omitted. Only available on Linux. Implies -v. Default: \\fIoff\\fP."));
+	addOption(parser, ArgParseOption("P", "progress", "While reading the input files, print the bytes consumed, the records per second, the records kept and filtered (unmapped, by length, by NH), the current contig and the estimated time remaining to stderr every \\fISECONDS\\fP seconds. The time remaining is only estimated for BAM files read with -R block.", ArgParseArgument::INTEGER, "SECONDS"));
+	setMinValue(parser, "progress", "1");
+	addOption(parser, ArgParseOption("S", "status-file", "While reading the input files, replace \\fIFILE\\fP with the current progress in JSON format every few seconds (every \\fISECONDS\\fP seconds, if -P is given), such that hung jobs can be detected by the field \\fIupdated\\fP (UNIX time). After all input files have been read, the field \\fIstate\\fP changes from \\fIreading\\fP to \\fIanalyzing\\fP. In batch mode, every sample reports to its own file \\fIFILE\\fP.\\fISAMPLE\\fP.", ArgParseArgument::OUTPUTFILE, "FILE"));
+	addOption(parser, ArgParseOption("e", "trace", "Record when every stage, every task of grouping the read stacks, every batch of decompressed BGZF blocks, every sample in batch mode and every chunk of output files begins and ends in every thread. The trace is written to \\fIFILE\\fP in the trace event format of Chrome on exit and can be viewed with Perfetto (https://ui.perfetto.dev) to find out where threads stall or idle.", ArgParseArgument::OUTPUTFILE, "FILE"));
 
-// function to replace all occurrences of a string within a string for another string
-// Input/output paramters:
-//	subjectString: the string to modify
-// Input parameters:
-//	searchString: the string to search for
-//	replaceString: the string that replaces <searchString>
-void stringReplace(string &subjectString, const string &searchString, const string &replaceString) {
-	size_t i = 0;
-	while((i = subjectString.find(searchString, i)) != string::npos)
+	// parse command line
+	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
+	if (parserResult != ArgumentParser::PARSE_OK)
+		return parserResult;
+
+	// extract options, if parsing was successful
+	options.browserTracks = isSet(parser, "browserTracks");
+	options.signatureIndex = isSet(parser, "signature-index");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "activity-window"); i++)
 	{
-	        subjectString.replace(i, searchString.length(), replaceString);
-        	i += replaceString.length(); // skip the string that we just inserted
+		unsigned int windowSize;
+		getOptionValue(windowSize, parser, "activity-window", i);
+		if (windowSize == 0)
+		{
+			cerr << getAppName(parser) << ": window size of activity track must be greater than 0" << endl;
+			return ArgumentParser::PARSE_ERROR;
+		}
+		options.activityWindows.push_back(windowSize);
 	}
-}
 
-// This function uses Rscript to generate histogram plots.
-// Multiple plots are written to a single PDF.
-// Input parameters:
-//	fileName: the name of the R script and PDF file to be generated, without the file extension
-//	titles: the titles of all histogram plots
-//	histograms: a collection of histograms to plot
-void plotHistogram(const string &fileName, const vector< string > &titles, const THistograms &histograms)
-{
-	// generate an R script that produces a histogram plot
-	ofstream rScript(toCString(fileName + ".R"), ios_base::out);
-	if (rScript.fail())
+	options.inputFiles.resize(getOptionValueCount(parser, "input")); // store input files in vector
+	if (options.inputFiles.size() > 0)
 	{
-		cerr << "Failed to create R script file" << endl;
-		return;
+		for (vector< string >::size_type i = 0; i < options.inputFiles.size(); i++)
+			getOptionValue(options.inputFiles[i], parser, "input", i);
 	}
 
-	rScript << "histograms = data.frame(" << endl; // store histograms in a data frame
-	rScript << "plotTitle = c("; // store plot titles in vector
-	for (unsigned int i = 0; i < titles.size(); i++)
+	string countMultiHits;
+	getOptionValue(countMultiHits, parser, "multi-hits");
+	if (countMultiHits == "unique")
 	{
-		// escape all single-quotes (') and escape slashes (\) in the title
-		string title = titles[i];
-		stringReplace(title, "\\", "\\\\");
-		stringReplace(title, "'", "\\'");
-		rScript << "'" << title << "'";
-
-		if (i < titles.size() - 1)
-			rScript << "," << endl; // separate titles by a comma, unless it is the last one
+		options.countMultiHits = multiHitsUnique;
 	}
-	rScript << ")," << endl; // close vector of plot titles
-	for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+	else if (countMultiHits == "discard")
 	{
-		// print one column in the data frame for every overlap
-		rScript << endl << "overlap_";
-		if (overlap < 0)
-			rScript << "minus_";
-		rScript << abs(overlap) << "=c(";
+		options.countMultiHits = multiHitsDiscard;
+	}
+	else
+	{
+		options.countMultiHits = multiHitsWeighted;
+	}
 
-		for (unsigned int i = 0; i < histograms.size(); i++)
-		{
-			if (i % 100 == 0)
-				rScript << endl; // insert a line-break every once in a while, because R cannot parse long lines
-			rScript << histograms[i][overlap-MIN_ARBITRARY_OVERLAP];
-			if (i < histograms.size() - 1)
-				rScript << ","; // separate histogram values by comma, unless it is the last one
-		}
+	getOptionValue(options.referenceFile, parser, "reference");
 
-		rScript << ")" << endl; // close column of data frame
-		if (overlap < MAX_ARBITRARY_OVERLAP)
-			rScript << ","; // separate columns of data frame by comma, unless it is the last column
+	string reader;
+	getOptionValue(reader, parser, "reader");
+	options.blockReader = (reader == "block");
+	getOptionValue(options.stackStore, parser, "stack-store");
+
+	getOptionValue(options.batchManifest, parser, "batch");
+	if (options.inputFiles.empty() && options.batchManifest.empty())
+	{
+		cerr << getAppName(parser) << ": either an input file (-i) or a manifest file (-B) must be given" << endl;
+		return ArgumentParser::PARSE_ERROR;
 	}
-	rScript << ")" << endl; // close data frame of histograms
+	getOptionValue(options.threads, parser, "threads");
+	getOptionValue(options.maxMemory, parser, "max-memory");
 
-	rScript
-	 	<< "# convert absolute values to z-scores" << endl
-		<< "means <- apply(histograms[,!colnames(histograms) %in% c('plotTitle', 'overlap_" << PING_PONG_OVERLAP << "')], 1, mean)" << endl
-		<< "sds <- apply(histograms[,!colnames(histograms) %in% c('plotTitle', 'overlap_" << PING_PONG_OVERLAP << "')], 1, sd)" << endl
-		<< "sds <- ifelse(sds < " << MIN_STANDARD_DEVIATION << "," << MIN_STANDARD_DEVIATION << ", sds)" << endl
-		<< "for (column in colnames(histograms[,colnames(histograms) != 'plotTitle'])) {" << endl
-		<< "	histograms[,column] = (histograms[,column] - means) / sds" << endl
-		<< "}" << endl
-		<< "# save plots to a single PDF" << endl
-		<< "pdf('" << fileName << ".pdf', onefile=TRUE)" << endl
-		<< "par(font.lab=2, mar=c(5.1, 5.1, 5.1, 2.1))" << endl
-		<< "# draw a red bar for ping-pong signatures and a grey bar for arbitrary overlaps" << endl
-		<< "barColors <- ifelse(colnames(histograms[,colnames(histograms) != 'plotTitle']) != 'overlap_" << PING_PONG_OVERLAP << "', rgb(0.7,0.7,0.7), rgb(0.8,0.4,0.4))" << endl
-		<< "# every row of the data frame <histograms> is rendered as a barplot" << endl
-		<< "for (i in 1:nrow(histograms)) {" << endl
-		<< "	histogram <- histograms[i,]" << endl
-		<< "	plotTitle <- histogram$plotTitle" << endl
-		<< "	histogram <- c(t(histogram[, colnames(histogram) != 'plotTitle']))" << endl
-		<< "	plot(0, 0, xlim=c(0,length(histogram)), type='n', xlab='overlap', ylim=c(min(c(0, histogram)), max(histogram)), ylab='z-score', xaxt='n', main=plotTitle, cex.axis=0.75)" << endl
-		<< "	axis(1, at=1:length(histogram)-0.25, labels=" << MIN_ARBITRARY_OVERLAP << ":" << MAX_ARBITRARY_OVERLAP << ", cex.axis=0.75)" << endl
-		<< "	barplot(histogram, col=barColors, border=NA, axes=FALSE, add=TRUE, width=0.5, space=1)" << endl
-		<< "}" << endl
-		<< "garbage <- dev.off()" << endl;
+	getOptionValue(options.minStackHeight, parser, "min-stack-height");
+	getOptionValue(options.maxFDR, parser, "max-fdr");
+	getOptionValue(options.topK, parser, "top-k");
 
-	// close R script
-	rScript.close();
+	getOptionValue(options.minAlignmentLength, parser, "min-alignment-length");
+	getOptionValue(options.maxAlignmentLength, parser, "max-alignment-length");
 
-	// execute R script with "Rscript"
-	// running the script via the source command is faster that running it directly
-	string RCommand = "Rscript -e 'source(\"" + fileName + ".R\")'";
-	system(toCString(RCommand));
-}
+	if (options.minAlignmentLength > options.maxAlignmentLength)
+	{
+		cerr << getAppName(parser) << ": maximum alignment length (" << options.maxAlignmentLength << ") must not be lower than minimum alignment length (" << options.minAlignmentLength << ")" << endl;
+		return ArgumentParser::PARSE_ERROR;
+	}
 
-// function to write ping-pong signatures found by the function <countStacksByGroup> to a TSV file
-// Input parameters:
-//	pingPongSignaturesPerGenome: the ping-pong signatures to write to a file as found by the function <countStacksByGroup>
-//	bamNameStore: mapping of numeric contig IDs to human-readable names
-//	minStackHeight: ping-pong signatures with a smaller stack height than this are omitted from the output
-//	browserTracks: if set to true, then a bedGraph file is generated in addition to the TSV file
-void writePingPongSignaturesToFile(TPingPongSignaturesPerGenome &pingPongSignaturesPerGenome, const TNameStore &bamNameStore, unsigned int minStackHeight, bool browserTracks)
-{
-	// open files to write ping-pong signatures to
-	ofstream signaturesTSV("ping-pong_signatures.tsv", ios_base::out);
-	ofstream readsOnPlusStrandBedGraph;
-	ofstream readsOnMinusStrandBedGraph;
-	ofstream scoresBedGraph;
-	if (browserTracks)
+	getOptionValue(options.output, parser, "output");
+	if ((length(options.output) > 0) && (options.output[length(options.output)-1] != PATH_DELIMITER))
+		options.output += PATH_DELIMITER; // append slash to output path, if missing
+
+	options.plot = isSet(parser, "plot");
+	options.qcOnly = isSet(parser, "qc-only");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "distance-histogram"); i++)
 	{
-		readsOnPlusStrandBedGraph.open("ping-pong_signatures_read_stacks_on_plus_strand.bedGraph", ios_base::out);
-		readsOnMinusStrandBedGraph.open("ping-pong_signatures_read_stacks_on_minus_strand.bedGraph", ios_base::out);
-		scoresBedGraph.open("ping-pong_signatures_scores.bedGraph", ios_base::out);
-		if (readsOnPlusStrandBedGraph.fail() || readsOnMinusStrandBedGraph.fail() || scoresBedGraph.fail())
+		string spec;
+		getOptionValue(spec, parser, "distance-histogram", i);
+		if (parseDistanceHistogramSpec(spec, options.distanceHistograms) != 0)
 		{
-			cerr << "Failed to create browser track files for ping-pong signatures" << endl;
-			return;
+			cerr << getAppName(parser) << ": invalid distance histogram '" << spec << "', expected RELATION:END:MIN:MAX, e.g., same:3:-5:30" << endl;
+			return ArgumentParser::PARSE_ERROR;
 		}
 	}
 
-	// use scientific formatting for floating point numbers
-	signaturesTSV.setf(ios::scientific, ios::floatfield);
-	if (browserTracks)
+	options.transposonFiles.resize(getOptionValueCount(parser, "transposons")); // store input files in vector
+	for (vector< string >::size_type i = 0; i < options.transposonFiles.size(); i++)
+		getOptionValue(options.transposonFiles[i], parser, "transposons", i);
+	getOptionValue(options.transposonAttribute, parser, "attribute");
+	options.transposonFamilies = isSet(parser, "families");
+	getOptionValue(options.transposonFamilyAttribute, parser, "family-attribute");
+	getOptionValue(options.annotationCache, parser, "annotation-cache");
+
+	if (isSet(parser, "predict-transposons"))
+	{
+		getOptionValue(options.predictTransposonsRange, parser, "predict-transposons");
+	}
+	else
 	{
-		readsOnPlusStrandBedGraph.setf(ios::scientific, ios::floatfield);
-		readsOnMinusStrandBedGraph.setf(ios::scientific, ios::floatfield);
-		scoresBedGraph.setf(ios::scientific, ios::floatfield);
+		options.predictTransposonsRange = 0;
 	}
 
-	// write track headers
-	signaturesTSV << "contig\tposition\tFDR\tstackHeightOnPlusStrand\tstackHeightOnMinusStrand" << endl;
-	if (browserTracks)
+	options.hardwareCounters = isSet(parser, "hardware-counters");
+	getOptionValue(options.traceFile, parser, "trace");
+	options.progressInterval = 0;
+	getOptionValue(options.progressInterval, parser, "progress");
+	getOptionValue(options.statusFile, parser, "status-file");
+	if (isSet(parser, "verbose") || options.hardwareCounters)
+	{
+		options.verbosity = 3;
+	}
+	else
 	{
-		readsOnPlusStrandBedGraph << "track type=bedGraph name=\"read stacks on + strand\" description=\"height of read stacks on the + strand\" visibility=full" << endl;
-		readsOnMinusStrandBedGraph << "track type=bedGraph name=\"read stacks on - strand\" description=\"height of read stacks on the - strand\" visibility=full" << endl;
-		scoresBedGraph << "track type=bedGraph name=\"scores\" description=\"scores of ping-pong signatures (1 - FDR)\" visibility=full viewLimits=0.0:1.0 autoScale=off" << endl;
+		options.verbosity = 0;
 	}
 
-	// write a line for each ping-pong signature
-	for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesPerGenome.begin(); contig != pingPongSignaturesPerGenome.end(); ++contig)
-		for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
-			if ((pingPongSignature->readsOnPlusStrand >= minStackHeight) && (pingPongSignature->readsOnMinusStrand >= minStackHeight))
+	return parserResult;
+}
+
+// function to measure the time elapsed since a given point in time
+inline double secondsSince(const chrono::steady_clock::time_point &start)
+{
+	return chrono::duration< double >(chrono::steady_clock::now() - start).count();
+}
+
+// if set to true (with --hardware-counters), <stopwatch> measures the hardware counters of every stage
+bool measureHardwareCounters = false;
+
+// This function starts the hardware counters of the calling thread.
+// The counters are inherited by the threads which the calling thread creates until <stopHardwareCounters> is called.
+// The counts of these threads are added when they terminate, so the counters of stages which join their threads
+// (e.g., via <stopThreadPool>) comprise all threads of the stage.
+// Output parameters:
+//	counters: the running counters; counters that cannot be opened are marked as unavailable
+void startHardwareCounters(THardwareCounters &counters)
+{
+	for (unsigned int counter = 0; counter < HARDWARE_COUNTER_COUNT; counter++)
+	{
+		counters.fileDescriptors[counter] = -1;
+		counters.available[counter] = false;
+		counters.values[counter] = 0;
+	}
+
+	#ifdef PINGPONGPRO_PERF_COUNTERS
+	const uint32_t types[HARDWARE_COUNTER_COUNT] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE };
+	const uint64_t configs[HARDWARE_COUNTER_COUNT] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_PAGE_FAULTS };
+	for (unsigned int counter = 0; counter < HARDWARE_COUNTER_COUNT; counter++)
+	{
+		struct perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = types[counter];
+		attributes.config = configs[counter];
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING; // to scale multiplexed counters
+		attributes.disabled = 1;
+		attributes.inherit = 1;
+		attributes.exclude_kernel = 1; // permitted with the default setting of perf_event_paranoid
+		attributes.exclude_hv = 1;
+		counters.fileDescriptors[counter] = syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+	}
+	for (unsigned int counter = 0; counter < HARDWARE_COUNTER_COUNT; counter++)
+		if (counters.fileDescriptors[counter] >= 0)
+			ioctl(counters.fileDescriptors[counter], PERF_EVENT_IOC_ENABLE, 0);
+	#endif
+}
+
+// This function stops the hardware counters started by <startHardwareCounters> and reads their values.
+// Input/output parameters:
+//	counters: the counters to stop; the values of the counters are stored in the same variable
+void stopHardwareCounters(THardwareCounters &counters)
+{
+	#ifdef PINGPONGPRO_PERF_COUNTERS
+	for (unsigned int counter = 0; counter < HARDWARE_COUNTER_COUNT; counter++)
+		if (counters.fileDescriptors[counter] >= 0)
+			ioctl(counters.fileDescriptors[counter], PERF_EVENT_IOC_DISABLE, 0);
+	for (unsigned int counter = 0; counter < HARDWARE_COUNTER_COUNT; counter++)
+	{
+		if (counters.fileDescriptors[counter] < 0)
+			continue;
+		uint64_t value[3]; // value, time enabled, time running
+		if ((read(counters.fileDescriptors[counter], value, sizeof(value)) == sizeof(value)) && (value[2] > 0))
+		{
+			counters.available[counter] = true;
+			counters.values[counter] = static_cast<double>(value[0]) * value[1] / value[2];
+		}
+		close(counters.fileDescriptors[counter]);
+		counters.fileDescriptors[counter] = -1;
+	}
+	#endif
+}
+
+// function to print the hardware counters of a stage in the form ", 1.2e+09 cycles, ..."
+// Input parameters:
+//	counters: the counters as read by <stopHardwareCounters>
+// Output parameters:
+//	stream: the stream to print the counters to
+void writeHardwareCounters(ostream &stream, const THardwareCounters &counters)
+{
+	stringstream text;
+	text.precision(3);
+	if (counters.available[counterCycles])
+		text << ", " << counters.values[counterCycles] << " cycles";
+	if (counters.available[counterCycles] && counters.available[counterInstructions] && (counters.values[counterCycles] > 0))
+		text << ", " << counters.values[counterInstructions] / counters.values[counterCycles] << " IPC";
+	if (counters.available[counterCacheMisses])
+		text << ", " << counters.values[counterCacheMisses] << " LLC misses";
+	if (counters.available[counterBranchMisses])
+		text << ", " << counters.values[counterBranchMisses] << " branch misses";
+	if (counters.available[counterPageFaults])
+		text << ", " << counters.values[counterPageFaults] << " page faults";
+	if (text.str().empty())
+		text << ", hardware counters unavailable";
+	stream << text.str();
+}
+
+// the trace written with --trace (see <traceBegin>)
+TTraceRecorder traceRecorder;
+
+// function to get the trace buffer of the calling thread, which is created when the thread records its first event
+TTraceBuffer &getTraceBuffer()
+{
+	static thread_local TTraceBuffer *buffer = NULL; // owned by <traceRecorder>
+	if (buffer == NULL)
+	{
+		lock_guard< mutex > lock(traceRecorder.lock);
+		traceRecorder.buffers.push_back(unique_ptr< TTraceBuffer >(new TTraceBuffer(traceRecorder.buffers.size())));
+		buffer = traceRecorder.buffers.back().get();
+	}
+	return *buffer;
+}
+
+// function to add an event to the trace buffer of the calling thread
+// Input parameters:
+//	begin: whether the event is the beginning or the end of a span
+//	name: the name of the span
+//	detail: additional information about the span
+void recordTraceEvent(bool begin, const string &name, const string &detail)
+{
+	TTraceBuffer &buffer = getTraceBuffer();
+	TTraceEvent event;
+	event.timestamp = chrono::duration_cast< chrono::nanoseconds >(chrono::steady_clock::now() - traceRecorder.start).count();
+	event.begin = begin;
+	strncpy(event.name, name.c_str(), TRACE_NAME_LENGTH - 1);
+	event.name[TRACE_NAME_LENGTH - 1] = 0;
+	strncpy(event.detail, detail.c_str(), TRACE_DETAIL_LENGTH - 1);
+	event.detail[TRACE_DETAIL_LENGTH - 1] = 0;
+	if (buffer.events.size() < TRACE_EVENTS_PER_THREAD)
+		buffer.events.push_back(event);
+	else
+		buffer.events[buffer.recorded % TRACE_EVENTS_PER_THREAD] = event;
+	buffer.recorded++;
+}
+
+// traceBegin/traceEnd: mark the beginning and the end of a span of time in the trace of the calling thread, if --trace is given
+// Spans of a thread must be nested. The stages measured by <stopwatch> are traced automatically.
+// Input parameters:
+//	name: the name of the span
+//	detail: additional information about the span (e.g., the number of the processed chunk)
+inline void traceBegin(const string &name, const string &detail = "")
+{
+	if (traceRecorder.enabled)
+		recordTraceEvent(true, name, detail);
+}
+inline void traceEnd()
+{
+	if (traceRecorder.enabled)
+		recordTraceEvent(false, "", "");
+}
+
+// function to write a string as a quoted JSON string
+// Input parameters:
+//	text: the string to write
+// Output parameters:
+//	stream: the stream to write the string to
+void writeJSONString(ostream &stream, const char *text)
+{
+	stream << '"';
+	for (; *text != 0; ++text)
+	{
+		if ((*text == '"') || (*text == '\\'))
+			stream << '\\' << *text;
+		else if (static_cast<unsigned char>(*text) < 0x20)
+			stream << "\\u00" << "0123456789abcdef"[*text >> 4] << "0123456789abcdef"[*text & 15];
+		else
+			stream << *text;
+	}
+	stream << '"';
+}
+
+// This function writes the events recorded by all threads to a file in the trace event format of Chrome,
+// which can be opened with Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+// It is called when the analysis has finished. It is also registered with atexit, when the trace is started,
+// such that the trace is written on exit paths, which bypass the end of <main>. The trace is written only once.
+// All threads except the calling one must have terminated.
+void writeTraceFile()
+{
+	if (traceRecorder.written)
+		return;
+	traceRecorder.written = true;
+
+	ofstream traceFile(traceRecorder.fileName.c_str(), ios_base::out);
+	if (traceFile.fail())
+	{
+		cerr << "Failed to create trace file \"" << traceRecorder.fileName << "\"." << endl;
+		return;
+	}
+	traceFile.setf(ios::fixed, ios::floatfield);
+	traceFile.precision(3);
+
+	traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	lock_guard< mutex > lock(traceRecorder.lock);
+	for (vector< unique_ptr< TTraceBuffer > >::iterator buffer = traceRecorder.buffers.begin(); buffer != traceRecorder.buffers.end(); ++buffer)
+	{
+		traceFile << (first ? "" : ",") << endl << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << (*buffer)->threadId << ",\"name\":\"thread_name\",\"args\":{\"name\":\"";
+		if ((*buffer)->threadId == 0)
+			traceFile << "main";
+		else
+			traceFile << "thread " << (*buffer)->threadId;
+		traceFile << "\"}}";
+		first = false;
+
+		// the oldest event is at the position of the next event to record, if the buffer has overflowed
+		uint64_t oldest = ((*buffer)->recorded > TRACE_EVENTS_PER_THREAD) ? (*buffer)->recorded % TRACE_EVENTS_PER_THREAD : 0;
+		for (uint64_t i = 0; i < (*buffer)->events.size(); i++)
+		{
+			const TTraceEvent &event = (*buffer)->events[(oldest + i) % (*buffer)->events.size()];
+			traceFile << "," << endl << "{\"ph\":\"" << (event.begin ? 'B' : 'E') << "\",\"pid\":1,\"tid\":" << (*buffer)->threadId << ",\"ts\":" << (event.timestamp / 1000.0);
+			if (event.begin)
 			{
-				signaturesTSV
-					<< bamNameStore[contig->first] << '\t'
-					<< pingPongSignature->position << '\t'
-					<< pingPongSignature->fdr << '\t'
-					<< pingPongSignature->readsOnPlusStrand << '\t'
-					<< pingPongSignature->readsOnMinusStrand << endl;
-				if (browserTracks)
+				traceFile << ",\"name\":";
+				writeJSONString(traceFile, event.name);
+				if (event.detail[0] != 0)
 				{
-					readsOnPlusStrandBedGraph
-						<< bamNameStore[contig->first] << '\t'
-						<< pingPongSignature->position << '\t'
-						<< (pingPongSignature->position+1) << '\t'
-						<< pingPongSignature->readsOnPlusStrand << endl;
-					readsOnMinusStrandBedGraph
-						<< bamNameStore[contig->first] << '\t'
-						<< pingPongSignature->position << '\t'
-						<< (pingPongSignature->position+1) << '\t'
-						<< pingPongSignature->readsOnMinusStrand << endl;
-					scoresBedGraph
-						<< bamNameStore[contig->first] << '\t'
-						<< pingPongSignature->position << '\t'
-						<< (pingPongSignature->position+1) << '\t'
-						<< (1-pingPongSignature->fdr) << endl;
+					traceFile << ",\"args\":{\"detail\":";
+					writeJSONString(traceFile, event.detail);
+					traceFile << "}";
 				}
 			}
+			traceFile << "}";
+		}
+	}
+	traceFile << endl << "]}" << endl;
+	traceFile.close();
+	if (traceFile.fail())
+		cerr << "Failed to write trace file \"" << traceRecorder.fileName << "\"." << endl;
+}
 
-	// close files
-	signaturesTSV.close();
-	if (browserTracks)
+// Function to measure time between the first and second invocation of the function.
+// If <measureHardwareCounters> is set, the hardware counters of the operation are measured, too.
+// The operation is recorded as a span of the trace, if --trace is given (see <traceBegin>).
+// Input parameters:
+//	operation: a description of the task being measured
+//	verbosity: if <operation> is not empty, the description is printed to stderr, if the verbosity level is >= INFO
+//	           if <operation is empty, the function prints the number of seconds since its last invocation
+// Return value: the number of seconds since the last invocation of the function
+unsigned int stopwatch(const string &operation, unsigned int verbosity)
+{
+	static thread_local time_t start = 0; // every thread measures its own operations
+	static thread_local THardwareCounters counters;
+	bool countersRunning = measureHardwareCounters && (verbosity >= 3);
+	unsigned int elapsedSeconds = 0;
+	if (start != 0)
+	{
+		if (countersRunning)
+			stopHardwareCounters(counters);
+		traceEnd();
+		elapsedSeconds = time(NULL) - start;
+		start = 0;
+	}
+	else
+	{
+		start = time(NULL);
+		traceBegin(operation.substr(min(operation.find_first_not_of(' '), operation.size())));
+		if (countersRunning)
+			startHardwareCounters(counters);
+	}
+	if (verbosity >= 3)
 	{
-		readsOnPlusStrandBedGraph.close();
-		readsOnMinusStrandBedGraph.close();
-		scoresBedGraph.close();
+		if (operation != "")
+		{
+			cerr << operation << " ... ";
+		}
+		else
+		{
+			cerr << "done (" << elapsedSeconds << " seconds";
+			if (countersRunning)
+				writeHardwareCounters(cerr, counters);
+			cerr << ")" << endl;
+		}
 	}
+	cerr.flush();
+	return elapsedSeconds;
+}
+unsigned int stopwatch(unsigned int verbosity)
+{
+	return stopwatch("", verbosity);
 }
 
-// generate plots that illustrate the difference in stack counts by overlap
+// Function to extract the number of collapsed reads from a read name.
+// Identical reads are expected to be collapsed into a single record, whose name holds the number of reads after an 'x' (e.g., "read1x25").
+// The name is split at every 'x' (consecutive separators count as one) and the second part is taken as the number of reads.
 // Input parameters:
-//	groupedStackCountsByOverlap: grouped stack counts as processed by the function <collapseBins>
-void generateGroupedStackCountsPlot(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap)
+//	readName: the name of the read
+// Return value: the number of reads represented by the record (1, if the name does not hold a number)
+unsigned int parseCollapsedReadCount(const char *readName)
 {
-	// find out in how many bins the stacks were grouped,
-	// because we need to generate a histogram for every bin
-	int binCount =
-		groupedStackCountsByOverlap.begin()->size() *
-		groupedStackCountsByOverlap.begin()->begin()->size() *
-		groupedStackCountsByOverlap.begin()->begin()->begin()->size();
-	THistograms histograms(binCount);
-	vector< string > plotTitles(binCount);
+	// skip the first part of the name
+	while (*readName == 'x')
+		readName++;
+	while ((*readName != 'x') && (*readName != '\0'))
+		readName++;
+	while (*readName == 'x')
+		readName++;
+	if (*readName == '\0')
+		return 1;
+	return atoi(readName);
+}
 
-	// collect histogram values and generate plot names
-	unsigned int x = 0;
-	stringstream ss;
-	for (int i = groupedStackCountsByOverlap.begin()->size() - 1; i >= 0; i--)
-		for (unsigned int j = 0; j < (*groupedStackCountsByOverlap.begin())[i].size(); j++)
-			for (unsigned int k = 0; k < (*groupedStackCountsByOverlap.begin())[i][j].size(); k++)
-			{
-				histograms[x].resize(groupedStackCountsByOverlap.size());
-				for (unsigned int overlap = 0; overlap < groupedStackCountsByOverlap.size(); overlap++)
-				{
-					histograms[x][overlap] = groupedStackCountsByOverlap[overlap][i][j][k];
+// This function reports the progress of reading the input files of a sample to stderr and/or to the status file.
+// Input parameters:
+//	progress: the progress to report
+//	state: "reading" while the input files are read, "analyzing" when all input files have been read
+void reportIngestProgress(TIngestProgress &progress, const char *state)
+{
+	double seconds = secondsSince(progress.start);
+	double recordsPerSecond = (seconds > 0) ? progress.metrics.records / seconds : 0;
+	uint64_t bytes = progress.bytesDone + progress.bytesConsumed;
+	string contig;
+	if ((progress.nameStore != NULL) && (progress.contig >= 0) && (progress.contig < static_cast<int32_t>(length(*progress.nameStore))))
+		contig = toCString((*progress.nameStore)[progress.contig]);
+
+	// the ETA is extrapolated from the bytes consumed so far, if the reader knows the offset in the file
+	double eta = -1;
+	if ((bytes > 0) && (bytes < progress.totalBytes) && ((progress.bytesConsumed > 0) || (progress.bytesDone > 0)))
+		eta = seconds * (progress.totalBytes - bytes) / bytes;
+
+	if (progress.messages)
+	{
+		stringstream message;
+		if (progress.lineOpen)
+			message << endl;
+		progress.lineOpen = false;
+		message << fixed << setprecision(1)
+			<< "    " << progress.fileName << ": " << (bytes / 1048576.0) << " of " << (progress.totalBytes / 1048576.0) << " MB, "
+			<< progress.metrics.records << " records (" << setprecision(0) << recordsPerSecond << "/s), "
+			<< progress.metrics.kept << " kept, " << progress.metrics.unmapped << " unmapped, " << progress.metrics.filteredByLength << " filtered by length, " << progress.metrics.filteredByMultiHits << " filtered by NH";
+		if (!contig.empty())
+			message << ", contig " << contig;
+		if (eta >= 0)
+			message << ", ETA " << eta << " s";
+		message << endl;
+		cerr << message.str();
+	}
 
-					ss << "z-scores of signatures with the following properties:" << endl;
-					ss << "stack height score of " << (groupedStackCountsByOverlap.begin()->size() - 1 - i) << endl;
-					if (j != HAS_BASE_BIAS)
-						ss << "no ";
-					ss << "adenine at position 10" << endl;
-					ss << "stack height " << ((k == IS_ABOVE_COVERAGE) ? "above" : "below") << " the local coverage";
-					plotTitles[x] = ss.str();
-					ss.str("");
-				}
-				x++;
-			}
+	if (!progress.statusFile.empty())
+	{
+		// replace the status file atomically, such that readers never see a partial file
+		string temporaryFile = progress.statusFile + ".tmp";
+		ofstream statusFile(temporaryFile.c_str(), ios_base::out);
+		statusFile << fixed << setprecision(1)
+			<< "{\"state\":\"" << state << "\",\"updated\":" << time(NULL) << ",\"file\":";
+		writeJSONString(statusFile, progress.fileName.c_str());
+		statusFile
+			<< ",\"bytesConsumed\":" << bytes << ",\"bytesTotal\":" << progress.totalBytes
+			<< ",\"records\":" << progress.metrics.records << ",\"recordsPerSecond\":" << recordsPerSecond
+			<< ",\"kept\":" << progress.metrics.kept << ",\"unmapped\":" << progress.metrics.unmapped
+			<< ",\"filteredByLength\":" << progress.metrics.filteredByLength << ",\"filteredByMultiHits\":" << progress.metrics.filteredByMultiHits
+			<< ",\"contig\":";
+		writeJSONString(statusFile, contig.c_str());
+		statusFile << ",\"elapsedSeconds\":" << seconds << ",\"etaSeconds\":";
+		if (eta >= 0)
+			statusFile << eta;
+		else
+			statusFile << "null";
+		statusFile << "}" << endl;
+		statusFile.close();
+		if (statusFile.fail() || (rename(temporaryFile.c_str(), progress.statusFile.c_str()) != 0))
+			cerr << "Failed to update status file \"" << progress.statusFile << "\"." << endl;
+	}
+}
 
-	// render histograms
-	plotHistogram("ping-pong_signatures_z-scores", plotTitles, histograms);
+// function to count a record in the progress of reading the input files and to report the progress, if it is due
+// Input parameters:
+//	contig: the contig of the record
+// Input/output parameters:
+//	progress: the progress of reading the input files of the sample
+inline void updateIngestProgress(TIngestProgress &progress, int32_t contig)
+{
+	progress.metrics.records++;
+	progress.contig = contig;
+	if ((progress.interval > 0) && (progress.metrics.records % PROGRESS_CHECK_RECORDS == 0) && (secondsSince(progress.lastReport) >= progress.interval))
+	{
+		reportIngestProgress(progress, "reading");
+		progress.lastReport = chrono::steady_clock::now();
+	}
 }
 
-// this functions reads genomic regions of transposons from a file
-// the transposons are checked for ping-pong activity by the function <findSuppressedTransposons>
+// function to count an alignment, which passed the length filter, in the ingestion metrics
 // Input parameters:
-//	transposonFile: the file from where to read the transposons
-//	fileFormat: the format of the file
+//	alignment: the alignment, which was passed to <countAlignment>
+//	clippedAt5PrimeEnd, clippedAt3PrimeEnd: whether bases are soft-clipped at the 5' and 3' end of the read
+//	kept: false, if <countAlignment> discarded the alignment
 // Input/output parameters:
-//	bamNameStore: a mapping of numeric contig IDs to human readable names
-//	              the name store is extended by names that it does not contain, but that are used in the transposon file
-// Output parameters:
-//	transposons: the transposons read from the file
-void readTransposonsFromFile(ifstream &transposonFile, TFileFormat fileFormat, TTransposonsPerGenome &transposons, TNameStore &bamNameStore)
+//	metrics: the ingestion metrics of the sample
+inline void countIngestedAlignment(TIngestMetrics &metrics, const TAlignment &alignment, bool clippedAt5PrimeEnd, bool clippedAt3PrimeEnd, bool kept)
 {
-	// the following variables store the numbers of the columns of the respective fields
-	unsigned int identifierField, strandField, contigField, startField, endField;
-	// some file formats address the first position on the contig with 0, others with 1
-	// some file formats include the last position in regions (half-open), others not (closed)
-	unsigned int offset, halfOpenOrClosed;
-	// character that separates columns
-	char delimiter;
+	metrics.multiHits[min(alignment.multiHits, METRICS_MULTI_HIT_BINS - 1)]++;
+	unsigned int collapsedBin = 0;
+	for (unsigned int reads = alignment.reads; (reads > 1) && (collapsedBin < METRICS_COLLAPSED_BINS - 1); reads >>= 1)
+		collapsedBin++;
+	metrics.collapsedReads[collapsedBin]++;
+	if (clippedAt5PrimeEnd)
+		metrics.softClippedAt5PrimeEnd++;
+	if (clippedAt3PrimeEnd)
+		metrics.softClippedAt3PrimeEnd++;
 
-	switch (fileFormat)
+	if (kept)
 	{
-		case fileFormatBED:
-			identifierField = 4;
-			strandField = 6;
-			contigField = 1;
-			startField = 2;
-			endField = 3;
-			offset = 0;
-			halfOpenOrClosed = 0;
-			delimiter = ' ';
-			break;
-		case fileFormatCSV:
-			identifierField = 1;
-			strandField = 2;
-			contigField = 3;
-			startField = 4;
-			endField = 5;
-			offset = 1;
-			halfOpenOrClosed = 0;
-			delimiter = ',';
-			break;
-		case fileFormatGFF:
-		case fileFormatGTF:
-			identifierField = 9;
-			strandField = 7;
-			contigField = 2;
-			startField = 4;
-			endField = 5;
-			offset = 1;
-			halfOpenOrClosed = 1;
-			delimiter = '\t';
-			break;
-		case fileFormatTSV:
-		default:
-			identifierField = 1;
-			strandField = 2;
-			contigField = 3;
-			startField = 4;
-			endField = 5;
-			offset = 1;
-			halfOpenOrClosed = 0;
-			delimiter = '\t';
+		unsigned int strand = alignment.reverse ? STRAND_MINUS : STRAND_PLUS;
+		metrics.kept++;
+		metrics.keptRecords[strand]++;
+		metrics.keptReads[strand] += alignment.reads;
+		if (alignment.AAtPosition10)
+		{
+			metrics.AAtPosition10Records[strand]++;
+			metrics.AAtPosition10Reads[strand] += alignment.reads;
+		}
+	}
+	else
+	{
+		metrics.filteredByMultiHits++;
+	}
+}
+
+// The following functions implement the operations of the stack stores (see <TStackStoreType>).
+// addToStackStore: adds reads to the stack at a given position
+// Input parameters:
+//	position: the key of the stack (see <countAlignment>)
+//	reads: the number of reads to add
+//	AAtPosition10: whether the reads have adenine at position 10
+// Input/output parameters:
+//	store: the store to add the reads to; the store must not be frozen
+inline void addToStackStore(TStackMap &stacks, unsigned int position, float reads, bool AAtPosition10)
+{
+	// reads of coordinate-sorted input files are appended to the end of the tree, which takes constant time with a hint
+	TReadStack &stack = (stacks.empty() || (stacks.rbegin()->first < position)) ? stacks.insert(stacks.end(), make_pair(position, TReadStack()))->second : stacks[position];
+	stack.reads += reads;
+	stack.AAtPosition10 = stack.AAtPosition10 || AAtPosition10;
+}
+inline void addToStackStore(TMapStackStore &store, unsigned int position, float reads, bool AAtPosition10)
+{
+	addToStackStore(store.stacks, position, reads, AAtPosition10);
+}
+inline void addToStackStore(TFlatStackStore &store, unsigned int position, float reads, bool AAtPosition10)
+{
+	if (store.stacks.empty() || (store.stacks.back().first != position))
+		store.stacks.push_back(TStackEntry(position, TReadStack()));
+	store.stacks.back().second.reads += reads;
+	store.stacks.back().second.AAtPosition10 = store.stacks.back().second.AAtPosition10 || AAtPosition10;
+}
+inline void addToStackStore(TDenseStackStore &store, unsigned int position, float reads, bool AAtPosition10)
+{
+	if (store.stacks.size() == store.head)
+	{
+		store.offset = position;
+	}
+	else if (position < store.offset)
+	{
+		// use the unused slots in front, if a stack precedes the first stack
+		size_t missingSlots = store.offset - position;
+		if (missingSlots > store.head)
+		{
+			// grow the front at least by the number of used slots, such that prepending stacks one by one
+			// takes amortized constant time like appending them, even if the input file is not sorted
+			size_t usedSlots = store.stacks.size() - store.head;
+			size_t head = max(missingSlots, usedSlots);
+			vector< TReadStack > stacks(head + usedSlots);
+			copy(store.stacks.begin() + store.head, store.stacks.end(), stacks.begin() + head);
+			store.stacks.swap(stacks);
+			store.head = head;
+		}
+		store.head -= missingSlots;
+		store.offset = position;
+	}
+	size_t slot = store.head + (position - store.offset);
+	if (slot >= store.stacks.size())
+		store.stacks.resize(slot + 1);
+	TReadStack &stack = store.stacks[slot];
+	stack.reads += reads;
+	stack.AAtPosition10 = stack.AAtPosition10 || AAtPosition10;
+}
+inline void addToStackStore(THashStackStore &store, unsigned int position, float reads, bool AAtPosition10)
+{
+	TReadStack &stack = store.table[position];
+	stack.reads += reads;
+	stack.AAtPosition10 = stack.AAtPosition10 || AAtPosition10;
+}
+inline void addToStackStore(TCompressedStackStore &store, unsigned int position, float reads, bool AAtPosition10)
+{
+	addToStackStore(store.staging, position, reads, AAtPosition10);
+}
+
+// function to compare stacks by position
+inline bool compareStackEntries(const TStackEntry &entry1, const TStackEntry &entry2)
+{
+	return entry1.first < entry2.first;
+}
+
+// function to append an unsigned integer to a string as variable-length integer (7 bits per byte, the high bit marks continuation)
+inline void appendVarInt(string &encoded, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		encoded += static_cast<char>((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	encoded += static_cast<char>(value);
+}
+
+// function to decode a variable-length integer written by <appendVarInt>
+// Input/output parameters:
+//	data: the position to decode from; it is advanced behind the integer
+inline uint64_t readVarInt(const char *&data)
+{
+	uint64_t value = 0;
+	for (unsigned int shift = 0; ; shift += 7)
+	{
+		unsigned char byte = *data++;
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if (byte < 0x80)
+			return value;
+	}
+}
+
+// freezeStackStore: prepares a store for iteration after all reads have been added
+// Input/output parameters:
+//	store: the store to freeze
+inline void freezeStackStore(TMapStackStore &)
+{
+}
+inline void freezeStackStore(TFlatStackStore &store)
+{
+	// sort the stacks by position and merge stacks with the same position
+	stable_sort(store.stacks.begin(), store.stacks.end(), compareStackEntries);
+	vector< TStackEntry >::iterator merged = store.stacks.begin();
+	for (vector< TStackEntry >::iterator entry = store.stacks.begin(); entry != store.stacks.end(); ++entry)
+	{
+		if ((merged != store.stacks.begin()) && ((merged - 1)->first == entry->first))
+		{
+			(merged - 1)->second.reads += entry->second.reads;
+			(merged - 1)->second.AAtPosition10 = (merged - 1)->second.AAtPosition10 || entry->second.AAtPosition10;
+		}
+		else
+		{
+			*merged++ = *entry;
+		}
+	}
+	store.stacks.erase(merged, store.stacks.end());
+	vector< TStackEntry >(store.stacks).swap(store.stacks); // release unused capacity
+}
+inline void freezeStackStore(TDenseStackStore &store)
+{
+	vector< TReadStack >(store.stacks.begin() + store.head, store.stacks.end()).swap(store.stacks); // release the unused slots and capacity
+	store.head = 0;
+}
+inline void freezeStackStore(THashStackStore &store)
+{
+	store.frozen.stacks.assign(store.table.begin(), store.table.end());
+	unordered_map< unsigned int, TReadStack >().swap(store.table);
+	freezeStackStore(store.frozen);
+}
+inline void freezeStackStore(TCompressedStackStore &store)
+{
+	freezeStackStore(store.staging);
+	unsigned int previousPosition = 0;
+	for (vector< TStackEntry >::iterator entry = store.staging.stacks.begin(); entry != store.staging.stacks.end(); ++entry)
+	{
+		appendVarInt(store.encoded, entry->first - previousPosition);
+		previousPosition = entry->first;
+		// the lowest bit tells whether the number of reads is an integer, the second bit is the base bias
+		bool integral = (entry->second.reads == floor(entry->second.reads)) && (entry->second.reads < (1 << 29));
+		appendVarInt(store.encoded, ((integral ? static_cast<uint64_t>(entry->second.reads) : 0) << 2) | (entry->second.AAtPosition10 ? 2 : 0) | (integral ? 0 : 1));
+		if (!integral)
+			store.encoded.append(reinterpret_cast<const char *>(&entry->second.reads), sizeof(entry->second.reads));
+	}
+	vector< TStackEntry >().swap(store.staging.stacks);
+	string(store.encoded).swap(store.encoded); // release unused capacity
+}
+
+// stackStoreBytes: estimates the memory consumption of a store in bytes (including the overhead of the allocator)
+inline size_t stackStoreBytes(const TMapStackStore &store)
+{
+	return store.stacks.size() * (sizeof(TStackMap::value_type) + 4 * sizeof(void *)); // a tree node has three pointers and a color
+}
+inline size_t stackStoreBytes(const TFlatStackStore &store)
+{
+	return store.stacks.capacity() * sizeof(TStackEntry);
+}
+inline size_t stackStoreBytes(const TDenseStackStore &store)
+{
+	return store.stacks.capacity() * sizeof(TReadStack);
+}
+inline size_t stackStoreBytes(const THashStackStore &store)
+{
+	return store.table.size() * (sizeof(unordered_map< unsigned int, TReadStack >::value_type) + 2 * sizeof(void *)) + store.table.bucket_count() * sizeof(void *) + stackStoreBytes(store.frozen);
+}
+inline size_t stackStoreBytes(const TCompressedStackStore &store)
+{
+	return store.encoded.capacity() + stackStoreBytes(store.staging);
+}
+
+// beginStacks: returns a cursor to the first stack of a frozen store
+// The cursor is advanced with <nextStack> until <atEndOfStacks> returns true; <stackPosition> and <stackValue> return the current stack.
+inline TMapStackCursor beginStacks(const TStackMap &stacks)
+{
+	TMapStackCursor cursor;
+	cursor.current = stacks.begin();
+	cursor.end = stacks.end();
+	return cursor;
+}
+inline TMapStackCursor beginStacks(const TMapStackStore &store)
+{
+	return beginStacks(store.stacks);
+}
+inline bool atEndOfStacks(const TMapStackCursor &cursor)
+{
+	return cursor.current == cursor.end;
+}
+inline unsigned int stackPosition(const TMapStackCursor &cursor)
+{
+	return cursor.current->first;
+}
+inline const TReadStack &stackValue(const TMapStackCursor &cursor)
+{
+	return cursor.current->second;
+}
+inline void nextStack(TMapStackCursor &cursor)
+{
+	++cursor.current;
+}
+
+inline TFlatStackCursor beginStacks(const TFlatStackStore &store)
+{
+	TFlatStackCursor cursor;
+	cursor.current = store.stacks.empty() ? NULL : &store.stacks[0];
+	cursor.end = cursor.current + store.stacks.size();
+	return cursor;
+}
+inline TFlatStackCursor beginStacks(const THashStackStore &store)
+{
+	return beginStacks(store.frozen);
+}
+inline bool atEndOfStacks(const TFlatStackCursor &cursor)
+{
+	return cursor.current == cursor.end;
+}
+inline unsigned int stackPosition(const TFlatStackCursor &cursor)
+{
+	return cursor.current->first;
+}
+inline const TReadStack &stackValue(const TFlatStackCursor &cursor)
+{
+	return cursor.current->second;
+}
+inline void nextStack(TFlatStackCursor &cursor)
+{
+	++cursor.current;
+}
+
+inline TDenseStackCursor beginStacks(const TDenseStackStore &store)
+{
+	TDenseStackCursor cursor;
+	cursor.offset = store.offset;
+	cursor.first = store.stacks.empty() ? NULL : &store.stacks[0];
+	cursor.current = cursor.first;
+	cursor.end = cursor.first + store.stacks.size();
+	return cursor;
+}
+inline bool atEndOfStacks(const TDenseStackCursor &cursor)
+{
+	return cursor.current == cursor.end;
+}
+inline unsigned int stackPosition(const TDenseStackCursor &cursor)
+{
+	return cursor.offset + (cursor.current - cursor.first);
+}
+inline const TReadStack &stackValue(const TDenseStackCursor &cursor)
+{
+	return *cursor.current;
+}
+inline void nextStack(TDenseStackCursor &cursor)
+{
+	// skip empty slots
+	do
+		++cursor.current;
+	while ((cursor.current != cursor.end) && (cursor.current->reads == 0));
+}
+
+inline void nextStack(TCompressedStackCursor &cursor)
+{
+	if (cursor.next == cursor.end)
+	{
+		cursor.atEnd = true;
+		return;
+	}
+	cursor.position += readVarInt(cursor.next);
+	uint64_t code = readVarInt(cursor.next);
+	cursor.stack.AAtPosition10 = (code & 2) != 0;
+	if (code & 1)
+	{
+		memcpy(&cursor.stack.reads, cursor.next, sizeof(cursor.stack.reads));
+		cursor.next += sizeof(cursor.stack.reads);
+	}
+	else
+	{
+		cursor.stack.reads = code >> 2;
+	}
+}
+inline TCompressedStackCursor beginStacks(const TCompressedStackStore &store)
+{
+	TCompressedStackCursor cursor;
+	cursor.next = store.encoded.data();
+	cursor.end = store.encoded.data() + store.encoded.size();
+	cursor.atEnd = false;
+	cursor.position = 0;
+	nextStack(cursor);
+	return cursor;
+}
+inline bool atEndOfStacks(const TCompressedStackCursor &cursor)
+{
+	return cursor.atEnd;
+}
+inline unsigned int stackPosition(const TCompressedStackCursor &cursor)
+{
+	return cursor.position;
+}
+inline const TReadStack &stackValue(const TCompressedStackCursor &cursor)
+{
+	return cursor.stack;
+}
+
+// function to advance a cursor of any store to the first stack at or after a given position
+// Since the stacks are visited in ascending order by <calculateDistanceHistograms> and <countStacksByGroup>, the windows of stacks
+// in a given range of a stack only ever move forward, such that every contig is swept in linear time.
+template <typename TCursor>
+inline void advanceStackCursor(TCursor &cursor, int64_t position)
+{
+	while (!atEndOfStacks(cursor) && (static_cast<int64_t>(stackPosition(cursor)) < position))
+		nextStack(cursor);
+}
+
+// beginStacksAt: returns a cursor to the first stack at or after a given position of a frozen store
+// Stores that can neither be searched nor indexed by position are walked from the first stack.
+template <typename TStore>
+inline typename TStore::TCursor beginStacksAt(const TStore &store, int64_t position)
+{
+	typename TStore::TCursor cursor = beginStacks(store);
+	advanceStackCursor(cursor, position);
+	return cursor;
+}
+inline TMapStackCursor beginStacksAt(const TStackMap &stacks, int64_t position)
+{
+	TMapStackCursor cursor;
+	cursor.current = (position <= 0) ? stacks.begin() : (position > numeric_limits< unsigned int >::max()) ? stacks.end() : stacks.lower_bound(position);
+	cursor.end = stacks.end();
+	return cursor;
+}
+inline TMapStackCursor beginStacksAt(const TMapStackStore &store, int64_t position)
+{
+	return beginStacksAt(store.stacks, position);
+}
+inline TFlatStackCursor beginStacksAt(const TFlatStackStore &store, int64_t position)
+{
+	TFlatStackCursor cursor = beginStacks(store);
+	if (position > numeric_limits< unsigned int >::max())
+		cursor.current = cursor.end;
+	else if (position > 0)
+		cursor.current = lower_bound(cursor.current, cursor.end, TStackEntry(static_cast<unsigned int>(position), TReadStack()), compareStackEntries);
+	return cursor;
+}
+inline TFlatStackCursor beginStacksAt(const THashStackStore &store, int64_t position)
+{
+	return beginStacksAt(store.frozen, position);
+}
+inline TDenseStackCursor beginStacksAt(const TDenseStackStore &store, int64_t position)
+{
+	TDenseStackCursor cursor = beginStacks(store);
+	if (position > static_cast<int64_t>(cursor.offset))
+	{
+		cursor.current = (position - cursor.offset < cursor.end - cursor.first) ? cursor.first + (position - cursor.offset) : cursor.end;
+		// skip empty slots
+		while ((cursor.current != cursor.end) && (cursor.current->reads == 0))
+			++cursor.current;
+	}
+	return cursor;
+}
+
+// The following functions dispatch the operations on the stacks of a contig in <TReadStacksPerGenome> to the store chosen for the contig.
+inline void addToStackStore(TReadStacksPerContig &stacks, unsigned int position, float reads, bool AAtPosition10)
+{
+	switch (stacks.type)
+	{
+		case stackStoreMap: addToStackStore(stacks.mapStore(), position, reads, AAtPosition10); break;
+		case stackStoreFlat: addToStackStore(stacks.flatStore(), position, reads, AAtPosition10); break;
+		case stackStoreDense: addToStackStore(stacks.denseStore(), position, reads, AAtPosition10); break;
+		case stackStoreHash: addToStackStore(stacks.hashStore(), position, reads, AAtPosition10); break;
+		case stackStoreCompressed: addToStackStore(stacks.compressedStore(), position, reads, AAtPosition10); break;
+	}
+}
+inline void freezeStackStore(TReadStacksPerContig &stacks)
+{
+	switch (stacks.type)
+	{
+		case stackStoreMap: freezeStackStore(stacks.mapStore()); break;
+		case stackStoreFlat: freezeStackStore(stacks.flatStore()); break;
+		case stackStoreDense: freezeStackStore(stacks.denseStore()); break;
+		case stackStoreHash: freezeStackStore(stacks.hashStore()); break;
+		case stackStoreCompressed: freezeStackStore(stacks.compressedStore()); break;
+	}
+}
+inline size_t stackStoreBytes(const TReadStacksPerContig &stacks)
+{
+	switch (stacks.type)
+	{
+		case stackStoreFlat: return stackStoreBytes(stacks.flatStore());
+		case stackStoreDense: return stackStoreBytes(stacks.denseStore());
+		case stackStoreHash: return stackStoreBytes(stacks.hashStore());
+		case stackStoreCompressed: return stackStoreBytes(stacks.compressedStore());
+		default: return stackStoreBytes(stacks.mapStore());
+	}
+}
+// function to free the memory of the stacks of a contig; the type of the store is kept
+inline void clearStackStore(TReadStacksPerContig &stacks)
+{
+	stacks = TReadStacksPerContig(stacks.type);
+}
+inline TStackCursor beginStacks(const TReadStacksPerContig &stacks)
+{
+	TStackCursor cursor = TStackCursor();
+	cursor.type = stacks.type;
+	switch (stacks.type)
+	{
+		case stackStoreMap: cursor.mapCursor = beginStacks(stacks.mapStore()); break;
+		case stackStoreFlat: cursor.flatCursor = beginStacks(stacks.flatStore()); break;
+		case stackStoreDense: cursor.denseCursor = beginStacks(stacks.denseStore()); break;
+		case stackStoreHash: cursor.flatCursor = beginStacks(stacks.hashStore()); break;
+		case stackStoreCompressed: cursor.compressedCursor = beginStacks(stacks.compressedStore()); break;
+	}
+	return cursor;
+}
+inline TStackCursor beginStacksAt(const TReadStacksPerContig &stacks, int64_t position)
+{
+	TStackCursor cursor = TStackCursor();
+	cursor.type = stacks.type;
+	switch (stacks.type)
+	{
+		case stackStoreMap: cursor.mapCursor = beginStacksAt(stacks.mapStore(), position); break;
+		case stackStoreFlat: cursor.flatCursor = beginStacksAt(stacks.flatStore(), position); break;
+		case stackStoreDense: cursor.denseCursor = beginStacksAt(stacks.denseStore(), position); break;
+		case stackStoreHash: cursor.flatCursor = beginStacksAt(stacks.hashStore(), position); break;
+		case stackStoreCompressed: cursor.compressedCursor = beginStacksAt(stacks.compressedStore(), position); break;
+	}
+	return cursor;
+}
+inline bool atEndOfStacks(const TStackCursor &cursor)
+{
+	switch (cursor.type)
+	{
+		case stackStoreFlat: case stackStoreHash: return atEndOfStacks(cursor.flatCursor);
+		case stackStoreDense: return atEndOfStacks(cursor.denseCursor);
+		case stackStoreCompressed: return atEndOfStacks(cursor.compressedCursor);
+		default: return atEndOfStacks(cursor.mapCursor);
+	}
+}
+inline unsigned int stackPosition(const TStackCursor &cursor)
+{
+	switch (cursor.type)
+	{
+		case stackStoreFlat: case stackStoreHash: return stackPosition(cursor.flatCursor);
+		case stackStoreDense: return stackPosition(cursor.denseCursor);
+		case stackStoreCompressed: return stackPosition(cursor.compressedCursor);
+		default: return stackPosition(cursor.mapCursor);
+	}
+}
+inline const TReadStack &stackValue(const TStackCursor &cursor)
+{
+	switch (cursor.type)
+	{
+		case stackStoreFlat: case stackStoreHash: return stackValue(cursor.flatCursor);
+		case stackStoreDense: return stackValue(cursor.denseCursor);
+		case stackStoreCompressed: return stackValue(cursor.compressedCursor);
+		default: return stackValue(cursor.mapCursor);
+	}
+}
+inline void nextStack(TStackCursor &cursor)
+{
+	switch (cursor.type)
+	{
+		case stackStoreFlat: case stackStoreHash: nextStack(cursor.flatCursor); break;
+		case stackStoreDense: nextStack(cursor.denseCursor); break;
+		case stackStoreCompressed: nextStack(cursor.compressedCursor); break;
+		default: nextStack(cursor.mapCursor); break;
+	}
+}
+// the cursor of the store is advanced directly, such that the type is dispatched once per window rather than once per stack
+inline void advanceStackCursor(TStackCursor &cursor, int64_t position)
+{
+	switch (cursor.type)
+	{
+		case stackStoreFlat: case stackStoreHash: advanceStackCursor(cursor.flatCursor, position); break;
+		case stackStoreDense: advanceStackCursor(cursor.denseCursor, position); break;
+		case stackStoreCompressed: advanceStackCursor(cursor.compressedCursor, position); break;
+		default: advanceStackCursor(cursor.mapCursor, position); break;
+	}
+}
+
+// function to get the stacks of a contig and strand, which are created in the store chosen for the contig, if the contig has no stacks yet
+// Input parameters:
+//	strand: STRAND_PLUS or STRAND_MINUS
+//	contig: the ID of the contig
+// Input/output parameters:
+//	readStacks: the stacks of all contigs and strands
+// Return value: the stacks of the contig and strand
+inline TReadStacksPerContig &getContigStacks(TReadStacksPerGenome &readStacks, unsigned int strand, unsigned int contig)
+{
+	TReadStacksPerStrand::iterator stacks = readStacks[strand].lower_bound(contig);
+	if ((stacks == readStacks[strand].end()) || (stacks->first != contig))
+	{
+		TStackStoreType type = (contig < readStacks.stores.contigs.size()) ? readStacks.stores.contigs[contig] : readStacks.stores.defaultType;
+		stacks = readStacks[strand].insert(stacks, make_pair(contig, TReadStacksPerContig(type)));
+	}
+	return stacks->second;
+}
+
+// function to freeze the stores of all contigs and strands after all input files have been read
+// Input/output parameters:
+//	readStacks: the stacks to freeze
+void freezeReadStacks(TReadStacksPerGenome &readStacks)
+{
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
+			freezeStackStore(contig->second);
+}
+
+// Function which adds an alignment to the read stacks.
+// It holds the logic that is shared by all readers of input files (see <countReadsInBamFile> and <countReadsInBgzfFile>).
+// Input parameters:
+//	alignment: the alignment to add
+//	minAlignmentLength: alignments which are shorter than this are ignored
+//	maxAlignmentLength: alignments which are longer than this are ignored
+//	countMultiHits: how to count multi-mapped reads (see declaration of TCountMultiHits)
+// Input/output parameters:
+//	readStacks: the stacks of reads to which the alignment is added
+//	threePrimeStacks: if not NULL, the alignment is also added to the stacks of the 3' ends of the reads
+//	                  stacks on the + strand are stored at the position after the 3' end and stacks on the - strand at the position of the 3' end,
+//	                  such that the keys of the 5' and 3' stacks of a read delimit the bases covered by the read on both strands
+//	totalReadCount: the total number of reads that were not discarded
+// Return value: false, if the alignment was discarded; true otherwise
+inline bool countAlignment(const TAlignment &alignment, TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, const unsigned int minAlignmentLength, const unsigned int maxAlignmentLength, TCountMultiHits countMultiHits, double &totalReadCount)
+{
+	// skip read, if alignment is too long or too short
+	if ((alignment.alignmentLength < minAlignmentLength) || (alignment.alignmentLength > maxAlignmentLength))
+		return false;
+
+	// the stack height is increased by the value of this variable (depends on how multi-hits are handled)
+	float readWeight;
+	if (countMultiHits == multiHitsUnique) // we do not distinguish between multi-hits and unique hits
+	{
+		// increase stack height by 1, regardless of whether it is a multi-hit or unique hit
+		// readWeight = 1;
+		readWeight = alignment.reads;
+	}
+	else if (countMultiHits == multiHitsWeighted)
+	{
+		// increase stack height by fraction
+		// readWeight = 1.0 / multiHits;
+		readWeight = 1.0 * alignment.reads / alignment.multiHits;
+	}
+	else /*if (countMultiHits == multiHitsDiscard)*/
+	{
+		// discard read (i.e., set readWeight to 0), if there is more than 1 instance in the SAM file
+		// readWeight = (multiHits == 1) ? 1 : 0;
+		readWeight = (alignment.multiHits == 1) ? alignment.reads : 0;
+	}
+
+	if (readWeight <= 0)
+		return false; // skip to next read, if read is to be discarded
+
+	// increase the height of the stack at the 5' end of the read
+	if (alignment.reverse) // read maps to minus strand
+		addToStackStore(getContigStacks(readStacks, STRAND_MINUS, alignment.contig), alignment.position+alignment.alignmentLength, readWeight, alignment.AAtPosition10);
+	else // read maps to plus strand
+		addToStackStore(getContigStacks(readStacks, STRAND_PLUS, alignment.contig), alignment.position, readWeight, alignment.AAtPosition10);
+	totalReadCount += readWeight;
+
+	if (threePrimeStacks != NULL)
+	{
+		if (alignment.reverse)
+			addToStackStore(getContigStacks(*threePrimeStacks, STRAND_MINUS, alignment.contig), alignment.position, readWeight, false);
+		else
+			addToStackStore(getContigStacks(*threePrimeStacks, STRAND_PLUS, alignment.contig), alignment.position+alignment.alignmentLength, readWeight, false);
+	}
+	return true;
+}
+
+// Function which finds stacks of reads in a BAM file.
+// Input parameters:
+//	bamFile: the BAM/SAM file from where to load the reads
+//	minAlignmentLength: reads in the <bamFile> which are shorter than this are ignored
+//	maxAlignmentLength: reads in the <bamFile> which are longer than this are ignored
+//	countMultiHits: how to count multi-mapped reads (see declaration of TCountMultiHits)
+// Output parameters:
+//	readStacks: stacks of reads that were found by the function
+//	threePrimeStacks: if not NULL, stacks of the 3' ends of the reads (see <countAlignment>)
+//	totalReadCount: the total number of reads that were not discarded
+// Input/output parameters:
+//	progress: the records are counted in the progress of reading the input files (see <updateIngestProgress>)
+// Return value: 1, if the <bamFile> could not be read; 0 otherwise
+int countReadsInBamFile(BamStream &bamFile, TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, const unsigned int minAlignmentLength, const unsigned int maxAlignmentLength, TCountMultiHits countMultiHits, double &totalReadCount, TIngestProgress &progress)
+{
+	progress.nameStore = &nameStore(bamFile.bamIOContext);
+	BamAlignmentRecord record;
+	while (!atEnd(bamFile))
+	{
+		if (readRecord(record, bamFile) != 0)
+		{
+			cerr << "Failed to read record" << endl;
+			return 1;
+		}
+		updateIngestProgress(progress, record.rID);
+
+		if ((record.beginPos == BamAlignmentRecord::INVALID_POS) || (record.beginPos == -1)) // skip unmapped reads
+		{
+			progress.metrics.unmapped++;
+		}
+		else
+		{
+			TAlignment alignment;
+			alignment.contig = record.rID;
+			alignment.position = record.beginPos;
+			alignment.reverse = hasFlagRC(record);
+
+			// calculate length of alignment using CIGAR string
+			for (unsigned int cigarIndex = 0; cigarIndex < length(record.cigar); ++cigarIndex)
+			{
+				if ((record.cigar[cigarIndex].operation == 'M') || (record.cigar[cigarIndex].operation == 'N') || (record.cigar[cigarIndex].operation == 'D') || (record.cigar[cigarIndex].operation == '=') || (record.cigar[cigarIndex].operation == 'X')) // these CIGAR elements indicate alignment
+					alignment.alignmentLength += record.cigar[cigarIndex].count;
+			}
+			progress.metrics.alignmentLengths[min(alignment.alignmentLength, METRICS_LENGTH_BINS - 1)]++;
+
+			// skip read, if alignment is too long or too short
+			if ((alignment.alignmentLength < minAlignmentLength) || (alignment.alignmentLength > maxAlignmentLength))
+			{
+				progress.metrics.filteredByLength++;
+				continue;
+			}
+
+			// check if the record is a multi-hit by examining the optional tags
+			// (the NH tag is also read when multi-hits are not distinguished, because it is counted in the ingestion metrics)
+			alignment.reads = parseCollapsedReadCount(toCString(record.qName));
+			BamTagsDict tagsDictionary(record.tags);
+			unsigned int tagIndex;
+			if (findTagKey(tagIndex, tagsDictionary, "NH"))
+				extractTagValue(alignment.multiHits, tagsDictionary, tagIndex);
+
+			size_t clippedBasesAt5PrimeEnd = 0;
+			bool clippedAt3PrimeEnd;
+			if (alignment.reverse) // read maps to minus strand
+			{
+				// check if base at position 10 is adenine
+				if ((length(record.cigar) > 1) && (record.cigar[length(record.cigar)-1].operation == 'S'))
+					clippedBasesAt5PrimeEnd = record.cigar[length(record.cigar)-1].count;
+				clippedAt3PrimeEnd = (length(record.cigar) > 1) && (record.cigar[0].operation == 'S');
+				if ((record.seq[length(record.seq)-clippedBasesAt5PrimeEnd-1-9] == 'T') || (record.seq[length(record.seq)-clippedBasesAt5PrimeEnd-1-9] == 't')) // check if 10th base is adenine (we check for uracil, because reads on the - strand are stored as the complement in SAM files
+					alignment.AAtPosition10 = true;
+			}
+			else // read maps to plus strand
+			{
+				// check if base at position 10 is adenine
+				if (record.cigar[0].operation == 'S')
+					clippedBasesAt5PrimeEnd = record.cigar[0].count;
+				clippedAt3PrimeEnd = (length(record.cigar) > 1) && (record.cigar[length(record.cigar)-1].operation == 'S');
+				if ((record.seq[clippedBasesAt5PrimeEnd+9] == 'A') || (record.seq[clippedBasesAt5PrimeEnd+9] == 'a'))
+					alignment.AAtPosition10 = true;
+			}
+
+			bool kept = countAlignment(alignment, readStacks, threePrimeStacks, minAlignmentLength, maxAlignmentLength, countMultiHits, totalReadCount);
+			countIngestedAlignment(progress.metrics, alignment, clippedBasesAt5PrimeEnd > 0, clippedAt3PrimeEnd, kept);
+		}
+	}
+	return 0;
+}
+
+#ifdef PINGPONGPRO_HTSLIB
+// Function which finds stacks of reads in a CRAM file, like <countReadsInBamFile>.
+// The CRAM file is decoded with htslib, which is told to decode only the fields needed to count reads
+// and to decode the containers of the file in parallel.
+// Input parameters:
+//	fileName: the CRAM file from where to load the reads
+//	referenceFile: the reference genome in FASTA format the reads were aligned to, which must be indexed with samtools faidx
+//	minAlignmentLength, maxAlignmentLength, countMultiHits: see <countReadsInBamFile>
+//	threads: the number of threads to decode the file
+// Output parameters:
+//	readStacks: stacks of reads that were found by the function
+//	threePrimeStacks: if not NULL, stacks of the 3' ends of the reads (see <countAlignment>)
+//	bamNameStore: the names of the contigs from the header of the file
+//	totalReadCount: the total number of reads that were not discarded
+// Input/output parameters:
+//	progress: the records are counted in the progress of reading the input files (see <updateIngestProgress>)
+// Return value: 1, if the file could not be read; 0 otherwise
+int countReadsInCramFile(const char *fileName, const string &referenceFile, TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, const unsigned int minAlignmentLength, const unsigned int maxAlignmentLength, TCountMultiHits countMultiHits, unsigned int threads, TNameStore &bamNameStore, double &totalReadCount, TIngestProgress &progress)
+{
+	// htslib would otherwise try to build a missing index next to the FASTA file, which is often read-only
+	struct stat indexStats;
+	if (stat((referenceFile + ".fai").c_str(), &indexStats) != 0)
+	{
+		cerr << "Reference genome is not indexed, run samtools faidx first: " << referenceFile << endl;
+		return 1;
+	}
+
+	samFile *cramFile = sam_open(fileName, "r");
+	if (cramFile == NULL)
+	{
+		cerr << "Failed to open input file: " << fileName << endl;
+		return 1;
+	}
+	if (hts_set_fai_filename(cramFile, referenceFile.c_str()) != 0)
+	{
+		cerr << "Failed to load reference genome: " << referenceFile << endl;
+		sam_close(cramFile);
+		return 1;
+	}
+
+	// skip the decoding of qualities, mate information and MD/NM tags
+	hts_set_opt(cramFile, CRAM_OPT_REQUIRED_FIELDS, SAM_QNAME | SAM_FLAG | SAM_RNAME | SAM_POS | SAM_CIGAR | SAM_SEQ | SAM_AUX);
+	hts_set_opt(cramFile, CRAM_OPT_DECODE_MD, 0);
+	if (threads > 1)
+		hts_set_threads(cramFile, threads);
+
+	bam_hdr_t *header = sam_hdr_read(cramFile);
+	if (header == NULL)
+	{
+		cerr << "Failed to read header of input file: " << fileName << endl;
+		sam_close(cramFile);
+		return 1;
+	}
+	TNameStore nameStore;
+	for (int32_t contig = 0; contig < header->n_targets; contig++)
+		appendValue(nameStore, CharString(header->target_name[contig]));
+	bamNameStore = nameStore;
+	progress.nameStore = &bamNameStore;
+
+	int result = 0;
+	int status;
+	bam1_t *record = bam_init1();
+	while ((status = sam_read1(cramFile, header, record)) >= 0)
+	{
+		updateIngestProgress(progress, record->core.tid);
+		if ((record->core.tid < 0) || (record->core.pos == -1))
+		{
+			progress.metrics.unmapped++;
+			continue; // skip unmapped reads
+		}
+
+		TAlignment alignment;
+		alignment.contig = record->core.tid;
+		alignment.position = record->core.pos;
+		alignment.reverse = bam_is_rev(record);
+
+		// calculate length of alignment using CIGAR string
+		const uint32_t *cigar = bam_get_cigar(record);
+		for (uint32_t cigarIndex = 0; cigarIndex < record->core.n_cigar; cigarIndex++)
+			if (bam_cigar_type(bam_cigar_op(cigar[cigarIndex])) & 2) // M, D, N, =, X consume the reference
+				alignment.alignmentLength += bam_cigar_oplen(cigar[cigarIndex]);
+		progress.metrics.alignmentLengths[min(alignment.alignmentLength, METRICS_LENGTH_BINS - 1)]++;
+		if ((alignment.alignmentLength < minAlignmentLength) || (alignment.alignmentLength > maxAlignmentLength))
+		{
+			progress.metrics.filteredByLength++;
+			continue;
+		}
+
+		alignment.reads = parseCollapsedReadCount(bam_get_qname(record));
+		const uint8_t *multiHitsTag = bam_aux_get(record, "NH"); // also read with -m unique for the ingestion metrics
+		if (multiHitsTag != NULL)
+			alignment.multiHits = bam_aux2i(multiHitsTag);
+
+		// check if base at position 10 is adenine (on the - strand, we check for uracil, because reads are stored as the complement)
+		const uint8_t *sequence = bam_get_seq(record);
+		int sequenceLength = record->core.l_qseq;
+		int clippedBasesAt5PrimeEnd = 0;
+		bool clippedAt3PrimeEnd;
+		if (alignment.reverse)
+		{
+			if ((record->core.n_cigar > 1) && (bam_cigar_op(cigar[record->core.n_cigar-1]) == BAM_CSOFT_CLIP))
+				clippedBasesAt5PrimeEnd = bam_cigar_oplen(cigar[record->core.n_cigar-1]);
+			clippedAt3PrimeEnd = (record->core.n_cigar > 1) && (bam_cigar_op(cigar[0]) == BAM_CSOFT_CLIP);
+			int basePosition = sequenceLength - clippedBasesAt5PrimeEnd - 1 - 9;
+			alignment.AAtPosition10 = (basePosition >= 0) && (basePosition < sequenceLength) && (seq_nt16_str[bam_seqi(sequence, basePosition)] == 'T');
+		}
+		else
+		{
+			if ((record->core.n_cigar > 0) && (bam_cigar_op(cigar[0]) == BAM_CSOFT_CLIP))
+				clippedBasesAt5PrimeEnd = bam_cigar_oplen(cigar[0]);
+			clippedAt3PrimeEnd = (record->core.n_cigar > 1) && (bam_cigar_op(cigar[record->core.n_cigar-1]) == BAM_CSOFT_CLIP);
+			int basePosition = clippedBasesAt5PrimeEnd + 9;
+			alignment.AAtPosition10 = (basePosition < sequenceLength) && (seq_nt16_str[bam_seqi(sequence, basePosition)] == 'A');
+		}
+
+		bool kept = countAlignment(alignment, readStacks, threePrimeStacks, minAlignmentLength, maxAlignmentLength, countMultiHits, totalReadCount);
+		countIngestedAlignment(progress.metrics, alignment, clippedBasesAt5PrimeEnd > 0, clippedAt3PrimeEnd, kept);
+	}
+	if (status < -1) // -1 indicates the end of the file
+	{
+		cerr << "Failed to read record" << endl;
+		result = 1;
+	}
+
+	bam_destroy1(record);
+	bam_hdr_destroy(header);
+	sam_close(cramFile);
+	return result;
+}
+#endif
+
+// Function, which converts every stack height into a score.
+// The score is directly based on how often a stack with a certain height is found in the input files of the program.
+// Therefore, the score maps every stack height to the empirical frequency of encountering such a stack in the input dataset.
+// Input parameters:
+//	readStacks: the read stacks that were found by the function <countReadsInBamFile>
+// Output parameters:
+//	heightScoreMap: output of the function
+//	                a mapping of [stack height -> empirical frequency of stacks with this height]
+void mapHeightsToScores(TReadStacksPerGenome &readStacks, THeightScoreMap &heightScoreMap)
+{
+	// iterate through all strands, contigs and positions to count how many stacks there are of any given height
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
+			for (TStackCursor stack = beginStacks(contig->second); !atEndOfStacks(stack); nextStack(stack))
+				heightScoreMap[0.5 + stackValue(stack).reads] += 1;
+}
+
+// functions to convert the class of a signature to the key of a <TActivityWindow> and back
+// Input parameters:
+//	overlap: the overlap minus <MIN_ARBITRARY_OVERLAP>
+//	heightScoreBin, baseBiasBin, localHeightScoreBin: the bins of the signature as assigned by the function <countStacksByGroup> (before collapsing)
+inline unsigned int encodeActivityClass(unsigned int overlap, unsigned int heightScoreBin, unsigned int baseBiasBin, unsigned int localHeightScoreBin)
+{
+	return ((overlap * HEIGHT_SCORE_BINS + heightScoreBin) * 2 + baseBiasBin) * 2 + localHeightScoreBin;
+}
+inline void decodeActivityClass(unsigned int activityClass, unsigned int &overlap, unsigned int &heightScoreBin, unsigned int &baseBiasBin, unsigned int &localHeightScoreBin)
+{
+	localHeightScoreBin = activityClass % 2;
+	baseBiasBin = (activityClass / 2) % 2;
+	heightScoreBin = (activityClass / 4) % HEIGHT_SCORE_BINS;
+	overlap = activityClass / 4 / HEIGHT_SCORE_BINS;
+}
+
+// function to get the FDR of a ping-pong signature from a table calculated by <buildFDRTable>
+// Input parameters:
+//	fdrTable: the FDR of every class of signatures
+//	overlap: the overlap of the signature minus <MIN_ARBITRARY_OVERLAP>
+//	pingPongSignature: the signature
+// Return value: the chances of the signature being a false discovery
+inline float getFDR(const TFDRTable &fdrTable, unsigned int overlap, const TPingPongSignature &pingPongSignature)
+{
+	return fdrTable[encodeActivityClass(overlap, pingPongSignature.heightScoreBin, pingPongSignature.baseBiasBin, pingPongSignature.localHeightScoreBin)];
+}
+
+// function to calculate the score of a ping-pong signature, which is used to aggregate signatures in a region
+inline float signatureScore(float readsOnPlusStrand, float readsOnMinusStrand, float fdr)
+{
+	return (readsOnPlusStrand + readsOnMinusStrand) * (1 - fdr);
+}
+
+// function which is executed by every worker thread of a <TThreadPool>
+// it takes tasks from the queue until the pool is stopped
+void runWorkerThread(TThreadPool *pool)
+{
+	unique_lock< mutex > lock(pool->lock);
+	while (true)
+	{
+		while (pool->tasks.empty() && !pool->stopping)
+			pool->taskAvailable.wait(lock);
+		if (pool->tasks.empty()) // the pool is being stopped and all tasks are done
+			return;
+
+		function< void() > task = pool->tasks.front();
+		pool->tasks.pop_front();
+		lock.unlock();
+		task();
+		lock.lock();
+
+		if (--pool->pendingTasks == 0)
+			pool->tasksDone.notify_all();
+	}
+}
+
+// function to start the worker threads of a thread pool
+// Input parameters:
+//	threads: the number of worker threads
+// Output parameters:
+//	pool: the started thread pool
+void startThreadPool(TThreadPool &pool, unsigned int threads)
+{
+	pool.stopping = false;
+	pool.pendingTasks = 0;
+	for (unsigned int i = 0; i < threads; i++)
+		pool.workers.push_back(thread(runWorkerThread, &pool));
+}
+
+// function to add a task to the queue of a thread pool
+// Input parameters:
+//	task: the function to execute by one of the worker threads
+// Input/output parameters:
+//	pool: the pool to execute the task
+void submitTask(TThreadPool &pool, const function< void() > &task)
+{
+	lock_guard< mutex > lock(pool.lock);
+	pool.tasks.push_back(task);
+	pool.pendingTasks++;
+	pool.taskAvailable.notify_one();
+}
+
+// function to wait until all tasks submitted to a thread pool have been executed
+void waitForTasks(TThreadPool &pool)
+{
+	unique_lock< mutex > lock(pool.lock);
+	while (pool.pendingTasks > 0)
+		pool.tasksDone.wait(lock);
+}
+
+// function to terminate the worker threads of a thread pool after all tasks have been executed
+void stopThreadPool(TThreadPool &pool)
+{
+	{
+		lock_guard< mutex > lock(pool.lock);
+		pool.stopping = true;
+		pool.taskAvailable.notify_all();
+	}
+	for (vector< thread >::iterator worker = pool.workers.begin(); worker != pool.workers.end(); ++worker)
+		worker->join();
+	pool.workers.clear();
+}
+
+// function to look up the score of a stack height in a map produced by <mapHeightsToScores>
+// unlike the operator [], the lookup does not modify the map, such that multiple threads may look up scores concurrently
+inline float getHeightScore(const THeightScoreMap &heightScoreMap, float stackHeight)
+{
+	THeightScoreMap::const_iterator heightScore = heightScoreMap.find(0.5 + stackHeight);
+	return (heightScore != heightScoreMap.end()) ? heightScore->second : 0;
+}
+
+// function to calculate the greatest common divisor of two numbers
+inline uint64_t greatestCommonDivisor(uint64_t a, uint64_t b)
+{
+	while (b != 0)
+	{
+		uint64_t remainder = a % b;
+		a = b;
+		b = remainder;
+	}
+	return a;
+}
+
+// function to move the reads of the current window of a <TActivityAccumulator> to an activity track
+// Input/output parameters:
+//	accumulator: the accumulator, which is emptied
+//	activityTrack: the track to which the window is appended
+void flushActivityAccumulator(TActivityAccumulator &accumulator, TActivityTrack &activityTrack)
+{
+	if (accumulator.classes.empty())
+		return;
+	sort(accumulator.classes.begin(), accumulator.classes.end());
+	TActivityWindowsPerContig &windows = activityTrack.contigs[accumulator.contig];
+	windows.push_back(make_pair(accumulator.window, TActivityWindow()));
+	TActivityWindow &window = windows.back().second;
+	window.reserve(accumulator.classes.size());
+	for (vector< unsigned int >::iterator activityClass = accumulator.classes.begin(); activityClass != accumulator.classes.end(); ++activityClass)
+	{
+		window.push_back(make_pair(*activityClass, accumulator.reads[*activityClass]));
+		accumulator.reads[*activityClass] = 0;
+	}
+	accumulator.classes.clear();
+	unsigned int &contigEnd = activityTrack.contigEnds[accumulator.contig];
+	contigEnd = max(contigEnd, accumulator.end);
+}
+
+// Function, which groups the read stacks of a single tile (see <countStacksByGroup>).
+// Since the stacks on the - strand in the vicinity of a stack on the + strand are taken from the entire contig,
+// the local coverage of the stacks at the edges of a tile is the same as without tiles.
+// Input parameters:
+//	heightScoreMap: a mapping of [stack height -> empirical frequency of stacks with this height] as produced by the function <mapHeightsToScores>
+//	maxHeightScore: the logarithm of the highest possible score that two overlapping stacks can get
+//	keepArbitraryOverlaps, minStackHeight: see <countStacksByGroup>
+// Input/output parameters:
+//	tile: the stacks to group; the grouped stack counts, signatures and activity tracks are stored in the tile
+void countStacksInTile(const THeightScoreMap *heightScoreMap, float maxHeightScore, bool keepArbitraryOverlaps, unsigned int minStackHeight, TStackTile *tile)
+{
+	if (traceRecorder.enabled)
+	{
+		stringstream detail;
+		if (!tile->segments.empty())
+			detail << "contig " << tile->segments.front().contig << ", ";
+		detail << tile->stacks << " stacks";
+		traceBegin("group stacks", detail.str());
+	}
+	tile->groupedStackCounts.assign(ARBITRARY_OVERLAP_COUNT * HEIGHT_SCORE_BINS * 2 * 2, 0);
+	vector< TActivityAccumulator > activityAccumulators(tile->activityTracks.size());
+	for (unsigned int track = 0; track < activityAccumulators.size(); track++)
+		activityAccumulators[track].reads.assign(ARBITRARY_OVERLAP_COUNT * HEIGHT_SCORE_BINS * 2 * 2, 0);
+
+	for (vector< TStackTileSegment >::iterator segment = tile->segments.begin(); segment != tile->segments.end(); ++segment)
+	{
+		segment->pingPongSignaturesByOverlap.resize(ARBITRARY_OVERLAP_COUNT);
+		if (atEndOfStacks(segment->plusStacks))
+			continue;
+		TStackCursor window = beginStacksAt(*segment->minusStacks, stackPosition(segment->plusStacks)); // first stack on the minus strand, which might overlap the current stack on the plus strand
+		vector< TReadStack > stacksInVicinity(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1); // copies of the stacks on the minus strand, since some cursors decode the current stack into the cursor (see <TCompressedStackCursor>)
+		for (TStackCursor positionPlusStrand = segment->plusStacks; !atEndOfStacks(positionPlusStrand) && (stackPosition(positionPlusStrand) < segment->plusEnd); nextStack(positionPlusStrand))
+		{
+			unsigned int plusPosition = stackPosition(positionPlusStrand);
+			const TReadStack &stackOnPlusStrand = stackValue(positionPlusStrand);
+			vector< const TReadStack * > stacksOnMinusStrand(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1, NULL);
+			float meanStackHeightInVicinity = 0;
+			float maxStackHeightInVicinity = 0;
+			// walk through the stacks on the minus strand within the range of arbitrary overlaps (see <calculateDistanceHistograms>)
+			advanceStackCursor(window, static_cast<int64_t>(plusPosition) + MIN_ARBITRARY_OVERLAP);
+			for (TStackCursor positionMinusStrand = window; !atEndOfStacks(positionMinusStrand) && (stackPosition(positionMinusStrand) <= plusPosition + MAX_ARBITRARY_OVERLAP); nextStack(positionMinusStrand))
+			{
+				int overlap = stackPosition(positionMinusStrand) - plusPosition;
+				const TReadStack &stackOnMinusStrand = stackValue(positionMinusStrand);
+				// calculate mean of stack heights in the vicinity
+				meanStackHeightInVicinity += stackOnMinusStrand.reads;
+				// find highest stacks height in the vicinity
+				if (stackOnMinusStrand.reads > maxStackHeightInVicinity)
+					maxStackHeightInVicinity = stackOnMinusStrand.reads;
+				// remember the stacks that we found, so we do not have to search them again
+				stacksInVicinity[overlap - MIN_ARBITRARY_OVERLAP] = stackOnMinusStrand;
+				stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP] = &stacksInVicinity[overlap - MIN_ARBITRARY_OVERLAP];
+			}
+			meanStackHeightInVicinity /= stacksOnMinusStrand.size();
+
+			if (maxStackHeightInVicinity > 0) // only continue, if there are any stacks in the vicinity at all
+			{
+				float heightScorePlus = getHeightScore(*heightScoreMap, stackOnPlusStrand.reads);
+
+				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+				{
+					if (stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP] != NULL)
+					{
+						// calculate score based on heights of overlapping stacks
+						float heightScore = heightScorePlus * getHeightScore(*heightScoreMap, stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads);
+						// find the bin for the score
+						unsigned int heightScoreBin =
+							static_cast<int>(0.5 // add 0.5 for arithmetic rounding when casting float to int
+							+ log10(heightScore) // take logarithm of score
+							/ maxHeightScore * (HEIGHT_SCORE_BINS - 1)); // assign every score to a bin
+
+						// calculate score based on how much higher the stack is compared to the stacks in the vicinity
+						float localHeightScore = (stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads - (meanStackHeightInVicinity - stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads/stacksOnMinusStrand.size())) / maxStackHeightInVicinity;
+						// 0.2 seems to be the magical threshold that best segregates ping-pong overlaps from arbitrary overlaps
+						unsigned int localHeightScoreBin = (localHeightScore < 0.2) ? IS_BELOW_COVERAGE : IS_ABOVE_COVERAGE;
+
+						// calculate score based on whether the stack has adenine at position 10
+						unsigned int baseBiasBin = (stackOnPlusStrand.AAtPosition10 || stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->AAtPosition10) ? HAS_BASE_BIAS : HAS_NO_BASE_BIAS;
+
+						// increase bin counter
+						unsigned int activityClass = encodeActivityClass(overlap - MIN_ARBITRARY_OVERLAP, heightScoreBin, baseBiasBin, localHeightScoreBin);
+						tile->groupedStackCounts[activityClass]++;
+
+						// keep a list of putative ping-pong signatures, so we can analyze later, which of them are (likely) true
+						if ((keepArbitraryOverlaps || (overlap == PING_PONG_OVERLAP)) && (stackOnPlusStrand.reads >= minStackHeight) && (stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads >= minStackHeight))
+							segment->pingPongSignaturesByOverlap[overlap - MIN_ARBITRARY_OVERLAP].push_back(TPingPongSignature(plusPosition, heightScoreBin, localHeightScoreBin, baseBiasBin, stackOnPlusStrand.reads, stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads));
+
+						// the score of a signature is (reads on + strand + reads on - strand) * (1 - FDR) and the FDR only depends on the class,
+						// so it suffices to sum up the reads by class until the FDRs are known
+						for (unsigned int track = 0; track < activityAccumulators.size(); track++)
+						{
+							TActivityAccumulator &accumulator = activityAccumulators[track];
+							unsigned int window = plusPosition / tile->activityTracks[track].windowSize;
+							if ((accumulator.window != window) || (accumulator.contig != segment->contig))
+							{
+								// the stacks are swept in order, so the previous window is complete
+								flushActivityAccumulator(accumulator, tile->activityTracks[track]);
+								accumulator.contig = segment->contig;
+								accumulator.window = window;
+							}
+							if (accumulator.reads[activityClass] == 0)
+								accumulator.classes.push_back(activityClass);
+							accumulator.reads[activityClass] += stackOnPlusStrand.reads + stacksOnMinusStrand[overlap - MIN_ARBITRARY_OVERLAP]->reads;
+							accumulator.end = plusPosition + 1;
+						}
+					}
+				}
+			}
+		}
+	}
+	for (unsigned int track = 0; track < activityAccumulators.size(); track++)
+		flushActivityAccumulator(activityAccumulators[track], tile->activityTracks[track]);
+	traceEnd();
+}
+
+// function to compare tiles by the number of stacks, largest first
+inline bool compareStackTilesBySize(const TStackTile *tile1, const TStackTile *tile2)
+{
+	return tile1->stacks > tile2->stacks;
+}
+
+// Function, which adds the results of a tile to the results of <countStacksByGroup>.
+// The tiles must be merged in the order of the contigs and positions, such that the signatures remain sorted.
+// Input/output parameters:
+//	tile: the tile to merge; its signatures are moved to <pingPongSignaturesByOverlap>
+//	groupedStackCountsByOverlap, pingPongSignaturesByOverlap, activityTracks: see <countStacksByGroup>
+void mergeStackTile(TStackTile &tile, TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, TActivityTracks *activityTracks)
+{
+	for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		for (unsigned int heightScoreBin = 0; heightScoreBin < HEIGHT_SCORE_BINS; heightScoreBin++)
+			for (unsigned int baseBiasBin = 0; baseBiasBin < 2; baseBiasBin++)
+				for (unsigned int localHeightScoreBin = 0; localHeightScoreBin < 2; localHeightScoreBin++)
+					groupedStackCountsByOverlap[overlap][heightScoreBin][baseBiasBin][localHeightScoreBin] += tile.groupedStackCounts[encodeActivityClass(overlap, heightScoreBin, baseBiasBin, localHeightScoreBin)];
+
+	for (vector< TStackTileSegment >::iterator segment = tile.segments.begin(); segment != tile.segments.end(); ++segment)
+		for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+			if (!segment->pingPongSignaturesByOverlap[overlap].empty())
+			{
+				TPingPongSignaturesPerContig &pingPongSignatures = pingPongSignaturesByOverlap[overlap][segment->contig];
+				pingPongSignatures.splice(pingPongSignatures.end(), segment->pingPongSignaturesByOverlap[overlap]);
+			}
+
+	// tiles are split at multiples of the window sizes and merged in order, so the windows of a tile follow those of the previous tiles
+	if (activityTracks != NULL)
+		for (unsigned int track = 0; track < activityTracks->size(); track++)
+		{
+			for (map< unsigned int, TActivityWindowsPerContig >::iterator contig = tile.activityTracks[track].contigs.begin(); contig != tile.activityTracks[track].contigs.end(); ++contig)
+			{
+				TActivityWindowsPerContig &windows = (*activityTracks)[track].contigs[contig->first];
+				if (windows.empty())
+					windows.swap(contig->second);
+				else
+					windows.insert(windows.end(), contig->second.begin(), contig->second.end());
+			}
+			for (map< unsigned int, unsigned int >::iterator contigEnd = tile.activityTracks[track].contigEnds.begin(); contigEnd != tile.activityTracks[track].contigEnds.end(); ++contigEnd)
+			{
+				unsigned int &mergedContigEnd = (*activityTracks)[track].contigEnds[contigEnd->first];
+				mergedContigEnd = max(mergedContigEnd, contigEnd->second);
+			}
+		}
+}
+
+// Function, which groups read stacks by all possible combinations of the following criteria:
+// - the height of the overlapping stacks
+// - whether the reads have adenine at position 10
+// - whether the height of the stacks are above or below the local coverage
+// For every group, the number of stacks falling into that particular group is counted.
+// The contigs are split into tiles of about <stacksPerTile> stacks, which are grouped in parallel (see <countStacksInTile>).
+// Large contigs are only split at multiples of the window sizes of the activity tracks, such that the results are identical to grouping the stacks sequentially.
+// Input parameters:
+//	readStacks: the read stacks that were found by the function <countReadsInBamFile>
+//	            the variable is emptied by the function to conserve memory
+//	heightScoreMap: a mapping of [stack height -> empirical frequency of stacks with this height] as produced by the function <mapHeightsToScores>
+// Output parameters:
+//	groupedStackCountsByOverlap: for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>, the number of read stacks falling into all possible groups
+//	pingPongSignaturesByOverlap: for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>, the ping-pong signatures that were found
+//	keepArbitraryOverlaps: if false, only the ping-pong signatures with an overlap of <PING_PONG_OVERLAP> are added to <pingPongSignaturesByOverlap>
+//	                       (the stacks with arbitrary overlaps are counted nonetheless)
+//	minStackHeight: signatures with a stack of fewer reads are not added to <pingPongSignaturesByOverlap>
+//	threads: the number of threads to group the tiles
+//	stacksPerTile: the number of stacks on the + strand per tile (see <planRun>)
+// Input/output parameters:
+//	activityTracks: if not NULL, the reads of every signature are added to the window of every track that contains the signature
+void countStacksByGroup(TReadStacksPerGenome &readStacks, THeightScoreMap &heightScoreMap, TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, TActivityTracks *activityTracks = NULL, bool keepArbitraryOverlaps = true, unsigned int minStackHeight = 0, unsigned int threads = 1, unsigned int stacksPerTile = STACKS_PER_TILE)
+{
+	// the following loop initializes a multi-dimensional array of stack counts with the following boundaries:
+	// MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1 (one for each possible overlap)
+	// HEIGHT_SCORE_BINS (one of each bin of the height scores)
+	// 2 (one for reads with adenine at position 10 and one for those with a different base)
+	// 2 (one for stack heights below the local coverage and one for stack heights above)
+	groupedStackCountsByOverlap.resize(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1);
+	for (TGroupedStackCountsByOverlap::iterator i = groupedStackCountsByOverlap.begin(); i != groupedStackCountsByOverlap.end(); ++i)
+	{
+		i->resize(HEIGHT_SCORE_BINS);
+		for (TGroupedStackCounts::iterator j = i->begin(); j != i->end(); ++j)
+		{
+			j->resize(2);
+			for (vector< vector< float > >::iterator k = j->begin(); k != j->end(); ++k)
+			{
+				k->resize(2);
+			}
+		}
+	}
+
+	pingPongSignaturesByOverlap.resize(MAX_ARBITRARY_OVERLAP - MIN_ARBITRARY_OVERLAP + 1);
+
+	// find the highest possible score that two overlapping stacks can get
+	float maxHeightScore = 0;
+	for (THeightScoreMap::iterator heightScore = heightScoreMap.begin(); heightScore != heightScoreMap.end(); ++heightScore)
+		if (heightScore->second > maxHeightScore)
+			maxHeightScore = heightScore->second;
+	maxHeightScore = log10(maxHeightScore * maxHeightScore);
+
+	// large contigs are split at multiples of all window sizes, such that no window of an activity track is shared by two tiles
+	// (0 = the least common multiple is too large to split contigs at all)
+	uint64_t tileAlignment = 1;
+	if (activityTracks != NULL)
+		for (TActivityTracks::iterator activityTrack = activityTracks->begin(); (activityTrack != activityTracks->end()) && (tileAlignment != 0); ++activityTrack)
+		{
+			tileAlignment = tileAlignment / greatestCommonDivisor(tileAlignment, activityTrack->windowSize) * activityTrack->windowSize;
+			if (tileAlignment > numeric_limits< unsigned int >::max())
+				tileAlignment = 0;
+		}
+
+	TThreadPool pool;
+	if (threads > 1)
+		startThreadPool(pool, threads);
+
+	// iterate through all contigs and positions to find those positions where a stack on the plus strand overlaps a stack on the minus strand by <overlap> nt
+	TReadStacksPerStrand::iterator contigPlusStrand = readStacks[STRAND_PLUS].begin();
+	TStackCursor unassignedStack; // the first stack of the current contig, which has not been assigned to a tile yet
+	if (contigPlusStrand != readStacks[STRAND_PLUS].end())
+		unassignedStack = beginStacks(contigPlusStrand->second);
+	while (contigPlusStrand != readStacks[STRAND_PLUS].end())
+	{
+		// assign the stacks to tiles until there are enough tiles to keep all threads busy
+		list< TStackTile > tiles;
+		vector< unsigned int > finishedContigs;
+		while ((contigPlusStrand != readStacks[STRAND_PLUS].end()) && ((tiles.size() < threads * TILES_PER_THREAD) || (tiles.back().stacks < stacksPerTile)))
+		{
+			TReadStacksPerStrand::iterator contigMinusStrand = readStacks[STRAND_MINUS].find(contigPlusStrand->first);
+			if ((contigMinusStrand == readStacks[STRAND_MINUS].end()) || atEndOfStacks(unassignedStack))
+			{
+				// all stacks of the contig have been assigned to tiles
+				finishedContigs.push_back(contigPlusStrand->first);
+				if (++contigPlusStrand != readStacks[STRAND_PLUS].end())
+					unassignedStack = beginStacks(contigPlusStrand->second);
+				continue;
+			}
+
+			if (tiles.empty() || (tiles.back().stacks >= stacksPerTile))
+				tiles.push_back(TStackTile(activityTracks));
+			TStackTile &tile = tiles.back();
+
+			// add as many stacks of the contig to the tile as fit into it
+			TStackCursor segmentEnd = unassignedStack;
+			unsigned int stacks = 0;
+			for (; !atEndOfStacks(segmentEnd) && (stacks < stacksPerTile - tile.stacks); nextStack(segmentEnd))
+				stacks++;
+			// split the contig at the next multiple of the window sizes of the activity tracks
+			if (!atEndOfStacks(segmentEnd))
+			{
+				int64_t boundary = (tileAlignment == 0) ? static_cast<int64_t>(numeric_limits< unsigned int >::max()) + 1 : (stackPosition(segmentEnd) + tileAlignment - 1) / tileAlignment * tileAlignment;
+				advanceStackCursor(segmentEnd, boundary);
+				stacks = stacksPerTile - tile.stacks; // the tile is full
+			}
+			tile.segments.push_back(TStackTileSegment(contigPlusStrand->first, unassignedStack, atEndOfStacks(segmentEnd) ? static_cast<int64_t>(numeric_limits< unsigned int >::max()) + 1 : stackPosition(segmentEnd), &contigMinusStrand->second));
+			tile.stacks += stacks;
+			unassignedStack = segmentEnd;
+		}
+
+		// group the stacks of all tiles, largest first to balance the work of the threads, and merge the results in the original order
+		vector< TStackTile * > schedule;
+		for (list< TStackTile >::iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+			schedule.push_back(&(*tile));
+		stable_sort(schedule.begin(), schedule.end(), compareStackTilesBySize);
+		for (vector< TStackTile * >::iterator tile = schedule.begin(); tile != schedule.end(); ++tile)
+		{
+			if (threads > 1)
+				submitTask(pool, bind(countStacksInTile, &heightScoreMap, maxHeightScore, keepArbitraryOverlaps, minStackHeight, *tile));
+			else
+				countStacksInTile(&heightScoreMap, maxHeightScore, keepArbitraryOverlaps, minStackHeight, *tile);
+		}
+		if (threads > 1)
+			waitForTasks(pool);
+		for (list< TStackTile >::iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+			mergeStackTile(*tile, groupedStackCountsByOverlap, pingPongSignaturesByOverlap, activityTracks);
+
+		// free memory of contigs on + and - strand, which have been processed entirely
+		for (vector< unsigned int >::iterator contig = finishedContigs.begin(); contig != finishedContigs.end(); ++contig)
+		{
+			clearStackStore(readStacks[STRAND_PLUS][*contig]);
+			TReadStacksPerStrand::iterator contigMinusStrand = readStacks[STRAND_MINUS].find(*contig);
+			if (contigMinusStrand != readStacks[STRAND_MINUS].end())
+				clearStackStore(contigMinusStrand->second);
+		}
+	}
+
+	if (threads > 1)
+		stopThreadPool(pool);
+
+	// free the rest of memory that might potentially not have been freed yet
+	for (TReadStacksPerStrand::iterator contigMinusStrand = readStacks[STRAND_MINUS].begin(); contigMinusStrand != readStacks[STRAND_MINUS].end(); ++contigMinusStrand)
+		clearStackStore(contigMinusStrand->second);
+}
+
+// The groups of stacks as produced by the function <countStacksByGroup> may be empty.
+// This function merges adjacent groups until there are no empty groups left.
+// The ping-pong signatures keep their original bins; the returned mapping is used to look up their FDRs instead (see <buildFDRTable>).
+// Input/output parameters:
+// 	groupedStackCountsByOverlap: the grouped stack counts as produced by the function <countStacksByGroup>
+// Output parameters:
+//	collapsedBins: the collapsed bin of every height score bin
+void collapseBins(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, vector< unsigned int > &collapsedBins)
+{
+	// create a new container to hold the collapsed bin counts
+	TGroupedStackCountsByOverlap collapsed = groupedStackCountsByOverlap;
+
+	// keep track of which bins are mapped to which collapsed bins
+	vector< unsigned int > oldBinCollapsedBinMap(groupedStackCountsByOverlap.begin()->size());
+
+	unsigned int collapsedBin = 0;
+	unsigned int bin = 0;
+	while (bin < groupedStackCountsByOverlap.begin()->size()){
+
+		// initialize collapsed bin with 0
+		for (TGroupedStackCountsByOverlap::iterator i = collapsed.begin(); i != collapsed.end(); ++i)
+			for (vector< vector< float > >::iterator j = (*i)[collapsedBin].begin(); j != (*i)[collapsedBin].end(); ++j)
+				for (vector< float >::iterator k = j->begin(); k != j->end(); ++k)
+					*k = 0;
+
+		unsigned int emptyBins;
+		do {
+			emptyBins = 0;
+
+			// collapse bins
+			for (unsigned int overlap = 0; overlap < groupedStackCountsByOverlap.size(); overlap++)
+				for (unsigned int i = 0; i < groupedStackCountsByOverlap[overlap][bin].size(); i++)
+					for (unsigned int j = 0; j < groupedStackCountsByOverlap[overlap][bin][i].size(); j++)
+					{
+						collapsed[overlap][collapsedBin][i][j] += groupedStackCountsByOverlap[overlap][bin][i][j];
+
+						// check if collapsedBin is still empty to decide whether to collapse even more
+						if (collapsed[overlap][collapsedBin][i][j] <= 0)
+							emptyBins++;
+					}
+
+			// remember with which new bin the current bin was merged
+			oldBinCollapsedBinMap[bin] = collapsedBin;
+
+			bin++;
+		// stop collapsing bins, when there are no empty bins or when all bins have been merged
+		} while ((emptyBins > 0) && (bin < groupedStackCountsByOverlap.begin()->size()));
+
+		collapsedBin++;
+	}
+
+	// shrink container to new number of bins
+	for (TGroupedStackCountsByOverlap::iterator i = collapsed.begin(); i != collapsed.end(); ++i)
+		i->resize(collapsedBin);
+
+	// return collapsed bins as result
+	groupedStackCountsByOverlap = collapsed;
+	collapsedBins.swap(oldBinCollapsedBinMap);
+}
+
+// This function calculates a FDR for every group of ping-pong stacks based on how often ping-pong stacks
+// with the properties of the group occur by chance compared to how often they occur
+// when looking at overlaps of 10 nt.
+// Input paramters:
+// 	groupedStackCountsByOverlap: the collapsed grouped stack counts as modified by the function <collapseBins>
+// Output parameters:
+//	fdrs: the FDR of every group of <groupedStackCountsByOverlap>
+void calculateFDRs(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TGroupedStackCountsByOverlap &fdrs)
+{
+	TGroupedStackCountsByOverlap FDRs = groupedStackCountsByOverlap; // the assignment shall only ensure that <FDRs> has the same dimensions as <groupedStackCountsByOverlap>
+
+	// estimate how many of the putative ping-pong signatures are random noise
+	for (unsigned int i = 0; i < groupedStackCountsByOverlap.begin()->size(); i++)
+		for (unsigned int j = 0; j < (*groupedStackCountsByOverlap.begin())[i].size(); j++)
+			for (unsigned int k = 0; k < (*groupedStackCountsByOverlap.begin())[i][j].size(); k++)
+			{
+				// calculate mean for all the bins of arbitrary overlaps
+				float meanOfArbitraryOverlaps = 0;
+				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+					if (overlap != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
+						meanOfArbitraryOverlaps += groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k];
+				meanOfArbitraryOverlaps = meanOfArbitraryOverlaps / (groupedStackCountsByOverlap.size() - 1 /* minus the one bin for ping-pong overlaps */);
+
+				// calculate standard deviation for all the bins of arbitrary overlaps
+				float stdDevOfArbitraryOverlaps = 0;
+				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+					if (overlap != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
+						stdDevOfArbitraryOverlaps += pow(groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] - meanOfArbitraryOverlaps, 2);
+				stdDevOfArbitraryOverlaps = sqrt(1.0 / (groupedStackCountsByOverlap.size() - 1 - 1 /* minus 1 for corrected sample STDDEV */) * stdDevOfArbitraryOverlaps);
+				if (stdDevOfArbitraryOverlaps <= MIN_STANDARD_DEVIATION)
+					stdDevOfArbitraryOverlaps = MIN_STANDARD_DEVIATION; // prevent division by 0, in case the STDDEV is 0
+
+				// calculate expected number of false positives among the putative ping-pong signatures
+				for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+				{
+					double fdr = 0;
+					for (double x = -APPROXIMATION_RANGE; x <= +APPROXIMATION_RANGE; x += APPROXIMATION_ACCURACY)
+					{
+						if (x >= (groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] - meanOfArbitraryOverlaps) / stdDevOfArbitraryOverlaps)
+						{
+							fdr += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x) * 1;
+						}
+						else
+						{
+							fdr += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x) * (x * stdDevOfArbitraryOverlaps + meanOfArbitraryOverlaps) / groupedStackCountsByOverlap[overlap - MIN_ARBITRARY_OVERLAP][i][j][k];
+						}
+					}
+
+					if (fdr < 0)
+					{
+						fdr = 0;
+					}
+					else if (fdr > 1)
+					{
+						fdr = 1;
+					}
+
+					FDRs[overlap - MIN_ARBITRARY_OVERLAP][i][j][k] = fdr;
+				}
+			}
+
+	fdrs.swap(FDRs);
+}
+
+// This function expands the FDRs of the collapsed groups to a table which maps the original bins of a signature to its FDR.
+// This way, the FDR of a signature can be looked up by the function <getFDR>, when it is needed, instead of storing it in every signature.
+// Input parameters:
+//	collapsedBins: the mapping of height score bins to collapsed bins as calculated by the function <collapseBins>
+//	fdrs: the FDR of every collapsed group as calculated by the function <calculateFDRs>
+// Output parameters:
+//	fdrTable: the FDR of every class of signatures as encoded by <encodeActivityClass>
+void buildFDRTable(const vector< unsigned int > &collapsedBins, const TGroupedStackCountsByOverlap &fdrs, TFDRTable &fdrTable)
+{
+	fdrTable.assign(ARBITRARY_OVERLAP_COUNT * HEIGHT_SCORE_BINS * 2 * 2, 0);
+	for (unsigned int overlap = 0; overlap < fdrs.size(); overlap++)
+		for (unsigned int heightScoreBin = 0; heightScoreBin < collapsedBins.size(); heightScoreBin++)
+			for (unsigned int baseBiasBin = 0; baseBiasBin < fdrs[overlap][collapsedBins[heightScoreBin]].size(); baseBiasBin++)
+				for (unsigned int localHeightScoreBin = 0; localHeightScoreBin < fdrs[overlap][collapsedBins[heightScoreBin]][baseBiasBin].size(); localHeightScoreBin++)
+					fdrTable[encodeActivityClass(overlap, heightScoreBin, baseBiasBin, localHeightScoreBin)] = fdrs[overlap][collapsedBins[heightScoreBin]][baseBiasBin][localHeightScoreBin];
+}
+
+// function to replace all occurrences of a string within a string for another string
+// Input/output paramters:
+//	subjectString: the string to modify
+// Input parameters:
+//	searchString: the string to search for
+//	replaceString: the string that replaces <searchString>
+void stringReplace(string &subjectString, const string &searchString, const string &replaceString) {
+	size_t i = 0;
+	while((i = subjectString.find(searchString, i)) != string::npos)
+	{
+	        subjectString.replace(i, searchString.length(), replaceString);
+        	i += replaceString.length(); // skip the string that we just inserted
+	}
+}
+
+// function to quote a string, e.g., a file path, as a string literal of R
+inline string quoteRString(string text)
+{
+	stringReplace(text, "\\", "\\\\");
+	stringReplace(text, "'", "\\'");
+	return "'" + text + "'";
+}
+
+// function to quote a string, e.g., a file path, as a single argument of a shell command
+inline string quoteShellArgument(string text)
+{
+	stringReplace(text, "'", "'\\''");
+	return "'" + text + "'";
+}
+
+// function to get the path of a file of an output sink on disk
+// Input parameters:
+//	sink: the output sink
+//	name: the name of the file within the sink
+// Return value: the path of the file
+inline string outputPath(const TOutputSink &sink, const string &name)
+{
+	return sink.directory + name;
+}
+
+// This function opens a file of an output sink for writing.
+// Input parameters:
+//	name: the name of the file within the sink
+//	mode: the mode to open the file with, if it is written to disk
+// Input/output parameters:
+//	sink: the output sink that receives the file when it is closed with <closeOutputFile>
+// Output parameters:
+//	file: the opened file; its contents are written to file.stream
+// Return value: 1, if the file could not be created; 0 otherwise
+int openOutputFile(TOutputSink &sink, const string &name, TOutputFile &file, ios_base::openmode mode = ios_base::out)
+{
+	file.sink = &sink;
+	file.name = name;
+	if (sink.inMemory)
+	{
+		file.buffer.str("");
+		file.stream = &file.buffer;
+		return 0;
+	}
+	file.file.open(outputPath(sink, name).c_str(), mode);
+	file.stream = &file.file;
+	return file.file.fail() ? 1 : 0;
+}
+
+// This function closes a file opened with <openOutputFile>. Files of sinks that keep the files in memory are handed over to the sink.
+// Nothing is done, if the file is not open.
+// Input/output parameters:
+//	file: the file to close
+// Return value: 1, if the file could not be written; 0 otherwise
+int closeOutputFile(TOutputFile &file)
+{
+	if (file.stream == NULL)
+		return 0;
+	bool failed = file.stream->fail();
+	if (file.sink->inMemory)
+	{
+		lock_guard< mutex > lock(file.sink->lock);
+		file.sink->files[file.name] = file.buffer.str();
+		file.buffer.str("");
+	}
+	else
+	{
+		file.file.close();
+		failed = failed || file.file.fail();
+	}
+	file.stream = NULL;
+	return failed ? 1 : 0;
+}
+
+// This function executes R scripts with a single invocation of Rscript.
+// Input parameters:
+//	scripts: the paths to the R scripts
+void runRScripts(const vector< string > &scripts)
+{
+	if (scripts.empty())
+		return;
+
+	// running the scripts via the source command is faster that running them directly
+	// the paths are quoted, since the output directory may contain any character
+	string RExpression;
+	for (unsigned int i = 0; i < scripts.size(); i++)
+		RExpression += "source(" + quoteRString(scripts[i]) + ");";
+	string RCommand = "Rscript -e " + quoteShellArgument(RExpression);
+	system(toCString(RCommand));
+}
+
+// This function uses Rscript to generate histogram plots.
+// Multiple plots are written to a single PDF.
+// For sinks that keep the files in memory, only the R script is generated, since Rscript cannot write to the sink.
+// Input parameters:
+//	fileName: the name of the R script and PDF file to be generated within the <sink>, without the file extension
+//	titles: the titles of all histogram plots
+//	histograms: a collection of histograms to plot
+// Output parameters:
+//	deferredScripts: if not NULL, the R script is not executed, but appended to this list,
+//	                 such that many scripts can be executed with a single invocation of Rscript (see <runRScripts>)
+// Input/output parameters:
+//	sink: the output sink to write the R script and the PDF file to
+void plotHistogram(TOutputSink &sink, const string &fileName, const vector< string > &titles, const THistograms &histograms, vector< string > *deferredScripts = NULL)
+{
+	// generate an R script that produces a histogram plot
+	TOutputFile rScriptFile;
+	if (openOutputFile(sink, fileName + ".R", rScriptFile) != 0)
+	{
+		cerr << "Failed to create R script file" << endl;
+		return;
+	}
+	ostream &rScript = *rScriptFile.stream;
+
+	rScript << "histograms = data.frame(" << endl; // store histograms in a data frame
+	rScript << "plotTitle = c("; // store plot titles in vector
+	for (unsigned int i = 0; i < titles.size(); i++)
+	{
+		// escape all single-quotes (') and escape slashes (\) in the title
+		string title = titles[i];
+		stringReplace(title, "\\", "\\\\");
+		stringReplace(title, "'", "\\'");
+		rScript << "'" << title << "'";
+
+		if (i < titles.size() - 1)
+			rScript << "," << endl; // separate titles by a comma, unless it is the last one
+	}
+	rScript << ")," << endl; // close vector of plot titles
+	for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+	{
+		// print one column in the data frame for every overlap
+		rScript << endl << "overlap_";
+		if (overlap < 0)
+			rScript << "minus_";
+		rScript << abs(overlap) << "=c(";
+
+		for (unsigned int i = 0; i < histograms.size(); i++)
+		{
+			if (i % 100 == 0)
+				rScript << endl; // insert a line-break every once in a while, because R cannot parse long lines
+			rScript << histograms[i][overlap-MIN_ARBITRARY_OVERLAP];
+			if (i < histograms.size() - 1)
+				rScript << ","; // separate histogram values by comma, unless it is the last one
+		}
+
+		rScript << ")" << endl; // close column of data frame
+		if (overlap < MAX_ARBITRARY_OVERLAP)
+			rScript << ","; // separate columns of data frame by comma, unless it is the last column
+	}
+	rScript << ")" << endl; // close data frame of histograms
+
+	rScript
+	 	<< "# convert absolute values to z-scores" << endl
+		<< "means <- apply(histograms[,!colnames(histograms) %in% c('plotTitle', 'overlap_" << PING_PONG_OVERLAP << "')], 1, mean)" << endl
+		<< "sds <- apply(histograms[,!colnames(histograms) %in% c('plotTitle', 'overlap_" << PING_PONG_OVERLAP << "')], 1, sd)" << endl
+		<< "sds <- ifelse(sds < " << MIN_STANDARD_DEVIATION << "," << MIN_STANDARD_DEVIATION << ", sds)" << endl
+		<< "for (column in colnames(histograms[,colnames(histograms) != 'plotTitle'])) {" << endl
+		<< "	histograms[,column] = (histograms[,column] - means) / sds" << endl
+		<< "}" << endl
+		<< "# save plots to a single PDF" << endl
+		<< "pdf(" << quoteRString(outputPath(sink, fileName + ".pdf")) << ", onefile=TRUE)" << endl
+		<< "par(font.lab=2, mar=c(5.1, 5.1, 5.1, 2.1))" << endl
+		<< "# draw a red bar for ping-pong signatures and a grey bar for arbitrary overlaps" << endl
+		<< "barColors <- ifelse(colnames(histograms[,colnames(histograms) != 'plotTitle']) != 'overlap_" << PING_PONG_OVERLAP << "', rgb(0.7,0.7,0.7), rgb(0.8,0.4,0.4))" << endl
+		<< "# every row of the data frame <histograms> is rendered as a barplot" << endl
+		<< "for (i in 1:nrow(histograms)) {" << endl
+		<< "	histogram <- histograms[i,]" << endl
+		<< "	plotTitle <- histogram$plotTitle" << endl
+		<< "	histogram <- c(t(histogram[, colnames(histogram) != 'plotTitle']))" << endl
+		<< "	plot(0, 0, xlim=c(0,length(histogram)), type='n', xlab='overlap', ylim=c(min(c(0, histogram)), max(histogram)), ylab='z-score', xaxt='n', main=plotTitle, cex.axis=0.75)" << endl
+		<< "	axis(1, at=1:length(histogram)-0.25, labels=" << MIN_ARBITRARY_OVERLAP << ":" << MAX_ARBITRARY_OVERLAP << ", cex.axis=0.75)" << endl
+		<< "	barplot(histogram, col=barColors, border=NA, axes=FALSE, add=TRUE, width=0.5, space=1)" << endl
+		<< "}" << endl
+		<< "garbage <- dev.off()" << endl;
+
+	// close R script
+	closeOutputFile(rScriptFile);
+
+	// execute R script with "Rscript"
+	if (sink.inMemory)
+		return;
+	if (deferredScripts != NULL)
+		deferredScripts->push_back(outputPath(sink, fileName + ".R"));
+	else
+		runRScripts(vector< string >(1, outputPath(sink, fileName + ".R")));
+}
+
+#ifdef PINGPONGPRO_BLOCK_READER
+#ifdef PINGPONGPRO_IO_URING
+// function to set up an io_uring instance for a <TBlockReader> using raw system calls (so that liburing is not needed)
+// Return value: false, if the kernel does not support io_uring; true otherwise
+bool setupIoUring(TBlockReader &reader)
+{
+	struct io_uring_params parameters;
+	memset(&parameters, 0, sizeof(parameters));
+	reader.ring = syscall(__NR_io_uring_setup, INPUT_BLOCKS_IN_FLIGHT, &parameters);
+	if (reader.ring < 0)
+		return false;
+
+	// map the submission and completion rings into memory
+	reader.submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned int);
+	reader.completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+	if (parameters.features & IORING_FEAT_SINGLE_MMAP)
+		reader.submissionRingSize = reader.completionRingSize = max(reader.submissionRingSize, reader.completionRingSize);
+	reader.submissionRing = mmap(NULL, reader.submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader.ring, IORING_OFF_SQ_RING);
+	if (reader.submissionRing == MAP_FAILED)
+	{
+		reader.submissionRing = NULL;
+		return false;
+	}
+	if (parameters.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		reader.completionRing = reader.submissionRing;
+	}
+	else
+	{
+		reader.completionRing = mmap(NULL, reader.completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader.ring, IORING_OFF_CQ_RING);
+		if (reader.completionRing == MAP_FAILED)
+		{
+			reader.completionRing = NULL;
+			return false;
+		}
+	}
+	reader.submissionEntriesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+	void *submissionEntries = mmap(NULL, reader.submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reader.ring, IORING_OFF_SQES);
+	if (submissionEntries == MAP_FAILED)
+		return false;
+	reader.submissionEntries = static_cast<struct io_uring_sqe *>(submissionEntries);
+
+	char *submissionRing = static_cast<char *>(reader.submissionRing);
+	reader.submissionTail = reinterpret_cast<unsigned int *>(submissionRing + parameters.sq_off.tail);
+	reader.submissionMask = reinterpret_cast<unsigned int *>(submissionRing + parameters.sq_off.ring_mask);
+	reader.submissionArray = reinterpret_cast<unsigned int *>(submissionRing + parameters.sq_off.array);
+	char *completionRing = static_cast<char *>(reader.completionRing);
+	reader.completionHead = reinterpret_cast<unsigned int *>(completionRing + parameters.cq_off.head);
+	reader.completionTail = reinterpret_cast<unsigned int *>(completionRing + parameters.cq_off.tail);
+	reader.completionMask = reinterpret_cast<unsigned int *>(completionRing + parameters.cq_off.ring_mask);
+	reader.completionEntries = reinterpret_cast<struct io_uring_cqe *>(completionRing + parameters.cq_off.cqes);
+
+	reader.vectors.resize(INPUT_BLOCKS_IN_FLIGHT);
+	for (unsigned int slot = 0; slot < INPUT_BLOCKS_IN_FLIGHT; slot++)
+	{
+		reader.vectors[slot].iov_base = &reader.buffers[slot][0];
+		reader.vectors[slot].iov_len = INPUT_BLOCK_SIZE;
+	}
+	return true;
+}
+
+// function to release the io_uring instance of a <TBlockReader>
+void closeIoUring(TBlockReader &reader)
+{
+	if (reader.submissionEntries != NULL)
+		munmap(reader.submissionEntries, reader.submissionEntriesSize);
+	if ((reader.completionRing != NULL) && (reader.completionRing != reader.submissionRing))
+		munmap(reader.completionRing, reader.completionRingSize);
+	if (reader.submissionRing != NULL)
+		munmap(reader.submissionRing, reader.submissionRingSize);
+	if (reader.ring >= 0)
+		close(reader.ring);
+	reader.submissionEntries = NULL;
+	reader.submissionRing = reader.completionRing = NULL;
+	reader.ring = -1;
+}
+
+// function to issue the read of a block via io_uring
+// Input parameters:
+//	block: the number of the block to read
+void submitBlockRead(TBlockReader &reader, uint64_t block)
+{
+	unsigned int slot = block % INPUT_BLOCKS_IN_FLIGHT;
+	reader.results[slot] = -1;
+	unsigned int tail = *reader.submissionTail;
+	unsigned int index = tail & *reader.submissionMask;
+	struct io_uring_sqe &entry = reader.submissionEntries[index];
+	memset(&entry, 0, sizeof(entry));
+	entry.opcode = IORING_OP_READV; // supported by all kernels with io_uring
+	entry.fd = reader.fileDescriptor;
+	entry.off = block * INPUT_BLOCK_SIZE;
+	entry.addr = reinterpret_cast<uint64_t>(&reader.vectors[slot]);
+	entry.len = 1;
+	entry.user_data = slot;
+	reader.submissionArray[index] = index;
+	__atomic_store_n(reader.submissionTail, tail + 1, __ATOMIC_RELEASE);
+	long submitted = syscall(__NR_io_uring_enter, reader.ring, 1, 0, 0, NULL, 0);
+	if (submitted < 0)
+		reader.failed = true;
+	else
+		reader.readsInFlight += submitted;
+}
+
+// function to wait for the completion of the read of a block via io_uring
+// Input parameters:
+//	slot: the buffer of the block
+void waitForBlockRead(TBlockReader &reader, unsigned int slot)
+{
+	while ((reader.results[slot] < 0) && !reader.failed)
+	{
+		unsigned int head = *reader.completionHead;
+		if (head == __atomic_load_n(reader.completionTail, __ATOMIC_ACQUIRE))
+		{
+			if ((syscall(__NR_io_uring_enter, reader.ring, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR))
+				reader.failed = true;
+			continue;
+		}
+		const struct io_uring_cqe &completion = reader.completionEntries[head & *reader.completionMask];
+		if (completion.res < 0)
+			reader.failed = true;
+		else
+			reader.results[completion.user_data] = completion.res;
+		reader.readsInFlight--;
+		__atomic_store_n(reader.completionHead, head + 1, __ATOMIC_RELEASE);
+	}
+}
+
+// function to wait for all reads submitted via io_uring, including those of blocks that will not be consumed anymore
+// Return value: false, if the completions could not be reaped, such that the kernel may still write to the buffers; true otherwise
+bool drainBlockReads(TBlockReader &reader)
+{
+	while (reader.readsInFlight > 0)
+	{
+		unsigned int head = *reader.completionHead;
+		if (head == __atomic_load_n(reader.completionTail, __ATOMIC_ACQUIRE))
+		{
+			if ((syscall(__NR_io_uring_enter, reader.ring, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR))
+				return false;
+			continue;
+		}
+		reader.readsInFlight--;
+		__atomic_store_n(reader.completionHead, head + 1, __ATOMIC_RELEASE);
+	}
+	return true;
+}
+#endif
+
+// function which is executed by the prefetching thread of a <TBlockReader>, if io_uring is not available
+// it reads the blocks of the file in order as long as there are free buffers
+void prefetchBlocks(TBlockReader *reader)
+{
+	for (uint64_t block = 0; block * INPUT_BLOCK_SIZE < reader->fileSize; block++)
+	{
+		unsigned int slot = block % INPUT_BLOCKS_IN_FLIGHT;
+		{
+			unique_lock< mutex > lock(reader->lock);
+			while ((block >= reader->blocksReleased + INPUT_BLOCKS_IN_FLIGHT) && !reader->stopping)
+				reader->blockReleased.wait(lock);
+			if (reader->stopping)
+				return;
+		}
+
+		// read the entire block, unless the end of the file is reached
+		// a read error or a file that shrinks while it is read must not hand out a short block, which would corrupt the BGZF stream
+		size_t expected = min(static_cast<uint64_t>(INPUT_BLOCK_SIZE), reader->fileSize - block * INPUT_BLOCK_SIZE);
+		size_t bytesRead = 0;
+		while (bytesRead < expected)
+		{
+			ssize_t bytes = pread(reader->fileDescriptor, &reader->buffers[slot][bytesRead], expected - bytesRead, block * INPUT_BLOCK_SIZE + bytesRead);
+			if ((bytes < 0) && (errno == EINTR))
+				continue;
+			if (bytes <= 0)
+				break;
+			bytesRead += bytes;
+		}
+
+		lock_guard< mutex > lock(reader->lock);
+		if (bytesRead < expected)
+			reader->failed = true;
+		reader->results[slot] = bytesRead;
+		reader->blockRead.notify_all();
+		if (reader->failed)
+			return;
+	}
+}
+
+// function to open a file for reading with a <TBlockReader>
+// Input parameters:
+//	fileName: the file to read
+//	counters: the counters to which the statistics about reading the file are added
+// Output parameters:
+//	reader: the reader of the file, which has started to read the first blocks
+// Return value: 1, if the file could not be opened; 0 otherwise
+int openBlockReader(const char *fileName, TBlockReader &reader, TInputCounters &counters)
+{
+	reader.fileDescriptor = open(fileName, O_RDONLY);
+	if (reader.fileDescriptor < 0)
+		return 1;
+	struct stat fileStats;
+	if (fstat(reader.fileDescriptor, &fileStats) != 0)
+		return 1;
+	reader.fileSize = fileStats.st_size;
+	posix_fadvise(reader.fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL); // let the kernel read ahead aggressively
+	reader.counters = &counters;
+	reader.buffers.assign(INPUT_BLOCKS_IN_FLIGHT, vector< char >(INPUT_BLOCK_SIZE));
+	reader.results.assign(INPUT_BLOCKS_IN_FLIGHT, -1);
+
+	#ifdef PINGPONGPRO_IO_URING
+	if (setupIoUring(reader))
+	{
+		counters.backend = "io_uring";
+		for (uint64_t block = 0; (block < INPUT_BLOCKS_IN_FLIGHT) && (block * INPUT_BLOCK_SIZE < reader.fileSize); block++)
+			submitBlockRead(reader, block);
+		return 0;
+	}
+	closeIoUring(reader); // io_uring is not supported by the kernel or forbidden, fall back to a thread
+	#endif
+
+	counters.backend = "threads";
+	reader.prefetcher = thread(prefetchBlocks, &reader);
+	return 0;
+}
+
+// function to get the next block of a file opened with <openBlockReader>
+// the data of the block remains valid until the next call of the function
+// Input/output parameters:
+//	reader: the reader of the file
+// Output parameters:
+//	data: the data of the block
+//	length: the size of the block
+// Return value: false, if the end of the file is reached or the file could not be read (then <reader.failed> is set); true otherwise
+bool readNextBlock(TBlockReader &reader, const char *&data, size_t &length)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	unsigned int slot = reader.blocksConsumed % INPUT_BLOCKS_IN_FLIGHT;
+
+	// the block handed out before is not needed anymore, so its buffer can be used to read ahead
+	if (reader.blocksConsumed > 0)
+	{
+		unsigned int previousSlot = (reader.blocksConsumed - 1) % INPUT_BLOCKS_IN_FLIGHT;
+		uint64_t nextBlock = reader.blocksConsumed - 1 + INPUT_BLOCKS_IN_FLIGHT;
+		#ifdef PINGPONGPRO_IO_URING
+		if (reader.ring >= 0)
+		{
+			reader.results[previousSlot] = -1;
+			reader.blocksReleased = reader.blocksConsumed;
+			if (nextBlock * INPUT_BLOCK_SIZE < reader.fileSize)
+				submitBlockRead(reader, nextBlock);
+		}
+		else
+		#endif
+		{
+			lock_guard< mutex > lock(reader.lock);
+			reader.results[previousSlot] = -1;
+			reader.blocksReleased = reader.blocksConsumed;
+			reader.blockReleased.notify_all();
+		}
+	}
+	if (reader.blocksConsumed * INPUT_BLOCK_SIZE >= reader.fileSize)
+		return false;
+
+	// wait for the block to be read
+	bool failed;
+	#ifdef PINGPONGPRO_IO_URING
+	if (reader.ring >= 0)
+	{
+		waitForBlockRead(reader, slot);
+
+		// complete short reads synchronously
+		uint64_t offset = reader.blocksConsumed * INPUT_BLOCK_SIZE;
+		size_t expected = min(static_cast<uint64_t>(INPUT_BLOCK_SIZE), reader.fileSize - offset);
+		while (!reader.failed && (static_cast<size_t>(reader.results[slot]) < expected))
+		{
+			ssize_t bytes = pread(reader.fileDescriptor, &reader.buffers[slot][reader.results[slot]], expected - reader.results[slot], offset + reader.results[slot]);
+			if ((bytes < 0) && (errno == EINTR))
+				continue;
+			if (bytes <= 0)
+				reader.failed = true;
+			else
+				reader.results[slot] += bytes;
+		}
+		failed = reader.failed;
+	}
+	else
+	#endif
+	{
+		unique_lock< mutex > lock(reader.lock);
+		while ((reader.results[slot] < 0) && !reader.failed)
+			reader.blockRead.wait(lock);
+		failed = reader.failed;
+	}
+	reader.counters->ioWaitSeconds += secondsSince(start);
+	if (failed)
+		return false;
+
+	data = &reader.buffers[slot][0];
+	length = reader.results[slot];
+	reader.counters->bytesRead += length;
+	reader.blocksConsumed++;
+	return true;
+}
+
+// function to close a file opened with <openBlockReader>
+void closeBlockReader(TBlockReader &reader)
+{
+	if (reader.prefetcher.joinable())
+	{
+		{
+			lock_guard< mutex > lock(reader.lock);
+			reader.stopping = true;
+			reader.blockReleased.notify_all();
+		}
+		reader.prefetcher.join();
+	}
+	#ifdef PINGPONGPRO_IO_URING
+	if (reader.ring >= 0)
+	{
+		// wait for reads in flight, also after a failure, since the kernel writes to the buffers
+		// if that is not possible, the buffers are leaked rather than released under the kernel's hands
+		if (!drainBlockReads(reader))
+		{
+			(new vector< vector< char > >())->swap(reader.buffers);
+			(new vector< struct iovec >())->swap(reader.vectors);
+		}
+		closeIoUring(reader);
+	}
+	#endif
+	if (reader.fileDescriptor >= 0)
+		close(reader.fileDescriptor);
+	reader.fileDescriptor = -1;
+}
+
+// function to check whether a file is compressed in BGZF format (which is used by BAM files)
+// Input parameters:
+//	fileName: the file to check
+// Return value: true, if the file starts with a BGZF block header; false otherwise
+bool isBgzfFile(const char *fileName)
+{
+	unsigned char header[16];
+	ifstream file(fileName, ios_base::in | ios_base::binary);
+	if (!file.read(reinterpret_cast<char *>(header), sizeof(header)))
+		return false;
+	return (header[0] == 31) && (header[1] == 139) && (header[2] == 8) && ((header[3] & 4) != 0) && (header[12] == 'B') && (header[13] == 'C');
+}
+
+// function to get the size of a BGZF block from its header
+// Input parameters:
+//	header: the first 18 bytes of the block
+// Return value: the size of the block including the header, 0 if the header is invalid
+inline size_t getBgzfBlockSize(const unsigned char *header)
+{
+	if ((header[0] != 31) || (header[1] != 139) || (header[2] != 8) || ((header[3] & 4) == 0) || (header[12] != 'B') || (header[13] != 'C'))
+		return 0;
+	return (header[16] | (header[17] << 8)) + 1;
+}
+
+// This function decompresses a batch of BGZF blocks.
+// It is executed by the decompression threads of a <TBgzfPipeline>.
+// Input parameters:
+//	batch: the number of the batch, which was added to <pipeline->compressedBatches>
+// Input/output parameters:
+//	pipeline: the decompressed data is added to <pipeline->decompressedBatches>
+void decompressBgzfBatch(TBgzfPipeline *pipeline, uint64_t batch)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	if (traceRecorder.enabled)
+	{
+		stringstream detail;
+		detail << "batch " << batch;
+		traceBegin("decompress BGZF blocks", detail.str());
+	}
+	string compressed, decompressed;
+	{
+		lock_guard< mutex > lock(pipeline->lock);
+		compressed.swap(pipeline->compressedBatches[batch]);
+		pipeline->compressedBatches.erase(batch);
+	}
+
+	bool failed = false;
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, -15) != Z_OK) // BGZF blocks hold raw deflate data
+		failed = true;
+	for (size_t offset = 0; (offset < compressed.size()) && !failed;)
+	{
+		const unsigned char *block = reinterpret_cast<const unsigned char *>(compressed.data() + offset);
+		size_t blockSize = getBgzfBlockSize(block);
+		size_t extraLength = block[10] | (block[11] << 8);
+		uint32_t uncompressedSize = block[blockSize-4] | (block[blockSize-3] << 8) | (block[blockSize-2] << 16) | (static_cast<uint32_t>(block[blockSize-1]) << 24);
+		if ((12 + extraLength + 8 > blockSize) || (uncompressedSize > 65536)) // a BGZF block holds at most 64 KiB of data
+		{
+			failed = true;
+			break;
+		}
+		size_t outputOffset = decompressed.size();
+		decompressed.resize(outputOffset + uncompressedSize);
+		inflateReset(&stream);
+		stream.next_in = const_cast<unsigned char *>(block + 12 + extraLength);
+		stream.avail_in = blockSize - 12 - extraLength - 8;
+		stream.next_out = reinterpret_cast<unsigned char *>(&decompressed[0] + outputOffset);
+		stream.avail_out = uncompressedSize;
+		int status = inflate(&stream, Z_FINISH);
+		if ((status != Z_STREAM_END) || (stream.total_out != uncompressedSize))
+			failed = true;
+		offset += blockSize;
+	}
+	inflateEnd(&stream);
+	traceEnd();
+
+	lock_guard< mutex > lock(pipeline->lock);
+	if (failed && !pipeline->failed)
+	{
+		pipeline->failed = true;
+		pipeline->error = "corrupt BGZF block";
+	}
+	pipeline->counters.bytesDecompressed += decompressed.size();
+	pipeline->counters.decompressionSeconds += secondsSince(start);
+	pipeline->decompressedBatches[batch].swap(decompressed);
+	pipeline->compressedSizes[batch] = compressed.size();
+	pipeline->batchDecompressed.notify_all();
+}
+
+// function to hand a batch of compressed BGZF blocks to the decompression threads of a <TBgzfPipeline>
+// the function waits, if too many batches are in flight
+// Input/output parameters:
+//	pipeline: the pipeline which decompresses the file
+//	batch: the batch to submit, which is empty afterwards
+// Return value: false, if the pipeline was stopped; true otherwise
+bool submitBgzfBatch(TBgzfPipeline *pipeline, string &batch)
+{
+	unique_lock< mutex > lock(pipeline->lock);
+	while (!pipeline->failed && (pipeline->batchesSubmitted >= pipeline->batchesConsumed + pipeline->maxBatchesInFlight))
+		pipeline->batchConsumed.wait(lock);
+	if (pipeline->failed)
+		return false;
+	pipeline->compressedBatches[pipeline->batchesSubmitted].swap(batch);
+	submitTask(pipeline->decompressors, bind(decompressBgzfBatch, pipeline, pipeline->batchesSubmitted));
+	pipeline->batchesSubmitted++;
+	batch.clear();
+	return true;
+}
+
+// This function is executed by the producer thread of a <TBgzfPipeline>.
+// It reads the file in large blocks, splits the data into BGZF blocks, and hands batches of them to the decompression threads.
+void produceBgzfBatches(TBgzfPipeline *pipeline)
+{
+	string pending; // data of BGZF blocks that are not yet complete
+	string batch;
+	const char *data;
+	size_t length;
+	bool endOfFile = false;
+	while (!endOfFile)
+	{
+		endOfFile = !readNextBlock(pipeline->reader, data, length);
+		if (!endOfFile)
+			pending.append(data, length);
+
+		// move all complete BGZF blocks to the batch
+		size_t offset = 0;
+		while (pending.size() - offset >= 18)
+		{
+			size_t blockSize = getBgzfBlockSize(reinterpret_cast<const unsigned char *>(pending.data() + offset));
+			if (blockSize < 26)
+			{
+				lock_guard< mutex > lock(pipeline->lock);
+				pipeline->failed = true;
+				pipeline->error = "invalid BGZF block header";
+				pipeline->batchDecompressed.notify_all();
+				return;
+			}
+			if (pending.size() - offset < blockSize)
+				break;
+			batch.append(pending, offset, blockSize);
+			offset += blockSize;
+			if ((batch.size() >= BGZF_BATCH_SIZE) && !submitBgzfBatch(pipeline, batch))
+				return;
+		}
+		pending.erase(0, offset);
+	}
+	if (!batch.empty() && !submitBgzfBatch(pipeline, batch))
+		return;
+
+	lock_guard< mutex > lock(pipeline->lock);
+	if (pipeline->reader.failed)
+	{
+		pipeline->failed = true;
+		pipeline->error = "read error";
+	}
+	else if (!pending.empty())
+	{
+		pipeline->failed = true;
+		pipeline->error = "file is truncated";
+	}
+	pipeline->inputComplete = true;
+	pipeline->batchDecompressed.notify_all();
+}
+
+// function to append the next batch of decompressed data of a <TBgzfPipeline> to a buffer
+// Input/output parameters:
+//	pipeline: the pipeline which decompresses the file
+//	buffer: the buffer to append the data to
+// Return value: false, if there is no more data or the pipeline failed; true otherwise
+bool appendBgzfBatch(TBgzfPipeline &pipeline, string &buffer)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	traceBegin("wait for BGZF blocks");
+	unique_lock< mutex > lock(pipeline.lock);
+	map< uint64_t, string >::iterator batch;
+	while (!pipeline.failed && ((batch = pipeline.decompressedBatches.find(pipeline.batchesConsumed)) == pipeline.decompressedBatches.end()) && !(pipeline.inputComplete && (pipeline.batchesConsumed == pipeline.batchesSubmitted)))
+		pipeline.batchDecompressed.wait(lock);
+	pipeline.counters.parserWaitSeconds += secondsSince(start);
+	traceEnd();
+	if (pipeline.failed || (batch == pipeline.decompressedBatches.end()))
+		return false;
+	buffer.append(batch->second);
+	pipeline.compressedBytesConsumed += pipeline.compressedSizes[batch->first];
+	pipeline.compressedSizes.erase(batch->first);
+	pipeline.decompressedBatches.erase(batch);
+	pipeline.batchesConsumed++;
+	pipeline.batchConsumed.notify_all();
+	return true;
+}
+
+// function to make sure that a buffer of decompressed data holds a given number of bytes after a given offset
+// the consumed data before the offset is discarded, before more data is taken from the pipeline
+// Input/output parameters:
+//	pipeline: the pipeline which decompresses the file
+//	buffer, offset: the buffer and the offset of the next unparsed byte
+// Input parameters:
+//	bytes: the number of bytes needed
+// Return value: false, if the file ends before; true otherwise
+bool ensureBgzfData(TBgzfPipeline &pipeline, string &buffer, size_t &offset, size_t bytes)
+{
+	while ((offset > buffer.size()) || (buffer.size() - offset < bytes))
+	{
+		// the offset may point beyond the end of the buffer, if data was skipped that has not been decompressed yet
+		size_t consumed = min(offset, buffer.size());
+		buffer.erase(0, consumed);
+		offset -= consumed;
+		if (!appendBgzfBatch(pipeline, buffer))
+			return false;
+	}
+	return true;
+}
+
+// functions to read little-endian integers from BAM records
+inline int32_t readInt32(const char *data)
+{
+	int32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+inline uint16_t readUInt16(const char *data)
+{
+	uint16_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+inline uint64_t readUInt64(const char *data)
+{
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+// function to get the base at a given position of the 4-bit encoded sequence of a BAM record
+inline char getBamBase(const char *sequence, int position)
+{
+	return "=ACMGRSVTWYHKDBN"[(static_cast<unsigned char>(sequence[position / 2]) >> ((position % 2 == 0) ? 4 : 0)) & 15];
+}
+
+// function to find the value of the NH tag of a BAM record
+// Input parameters:
+//	tags, tagsEnd: the optional fields of the BAM record
+// Output parameters:
+//	multiHits: the value of the NH tag, unchanged if there is none
+// Return value: false, if the fields are malformed; true otherwise
+bool findMultiHitsTag(const char *tags, const char *tagsEnd, unsigned int &multiHits)
+{
+	while (tags + 3 <= tagsEnd)
+	{
+		bool isNH = (tags[0] == 'N') && (tags[1] == 'H');
+		char type = tags[2];
+		const char *value = tags + 3;
+		size_t valueSize;
+		switch (type)
+		{
+			case 'A': case 'c': case 'C': valueSize = 1; break;
+			case 's': case 'S': valueSize = 2; break;
+			case 'i': case 'I': case 'f': valueSize = 4; break;
+			case 'Z': case 'H':
+			{
+				const char *valueEnd = static_cast<const char *>(memchr(value, '\0', tagsEnd - value));
+				if (valueEnd == NULL)
+					return false;
+				valueSize = valueEnd - value + 1;
+				break;
+			}
+			case 'B':
+			{
+				if (value + 5 > tagsEnd)
+					return false;
+				size_t elementSize = ((value[0] == 'c') || (value[0] == 'C')) ? 1 : ((value[0] == 's') || (value[0] == 'S')) ? 2 : 4;
+				valueSize = 5 + elementSize * static_cast<uint32_t>(readInt32(value + 1));
+				break;
+			}
+			default:
+				return false;
+		}
+		if (value + valueSize > tagsEnd)
+			return false;
+		if (isNH)
+		{
+			switch (type)
+			{
+				case 'c': multiHits = static_cast<signed char>(value[0]); break;
+				case 'C': multiHits = static_cast<unsigned char>(value[0]); break;
+				case 's': multiHits = static_cast<int16_t>(readUInt16(value)); break;
+				case 'S': multiHits = readUInt16(value); break;
+				case 'i': case 'I': multiHits = readInt32(value); break;
+			}
+			return true;
+		}
+		tags = value + valueSize;
+	}
+	return true;
+}
+
+// Function which finds stacks of reads in a BAM file, like <countReadsInBamFile>, but without SeqAn.
+// The file is read in large blocks ahead of time (see <readNextBlock>) and the BGZF blocks are decompressed by multiple threads,
+// while the calling thread parses the BAM records.
+// Input parameters:
+//	fileName: the BAM file from where to load the reads
+//	minAlignmentLength, maxAlignmentLength, countMultiHits: see <countReadsInBamFile>
+//	threads: the number of threads to decompress the file
+// Output parameters:
+//	readStacks: stacks of reads that were found by the function
+//	threePrimeStacks: if not NULL, stacks of the 3' ends of the reads (see <countAlignment>)
+//	bamNameStore: the names of the contigs from the header of the file
+//	totalReadCount: the total number of reads that were not discarded
+//	counters: statistics about reading the file
+// Input/output parameters:
+//	progress: the records are counted in the progress of reading the input files (see <updateIngestProgress>)
+// Return value: 1, if the file could not be read; 2, if the file is not a BAM file (e.g., a compressed SAM file); 0 otherwise
+int countReadsInBgzfFile(const char *fileName, TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, const unsigned int minAlignmentLength, const unsigned int maxAlignmentLength, TCountMultiHits countMultiHits, unsigned int threads, TNameStore &bamNameStore, double &totalReadCount, TInputCounters &counters, TIngestProgress &progress)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	TBgzfPipeline pipeline;
+	if (openBlockReader(fileName, pipeline.reader, pipeline.counters) != 0)
+	{
+		closeBlockReader(pipeline.reader);
+		cerr << "Failed to open input file: " << fileName << endl;
+		return 1;
+	}
+	pipeline.maxBatchesInFlight = 2 * threads + 2;
+	startThreadPool(pipeline.decompressors, threads);
+	thread producer(produceBgzfBatches, &pipeline);
+
+	int result = 0;
+	string buffer;
+	size_t offset = 0;
+
+	// parse header
+	if (!ensureBgzfData(pipeline, buffer, offset, 8) || (memcmp(buffer.data(), "BAM\1", 4) != 0))
+	{
+		result = 2;
+	}
+	else
+	{
+		int32_t headerTextLength = readInt32(buffer.data() + 4);
+		if ((headerTextLength < 0) || !ensureBgzfData(pipeline, buffer, offset, 8 + static_cast<size_t>(headerTextLength)))
+			result = 1;
+		else
+			offset += 8 + headerTextLength; // skip SAM header text
+		if ((result == 0) && !ensureBgzfData(pipeline, buffer, offset, 4))
+			result = 1;
+		int32_t contigCount = (result == 0) ? readInt32(buffer.data() + offset) : 0;
+		offset += 4;
+		TNameStore nameStore;
+		for (int32_t contig = 0; (contig < contigCount) && (result == 0); contig++)
+		{
+			if (!ensureBgzfData(pipeline, buffer, offset, 4) || (readInt32(buffer.data() + offset) < 0) || !ensureBgzfData(pipeline, buffer, offset, 8 + readInt32(buffer.data() + offset)))
+			{
+				result = 1;
+				break;
+			}
+			int32_t nameLength = readInt32(buffer.data() + offset);
+			appendValue(nameStore, CharString(string(buffer.data() + offset + 4, max(nameLength - 1, 0)))); // the name is terminated by NUL
+			offset += 8 + nameLength;
+		}
+		bamNameStore = nameStore;
+		progress.nameStore = &bamNameStore;
+	}
+
+	// parse records
+	while (result == 0)
+	{
+		if (!ensureBgzfData(pipeline, buffer, offset, 4))
+			break; // end of file
+		int32_t recordSize = readInt32(buffer.data() + offset);
+		if ((recordSize < 32) || !ensureBgzfData(pipeline, buffer, offset, 4 + recordSize))
+		{
+			result = 1;
+			break;
+		}
+		const char *record = buffer.data() + offset + 4;
+		const char *recordEnd = record + recordSize;
+		offset += 4 + recordSize;
+		counters.records++;
+
+		int32_t contig = readInt32(record);
+		int32_t position = readInt32(record + 4);
+		progress.bytesConsumed = pipeline.compressedBytesConsumed;
+		updateIngestProgress(progress, contig);
+		if ((contig < 0) || (position == -1))
+		{
+			progress.metrics.unmapped++;
+			continue; // skip unmapped reads (like <countReadsInBamFile>, other negative positions are kept)
+		}
+		unsigned int nameLength = static_cast<unsigned char>(record[8]);
+		unsigned int cigarLength = readUInt16(record + 12);
+		uint16_t flag = readUInt16(record + 14);
+		int32_t sequenceLength = readInt32(record + 16);
+		const char *name = record + 32;
+		const char *cigar = name + nameLength;
+		const char *sequence = cigar + 4 * cigarLength;
+		const char *tags = sequence + (sequenceLength + 1) / 2 + sequenceLength;
+		if ((nameLength == 0) || (sequenceLength < 0) || (tags > recordEnd) || (name[nameLength-1] != '\0') || (contig >= static_cast<int32_t>(length(bamNameStore))))
+		{
+			result = 1;
+			break;
+		}
+
+		TAlignment alignment;
+		alignment.contig = contig;
+		alignment.position = position;
+		alignment.reverse = (flag & 16) != 0;
+
+		// calculate length of alignment using CIGAR string
+		for (unsigned int cigarIndex = 0; cigarIndex < cigarLength; cigarIndex++)
+		{
+			uint32_t operation = static_cast<uint32_t>(readInt32(cigar + 4 * cigarIndex));
+			switch (operation & 15)
+			{
+				case 0: case 2: case 3: case 7: case 8: // M, D, N, =, X indicate alignment
+					alignment.alignmentLength += operation >> 4;
+			}
+		}
+		progress.metrics.alignmentLengths[min(alignment.alignmentLength, METRICS_LENGTH_BINS - 1)]++;
+		if ((alignment.alignmentLength < minAlignmentLength) || (alignment.alignmentLength > maxAlignmentLength))
+		{
+			progress.metrics.filteredByLength++;
+			continue;
+		}
+
+		alignment.reads = parseCollapsedReadCount(name);
+		if (!findMultiHitsTag(tags, recordEnd, alignment.multiHits) && (countMultiHits != multiHitsUnique)) // the NH tag is also read with -m unique for the ingestion metrics
+		{
+			result = 1;
+			break;
+		}
+
+		// check if base at position 10 is adenine (on the - strand, we check for uracil, because reads are stored as the complement)
+		int clippedBasesAt5PrimeEnd = 0;
+		bool clippedAt3PrimeEnd;
+		if (alignment.reverse)
+		{
+			uint32_t lastOperation = (cigarLength > 1) ? static_cast<uint32_t>(readInt32(cigar + 4 * (cigarLength - 1))) : 0;
+			if ((lastOperation & 15) == 4) // S
+				clippedBasesAt5PrimeEnd = lastOperation >> 4;
+			clippedAt3PrimeEnd = (cigarLength > 1) && ((readInt32(cigar) & 15) == 4);
+			int basePosition = sequenceLength - clippedBasesAt5PrimeEnd - 1 - 9;
+			alignment.AAtPosition10 = (basePosition >= 0) && (basePosition < sequenceLength) && (getBamBase(sequence, basePosition) == 'T');
+		}
+		else
+		{
+			uint32_t firstOperation = (cigarLength > 0) ? static_cast<uint32_t>(readInt32(cigar)) : 0;
+			if ((firstOperation & 15) == 4) // S
+				clippedBasesAt5PrimeEnd = firstOperation >> 4;
+			clippedAt3PrimeEnd = (cigarLength > 1) && ((readInt32(cigar + 4 * (cigarLength - 1)) & 15) == 4);
+			int basePosition = clippedBasesAt5PrimeEnd + 9;
+			alignment.AAtPosition10 = (basePosition < sequenceLength) && (getBamBase(sequence, basePosition) == 'A');
+		}
+
+		bool kept = countAlignment(alignment, readStacks, threePrimeStacks, minAlignmentLength, maxAlignmentLength, countMultiHits, totalReadCount);
+		countIngestedAlignment(progress.metrics, alignment, clippedBasesAt5PrimeEnd > 0, clippedAt3PrimeEnd, kept);
+	}
+
+	// stop the pipeline
+	string error;
+	{
+		lock_guard< mutex > lock(pipeline.lock);
+		if (pipeline.failed)
+			error = pipeline.error;
+		pipeline.failed = true; // stops the producer, if the parser quit early
+		pipeline.batchConsumed.notify_all();
+	}
+	producer.join();
+	stopThreadPool(pipeline.decompressors);
+	closeBlockReader(pipeline.reader);
+
+	if (!error.empty())
+	{
+		cerr << "Failed to read input file " << fileName << ": " << error << endl;
+		result = 1;
+	}
+	else if (result == 1)
+	{
+		cerr << "Failed to read record" << endl;
+	}
+
+	counters.backend = pipeline.counters.backend;
+	counters.bytesRead += pipeline.counters.bytesRead;
+	counters.ioWaitSeconds += pipeline.counters.ioWaitSeconds;
+	counters.bytesDecompressed += pipeline.counters.bytesDecompressed;
+	counters.decompressionSeconds += pipeline.counters.decompressionSeconds;
+	counters.parserWaitSeconds += pipeline.counters.parserWaitSeconds;
+	counters.seconds += secondsSince(start);
+	return result;
+}
+
+// function to print the statistics gathered by <countReadsInBgzfFile> to stderr, if the verbosity level is >= INFO
+// the stage that kept the parser waiting is reported as the bottleneck
+void printInputCounters(const TInputCounters &counters, unsigned int verbosity)
+{
+	if (verbosity < 3)
+		return;
+	const char *bottleneck = "parsing"; // the parser rarely waited for data
+	if (counters.parserWaitSeconds > 0.25 * counters.seconds)
+		bottleneck = (counters.ioWaitSeconds > counters.parserWaitSeconds / 2) ? "I/O" : "decompression";
+	cerr << fixed << setprecision(2)
+	     << "    read " << (counters.bytesRead / 1048576.0) << " MB via " << counters.backend
+	     << " (" << ((counters.seconds > 0) ? counters.bytesRead / 1048576.0 / counters.seconds : 0) << " MB/s), "
+	     << "decompressed " << (counters.bytesDecompressed / 1048576.0) << " MB, " << counters.records << " records; "
+	     << "I/O wait " << counters.ioWaitSeconds << " s, decompression " << counters.decompressionSeconds << " s, parser wait " << counters.parserWaitSeconds << " s; "
+	     << "limited by " << bottleneck << endl;
+	cerr.unsetf(ios_base::floatfield);
+	cerr << setprecision(6);
+}
+#endif
+
+// function to format a chunk of lines of several output files
+// Input parameters:
+//	chunk: the number of the chunk to format
+// Output parameters:
+//	streams: one stream for every output file, to which the lines of the chunk are written
+typedef function< void(unsigned int chunk, vector< stringstream > &streams) > TFormatChunk;
+
+// function to format a chunk of lines and to hand it over to the writer threads (see <writeChunksInParallel>)
+// it is executed by the worker threads of a <TThreadPool>
+void formatChunk(const TFormatChunk *format, unsigned int chunk, TOrderedChunks *chunks)
+{
+	if (traceRecorder.enabled)
+	{
+		stringstream detail;
+		detail << "chunk " << chunk;
+		traceBegin("format output", detail.str());
+	}
+	vector< stringstream > streams(chunks->files.size());
+	for (unsigned int file = 0; file < streams.size(); file++)
+	{
+		streams[file].flags(chunks->files[file]->flags());
+		streams[file].precision(chunks->files[file]->precision());
+	}
+	(*format)(chunk, streams);
+	traceEnd();
+
+	lock_guard< mutex > lock(chunks->lock);
+	for (unsigned int file = 0; file < streams.size(); file++)
+		chunks->chunks[file][chunk] = streams[file].str();
+	chunks->formatted[chunk] = true;
+	chunks->chunkFormatted.notify_all();
+}
+
+// function which is executed by the writer thread of an output file
+// it appends the formatted chunks to the file in the order of their numbers
+// Input parameters:
+//	file: the number of the output file
+// Input/output parameters:
+//	chunks: the chunks that are formatted by <formatChunk>
+void writeChunksInOrder(unsigned int file, TOrderedChunks *chunks)
+{
+	for (unsigned int chunk = 0; chunk < chunks->formatted.size(); chunk++)
+	{
+		string text;
+		{
+			unique_lock< mutex > lock(chunks->lock);
+			while (!chunks->formatted[chunk])
+				chunks->chunkFormatted.wait(lock);
+			text.swap(chunks->chunks[file][chunk]); // free the memory of the chunk as soon as it is written
+		}
+		if (traceRecorder.enabled)
+		{
+			stringstream detail;
+			detail << "chunk " << chunk << ", " << text.size() << " bytes";
+			traceBegin("write output", detail.str());
+		}
+		chunks->files[file]->write(text.data(), text.size());
+		traceEnd();
+		{
+			lock_guard< mutex > lock(chunks->lock);
+			chunks->written[file] = chunk + 1;
+			chunks->chunkWritten.notify_all();
+		}
+	}
+}
+
+// This function writes lines to several output files, whereby the lines are formatted in chunks by multiple threads.
+// Every file has a dedicated writer thread, which appends the chunks in the order of their numbers, such that the
+// contents of the files are identical to those written by a single thread. To limit memory consumption, chunks
+// are only formatted, if the writer threads are at most a few chunks behind.
+// Input parameters:
+//	chunkCount: the number of chunks
+//	format: the function that formats a given chunk
+//	threads: the number of threads to format chunks; if less than 2, the chunks are formatted and written by the calling thread
+// Input/output parameters:
+//	files: the output files; the formatting flags of the files are applied to the chunks
+void writeChunksInParallel(const vector< ostream * > &files, unsigned int chunkCount, const TFormatChunk &format, unsigned int threads)
+{
+	if (threads < 2)
+	{
+		for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+		{
+			vector< stringstream > streams(files.size());
+			for (unsigned int file = 0; file < streams.size(); file++)
+			{
+				streams[file].flags(files[file]->flags());
+				streams[file].precision(files[file]->precision());
+			}
+			format(chunk, streams);
+			for (unsigned int file = 0; file < streams.size(); file++)
+			{
+				string text = streams[file].str();
+				files[file]->write(text.data(), text.size());
+			}
+		}
+		return;
+	}
+
+	TOrderedChunks chunks(files, chunkCount);
+	vector< thread > writers;
+	for (unsigned int file = 0; file < files.size(); file++)
+		writers.push_back(thread(writeChunksInOrder, file, &chunks));
+
+	TThreadPool pool;
+	startThreadPool(pool, threads);
+	for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		// wait until the slowest writer has caught up
+		{
+			unique_lock< mutex > lock(chunks.lock);
+			while (chunk >= *min_element(chunks.written.begin(), chunks.written.end()) + 4 * threads)
+				chunks.chunkWritten.wait(lock);
+		}
+		submitTask(pool, bind(formatChunk, &format, chunk, &chunks));
+	}
+	waitForTasks(pool);
+	stopThreadPool(pool);
+	for (vector< thread >::iterator writer = writers.begin(); writer != writers.end(); ++writer)
+		writer->join();
+}
+
+// type to refer to the ping-pong signatures selected for the output by <selectPingPongSignatures>
+typedef vector< TPingPongSignaturesPerContig::const_iterator > TSelectedSignatures;
+
+// Function to sort ping-pong signatures by descending score, such that the strongest signatures come first.
+// Signatures with equal scores are sorted by position, such that the selection of <selectPingPongSignatures> is deterministic.
+struct TCompareSignaturesByScore
+{
+	const TFDRTable &fdrTable;
+
+	TCompareSignaturesByScore(const TFDRTable &fdrTable):
+		fdrTable(fdrTable)
+	{
+	}
+
+	inline float score(const TPingPongSignature &pingPongSignature) const
+	{
+		return signatureScore(pingPongSignature.readsOnPlusStrand, pingPongSignature.readsOnMinusStrand, getFDR(fdrTable, PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP, pingPongSignature));
+	}
+
+	inline bool operator()(const TPingPongSignaturesPerContig::const_iterator &signature1, const TPingPongSignaturesPerContig::const_iterator &signature2) const
+	{
+		float score1 = score(*signature1);
+		float score2 = score(*signature2);
+		if (score1 != score2)
+			return score1 > score2;
+		else
+			return signature1->position < signature2->position;
+	}
+};
+
+// function to sort ping-pong signatures by position
+struct TCompareSignaturesByPosition
+{
+	inline bool operator()(const TPingPongSignaturesPerContig::const_iterator &signature1, const TPingPongSignaturesPerContig::const_iterator &signature2) const
+	{
+		return signature1->position < signature2->position;
+	}
+};
+
+// This function selects the ping-pong signatures of a contig which are written to the output.
+// Signatures which do not pass the filters are skipped before they are formatted.
+// Input parameters:
+//	pingPongSignaturesPerContig: the ping-pong signatures of the contig sorted by position
+//	fdrTable: the FDR of every class of signatures (see <getFDR>)
+//	minStackHeight: ping-pong signatures with a smaller stack height than this are omitted
+//	maxFDR: ping-pong signatures with a higher FDR than this are omitted
+//	topK: if greater than 0, only this many signatures with the highest scores are selected
+// Output parameters:
+//	selectedSignatures: the selected signatures are appended in the order of their positions
+void selectPingPongSignatures(const TPingPongSignaturesPerContig &pingPongSignaturesPerContig, const TFDRTable &fdrTable, unsigned int minStackHeight, float maxFDR, unsigned int topK, TSelectedSignatures &selectedSignatures)
+{
+	TSelectedSignatures::size_type first = selectedSignatures.size();
+	for (TPingPongSignaturesPerContig::const_iterator pingPongSignature = pingPongSignaturesPerContig.begin(); pingPongSignature != pingPongSignaturesPerContig.end(); ++pingPongSignature)
+		if ((pingPongSignature->readsOnPlusStrand >= minStackHeight) && (pingPongSignature->readsOnMinusStrand >= minStackHeight) && (getFDR(fdrTable, PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP, *pingPongSignature) <= maxFDR))
+			selectedSignatures.push_back(pingPongSignature);
+
+	// keep only the strongest signatures, but restore the order by position
+	if ((topK > 0) && (selectedSignatures.size() - first > topK))
+	{
+		nth_element(selectedSignatures.begin() + first, selectedSignatures.begin() + first + topK, selectedSignatures.end(), TCompareSignaturesByScore(fdrTable));
+		selectedSignatures.resize(first + topK);
+		sort(selectedSignatures.begin() + first, selectedSignatures.end(), TCompareSignaturesByPosition());
+	}
+}
+
+// function to format a chunk of ping-pong signatures for <writePingPongSignaturesToFile>
+// Input parameters:
+//	signatureChunks: the signatures of every chunk
+//	selectedSignatures: the signatures to write as selected by <selectPingPongSignatures>
+//	fdrTable: the FDR of every class of signatures (see <getFDR>)
+//	bamNameStore: mapping of numeric contig IDs to human-readable names
+//	browserTracks: if set to true, then lines for the bedGraph files are generated in addition to the TSV file
+//	chunk: the number of the chunk to format
+// Output parameters:
+//	streams: the streams for the TSV file and the bedGraph files of stacks on the + strand, stacks on the - strand and scores
+void formatPingPongSignatures(const vector< TSignatureChunk > *signatureChunks, const TSelectedSignatures *selectedSignatures, const TFDRTable *fdrTable, const TNameStore *bamNameStore, bool browserTracks, unsigned int chunk, vector< stringstream > &streams)
+{
+	const TSignatureChunk &signatureChunk = (*signatureChunks)[chunk];
+	const CharString &contig = (*bamNameStore)[signatureChunk.contig];
+	for (unsigned int signature = signatureChunk.begin; signature < signatureChunk.end; signature++)
+	{
+		TPingPongSignaturesPerContig::const_iterator pingPongSignature = (*selectedSignatures)[signature];
+		float fdr = getFDR(*fdrTable, PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP, *pingPongSignature);
+		streams[0]
+			<< contig << '\t'
+			<< pingPongSignature->position << '\t'
+			<< fdr << '\t'
+			<< pingPongSignature->readsOnPlusStrand << '\t'
+			<< pingPongSignature->readsOnMinusStrand << '\n';
+		if (browserTracks)
+		{
+			streams[1]
+				<< contig << '\t'
+				<< pingPongSignature->position << '\t'
+				<< (pingPongSignature->position+1) << '\t'
+				<< pingPongSignature->readsOnPlusStrand << '\n';
+			streams[2]
+				<< contig << '\t'
+				<< pingPongSignature->position << '\t'
+				<< (pingPongSignature->position+1) << '\t'
+				<< pingPongSignature->readsOnMinusStrand << '\n';
+			streams[3]
+				<< contig << '\t'
+				<< pingPongSignature->position << '\t'
+				<< (pingPongSignature->position+1) << '\t'
+				<< (1-fdr) << '\n';
+		}
+	}
+}
+
+// function to write ping-pong signatures found by the function <countStacksByGroup> to a TSV file
+// Input parameters:
+//	pingPongSignaturesPerGenome: the ping-pong signatures to write to a file as found by the function <countStacksByGroup>
+//	fdrTable: the FDR of every class of signatures as calculated by the function <buildFDRTable>
+//	bamNameStore: mapping of numeric contig IDs to human-readable names
+//	minStackHeight: ping-pong signatures with a smaller stack height than this are omitted from the output
+//	maxFDR: ping-pong signatures with a higher FDR than this are omitted from the output
+//	topK: if greater than 0, only this many of the strongest ping-pong signatures of every contig are written
+//	browserTracks: if set to true, then a bedGraph file is generated in addition to the TSV file
+//	threads: the number of threads to format the lines of the files (see <writeChunksInParallel>)
+// Input/output parameters:
+//	sink: the output sink to write the files to
+void writePingPongSignaturesToFile(TPingPongSignaturesPerGenome &pingPongSignaturesPerGenome, const TFDRTable &fdrTable, const TNameStore &bamNameStore, unsigned int minStackHeight, float maxFDR, unsigned int topK, bool browserTracks, TOutputSink &sink, unsigned int threads)
+{
+	// open files to write ping-pong signatures to
+	TOutputFile signaturesTSV;
+	TOutputFile readsOnPlusStrandBedGraph;
+	TOutputFile readsOnMinusStrandBedGraph;
+	TOutputFile scoresBedGraph;
+	openOutputFile(sink, "ping-pong_signatures.tsv", signaturesTSV);
+	if (browserTracks)
+	{
+		if ((openOutputFile(sink, "ping-pong_signatures_read_stacks_on_plus_strand.bedGraph", readsOnPlusStrandBedGraph) != 0) ||
+		    (openOutputFile(sink, "ping-pong_signatures_read_stacks_on_minus_strand.bedGraph", readsOnMinusStrandBedGraph) != 0) ||
+		    (openOutputFile(sink, "ping-pong_signatures_scores.bedGraph", scoresBedGraph) != 0))
+		{
+			cerr << "Failed to create browser track files for ping-pong signatures" << endl;
+			return;
+		}
+	}
+
+	// use scientific formatting for floating point numbers
+	signaturesTSV.stream->setf(ios::scientific, ios::floatfield);
+	if (browserTracks)
+	{
+		readsOnPlusStrandBedGraph.stream->setf(ios::scientific, ios::floatfield);
+		readsOnMinusStrandBedGraph.stream->setf(ios::scientific, ios::floatfield);
+		scoresBedGraph.stream->setf(ios::scientific, ios::floatfield);
+	}
+
+	// write track headers
+	*signaturesTSV.stream << "contig\tposition\tFDR\tstackHeightOnPlusStrand\tstackHeightOnMinusStrand" << endl;
+	if (browserTracks)
+	{
+		*readsOnPlusStrandBedGraph.stream << "track type=bedGraph name=\"read stacks on + strand\" description=\"height of read stacks on the + strand\" visibility=full" << endl;
+		*readsOnMinusStrandBedGraph.stream << "track type=bedGraph name=\"read stacks on - strand\" description=\"height of read stacks on the - strand\" visibility=full" << endl;
+		*scoresBedGraph.stream << "track type=bedGraph name=\"scores\" description=\"scores of ping-pong signatures (1 - FDR)\" visibility=full viewLimits=0.0:1.0 autoScale=off" << endl;
+	}
+
+	// select the signatures to write and split them into chunks of at most <OUTPUT_CHUNK_SIZE> signatures of a single contig
+	TSelectedSignatures selectedSignatures;
+	vector< TSignatureChunk > signatureChunks;
+	for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesPerGenome.begin(); contig != pingPongSignaturesPerGenome.end(); ++contig)
+	{
+		unsigned int begin = selectedSignatures.size();
+		selectPingPongSignatures(contig->second, fdrTable, minStackHeight, maxFDR, topK, selectedSignatures);
+		for (unsigned int signature = begin; signature < selectedSignatures.size(); signature += OUTPUT_CHUNK_SIZE)
+		{
+			TSignatureChunk signatureChunk = { contig->first, signature, min(signature + OUTPUT_CHUNK_SIZE, static_cast<unsigned int>(selectedSignatures.size())) };
+			signatureChunks.push_back(signatureChunk);
+		}
+	}
+
+	// write a line for each ping-pong signature
+	vector< ostream * > files(1, signaturesTSV.stream);
+	if (browserTracks)
+	{
+		files.push_back(readsOnPlusStrandBedGraph.stream);
+		files.push_back(readsOnMinusStrandBedGraph.stream);
+		files.push_back(scoresBedGraph.stream);
+	}
+	writeChunksInParallel(files, signatureChunks.size(), bind(formatPingPongSignatures, &signatureChunks, &selectedSignatures, &fdrTable, &bamNameStore, browserTracks, placeholders::_1, placeholders::_2), threads);
+
+	// close files
+	closeOutputFile(signaturesTSV);
+	closeOutputFile(readsOnPlusStrandBedGraph);
+	closeOutputFile(readsOnMinusStrandBedGraph);
+	closeOutputFile(scoresBedGraph);
+}
+
+// generate plots that illustrate the difference in stack counts by overlap
+// Input parameters:
+//	groupedStackCountsByOverlap: grouped stack counts as processed by the function <collapseBins>
+// Input/output parameters:
+//	sink: the output sink to write the plots to
+// Output parameters:
+//	deferredScripts: if not NULL, the R script is not executed, but appended to this list (see <plotHistogram>)
+void generateGroupedStackCountsPlot(TGroupedStackCountsByOverlap &groupedStackCountsByOverlap, TOutputSink &sink, vector< string > *deferredScripts = NULL)
+{
+	// find out in how many bins the stacks were grouped,
+	// because we need to generate a histogram for every bin
+	int binCount =
+		groupedStackCountsByOverlap.begin()->size() *
+		groupedStackCountsByOverlap.begin()->begin()->size() *
+		groupedStackCountsByOverlap.begin()->begin()->begin()->size();
+	THistograms histograms(binCount);
+	vector< string > plotTitles(binCount);
+
+	// collect histogram values and generate plot names
+	unsigned int x = 0;
+	stringstream ss;
+	for (int i = groupedStackCountsByOverlap.begin()->size() - 1; i >= 0; i--)
+		for (unsigned int j = 0; j < (*groupedStackCountsByOverlap.begin())[i].size(); j++)
+			for (unsigned int k = 0; k < (*groupedStackCountsByOverlap.begin())[i][j].size(); k++)
+			{
+				histograms[x].resize(groupedStackCountsByOverlap.size());
+				for (unsigned int overlap = 0; overlap < groupedStackCountsByOverlap.size(); overlap++)
+				{
+					histograms[x][overlap] = groupedStackCountsByOverlap[overlap][i][j][k];
+
+					ss << "z-scores of signatures with the following properties:" << endl;
+					ss << "stack height score of " << (groupedStackCountsByOverlap.begin()->size() - 1 - i) << endl;
+					if (j != HAS_BASE_BIAS)
+						ss << "no ";
+					ss << "adenine at position 10" << endl;
+					ss << "stack height " << ((k == IS_ABOVE_COVERAGE) ? "above" : "below") << " the local coverage";
+					plotTitles[x] = ss.str();
+					ss.str("");
+				}
+				x++;
+			}
+
+	// render histograms
+	plotHistogram(sink, "ping-pong_signatures_z-scores", plotTitles, histograms, deferredScripts);
+}
+
+// type to refer to a sequence of characters within a larger buffer (e.g., a field of a memory-mapped file) without copying it
+struct TStringView
+{
+	const char *characters;
+	size_t length;
+
+	TStringView(const char *characters = NULL, size_t length = 0):
+		characters(characters), length(length)
+	{
+	}
+};
+
+// function to compare a <TStringView> to a string
+inline bool operator==(const TStringView &view, const char *characters)
+{
+	return (strlen(characters) == view.length) && (strncmp(view.characters, characters, view.length) == 0);
+}
+
+// function to calculate a hash value of a string (FNV-1a)
+// Input parameters:
+//	characters: the string to calculate the hash value of
+//	length: the number of characters of the string
+// Return value: the hash value
+inline unsigned int hashString(const char *characters, size_t length)
+{
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ static_cast<unsigned char>(characters[i])) * 16777619u;
+	return hash;
+}
+
+// functions to access the strings of a <TStringArena>
+// Input parameters:
+//	arena: the arena holding the string
+//	id: the ID of the string as returned by <internString>
+inline unsigned int countInternedStrings(const TStringArena &arena)
+{
+	return arena.offsets.size() - 1;
+}
+inline const char *internedString(const TStringArena &arena, unsigned int id)
+{
+	return arena.characters.data() + arena.offsets[id];
+}
+inline size_t internedStringLength(const TStringArena &arena, unsigned int id)
+{
+	return arena.offsets[id+1] - arena.offsets[id];
+}
+inline string getInternedString(const TStringArena &arena, unsigned int id)
+{
+	return string(internedString(arena, id), internedStringLength(arena, id));
+}
+inline ostream &writeInternedString(ostream &stream, const TStringArena &arena, unsigned int id)
+{
+	return stream.write(internedString(arena, id), internedStringLength(arena, id));
+}
+
+// Function to store a string in a <TStringArena>, unless the arena already contains the string.
+// Input parameters:
+//	characters: the string to store (need not be null-terminated)
+//	length: the number of characters of the string
+// Input/output parameters:
+//	arena: the arena to add the string to
+// Return value: the ID of the string in the arena
+unsigned int internString(TStringArena &arena, const char *characters, size_t length)
+{
+	// look for the string in the hash table
+	unsigned int mask = arena.hashTable.size() - 1;
+	unsigned int slot = hashString(characters, length) & mask;
+	while (arena.hashTable[slot] != 0)
+	{
+		unsigned int id = arena.hashTable[slot] - 1;
+		if ((internedStringLength(arena, id) == length) && (arena.characters.compare(arena.offsets[id], length, characters, length) == 0))
+			return id; // the string has been interned before
+		slot = (slot + 1) & mask;
+	}
+
+	// the string is new => append it to the arena
+	unsigned int id = countInternedStrings(arena);
+	arena.characters.append(characters, length);
+	arena.offsets.push_back(arena.characters.size());
+	arena.hashTable[slot] = id + 1;
+
+	// keep the hash table at most half full, so that probing stays short
+	if (2 * countInternedStrings(arena) > arena.hashTable.size())
+	{
+		arena.hashTable.assign(2 * arena.hashTable.size(), 0);
+		mask = arena.hashTable.size() - 1;
+		for (unsigned int i = 0; i < countInternedStrings(arena); i++)
+		{
+			slot = hashString(internedString(arena, i), internedStringLength(arena, i)) & mask;
+			while (arena.hashTable[slot] != 0)
+				slot = (slot + 1) & mask;
+			arena.hashTable[slot] = i + 1;
+		}
+	}
+
+	return id;
+}
+inline unsigned int internString(TStringArena &arena, const string &characters)
+{
+	return internString(arena, characters.data(), characters.size());
+}
+
+// function to add a transposon to the end of a <TTransposonTable>
+// Input parameters:
+//	identifier: the name of the transposon
+//	family: the name of the family that the transposon belongs to
+//	contig, strand, start, end: the genomic region of the transposon
+// Input/output parameters:
+//	transposons: the table to add the transposon to
+void appendTransposon(TTransposonTable &transposons, const TStringView &identifier, const TStringView &family, unsigned int contig, unsigned int strand, unsigned int start, unsigned int end)
+{
+	transposons.identifier.push_back(internString(transposons.identifiers, identifier.characters, identifier.length));
+	transposons.family.push_back(internString(transposons.families, family.characters, family.length));
+	transposons.contig.push_back(contig);
+	transposons.strand.push_back(strand);
+	transposons.start.push_back(start);
+	transposons.end.push_back(end);
+}
+
+// Function to sort a list of row numbers of a <TTransposonTable> by genomic position.
+// The function is used by stable_sort to compare which of two transposons comes first.
+struct TCompareTransposonsByPosition
+{
+	const TTransposonTable &transposons;
+
+	TCompareTransposonsByPosition(const TTransposonTable &transposons):
+		transposons(transposons)
+	{
+	}
+
+	inline bool operator()(unsigned int row1, unsigned int row2) const
+	{
+		if (transposons.contig[row1] != transposons.contig[row2])
+			return transposons.contig[row1] < transposons.contig[row2];
+		else if (transposons.start[row1] != transposons.start[row2])
+			return transposons.start[row1] < transposons.start[row2];
+		else
+			return transposons.end[row1] < transposons.end[row2];
+	}
+};
+
+// function to rearrange the elements of a column of a table according to a permutation of row numbers
+// Input parameters:
+//	permutation: the i-th element holds the row number that shall become the i-th row
+// Input/output parameters:
+//	column: the column to rearrange
+template <typename TValue>
+void permuteColumn(vector< TValue > &column, const vector< unsigned int > &permutation)
+{
+	vector< TValue > permuted(column.size());
+	for (unsigned int row = 0; row < permutation.size(); row++)
+		permuted[row] = column[permutation[row]];
+	column.swap(permuted);
+}
+
+// This function sorts transposons by genomic position and determines which rows belong to which contig.
+// Only the row numbers are sorted. Afterwards, every column is rearranged in a single pass.
+// Input/output parameters:
+//	transposons: the transposons to sort
+void sortTransposonTable(TTransposonTable &transposons)
+{
+	vector< unsigned int > permutation(transposons.start.size());
+	for (unsigned int row = 0; row < permutation.size(); row++)
+		permutation[row] = row;
+	stable_sort(permutation.begin(), permutation.end(), TCompareTransposonsByPosition(transposons));
+
+	permuteColumn(transposons.identifier, permutation);
+	permuteColumn(transposons.family, permutation);
+	permuteColumn(transposons.contig, permutation);
+	permuteColumn(transposons.strand, permutation);
+	permuteColumn(transposons.start, permutation);
+	permuteColumn(transposons.end, permutation);
+
+	// find the rows of every contig
+	transposons.contigs.clear();
+	for (unsigned int row = 0; row < transposons.contig.size(); row++)
+	{
+		if ((row == 0) || (transposons.contig[row] != transposons.contig[row-1]))
+			transposons.contigs[transposons.contig[row]].begin = row;
+		transposons.contigs[transposons.contig[row]].end = row + 1;
+	}
+}
+
+// function to convert a <TStringView> to an unsigned integer
+// Input parameters:
+//	view: the characters to convert
+// Output parameters:
+//	number: the converted number
+// Return value: false, if <view> is not a number or the number does not fit into an unsigned int; true otherwise
+bool parseUnsignedInteger(const TStringView &view, unsigned int &number)
+{
+	if (view.length == 0)
+		return false;
+	number = 0;
+	for (size_t i = 0; i < view.length; i++)
+	{
+		if ((view.characters[i] < '0') || (view.characters[i] > '9'))
+			return false;
+		unsigned int digit = view.characters[i] - '0';
+		if (number > (UINT_MAX - digit) / 10)
+			return false; // the number would wrap around
+		number = number * 10 + digit;
+	}
+	return true;
+}
+
+// function to convert a <TStringView> to a floating point number
+// Input parameters:
+//	view: the characters to convert
+// Output parameters:
+//	number: the converted number
+// Return value: false, if <view> is not a number; true otherwise
+bool parseFloat(const TStringView &view, float &number)
+{
+	char buffer[64];
+	if ((view.length == 0) || (view.length >= sizeof(buffer)))
+		return false;
+	memcpy(buffer, view.characters, view.length);
+	buffer[view.length] = '\0';
+	char *end;
+	number = strtod(buffer, &end);
+	return *end == '\0';
+}
+
+// This function extracts the value of a single attribute from column 9 of a GFF/GTF file.
+// Both the GTF syntax (key "value"; key "value") and the GFF3 syntax (key=value;key=value) are understood.
+// The column is only scanned until the attribute is found, and the value is not copied.
+// Input parameters:
+//	attributes: column 9 of the GFF/GTF file
+//	key: the name of the attribute to extract (e.g., "gene_id" or "Name")
+// Output parameters:
+//	value: the value of the attribute without enclosing quotes
+// Return value: true, if the attribute was found; false otherwise
+bool findAttribute(const TStringView &attributes, const string &key, TStringView &value)
+{
+	const char *attributesEnd = attributes.characters + attributes.length;
+	const char *attribute = attributes.characters;
+	while (attribute < attributesEnd)
+	{
+		// skip white-space before the key
+		while ((attribute < attributesEnd) && ((*attribute == ' ') || (*attribute == '\t')))
+			attribute++;
+
+		// find the end of the current attribute
+		const char *attributeEnd = attribute;
+		bool quotesOpen = false;
+		while ((attributeEnd < attributesEnd) && ((*attributeEnd != ';') || quotesOpen))
+		{
+			if (*attributeEnd == '"')
+				quotesOpen = !quotesOpen;
+			attributeEnd++;
+		}
+
+		// check if the key of the attribute is the one we are looking for
+		if ((attribute + key.length() < attributeEnd) &&
+		    (key.compare(0, key.length(), attribute, key.length()) == 0) &&
+		    ((attribute[key.length()] == ' ') || (attribute[key.length()] == '=')))
+		{
+			// strip separator, white-space and quotes from the value
+			const char *valueStart = attribute + key.length() + 1;
+			const char *valueEnd = attributeEnd;
+			while ((valueStart < valueEnd) && ((*valueStart == ' ') || (*valueStart == '"')))
+				valueStart++;
+			while ((valueEnd > valueStart) && ((*(valueEnd-1) == ' ') || (*(valueEnd-1) == '"')))
+				valueEnd--;
+			value = TStringView(valueStart, valueEnd - valueStart);
+			return true;
+		}
+
+		attribute = attributeEnd + 1;
+	}
+	return false;
+}
+
+// type to hold the contents of a file that was mapped into memory
+struct TMappedFile
+{
+	const char *data;
+	size_t size;
+	#if defined(WIN32) || defined(_WIN32)
+	vector< char > buffer; // on Windows, the file is read into this buffer instead of being mapped
+	#endif
+
+	TMappedFile():
+		data(NULL), size(0)
+	{
+	}
+};
+
+// function to map a file into memory for reading
+// Input parameters:
+//	fileName: the file to map
+// Output parameters:
+//	mappedFile: the contents of the file
+// Return value: 1, if the file could not be mapped; 0 otherwise
+int openMappedFile(const char *fileName, TMappedFile &mappedFile)
+{
+	#if defined(WIN32) || defined(_WIN32)
+	ifstream file(fileName, ios_base::in | ios_base::binary);
+	if (file.fail())
+		return 1;
+	mappedFile.buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	mappedFile.data = (mappedFile.buffer.size() > 0) ? &mappedFile.buffer[0] : NULL;
+	mappedFile.size = mappedFile.buffer.size();
+	#else
+	int fileDescriptor = open(fileName, O_RDONLY);
+	if (fileDescriptor < 0)
+		return 1;
+	struct stat fileStats;
+	if (fstat(fileDescriptor, &fileStats) != 0)
+	{
+		close(fileDescriptor);
+		return 1;
+	}
+	mappedFile.size = fileStats.st_size;
+	mappedFile.data = NULL;
+	if (mappedFile.size > 0)
+	{
+		void *data = mmap(NULL, mappedFile.size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fileDescriptor);
+			return 1;
+		}
+		madvise(data, mappedFile.size, MADV_SEQUENTIAL);
+		mappedFile.data = static_cast<const char *>(data);
+	}
+	close(fileDescriptor); // the mapping remains valid after closing the file
+	#endif
+	return 0;
+}
+
+// function to release a file that was mapped with <openMappedFile>
+void closeMappedFile(TMappedFile &mappedFile)
+{
+	#if defined(WIN32) || defined(_WIN32)
+	mappedFile.buffer.clear();
+	#else
+	if (mappedFile.data != NULL)
+		munmap(const_cast<char *>(mappedFile.data), mappedFile.size);
+	#endif
+	mappedFile.data = NULL;
+	mappedFile.size = 0;
+}
+
+// this functions reads genomic regions of transposons from a file
+// the transposons are checked for ping-pong activity by the function <findSuppressedTransposons>
+// Input parameters:
+//	transposonFile: the contents of the file from where to read the transposons
+//	fileFormat: the format of the file
+//	attributeKey: for GFF/GTF files, the attribute in column 9 to use as identifier
+//	              if empty, the entire column 9 is used as identifier
+//	familyKey: for GFF/GTF files, the attribute in column 9 to use as name of the transposon family
+//	           if empty, or for other file formats, transposons with the same identifier form a family
+// Input/output parameters:
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+//	              the name store is extended by names that it does not contain, but that are used in the transposon file
+// Output parameters:
+//	transposons: the transposons read from the file are appended to this table
+//	             the table must be sorted with the function <sortTransposonTable> after all files have been read
+void readTransposonsFromFile(const TMappedFile &transposonFile, TFileFormat fileFormat, const string &attributeKey, const string &familyKey, TTransposonTable &transposons, TNameStore &bamNameStore)
+{
+	// the following variables store the numbers of the columns of the respective fields
+	unsigned int identifierField, strandField, contigField, startField, endField;
+	// some file formats address the first position on the contig with 0, others with 1
+	// some file formats include the last position in regions (half-open), others not (closed)
+	unsigned int offset, halfOpenOrClosed;
+	// character that separates columns
+	char delimiter;
+
+	switch (fileFormat)
+	{
+		case fileFormatBED:
+			identifierField = 4;
+			strandField = 6;
+			contigField = 1;
+			startField = 2;
+			endField = 3;
+			offset = 0;
+			halfOpenOrClosed = 0;
+			delimiter = ' ';
+			break;
+		case fileFormatCSV:
+			identifierField = 1;
+			strandField = 2;
+			contigField = 3;
+			startField = 4;
+			endField = 5;
+			offset = 1;
+			halfOpenOrClosed = 0;
+			delimiter = ',';
+			break;
+		case fileFormatGFF:
+		case fileFormatGTF:
+			identifierField = 9;
+			strandField = 7;
+			contigField = 1;
+			startField = 4;
+			endField = 5;
+			offset = 1;
+			halfOpenOrClosed = 1;
+			delimiter = '\t';
+			break;
+		case fileFormatTSV:
+		default:
+			identifierField = 1;
+			strandField = 2;
+			contigField = 3;
+			startField = 4;
+			endField = 5;
+			offset = 1;
+			halfOpenOrClosed = 0;
+			delimiter = '\t';
+			break;
+	}
+	bool isGFF = (fileFormat == fileFormatGFF) || (fileFormat == fileFormatGTF);
+
+	// index the contig names, so they can be looked up quickly
+	// since contig names are unique, the IDs in the arena equal the IDs in the name store
+	TStringArena contigNames;
+	for (unsigned int i = 0; i < length(bamNameStore); i++)
+		internString(contigNames, toCString(bamNameStore[i]), length(bamNameStore[i]));
+
+	string unquotedField; // CSV fields with double-quotes are copied into this variable, all other fields are referred to in place
+
+	const char *character = transposonFile.data;
+	const char *fileEnd = transposonFile.data + transposonFile.size;
+	while (character < fileEnd)
+	{
+		// find the end of the current line
+		const char *lineEnd = static_cast<const char *>(memchr(character, '\n', fileEnd - character));
+		if (lineEnd == NULL)
+			lineEnd = fileEnd; // make sure the last line is processed, even if it does not end on a line feed
+		const char *nextLine = lineEnd + 1;
+		if ((lineEnd > character) && (*(lineEnd-1) == '\r'))
+			lineEnd--; // skip carriage-returns at the end of the line
+
+		// when a field has been fully read, it is assigned to one of the following transposon attributes:
+		TStringView transposonIdentifier;
+		TStringView transposonFamily;
+		TStringView transposonContig;
+		int transposonStrand = -1;
+		int transposonStart = -1;
+		int transposonEnd = -1;
+
+		// split the line into fields, consecutive delimiters are treated as a single one
+		unsigned int fieldNumber = 1; // index of the column that is currently being read from the input file
+		while ((character < lineEnd) && (fieldNumber <= identifierField || fieldNumber <= strandField || fieldNumber <= contigField || fieldNumber <= endField))
+		{
+			// skip delimiters
+			while ((character < lineEnd) && ((*character == delimiter) || ((delimiter == ' ') && (*character == '\t')))) // when delimiter is set to a blank, then treat any white-space (i.e., ' ' and '\t') as a delimiter
+				character++;
+			if (character == lineEnd)
+				break;
+
+			// find the end of the field
+			TStringView field(character, 0);
+			if ((fileFormat == fileFormatCSV) && (memchr(character, '"', lineEnd - character) != NULL))
+			{
+				// in the CSV format, fields may be enclosed by double-quotes
+				// we need to keep track of whether all opening quotes have a closing counterpart
+				bool quotesOpen = false;
+				if (fieldNumber == identifierField)
+					unquotedField.clear();
+				while ((character < lineEnd) && ((*character != delimiter) || quotesOpen))
+				{
+					if (*character == '"')
+					{
+						if ((field.length > 0) && !quotesOpen && (fieldNumber == identifierField))
+							unquotedField += '"'; // two consecutive double-quotes are collapsed to one
+						quotesOpen = !quotesOpen;
+					}
+					else if (fieldNumber == identifierField)
+					{
+						unquotedField += *character;
+					}
+					field.length++;
+					character++;
+				}
+				if (fieldNumber == identifierField)
+					field = TStringView(unquotedField.data(), unquotedField.size());
+			}
+			else
+			{
+				while ((character < lineEnd) && (*character != delimiter) && !((delimiter == ' ') && (*character == '\t')))
+					character++;
+				field.length = character - field.characters;
+			}
+
+			// assign field to appropriate transposon attribute
+			if (fieldNumber == identifierField)
+			{
+				if (isGFF && (!attributeKey.empty() || !familyKey.empty()))
+				{
+					// for GFF/GTF files, column 9 is the last column and may contain the delimiter
+					TStringView attributes(field.characters, lineEnd - field.characters);
+					character = lineEnd;
+					if (attributeKey.empty())
+						transposonIdentifier = field;
+					else if (!findAttribute(attributes, attributeKey, transposonIdentifier))
+						transposonIdentifier = TStringView();
+					if (!familyKey.empty() && !findAttribute(attributes, familyKey, transposonFamily))
+						transposonFamily = TStringView();
+				}
+				else
+				{
+					transposonIdentifier = field;
+				}
+			}
+			else if (fieldNumber == strandField)
+			{
+				if (field == "+")
+					transposonStrand = STRAND_PLUS;
+				else if (field == "-")
+					transposonStrand = STRAND_MINUS;
+			}
+			else if (fieldNumber == contigField)
+			{
+				transposonContig = field;
+			}
+			else if (fieldNumber == startField)
+			{
+				unsigned int number;
+				if (parseUnsignedInteger(field, number) && (number >= offset))
+					transposonStart = number - offset; // shift coordinate, in case the file format starts counting at 1 instead of 0
+			}
+			else if (fieldNumber == endField)
+			{
+				unsigned int number;
+				if (parseUnsignedInteger(field, number) && (number + halfOpenOrClosed >= offset))
+					transposonEnd = number - offset + halfOpenOrClosed; // shift coordinate, in case the file format starts counting at 1 instead of 0 or if the format is closed instead of half open
+			}
+
+			fieldNumber++;
+		}
+
+		// skip lines that could not be parsed
+		if ((transposonStrand >= 0) && (transposonContig.length > 0) && (transposonStart >= 0) && (transposonEnd >= 0) && (transposonIdentifier.length > 0))
+		{
+			unsigned int contig = internString(contigNames, transposonContig.characters, transposonContig.length);
+			if (contig == length(bamNameStore)) // the contig was not found in the name store
+				appendValue(bamNameStore, CharString(string(transposonContig.characters, transposonContig.length))); // add a new element to the name store
+
+			if (transposonFamily.length == 0)
+				transposonFamily = transposonIdentifier; // transposons with the same name are copies of the same family
+			appendTransposon(transposons, transposonIdentifier, transposonFamily, contig, transposonStrand, transposonStart, transposonEnd);
+		}
+
+		character = nextLine;
+	}
+}
+
+// function to add the transposons of one table to another table
+// Input parameters:
+//	moreTransposons: the transposons to add; the table is emptied by the function
+// Input/output parameters:
+//	transposons: the table to add the transposons to
+//	             the table must be sorted with the function <sortTransposonTable> afterwards, unless it was empty
+void appendTransposonTable(TTransposonTable &transposons, TTransposonTable &moreTransposons)
+{
+	if (transposons.start.empty())
+	{
+		// nothing to merge, take over the table as it is
+		swap(transposons, moreTransposons);
+		return;
+	}
+
+	for (unsigned int row = 0; row < moreTransposons.start.size(); row++)
+	{
+		transposons.identifier.push_back(internString(transposons.identifiers, internedString(moreTransposons.identifiers, moreTransposons.identifier[row]), internedStringLength(moreTransposons.identifiers, moreTransposons.identifier[row])));
+		transposons.family.push_back(internString(transposons.families, internedString(moreTransposons.families, moreTransposons.family[row]), internedStringLength(moreTransposons.families, moreTransposons.family[row])));
+	}
+	transposons.contig.insert(transposons.contig.end(), moreTransposons.contig.begin(), moreTransposons.contig.end());
+	transposons.strand.insert(transposons.strand.end(), moreTransposons.strand.begin(), moreTransposons.strand.end());
+	transposons.start.insert(transposons.start.end(), moreTransposons.start.begin(), moreTransposons.start.end());
+	transposons.end.insert(transposons.end.end(), moreTransposons.end.begin(), moreTransposons.end.end());
+	moreTransposons = TTransposonTable();
+}
+
+// The parsed and sorted contents of transposon files can be cached in a binary file, which is loaded much faster than the original file.
+// A cache file consists of a <TAnnotationCacheHeader> followed by these sections (each padded to a multiple of 8 bytes):
+//	- the key: path, size and modification time of the original file and the parameters with which it was parsed
+//	- the names of the contigs referred to by the transposons: offsets (uint64) and characters
+//	- the identifiers of the transposons: offsets (uint64), characters and hash table (uint32)
+//	- the families of the transposons: offsets (uint64), characters and hash table (uint32)
+//	- the columns identifier, family, contig, start, end (uint32) and strand (uint8) with one element per transposon
+// Cache files are written to a temporary file first, which is then renamed. Since renaming is atomic, concurrent readers
+// either see no cache file or a complete one, even if several processes write the same cache file at the same time.
+const char ANNOTATION_CACHE_MAGIC[8] = { 'P', 'P', 'A', 'N', 'N', 'O', 'T', '1' };
+const uint64_t ANNOTATION_CACHE_BYTE_ORDER = 0x0102030405060708ULL; // to detect cache files written on a machine with a different byte order
+struct TAnnotationCacheHeader
+{
+	char magic[8];
+	uint64_t byteOrder;
+	uint64_t fileSize; // size of the cache file, to detect incomplete files
+	uint64_t keyLength;
+	uint64_t contigCount;
+	uint64_t contigNamesLength;
+	uint64_t identifierCount;
+	uint64_t identifiersLength;
+	uint64_t identifierHashTableSize;
+	uint64_t familyCount;
+	uint64_t familiesLength;
+	uint64_t familyHashTableSize;
+	uint64_t transposonCount;
+};
+
+// function to calculate the number of bytes needed to pad a section of a cache file to a multiple of 8 bytes
+inline size_t padToWord(size_t size)
+{
+	return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// function to calculate the size of a cache file from the number of elements of its sections given in the header
+inline uint64_t getAnnotationCacheSize(const TAnnotationCacheHeader &header)
+{
+	return
+		sizeof(TAnnotationCacheHeader) + padToWord(header.keyLength) +
+		padToWord((header.contigCount + 1) * sizeof(uint64_t)) + padToWord(header.contigNamesLength) +
+		padToWord((header.identifierCount + 1) * sizeof(uint64_t)) + padToWord(header.identifiersLength) + padToWord(header.identifierHashTableSize * sizeof(unsigned int)) +
+		padToWord((header.familyCount + 1) * sizeof(uint64_t)) + padToWord(header.familiesLength) + padToWord(header.familyHashTableSize * sizeof(unsigned int)) +
+		5 * padToWord(header.transposonCount * sizeof(uint32_t)) + padToWord(header.transposonCount * sizeof(uint8_t));
+}
+
+// This function determines the name of the cache file of a transposon file.
+// Input parameters:
+//	cacheDirectory: the directory where cache files are stored
+//	transposonFile: the original transposon file
+//	fileFormat, attributeKey, familyKey: the parameters with which the transposon file is parsed (see <readTransposonsFromFile>)
+// Output parameters:
+//	key: a string that uniquely identifies the contents of the cache file
+//	cacheFile: the path to the cache file
+// Return value: 1, if the transposon file does not exist; 0 otherwise
+int getAnnotationCacheFile(const string &cacheDirectory, const char *transposonFile, TFileFormat fileFormat, const string &attributeKey, const string &familyKey, string &key, string &cacheFile)
+{
+	struct stat fileStats;
+	if (stat(transposonFile, &fileStats) != 0)
+		return 1;
+
+	// use the absolute path, so that the cache works from any working directory
+	string path = transposonFile;
+	#if !defined(WIN32) && !defined(_WIN32)
+	char *absolutePath = realpath(transposonFile, NULL);
+	if (absolutePath != NULL)
+	{
+		path = absolutePath;
+		free(absolutePath);
+	}
+	#endif
+
+	stringstream ss;
+	ss << path << '\t' << static_cast<uint64_t>(fileStats.st_size) << '\t' << static_cast<int64_t>(fileStats.st_mtime) << '\t' << fileFormat << '\t' << attributeKey << '\t' << familyKey;
+	key = ss.str();
+
+	// name the cache file after the hash of the key and a hash of the reversed key to make collisions unlikely
+	// (should they occur nonetheless, the key stored in the cache file does not match and the file is ignored)
+	string reversedKey(key.rbegin(), key.rend());
+	ss.str("");
+	ss << cacheDirectory;
+	if (!cacheDirectory.empty() && (cacheDirectory[cacheDirectory.size()-1] != PATH_DELIMITER))
+		ss << PATH_DELIMITER;
+	ss << hex << setfill('0') << setw(8) << hashString(key.data(), key.size()) << setw(8) << hashString(reversedKey.data(), reversedKey.size()) << ".ppcache";
+	cacheFile = ss.str();
+	return 0;
+}
+
+// function to read a string arena from a section of a cache file
+// Input parameters:
+//	data: pointer to the section
+//	count: the number of strings in the section
+//	charactersLength: the number of characters in the section
+//	hashTableSize: the number of slots in the hash table of the section
+// Output parameters:
+//	arena: the strings read from the section
+// Return value: pointer to the end of the section
+const char *readStringArenaFromCache(const char *data, uint64_t count, uint64_t charactersLength, uint64_t hashTableSize, TStringArena &arena)
+{
+	const uint64_t *offsets = reinterpret_cast<const uint64_t *>(data);
+	arena.offsets.assign(offsets, offsets + count + 1);
+	data += padToWord((count + 1) * sizeof(uint64_t));
+	arena.characters.assign(data, charactersLength);
+	data += padToWord(charactersLength);
+	const unsigned int *hashTable = reinterpret_cast<const unsigned int *>(data);
+	arena.hashTable.assign(hashTable, hashTable + hashTableSize);
+	data += padToWord(hashTableSize * sizeof(unsigned int));
+	return data;
+}
+
+// function to check whether a string arena read from a cache file is consistent, such that it can be used safely
+// Input parameters:
+//	arena: the arena read by the function <readStringArenaFromCache>
+//	hashTable: whether the arena has a hash table
+// Return value: true, if the offsets lie within the characters and the hash table refers to existing strings only; false otherwise
+bool isValidStringArenaFromCache(const TStringArena &arena, bool hashTable)
+{
+	if (arena.offsets[0] != 0)
+		return false;
+	for (unsigned int i = 1; i < arena.offsets.size(); i++)
+		if (arena.offsets[i] < arena.offsets[i-1])
+			return false;
+	if (arena.offsets.back() != arena.characters.size())
+		return false;
+	if (hashTable)
+	{
+		// the size of the hash table must be a power of 2 with at least one empty slot, so that lookups terminate (see <internString>)
+		if ((arena.hashTable.size() <= countInternedStrings(arena)) || ((arena.hashTable.size() & (arena.hashTable.size() - 1)) != 0))
+			return false;
+		for (vector< unsigned int >::const_iterator slot = arena.hashTable.begin(); slot != arena.hashTable.end(); ++slot)
+			if (*slot > countInternedStrings(arena))
+				return false;
+	}
+	return true;
+}
+
+// function to check whether all IDs in a column read from a cache file are smaller than a given number
+inline bool isValidColumnFromCache(const vector< unsigned int > &column, uint64_t count)
+{
+	for (vector< unsigned int >::const_iterator value = column.begin(); value != column.end(); ++value)
+		if (*value >= count)
+			return false;
+	return true;
+}
+
+// function to read a column of a table from a section of a cache file
+template <typename TValue, typename TStoredValue>
+const char *readColumnFromCache(const char *data, uint64_t count, vector< TValue > &column)
+{
+	const TStoredValue *values = reinterpret_cast<const TStoredValue *>(data);
+	column.assign(values, values + count);
+	return data + padToWord(count * sizeof(TStoredValue));
+}
+
+// This function loads transposons from a cache file written by the function <writeAnnotationCache>.
+// Input parameters:
+//	cacheFile: the file to load
+//	key: the key of the transposon file as determined by the function <getAnnotationCacheFile>
+// Input/output parameters:
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+//	              the name store is extended by names that it does not contain, but that are used in the cache file
+// Output parameters:
+//	transposons: the sorted transposons loaded from the cache file
+// Return value: 1, if the cache file does not exist, is incomplete or does not match the key; 0 otherwise
+int readAnnotationCache(const string &cacheFile, const string &key, TTransposonTable &transposons, TNameStore &bamNameStore)
+{
+	TMappedFile mappedFile;
+	if (openMappedFile(cacheFile.c_str(), mappedFile) != 0)
+		return 1;
+
+	// check if the file is complete and belongs to the transposon file
+	// every section must be smaller than the file, such that the size calculated from the header cannot overflow
+	const TAnnotationCacheHeader *header = reinterpret_cast<const TAnnotationCacheHeader *>(mappedFile.data);
+	if ((mappedFile.size < sizeof(TAnnotationCacheHeader)) ||
+	    (memcmp(header->magic, ANNOTATION_CACHE_MAGIC, sizeof(ANNOTATION_CACHE_MAGIC)) != 0) ||
+	    (header->byteOrder != ANNOTATION_CACHE_BYTE_ORDER) ||
+	    (header->fileSize != mappedFile.size) ||
+	    (header->keyLength > mappedFile.size) || (header->contigCount > mappedFile.size) || (header->contigNamesLength > mappedFile.size) ||
+	    (header->identifierCount > mappedFile.size) || (header->identifiersLength > mappedFile.size) || (header->identifierHashTableSize > mappedFile.size) ||
+	    (header->familyCount > mappedFile.size) || (header->familiesLength > mappedFile.size) || (header->familyHashTableSize > mappedFile.size) ||
+	    (header->transposonCount > mappedFile.size) ||
+	    (getAnnotationCacheSize(*header) != mappedFile.size) ||
+	    (header->keyLength != key.size()) ||
+	    (key.compare(0, key.size(), mappedFile.data + sizeof(TAnnotationCacheHeader), header->keyLength) != 0))
+	{
+		closeMappedFile(mappedFile);
+		return 1;
+	}
+	const char *data = mappedFile.data + sizeof(TAnnotationCacheHeader) + padToWord(header->keyLength);
+
+	// load the transposons
+	TStringArena contigNames;
+	data = readStringArenaFromCache(data, header->contigCount, header->contigNamesLength, 0, contigNames);
+	data = readStringArenaFromCache(data, header->identifierCount, header->identifiersLength, header->identifierHashTableSize, transposons.identifiers);
+	data = readStringArenaFromCache(data, header->familyCount, header->familiesLength, header->familyHashTableSize, transposons.families);
+	data = readColumnFromCache<unsigned int, uint32_t>(data, header->transposonCount, transposons.identifier);
+	data = readColumnFromCache<unsigned int, uint32_t>(data, header->transposonCount, transposons.family);
+	data = readColumnFromCache<unsigned int, uint32_t>(data, header->transposonCount, transposons.contig);
+	data = readColumnFromCache<unsigned int, uint32_t>(data, header->transposonCount, transposons.start);
+	data = readColumnFromCache<unsigned int, uint32_t>(data, header->transposonCount, transposons.end);
+	data = readColumnFromCache<unsigned char, uint8_t>(data, header->transposonCount, transposons.strand);
+	closeMappedFile(mappedFile);
+
+	// a corrupt cache file is ignored, such that it is rebuilt from the transposon file
+	bool valid =
+		isValidStringArenaFromCache(contigNames, false) &&
+		isValidStringArenaFromCache(transposons.identifiers, true) &&
+		isValidStringArenaFromCache(transposons.families, true) &&
+		isValidColumnFromCache(transposons.identifier, countInternedStrings(transposons.identifiers)) &&
+		isValidColumnFromCache(transposons.family, countInternedStrings(transposons.families)) &&
+		isValidColumnFromCache(transposons.contig, countInternedStrings(contigNames));
+	TStringArena distinctContigNames;
+	for (unsigned int i = 0; (i < countInternedStrings(contigNames)) && valid; i++)
+		valid = internString(distinctContigNames, internedString(contigNames, i), internedStringLength(contigNames, i)) == i;
+	vector< bool > contigSeen(countInternedStrings(contigNames), false);
+	for (unsigned int row = 0; (row < transposons.strand.size()) && valid; row++)
+	{
+		valid = (transposons.strand[row] <= STRAND_MINUS) && (transposons.start[row] <= transposons.end[row]);
+		if ((row == 0) || (transposons.contig[row] != transposons.contig[row-1]))
+		{
+			valid = valid && !contigSeen[transposons.contig[row]]; // the transposons must be grouped by contig
+			contigSeen[transposons.contig[row]] = true;
+		}
+	}
+	if (!valid)
+	{
+		transposons = TTransposonTable();
+		return 1;
+	}
+
+	// map the contig names of the cache file to the IDs of the name store
+	TStringArena bamContigNames;
+	for (unsigned int i = 0; i < length(bamNameStore); i++)
+		internString(bamContigNames, toCString(bamNameStore[i]), length(bamNameStore[i]));
+	vector< unsigned int > contigIds(countInternedStrings(contigNames));
+	for (unsigned int i = 0; i < contigIds.size(); i++)
+	{
+		contigIds[i] = internString(bamContigNames, internedString(contigNames, i), internedStringLength(contigNames, i));
+		if (contigIds[i] == length(bamNameStore)) // the contig was not found in the name store
+			appendValue(bamNameStore, CharString(getInternedString(contigNames, i)));
+	}
+
+	// the transposons are sorted by position and grouped by contig, only the contig IDs need to be translated
+	transposons.contigs.clear();
+	for (unsigned int row = 0; row < transposons.contig.size(); row++)
+	{
+		transposons.contig[row] = contigIds[transposons.contig[row]];
+		if ((row == 0) || (transposons.contig[row] != transposons.contig[row-1]))
+			transposons.contigs[transposons.contig[row]].begin = row;
+		transposons.contigs[transposons.contig[row]].end = row + 1;
+	}
+	return 0;
+}
+
+// function to write a string arena to a section of a cache file
+void writeStringArenaToCache(ofstream &cache, const TStringArena &arena, bool writeHashTable)
+{
+	const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	vector< uint64_t > offsets(arena.offsets.begin(), arena.offsets.end());
+	cache.write(reinterpret_cast<const char *>(&offsets[0]), offsets.size() * sizeof(uint64_t));
+	cache.write(padding, padToWord(offsets.size() * sizeof(uint64_t)) - offsets.size() * sizeof(uint64_t));
+	cache.write(arena.characters.data(), arena.characters.size());
+	cache.write(padding, padToWord(arena.characters.size()) - arena.characters.size());
+	if (writeHashTable)
+	{
+		cache.write(reinterpret_cast<const char *>(&arena.hashTable[0]), arena.hashTable.size() * sizeof(unsigned int));
+		cache.write(padding, padToWord(arena.hashTable.size() * sizeof(unsigned int)) - arena.hashTable.size() * sizeof(unsigned int));
+	}
+}
+
+// function to write a column of a table to a section of a cache file
+template <typename TStoredValue, typename TValue>
+void writeColumnToCache(ofstream &cache, const vector< TValue > &column)
+{
+	const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	vector< TStoredValue > values(column.begin(), column.end());
+	if (!values.empty())
+		cache.write(reinterpret_cast<const char *>(&values[0]), values.size() * sizeof(TStoredValue));
+	cache.write(padding, padToWord(values.size() * sizeof(TStoredValue)) - values.size() * sizeof(TStoredValue));
+}
+
+// This function writes transposons to a cache file, which can be loaded with the function <readAnnotationCache>.
+// Input parameters:
+//	cacheFile: the file to write
+//	key: the key of the transposon file as determined by the function <getAnnotationCacheFile>
+//	transposons: the transposons read from the transposon file as sorted by the function <sortTransposonTable>
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+// Return value: 1, if the cache file could not be written; 0 otherwise
+int writeAnnotationCache(const string &cacheFile, const string &key, const TTransposonTable &transposons, const TNameStore &bamNameStore)
+{
+	// collect the names of the contigs used by the transposons and number them consecutively
+	TStringArena contigNames;
+	map< unsigned int, unsigned int > contigIds;
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+		contigIds[contig->first] = internString(contigNames, toCString(bamNameStore[contig->first]), length(bamNameStore[contig->first]));
+	vector< unsigned int > contig(transposons.contig.size());
+	for (unsigned int row = 0; row < contig.size(); row++)
+		contig[row] = contigIds[transposons.contig[row]];
+
+	TAnnotationCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ANNOTATION_CACHE_MAGIC, sizeof(ANNOTATION_CACHE_MAGIC));
+	header.byteOrder = ANNOTATION_CACHE_BYTE_ORDER;
+	header.keyLength = key.size();
+	header.contigCount = countInternedStrings(contigNames);
+	header.contigNamesLength = contigNames.characters.size();
+	header.identifierCount = countInternedStrings(transposons.identifiers);
+	header.identifiersLength = transposons.identifiers.characters.size();
+	header.identifierHashTableSize = transposons.identifiers.hashTable.size();
+	header.familyCount = countInternedStrings(transposons.families);
+	header.familiesLength = transposons.families.characters.size();
+	header.familyHashTableSize = transposons.families.hashTable.size();
+	header.transposonCount = transposons.start.size();
+	header.fileSize = getAnnotationCacheSize(header);
+
+	// write to a temporary file with a unique name, so that concurrent writers do not interfere, even on different hosts sharing the cache directory
+	char hostName[256] = "";
+	gethostname(hostName, sizeof(hostName) - 1);
+	stringstream temporaryFile;
+	temporaryFile << cacheFile << ".tmp." << hostName << "." << getpid() << "." << time(NULL);
+	ofstream cache(temporaryFile.str().c_str(), ios_base::out | ios_base::binary);
+	if (cache.fail())
+		return 1;
+	const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	cache.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	cache.write(key.data(), key.size());
+	cache.write(padding, padToWord(key.size()) - key.size());
+	writeStringArenaToCache(cache, contigNames, false);
+	writeStringArenaToCache(cache, transposons.identifiers, true);
+	writeStringArenaToCache(cache, transposons.families, true);
+	writeColumnToCache<uint32_t>(cache, transposons.identifier);
+	writeColumnToCache<uint32_t>(cache, transposons.family);
+	writeColumnToCache<uint32_t>(cache, contig);
+	writeColumnToCache<uint32_t>(cache, transposons.start);
+	writeColumnToCache<uint32_t>(cache, transposons.end);
+	writeColumnToCache<uint8_t>(cache, transposons.strand);
+	cache.close();
+	if (cache.fail())
+	{
+		remove(temporaryFile.str().c_str());
+		return 1;
+	}
+
+	// atomically replace the cache file
+	if (rename(temporaryFile.str().c_str(), cacheFile.c_str()) != 0)
+	{
+		remove(temporaryFile.str().c_str());
+		return 1;
+	}
+	return 0;
+}
+
+// Signature index files store the ping-pong signatures of all overlaps, such that regions can be queried without reading the entire file.
+// All sections are aligned to 8 bytes. The layout is:
+//	- a <TSignatureIndexFileHeader>
+//	- a <TSignatureIndexFileContig> for every contig, sorted by name
+//	- the names of the contigs
+//	- for every contig and overlap: the signatures as <TSignatureIndexFileRecord> sorted by position,
+//	  followed by a coarse block index with one <TSignatureIndexFileBlock> for every <SIGNATURE_INDEX_BLOCK_SIZE> signatures plus a sentinel
+// A query locates the block of the start of a region by binary search and only touches the records of the blocks at both ends of the region,
+// because the block index stores the sums of the scores and reads of all preceding signatures.
+const char SIGNATURE_INDEX_MAGIC[8] = { 'P', 'P', 'S', 'I', 'G', 'I', 'X', '1' };
+const unsigned int SIGNATURE_INDEX_BLOCK_SIZE = 256;
+struct TSignatureIndexFileHeader
+{
+	char magic[8];
+	uint64_t byteOrder; // to detect index files written on a machine with a different byte order
+	uint64_t fileSize; // size of the index file, to detect incomplete files
+	uint64_t blockSize; // number of signatures per block
+	uint64_t contigCount;
+};
+
+struct TSignatureIndexFileContig
+{
+	uint64_t nameOffset;
+	uint64_t nameLength;
+	uint64_t signatureOffset[ARBITRARY_OVERLAP_COUNT]; // file offset of the first <TSignatureIndexFileRecord> of every overlap
+	uint64_t signatureCount[ARBITRARY_OVERLAP_COUNT];
+	uint64_t blockOffset[ARBITRARY_OVERLAP_COUNT]; // file offset of the first <TSignatureIndexFileBlock> of every overlap
+};
+
+struct TSignatureIndexFileRecord
+{
+	uint32_t position;
+	float fdr;
+	float readsOnPlusStrand;
+	float readsOnMinusStrand;
+};
+
+struct TSignatureIndexFileBlock
+{
+	uint64_t firstPosition; // position of the first signature of the block; UINT64_MAX for the sentinel
+	double scorePrefixSum; // sum of the scores of all signatures before the block
+	double readsOnPlusStrandPrefixSum;
+	double readsOnMinusStrandPrefixSum;
+};
+
+
+// Function to sort contig IDs by the name of the contigs.
+// The function is used by sort to arrange the contigs of a signature index file.
+struct TCompareContigsByName
+{
+	const TNameStore &bamNameStore;
+
+	TCompareContigsByName(const TNameStore &bamNameStore):
+		bamNameStore(bamNameStore)
+	{
+	}
+
+	inline bool operator()(unsigned int contig1, unsigned int contig2) const
+	{
+		return toCString(bamNameStore[contig1]) < string(toCString(bamNameStore[contig2]));
+	}
+};
+
+// This function writes the ping-pong signatures of all overlaps to a signature index file (see <SIGNATURE_INDEX_MAGIC>),
+// which can be queried by the functions <querySignatureIndexFile> and <findSignaturesInRegion>.
+// Input parameters:
+//	pingPongSignaturesByOverlap: the ping-pong signatures found by the function <countStacksByGroup>
+//	fdrTable: the FDR of every class of signatures as calculated by the function <buildFDRTable>
+//	bamNameStore: mapping of numeric contig IDs to human-readable names
+//	minStackHeight: ping-pong signatures with a smaller stack height than this are omitted, like in <writePingPongSignaturesToFile>
+//	fileName: the name of the index file within the <sink>
+// Input/output parameters:
+//	sink: the output sink to write the index file to
+// Return value: 1, if the file could not be written; 0 otherwise
+int writeSignatureIndexFile(TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, const TFDRTable &fdrTable, const TNameStore &bamNameStore, unsigned int minStackHeight, TOutputSink &sink, const string &fileName)
+{
+	// collect the contigs which have signatures with any overlap
+	vector< unsigned int > contigs;
+	for (TPingPongSignaturesByOverlap::iterator pingPongSignaturesPerGenome = pingPongSignaturesByOverlap.begin(); pingPongSignaturesPerGenome != pingPongSignaturesByOverlap.end(); ++pingPongSignaturesPerGenome)
+		for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesPerGenome->begin(); contig != pingPongSignaturesPerGenome->end(); ++contig)
+			if (!contig->second.empty())
+				contigs.push_back(contig->first);
+	sort(contigs.begin(), contigs.end());
+	contigs.erase(unique(contigs.begin(), contigs.end()), contigs.end());
+	sort(contigs.begin(), contigs.end(), TCompareContigsByName(bamNameStore));
+
+	// calculate the layout of the file
+	TSignatureIndexFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SIGNATURE_INDEX_MAGIC, sizeof(header.magic));
+	header.byteOrder = ANNOTATION_CACHE_BYTE_ORDER;
+	header.blockSize = SIGNATURE_INDEX_BLOCK_SIZE;
+	header.contigCount = contigs.size();
+	vector< TSignatureIndexFileContig > directory(contigs.size());
+	uint64_t offset = sizeof(header) + directory.size() * sizeof(TSignatureIndexFileContig);
+	for (unsigned int i = 0; i < contigs.size(); i++)
+	{
+		directory[i].nameOffset = offset;
+		directory[i].nameLength = length(bamNameStore[contigs[i]]);
+		offset += padToWord(directory[i].nameLength);
+	}
+	for (unsigned int i = 0; i < contigs.size(); i++)
+		for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		{
+			uint64_t signatureCount = 0;
+			TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesByOverlap[overlap].find(contigs[i]);
+			if (contig != pingPongSignaturesByOverlap[overlap].end())
+				for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
+					if ((pingPongSignature->readsOnPlusStrand >= minStackHeight) && (pingPongSignature->readsOnMinusStrand >= minStackHeight))
+						signatureCount++;
+			directory[i].signatureOffset[overlap] = offset;
+			directory[i].signatureCount[overlap] = signatureCount;
+			offset += signatureCount * sizeof(TSignatureIndexFileRecord);
+			directory[i].blockOffset[overlap] = offset;
+			offset += ((signatureCount + SIGNATURE_INDEX_BLOCK_SIZE - 1) / SIGNATURE_INDEX_BLOCK_SIZE + 1) * sizeof(TSignatureIndexFileBlock);
+		}
+	header.fileSize = offset;
+
+	// write the file
+	TOutputFile outputFile;
+	if (openOutputFile(sink, fileName, outputFile, ios_base::out | ios_base::binary) != 0)
+	{
+		cerr << "Failed to create signature index file \"" << outputPath(sink, fileName) << "\"." << endl;
+		return 1;
+	}
+	ostream &indexFile = *outputFile.stream;
+	const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	indexFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	if (!directory.empty())
+		indexFile.write(reinterpret_cast<const char *>(&directory[0]), directory.size() * sizeof(TSignatureIndexFileContig));
+	for (unsigned int i = 0; i < contigs.size(); i++)
+	{
+		indexFile.write(toCString(bamNameStore[contigs[i]]), directory[i].nameLength);
+		indexFile.write(padding, padToWord(directory[i].nameLength) - directory[i].nameLength);
+	}
+	vector< TSignatureIndexFileRecord > records;
+	vector< TSignatureIndexFileBlock > blocks;
+	for (unsigned int i = 0; i < contigs.size(); i++)
+		for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		{
+			// collect the signatures and sum up their scores block-wise
+			records.clear();
+			blocks.clear();
+			TSignatureIndexFileBlock block = { 0, 0, 0, 0 };
+			TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesByOverlap[overlap].find(contigs[i]);
+			if (contig != pingPongSignaturesByOverlap[overlap].end())
+				for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
+					if ((pingPongSignature->readsOnPlusStrand >= minStackHeight) && (pingPongSignature->readsOnMinusStrand >= minStackHeight))
+					{
+						if (records.size() % SIGNATURE_INDEX_BLOCK_SIZE == 0)
+						{
+							block.firstPosition = pingPongSignature->position;
+							blocks.push_back(block);
+						}
+						TSignatureIndexFileRecord record = { pingPongSignature->position, getFDR(fdrTable, overlap, *pingPongSignature), pingPongSignature->readsOnPlusStrand, pingPongSignature->readsOnMinusStrand };
+						records.push_back(record);
+						block.scorePrefixSum += signatureScore(record.readsOnPlusStrand, record.readsOnMinusStrand, record.fdr);
+						block.readsOnPlusStrandPrefixSum += record.readsOnPlusStrand;
+						block.readsOnMinusStrandPrefixSum += record.readsOnMinusStrand;
+					}
+			block.firstPosition = UINT64_MAX; // sentinel holding the totals
+			blocks.push_back(block);
+
+			if (!records.empty())
+				indexFile.write(reinterpret_cast<const char *>(&records[0]), records.size() * sizeof(TSignatureIndexFileRecord));
+			indexFile.write(reinterpret_cast<const char *>(&blocks[0]), blocks.size() * sizeof(TSignatureIndexFileBlock));
+		}
+	if (closeOutputFile(outputFile) != 0)
+	{
+		cerr << "Failed to write signature index file \"" << outputPath(sink, fileName) << "\"." << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Function to sort row numbers of transposons by p-value for multiple testing correction using Benjamini-Hochberg procedure.
+// The function is used by stable_sort to compare which of two transposons is lower, based on their p-value.
+struct TCompareTransposonsByPValue
+{
+	const vector< float > &pValue;
+
+	TCompareTransposonsByPValue(const vector< float > &pValue):
+		pValue(pValue)
+	{
+	}
+
+	// Input parameters:
+	// 	row1, row2: the row numbers of the transposons to compare
+	// Return value: true, if transposon1 has a lower p-value than transposon2; false otherwise
+	inline bool operator()(unsigned int row1, unsigned int row2) const
+	{
+		return pValue[row1] < pValue[row2];
+	}
+};
+
+// This function calculates how many standard deviations the score of the ping-pong overlap in a histogram is above the mean of the arbitrary overlaps.
+// Input parameters:
+//	histogram: the sum of the scores of the signatures in a region for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Return value: the z-score of the ping-pong overlap
+double calculateZScoreOfHistogram(const float *histogram)
+{
+	// calculate mean score of all arbitrary overlaps
+	float meanOfArbitraryOverlaps = 0;
+	for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP != PING_PONG_OVERLAP) // ignore ping-pong overlaps in the mean calculation, since they would skew the result
+			meanOfArbitraryOverlaps += histogram[overlap];
+	meanOfArbitraryOverlaps = meanOfArbitraryOverlaps / (ARBITRARY_OVERLAP_COUNT - 1 /* minus the one bin for ping-pong overlaps */);
+
+	// calculate standard deviation of score of all arbitrary overlaps
+	float stdDevOfArbitraryOverlaps = 0;
+	for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
+			stdDevOfArbitraryOverlaps += pow(histogram[overlap] - meanOfArbitraryOverlaps, 2);
+	stdDevOfArbitraryOverlaps = sqrt(1.0 / (ARBITRARY_OVERLAP_COUNT - 1 - 1 /* minus 1 for corrected sample STDDEV */) * stdDevOfArbitraryOverlaps);
+	if (stdDevOfArbitraryOverlaps <= MIN_STANDARD_DEVIATION)
+		stdDevOfArbitraryOverlaps = MIN_STANDARD_DEVIATION; // prevent division by 0, in case the STDDEV is 0
+
+	return (histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] - meanOfArbitraryOverlaps) / stdDevOfArbitraryOverlaps;
+}
+
+// This function calculates the significance of the ping-pong overlap in a histogram compared to the arbitrary overlaps.
+// Input parameters:
+//	histogram: the sum of the scores of the signatures in a region for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Return value: the probability that the score of the ping-pong overlap is that high by chance
+float calculatePValueOfHistogram(const float *histogram)
+{
+	// check if there are any signatures in the region
+	bool empty = true;
+	for (unsigned int overlap = 0; (overlap < ARBITRARY_OVERLAP_COUNT) && empty; overlap++)
+		empty = histogram[overlap] == 0;
+	if (empty)
+		return 1;
+
+	// calculate significance of score of ping-pong overlap vs. arbitrary overlaps
+	double zValue = calculateZScoreOfHistogram(histogram);
+	double pValue = 0;
+	if (zValue > 40)
+		return pValue; // the density underflows to 0 beyond this point; for huge z-values, x would not even advance in the loop below
+	for (double x = zValue; x <= zValue + APPROXIMATION_RANGE; x += APPROXIMATION_ACCURACY)
+		pValue += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x);
+	return pValue;
+}
+
+// This function counts the pairs of read stacks at every distance for a list of histograms in a single pass over every contig.
+// Distances are measured from the anchor end of a read (5' or 3') to the 5' end of another read in the direction of the read.
+// On the same strand, the distance is the offset between the ends, where 1 means that the 5' end directly follows the anchor end.
+// (The distance 0 between the 5' end of a stack and itself is not counted.)
+// On opposite strands, the distance is the number of bases between both ends inclusively, i.e., the overlap of the 5' ends in case of ping-pong pairs.
+// Since this overlap is symmetric, pairs of 5' ends on opposite strands are only counted once with the stack on the + strand as anchor.
+// Given the keys of the stacks (see <countAlignment>), the distance is (target - anchor) for anchors on the + strand and (anchor - target) for anchors on the - strand,
+// plus 1 for 3' anchors, such that all histograms of an anchor end can be filled by sweeping the anchors once with a monotonic window for each histogram.
+// Input parameters:
+//	readStacks: the stacks of the 5' ends of the reads as found by the function <countReadsInSample>
+//	threePrimeStacks: the stacks of the 3' ends of the reads or NULL, if no histogram has a 3' anchor
+// Input/output parameters:
+//	histograms: the histograms to fill, the counts of which are reset by the function
+void calculateDistanceHistograms(const TReadStacksPerGenome &readStacks, const TReadStacksPerGenome *threePrimeStacks, TDistanceHistograms &histograms)
+{
+	for (TDistanceHistograms::iterator histogram = histograms.begin(); histogram != histograms.end(); ++histogram)
+	{
+		histogram->pairs.assign(histogram->maxDistance - histogram->minDistance + 1, 0);
+		histogram->reads.assign(histogram->maxDistance - histogram->minDistance + 1, 0);
+	}
+
+	for (unsigned int anchorEnd = fivePrimeEnd; anchorEnd <= threePrimeEnd; ++anchorEnd)
+	{
+		const TReadStacksPerGenome *anchorStacks = (anchorEnd == fivePrimeEnd) ? &readStacks : threePrimeStacks;
+		if (anchorStacks == NULL)
+			continue;
+
+		for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		{
+			// find the histograms which are filled by the anchors of this end and strand
+			vector< TDistanceHistogram * > sweptHistograms;
+			for (TDistanceHistograms::iterator histogram = histograms.begin(); histogram != histograms.end(); ++histogram)
+				if ((histogram->anchor == anchorEnd) && !((histogram->strands == oppositeStrand) && (histogram->anchor == fivePrimeEnd) && (strand == STRAND_MINUS)))
+					sweptHistograms.push_back(&(*histogram));
+			if (sweptHistograms.empty())
+				continue;
+			int sign = (strand == STRAND_PLUS) ? 1 : -1;
+			int offset = (anchorEnd == threePrimeEnd) ? 1 : 0;
+
+			for (TReadStacksPerStrand::const_iterator contig = (*anchorStacks)[strand].begin(); contig != (*anchorStacks)[strand].end(); ++contig)
+			{
+				// every histogram has its own window of target stacks, which slides along with the anchors
+				vector< bool > targets(sweptHistograms.size(), false);
+				vector< TStackCursor > windows(sweptHistograms.size());
+				for (unsigned int i = 0; i < sweptHistograms.size(); i++)
+				{
+					unsigned int targetStrand = (sweptHistograms[i]->strands == sameStrand) ? strand : 1 - strand;
+					TReadStacksPerStrand::const_iterator targetContig = readStacks[targetStrand].find(contig->first);
+					if (targetContig != readStacks[targetStrand].end())
+					{
+						targets[i] = true;
+						windows[i] = beginStacks(targetContig->second);
+					}
+				}
+
+				for (TStackCursor anchor = beginStacks(contig->second); !atEndOfStacks(anchor); nextStack(anchor))
+				{
+					unsigned int anchorPosition = stackPosition(anchor);
+					for (unsigned int i = 0; i < sweptHistograms.size(); i++)
+					{
+						if (!targets[i])
+							continue;
+						TDistanceHistogram &histogram = *sweptHistograms[i];
+						bool skipSelf = (histogram.strands == sameStrand) && (anchorEnd == fivePrimeEnd);
+
+						// range of keys of the target stacks, which are within the range of distances of the histogram
+						int64_t firstTarget = (sign > 0) ? static_cast<int64_t>(anchorPosition) + histogram.minDistance - offset : static_cast<int64_t>(anchorPosition) - histogram.maxDistance + offset;
+						int64_t lastTarget = (sign > 0) ? static_cast<int64_t>(anchorPosition) + histogram.maxDistance - offset : static_cast<int64_t>(anchorPosition) - histogram.minDistance + offset;
+						advanceStackCursor(windows[i], firstTarget);
+
+						for (TStackCursor target = windows[i]; !atEndOfStacks(target) && (static_cast<int64_t>(stackPosition(target)) <= lastTarget); nextStack(target))
+						{
+							if (skipSelf && (stackPosition(target) == anchorPosition))
+								continue;
+							int distance = sign * (static_cast<int64_t>(stackPosition(target)) - static_cast<int64_t>(anchorPosition)) + offset;
+							histogram.pairs[distance - histogram.minDistance]++;
+							histogram.reads[distance - histogram.minDistance] += stackValue(anchor).reads + stackValue(target).reads;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// This function writes the histograms calculated by <calculateDistanceHistograms> to the file distance_histograms.tsv.
+// Input parameters:
+//	histograms: the histograms to write
+// Input/output parameters:
+//	sink: the output sink to write the file to
+void writeDistanceHistogramsToFile(const TDistanceHistograms &histograms, TOutputSink &sink)
+{
+	TOutputFile outputFile;
+	if (openOutputFile(sink, "distance_histograms.tsv", outputFile) != 0)
+	{
+		cerr << "Failed to create file \"" << outputPath(sink, "distance_histograms.tsv") << "\"." << endl;
+		return;
+	}
+	ostream &tsvFile = *outputFile.stream;
+
+	tsvFile << "strands\tanchor\tdistance\tpairs\treads" << endl;
+	for (TDistanceHistograms::const_iterator histogram = histograms.begin(); histogram != histograms.end(); ++histogram)
+		for (int distance = histogram->minDistance; distance <= histogram->maxDistance; distance++)
+			tsvFile
+				<< ((histogram->strands == sameStrand) ? "same" : "opposite") << '\t'
+				<< ((histogram->anchor == fivePrimeEnd) ? "5'" : "3'") << '\t'
+				<< distance << '\t'
+				<< histogram->pairs[distance - histogram->minDistance] << '\t'
+				<< histogram->reads[distance - histogram->minDistance] << endl;
+
+	closeOutputFile(outputFile);
+}
+
+// This function calculates the distance histograms requested on the command-line and writes them to a file (see <calculateDistanceHistograms>).
+// Input parameters:
+//	readStacks: the stacks of the 5' ends of the reads as found by the function <countReadsInSample>
+//	options: the options from the command line
+//	verbosity: whether to print progress messages to stderr (see <stopwatch>)
+// Input/output parameters:
+//	threePrimeStacks: the stacks of the 3' ends of the reads or NULL, if not needed; the variable is emptied to conserve memory
+//	sink: the output sink to write the file to
+void analyzeDistances(const TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, const AppOptions &options, TOutputSink &sink, unsigned int verbosity)
+{
+	if (options.distanceHistograms.empty())
+		return;
+
+	stopwatch("Calculating distance histograms", verbosity);
+	TDistanceHistograms histograms = options.distanceHistograms;
+	calculateDistanceHistograms(readStacks, threePrimeStacks, histograms);
+	writeDistanceHistogramsToFile(histograms, sink);
+	if (threePrimeStacks != NULL)
+		for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+			(*threePrimeStacks)[strand].clear();
+	stopwatch(verbosity);
+}
+
+// This function checks, if any of the requested distance histograms measures distances from the 3' ends of the reads,
+// in which case the readers need to collect the stacks of 3' ends in addition (see <countAlignment>).
+// Input parameters:
+//	histograms: the requested histograms
+// Return value: true, if any histogram has a 3' anchor
+bool needsThreePrimeStacks(const TDistanceHistograms &histograms)
+{
+	for (TDistanceHistograms::const_iterator histogram = histograms.begin(); histogram != histograms.end(); ++histogram)
+		if (histogram->anchor == threePrimeEnd)
+			return true;
+	return false;
+}
+
+// This function sums up the reads of opposite stacks for every overlap between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP> across the entire genome.
+// Unlike <countStacksByGroup>, no ping-pong signatures are stored and no FDRs are calculated, such that a library can be assessed in a single sweep
+// (see <calculateDistanceHistograms>).
+// Input parameters:
+//	readStacks: the read stacks that were found by the function <countReadsInSample>
+// Output parameters:
+//	qc: the histogram of overlaps and the number of stacks
+void calculatePingPongQC(const TReadStacksPerGenome &readStacks, TPingPongQC &qc)
+{
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::const_iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
+			for (TStackCursor stack = beginStacks(contig->second); !atEndOfStacks(stack); nextStack(stack))
+				qc.stacks++;
+
+	TDistanceHistograms overlaps(1, TDistanceHistogram(oppositeStrand, fivePrimeEnd, MIN_ARBITRARY_OVERLAP, MAX_ARBITRARY_OVERLAP));
+	calculateDistanceHistograms(readStacks, NULL, overlaps);
+	copy(overlaps[0].reads.begin(), overlaps[0].reads.end(), qc.histogram);
+	copy(overlaps[0].pairs.begin(), overlaps[0].pairs.end(), qc.pairs);
+}
+
+// This function prints the header of the table written by <writePingPongQC>.
+// Input parameters:
+//	stream: the stream to write to
+void writePingPongQCHeader(ostream &stream)
+{
+	stream << "sample\treads\tstacks\tping-pong pairs\tz-score\tp-value";
+	for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+		stream << '\t' << overlap << " nt";
+	stream << endl;
+}
+
+// This function prints the summary of a library as calculated by <calculatePingPongQC> as a line of a tab-separated table.
+// Input parameters:
+//	stream: the stream to write to
+//	sample: the name of the library
+//	totalReadCount: the number of reads in the library
+//	qc: the histogram of overlaps
+void writePingPongQC(ostream &stream, const string &sample, double totalReadCount, const TPingPongQC &qc)
+{
+	stream
+		<< sample << '\t'
+		<< totalReadCount << '\t'
+		<< qc.stacks << '\t'
+		<< qc.pairs[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] << '\t'
+		<< calculateZScoreOfHistogram(qc.histogram) << '\t'
+		<< calculatePValueOfHistogram(qc.histogram);
+	for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+		stream << '\t' << qc.histogram[overlap];
+	stream << endl;
+}
+
+// This function writes a genome-wide track of ping-pong activity in windows of fixed size.
+// For every window, the scores of the signatures of every overlap are summed up like for transposons (see <findSuppressedTransposons>)
+// and the score of the ping-pong overlap is z-scored against the scores of the arbitrary overlaps.
+// Windows without signatures are omitted. Since the lengths of the contigs are unknown, the last window of a contig ends after its last signature.
+// Input parameters:
+//	activityTrack: the windows as accumulated by the function <countStacksByGroup>
+//	fdrTable: the FDR of every class of signatures as calculated by the function <buildFDRTable>
+//	bamNameStore: mapping of numeric contig IDs to human-readable names
+// Input/output parameters:
+//	sink: the output sink to write the file to
+void writeActivityTrackToFile(const TActivityTrack &activityTrack, const TFDRTable &fdrTable, const TNameStore &bamNameStore, TOutputSink &sink)
+{
+	stringstream fileName;
+	fileName << "ping-pong_activity_" << activityTrack.windowSize << "bp.bedGraph";
+	TOutputFile outputFile;
+	if (openOutputFile(sink, fileName.str(), outputFile) != 0)
+	{
+		cerr << "Failed to create file \"" << outputPath(sink, fileName.str()) << "\"." << endl;
+		return;
+	}
+	ostream &bedGraph = *outputFile.stream;
+	bedGraph.setf(ios::scientific, ios::floatfield);
+	bedGraph << "track type=bedGraph name=\"ping-pong activity (" << activityTrack.windowSize << " bp)\" description=\"z-score of ping-pong signatures vs. arbitrary overlaps in windows of " << activityTrack.windowSize << " bp\" visibility=full" << endl;
+
+	// write contigs in the order of their names, such that the file can be converted to bigWig
+	vector< unsigned int > contigs;
+	for (map< unsigned int, TActivityWindowsPerContig >::const_iterator contig = activityTrack.contigs.begin(); contig != activityTrack.contigs.end(); ++contig)
+		contigs.push_back(contig->first);
+	sort(contigs.begin(), contigs.end(), TCompareContigsByName(bamNameStore));
+
+	for (vector< unsigned int >::iterator contig = contigs.begin(); contig != contigs.end(); ++contig)
+	{
+		const TActivityWindowsPerContig &windows = activityTrack.contigs.find(*contig)->second;
+		unsigned int contigEnd = activityTrack.contigEnds.find(*contig)->second;
+		for (TActivityWindowsPerContig::const_iterator window = windows.begin(); window != windows.end(); ++window)
+		{
+			// convert the reads of every class of signatures to scores
+			float histogram[ARBITRARY_OVERLAP_COUNT] = { 0 };
+			for (TActivityWindow::const_iterator signatureClass = window->second.begin(); signatureClass != window->second.end(); ++signatureClass)
+				histogram[signatureClass->first / 4 / HEIGHT_SCORE_BINS] += signatureClass->second * (1 - fdrTable[signatureClass->first]);
+
+			unsigned int windowStart = window->first * activityTrack.windowSize;
+			bedGraph
+				<< bamNameStore[*contig] << '\t'
+				<< windowStart << '\t'
+				<< min(windowStart + activityTrack.windowSize, contigEnd) << '\t'
+				<< calculateZScoreOfHistogram(histogram) << endl;
+		}
+	}
+
+	closeOutputFile(outputFile);
+}
+
+// This function corrects p-values for multiple testing using the Benjamini-Hochberg procedure (FDR).
+// Input parameters:
+//	rows: the rows of <scores> to correct
+// Input/output parameters:
+//	scores: the q-values are calculated from the p-values, histograms and read counts
+void calculateQValues(vector< unsigned int > &rows, TTransposonScores &scores)
+{
+	// sort rows by p-value
+	stable_sort(rows.begin(), rows.end(), TCompareTransposonsByPValue(scores.pValue));
+
+	unsigned i = 1;
+	float previousPValue = 1;
+	float previousQValue = 1;
+	vector< unsigned int >::reverse_iterator row = rows.rbegin();
+	while (row != rows.rend())
+	{
+		if ((scores.histograms[*row * ARBITRARY_OVERLAP_COUNT + PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP]) / (scores.readsOnPlusStrand[*row] + scores.readsOnMinusStrand[*row]) < 0.2) // more than 80% of reads were discarded => this is probably a false positive
+		{
+			scores.qValue[*row] = 1;
+		}
+		else if (scores.pValue[*row] == previousPValue)
+		{
+			// If two transposons have the same p-value, re-use the previously calculated q-value.
+			// This is pretty unlikely, but ensures that two transposons with the same p-value also
+			// get the same q-value.
+			scores.qValue[*row] = previousQValue;
+		}
+		else
+		{
+			scores.qValue[*row] = scores.pValue[*row] * rows.size() / i;
+			if (scores.qValue[*row] > 1)
+				scores.qValue[*row] = 1;
+
+			previousPValue = scores.pValue[*row];
+			previousQValue = scores.qValue[*row];
+		}
+
+		++row;
+		i++;
+	}
+}
+
+// function to allocate the columns of a <TTransposonScores> and to reset all values
+// Input parameters:
+//	count: the number of transposons (or families) to score
+// Output parameters:
+//	scores: the initialized scores
+void initializeTransposonScores(unsigned int count, TTransposonScores &scores)
+{
+	scores.pValue.assign(count, 1);
+	scores.qValue.assign(count, 1);
+	scores.readsOnPlusStrand.assign(count, 0);
+	scores.readsOnMinusStrand.assign(count, 0);
+	scores.histograms.assign(count * ARBITRARY_OVERLAP_COUNT, 0);
+}
+
+// This function checks given transposons for ping-pong activity.
+// A transposon is assumed to be suppressed by ping-pong activity, if there are significantly more ping-pong signatures within its region
+// than there are arbitrary signatures.
+// Optionally, the transposons are also aggregated by family: while sliding over the genome, the histogram of every transposon
+// is added to the histogram of its family, such that families are scored without a second pass over the signatures.
+// Input parameters:
+//	pingPongSignaturesByOverlap: the ping-pong signtures found by function <countStacksByGroup>
+//	fdrTable: the FDR of every class of signatures as calculated by the function <buildFDRTable>
+//	transposons: a table of transposons to check for ping-pong activity as sorted by the function <sortTransposonTable>
+// Output parameters:
+//	scores: every transposon is assigned a p-value and a q-value indicating the statistical significance of ping-pong activity
+//	familyScores: if not NULL, every family of transposons is assigned a p-value and a q-value in the same way
+//	              the rows correspond to the family IDs of the table
+void findSuppressedTransposons(TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, const TFDRTable &fdrTable, const TTransposonTable &transposons, TTransposonScores &scores, TTransposonScores *familyScores = NULL)
+{
+	unsigned int transposonCount = transposons.start.size();
+	initializeTransposonScores(transposonCount, scores);
+	if (familyScores != NULL)
+		initializeTransposonScores(countInternedStrings(transposons.families), *familyScores);
+
+	// slide over the genome and calculate a z-score for every transposon overlapping the current position
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+	{
+		// for every overlap we need to keep track of the iterator that points to the ping-pong signature where we are currently at
+		vector< TPingPongSignaturesPerContig::iterator > positionByOverlap(pingPongSignaturesByOverlap.size());
+		for (unsigned int overlap = 0; overlap < pingPongSignaturesByOverlap.size(); overlap++)
+			if (pingPongSignaturesByOverlap[overlap].find(contig->first) != pingPongSignaturesByOverlap[overlap].end())
+				positionByOverlap[overlap] = pingPongSignaturesByOverlap[overlap][contig->first].begin();
+			else
+				positionByOverlap[overlap] = pingPongSignaturesByOverlap[overlap][contig->first].end(); // there are no ping-pong stacks for the given contig and overlap
+
+		for (unsigned int transposon = contig->second.begin; transposon < contig->second.end; transposon++)
+		{
+			float *histogram = &scores.histograms[transposon * ARBITRARY_OVERLAP_COUNT];
+
+			// calculate score for transposon for each overlap
+			for (unsigned int overlap = 0; overlap < positionByOverlap.size(); overlap++)
+			{
+				TPingPongSignaturesPerContig &pingPongSignaturesPerContig = pingPongSignaturesByOverlap[overlap][contig->first];
+
+				// move iterator of ping-pong signature to start of current transposon
+				while ((positionByOverlap[overlap] != pingPongSignaturesPerContig.begin()) && ((positionByOverlap[overlap] == pingPongSignaturesPerContig.end()) || (positionByOverlap[overlap]->position > transposons.start[transposon])))
+					--(positionByOverlap[overlap]);
+				while ((positionByOverlap[overlap] != pingPongSignaturesPerContig.end()) && (positionByOverlap[overlap]->position < transposons.start[transposon]))
+					++(positionByOverlap[overlap]);
+
+				// sum up the scores of all signatures (ping-pong or arbitrary) within the transposon region
+				float sumOfScores = 0;
+				while ((positionByOverlap[overlap] != pingPongSignaturesPerContig.end()) && (positionByOverlap[overlap]->position <= transposons.end[transposon]))
+				{
+					// sum up scores of all signatures (ping-pong or arbitrary) within the transposon region
+					sumOfScores += (positionByOverlap[overlap]->readsOnPlusStrand + positionByOverlap[overlap]->readsOnMinusStrand) * (1 - getFDR(fdrTable, overlap, *positionByOverlap[overlap]));
+
+					// sum up the number of reads on each strand (for ping-pong overlaps only)
+					if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP == PING_PONG_OVERLAP)
+					{
+						scores.readsOnPlusStrand[transposon] += positionByOverlap[overlap]->readsOnPlusStrand;
+						scores.readsOnMinusStrand[transposon] += positionByOverlap[overlap]->readsOnMinusStrand;
+					}
+
+					++(positionByOverlap[overlap]);
+				}
+
+				histogram[overlap] = sumOfScores;
+			}
+
+			scores.pValue[transposon] = calculatePValueOfHistogram(histogram);
+
+			// add the transposon to the accumulator of its family
+			if (familyScores != NULL)
+			{
+				unsigned int family = transposons.family[transposon];
+				float *familyHistogram = &familyScores->histograms[family * ARBITRARY_OVERLAP_COUNT];
+				for (unsigned int overlap = 0; overlap < ARBITRARY_OVERLAP_COUNT; overlap++)
+					familyHistogram[overlap] += histogram[overlap];
+				familyScores->readsOnPlusStrand[family] += scores.readsOnPlusStrand[transposon];
+				familyScores->readsOnMinusStrand[family] += scores.readsOnMinusStrand[transposon];
+			}
+		}
+	}
+
+	// correct p-values for multiple testing
+	vector< unsigned int > transposonsSortedByPValue;
+	transposonsSortedByPValue.reserve(transposonCount);
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+		for (unsigned int transposon = contig->second.begin; transposon < contig->second.end; transposon++)
+			transposonsSortedByPValue.push_back(transposon);
+	calculateQValues(transposonsSortedByPValue, scores);
+
+	// evaluate all families in one batch
+	if (familyScores != NULL)
+	{
+		vector< unsigned int > familiesSortedByPValue(familyScores->pValue.size());
+		for (unsigned int family = 0; family < familiesSortedByPValue.size(); family++)
+		{
+			familyScores->pValue[family] = calculatePValueOfHistogram(&familyScores->histograms[family * ARBITRARY_OVERLAP_COUNT]);
+			familiesSortedByPValue[family] = family;
+		}
+		calculateQValues(familiesSortedByPValue, *familyScores);
+	}
+}
+
+// Similar to the function <findSuppressedTransposons>, this function transposons for ping-pong activity.
+// In contrast to <findSuppressedTransposons>, this function does not take transposons as an input argument,
+// but tries to find transposons automatically based on where there is a lot of ping-pong activity.
+// Input parameters:
+//	pingPongSignaturesByOverlap: the ping-pong signtures found by function <countStacksByGroup>
+//	fdrTable: the FDR of every class of signatures as calculated by the function <buildFDRTable>
+//      bamNameStore: a mapping of numeric contig IDs to human readable names
+//	range: ping-pong signatures that are this close to one another are considered to belong to the same transposon
+// Output parameters:
+//	putativeTransposons: putative transposons that were found by the function
+//	scores: p- and q-values of the putative transposons
+void predictSuppressedTransposons(TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, const TFDRTable &fdrTable, TTransposonTable &putativeTransposons, TTransposonScores &scores, const TNameStore &bamNameStore, unsigned int range)
+{
+	// define a putative transposon around every ping-pong signature
+	for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP].begin(); contig != pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP].end() && contig->second.size() > 0; ++contig)
+	{
+		unsigned int putativeTransposonStart = contig->second.begin()->position;
+		unsigned int putativeTransposonEnd = putativeTransposonStart + 1;
+		for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
+		{
+			if (putativeTransposonEnd + range >= pingPongSignature->position) // merge close-by windows
+			{
+				putativeTransposonEnd = pingPongSignature->position + 1;
+			}
+			else // the ping-pong signatures are so far apart, that they likely do not belong to the same transposon
+			{
+				if (putativeTransposonStart + PREDICT_TRANSPOSONS_MIN_LENGTH < putativeTransposonEnd) // skip regions that are too short
+				{
+					// name putative transposon after genomic location
+					stringstream putativeTransposonIdentifier;
+					putativeTransposonIdentifier << bamNameStore[contig->first] << ":" << putativeTransposonStart << "-" << putativeTransposonEnd;
+
+					// add transposon to table
+					string identifier = putativeTransposonIdentifier.str();
+					appendTransposon(putativeTransposons, TStringView(identifier.data(), identifier.size()), TStringView(identifier.data(), identifier.size()), contig->first, STRAND_PLUS, putativeTransposonStart, putativeTransposonEnd);
+				}
+
+				// start a new region
+				putativeTransposonStart = pingPongSignature->position;
+				putativeTransposonEnd = putativeTransposonStart + 1;
+			}
+		}
+	}
+	sortTransposonTable(putativeTransposons); // the transposons are already sorted, but the rows of each contig need to be determined
+
+	// check putative transposons for ping-pong activity
+	findSuppressedTransposons(pingPongSignaturesByOverlap, fdrTable, putativeTransposons, scores);
+}
+
+// function to format a chunk of transposons for <writeTransposonsToFile>
+// Input parameters:
+//	transposonChunks: the transposons of every chunk
+//	transposons, scores, bamNameStore, browserTracks, totalReadCount: see <writeTransposonsToFile>
+//	chunk: the number of the chunk to format
+// Output parameters:
+//	streams: the streams for the TSV file and the BED file
+void formatTransposons(const vector< TTransposonChunk > *transposonChunks, const TTransposonTable *transposons, const TTransposonScores *scores, const TNameStore *bamNameStore, bool browserTracks, double totalReadCount, unsigned int chunk, vector< stringstream > &streams)
+{
+	const TTransposonChunk &transposonChunk = (*transposonChunks)[chunk];
+	const CharString &contig = (*bamNameStore)[transposonChunk.contig];
+	for (unsigned int transposon = transposonChunk.begin; transposon < transposonChunk.end; transposon++)
+	{
+		float pingPongReads = scores->histograms[transposon * ARBITRARY_OVERLAP_COUNT + PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP];
+		writeInternedString(streams[0], transposons->identifiers, transposons->identifier[transposon]) << '\t'
+			<< ((transposons->strand[transposon] == STRAND_PLUS) ? '+' : '-') << '\t'
+			<< contig << '\t'
+			<< transposons->start[transposon] << '\t'
+			<< transposons->end[transposon] << '\t'
+			<< scores->pValue[transposon] << '\t'
+			<< scores->qValue[transposon] << '\t'
+			<< pingPongReads << '\t'
+			<< pingPongReads / ((static_cast<float>(transposons->end[transposon]) - transposons->start[transposon])/1000) / (totalReadCount/1000000) << '\t'
+			<< ((scores->readsOnPlusStrand[transposon]+scores->readsOnMinusStrand[transposon]) - pingPongReads) << '\t'
+			<< ((scores->readsOnMinusStrand[transposon] > 0) ? scores->readsOnPlusStrand[transposon]/scores->readsOnMinusStrand[transposon] : 1) << '\n';
+		if (browserTracks)
+		{
+			streams[1]
+				<< contig << '\t'
+				<< transposons->start[transposon] << '\t'
+				<< transposons->end[transposon] << '\t';
+			writeInternedString(streams[1], transposons->identifiers, transposons->identifier[transposon]) << '\t'
+				<< static_cast<int>(round((1 - scores->qValue[transposon]) * 1000)) << '\t'
+				<< ((transposons->strand[transposon] == STRAND_PLUS) ? '+' : '-') << '\n';
+		}
+	}
+}
+
+// Function to write transposons to a TSV file.
+// Input paramters:
+//	transposons: the transposons to write to the file
+//	scores: the p- and q-values of the transposons as calculated by the function <findSuppressedTransposons>
+//      bamNameStore: a mapping of numeric contig IDs to human readable names
+//	browserTracks: if set to true, then a BED file is generated in addition to the TSV file
+//	fileName: the name of the file within the <sink> that the transposons are written to, without the file extension
+//	totalReadCount: the total number of reads (as returned by countReadsInBamFile) for normalization
+//	threads: the number of threads to format the lines of the files (see <writeChunksInParallel>)
+// Input/output parameters:
+//	sink: the output sink to write the files to
+void writeTransposonsToFile(const TTransposonTable &transposons, const TTransposonScores &scores, const TNameStore &bamNameStore, bool browserTracks, TOutputSink &sink, string fileName, const double totalReadCount, unsigned int threads)
+{
+	// open files to write transposon data to
+	TOutputFile transposonsTSV;
+	if (openOutputFile(sink, fileName + ".tsv", transposonsTSV) != 0)
+	{
+		cerr << "Failed to create TSV file for transposons" << endl;
+		return;
+	}
+	TOutputFile transposonsBED;
+	if (browserTracks)
+	{
+		if (openOutputFile(sink, fileName + ".bed", transposonsBED) != 0)
+		{
+			cerr << "Failed to create browser track file for transposons" << endl;
+			return;
+		}
+	}
+
+	// use scientific formatting for floating point numbers in the output files
+	transposonsTSV.stream->setf(ios::scientific, ios::floatfield);
+	if (browserTracks)
+		transposonsBED.stream->setf(ios::scientific, ios::floatfield);
+
+	// write file headers
+	*transposonsTSV.stream << "identifier\tstrand\tcontig\tstart\tend\tpValue\tqValue\tpingPongReads\tnormalizedPingPongReads\tdiscardedPingPongReads\tstrandRatio" << endl;
+	if (browserTracks)
+	{
+		// remove underscores (_) from fileName for the track name
+		stringReplace(fileName, "_", " ");
+		*transposonsBED.stream << "track name=\"" << fileName << "\" description=\"" << fileName << " shaded by ping-pong activity (1000 * (1 - q-value))\" useScore=1 visibility=dense" << endl;
+	}
+
+	// split the transposons into chunks of at most <OUTPUT_CHUNK_SIZE> transposons of a single contig
+	vector< TTransposonChunk > transposonChunks;
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+		for (unsigned int transposon = contig->second.begin; transposon < contig->second.end; transposon += OUTPUT_CHUNK_SIZE)
+		{
+			TTransposonChunk transposonChunk = { contig->first, transposon, min(transposon + OUTPUT_CHUNK_SIZE, contig->second.end) };
+			transposonChunks.push_back(transposonChunk);
+		}
+
+	// write transposon data in TSV/BED format
+	vector< ostream * > files(1, transposonsTSV.stream);
+	if (browserTracks)
+		files.push_back(transposonsBED.stream);
+	writeChunksInParallel(files, transposonChunks.size(), bind(formatTransposons, &transposonChunks, &transposons, &scores, &bamNameStore, browserTracks, totalReadCount, placeholders::_1, placeholders::_2), threads);
+
+	// close output files
+	closeOutputFile(transposonsTSV);
+	closeOutputFile(transposonsBED);
+}
+
+// Function to write the aggregated ping-pong activity of transposon families to a TSV file.
+// Input paramters:
+//	transposons: the transposons that the families were aggregated from
+//	familyScores: the p- and q-values of the families as calculated by the function <findSuppressedTransposons>
+//	fileName: the name of the file within the <sink> that the families are written to, without the file extension
+//	totalReadCount: the total number of reads (as returned by countReadsInBamFile) for normalization
+// Input/output parameters:
+//	sink: the output sink to write the file to
+void writeTransposonFamiliesToFile(const TTransposonTable &transposons, const TTransposonScores &familyScores, TOutputSink &sink, const string &fileName, const double totalReadCount)
+{
+	TOutputFile outputFile;
+	if (openOutputFile(sink, fileName + ".tsv", outputFile) != 0)
+	{
+		cerr << "Failed to create TSV file for transposon families" << endl;
+		return;
+	}
+	ostream &familiesTSV = *outputFile.stream;
+
+	// count the copies of every family and their total length for normalization
+	vector< unsigned int > copies(familyScores.pValue.size(), 0);
+	vector< double > totalLength(familyScores.pValue.size(), 0);
+	for (unsigned int transposon = 0; transposon < transposons.family.size(); transposon++)
+	{
+		copies[transposons.family[transposon]]++;
+		totalLength[transposons.family[transposon]] += static_cast<double>(transposons.end[transposon]) - transposons.start[transposon];
+	}
+
+	// use scientific formatting for floating point numbers in the output file
+	familiesTSV.setf(ios::scientific, ios::floatfield);
+
+	familiesTSV << "family\tcopies\tpValue\tqValue\tpingPongReads\tnormalizedPingPongReads\tdiscardedPingPongReads\tstrandRatio" << endl;
+	for (unsigned int family = 0; family < familyScores.pValue.size(); family++)
+	{
+		float pingPongReads = familyScores.histograms[family * ARBITRARY_OVERLAP_COUNT + PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP];
+		writeInternedString(familiesTSV, transposons.families, family) << '\t'
+			<< copies[family] << '\t'
+			<< familyScores.pValue[family] << '\t'
+			<< familyScores.qValue[family] << '\t'
+			<< pingPongReads << '\t'
+			<< pingPongReads / (totalLength[family]/1000) / (totalReadCount/1000000) << '\t'
+			<< ((familyScores.readsOnPlusStrand[family]+familyScores.readsOnMinusStrand[family]) - pingPongReads) << '\t'
+			<< ((familyScores.readsOnMinusStrand[family] > 0) ? familyScores.readsOnPlusStrand[family]/familyScores.readsOnMinusStrand[family] : 1) << endl;
+	}
+
+	closeOutputFile(outputFile);
+}
+
+// generate plots that illustrate the statistical significance of ping-pong activity for a list of transposons
+// Input paramters:
+//	transposons: a table of transposons; a plot is generated for each of them
+//	scores: the histograms and p-values of the transposons as calculated by the function <findSuppressedTransposons>
+//	fileName: name of the file within the <sink> that the plots are written to
+// Input/output parameters:
+//	sink: the output sink to write the plots to
+// Output parameters:
+//	deferredScripts: if not NULL, the R script is not executed, but appended to this list (see <plotHistogram>)
+void generateTransposonsPlot(const TTransposonTable &transposons, const TTransposonScores &scores, TOutputSink &sink, const string &fileName, vector< string > *deferredScripts = NULL)
+{
+	int transposonCount = transposons.start.size();
+
+	THistograms histograms(transposonCount);
+	vector< string > plotTitles(transposonCount);
+	stringstream ss;
+	unsigned int i = 0;
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+		for (unsigned int transposon = contig->second.begin; transposon < contig->second.end; transposon++)
+		{
+			histograms[i].assign(scores.histograms.begin() + transposon * ARBITRARY_OVERLAP_COUNT, scores.histograms.begin() + (transposon + 1) * ARBITRARY_OVERLAP_COUNT);
+			ss << "z-scores of transposon ";
+			writeInternedString(ss, transposons.identifiers, transposons.identifier[transposon]) << endl
+				<< "(p-value for overlap of " << PING_PONG_OVERLAP << " nt = " << scores.pValue[transposon] << ")";
+			plotTitles[i] = ss.str();
+			ss.str("");
+			i++;
+		}
+	plotHistogram(sink, fileName, plotTitles, histograms, deferredScripts);
+}
+
+// function to check if two name stores contain the same contig names in the same order
+// Input parameters:
+//	nameStore1, nameStore2: the name stores to compare
+// Return value: true, if the name stores are identical; false otherwise
+bool nameStoresEqual(const TNameStore &nameStore1, const TNameStore &nameStore2)
+{
+	if (length(nameStore1) != length(nameStore2))
+		return false;
+	for (unsigned int i = 0; i < length(nameStore1); i++)
+		if (nameStore1[i] != nameStore2[i])
+			return false;
+	return true;
+}
+
+// function to check the @SQ header lines of an input file against the contigs of the previous input files of a sample
+// The contigs of the header are referred to by their numeric IDs, so they must come first in the name store,
+// while contigs that are only used by count tables may follow (see <countReadsInCountTable>).
+// Input parameters:
+//	headerNameStore: the contigs from the header of the input file
+// Input/output parameters:
+//	bamNameStore: the contigs of the previous input files, which are set to <headerNameStore>, if there are none yet
+// Return value: false, if the header does not match the first contigs of <bamNameStore>; true otherwise
+bool mergeHeaderNameStore(TNameStore &bamNameStore, const TNameStore &headerNameStore)
+{
+	if (length(bamNameStore) == 0)
+	{
+		bamNameStore = headerNameStore;
+		return true;
+	}
+	if (length(headerNameStore) > length(bamNameStore))
+		return false;
+	for (unsigned int i = 0; i < length(headerNameStore); i++)
+		if (headerNameStore[i] != bamNameStore[i])
+			return false;
+	return true;
+}
+
+// type to hold a line of a count table until the lines are sorted (see <countReadsInCountTable>)
+struct TCountTableEntry
+{
+	unsigned int strand;
+	unsigned int contig;
+	unsigned int position; // key of the stack in <TReadStacksPerContig>
+	float reads;
+	bool AAtPosition10;
+};
+
+// function to sort the lines of a count table by strand, contig and position
+inline bool compareCountTableEntries(const TCountTableEntry &entry1, const TCountTableEntry &entry2)
+{
+	if (entry1.strand != entry2.strand)
+		return entry1.strand < entry2.strand;
+	else if (entry1.contig != entry2.contig)
+		return entry1.contig < entry2.contig;
+	else
+		return entry1.position < entry2.position;
+}
+
+// function to check whether an input file is a table of read counts rather than a SAM/BAM/CRAM file
+// Input parameters:
+//	fileName: the input file
+// Output parameters:
+//	bedGraph: whether the table is in bedGraph format (otherwise it is in TSV format)
+// Return value: true, if the file is a count table; false otherwise
+bool isCountTable(const char *fileName, bool &bedGraph)
+{
+	bedGraph = _compareExtension(fileName, ".bedGraph") || _compareExtension(fileName, ".bg");
+	return bedGraph || _compareExtension(fileName, ".tsv");
+}
+
+// Function which reads stacks of reads from a table of read counts per 5' end, which other pipelines may produce instead of a BAM file.
+// Two formats are accepted:
+// - TSV files with the columns contig, strand (+/-), position of the 5' end (1-based), number of reads, and whether the 10th base is adenine (1/0)
+//   a header line is skipped
+// - bedGraph files, whose intervals (0-based, half-open) hold the number of reads with a 5' end at every position of the interval;
+//   positive values count reads on the + strand, negative values reads on the - strand; since bedGraph files do not tell the base at
+//   position 10, all stacks are assumed not to have adenine at position 10
+// Since the reads are counted already, the filters by alignment length and multi-hits do not apply.
+// The lines are collected and sorted first, such that the stacks can be appended to <readStacks> in order.
+// Input parameters:
+//	fileName: the count table from where to load the stacks
+//	bedGraph: whether the file is in bedGraph format (see <isCountTable>)
+// Input/output parameters:
+//	readStacks: the stacks of the file are added to these stacks; if NULL, only the names of the contigs are collected
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+//	              the name store is extended by names that it does not contain, but that are used in the count table
+//	totalReadCount: the number of reads in the table is added to this variable
+// Return value: 1, if the file could not be read; 0 otherwise
+int countReadsInCountTable(const char *fileName, bool bedGraph, TReadStacksPerGenome *readStacks, TNameStore &bamNameStore, double &totalReadCount)
+{
+	TMappedFile mappedFile;
+	if (openMappedFile(fileName, mappedFile) != 0)
+	{
+		cerr << "Failed to open input file: " << fileName << endl;
+		return 1;
+	}
+
+	// index the contig names, so they can be looked up quickly
+	TStringArena contigNames;
+	for (unsigned int i = 0; i < length(bamNameStore); i++)
+		internString(contigNames, toCString(bamNameStore[i]), length(bamNameStore[i]));
+
+	vector< TCountTableEntry > entries;
+	const char *character = mappedFile.data;
+	const char *fileEnd = mappedFile.data + mappedFile.size;
+	unsigned int lineNumber = 0;
+	bool firstRow = true; // the first row of a TSV file may be a header
+	while (character < fileEnd)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(character, '\n', fileEnd - character));
+		if (lineEnd == NULL)
+			lineEnd = fileEnd;
+		const char *nextLine = lineEnd + 1;
+		if ((lineEnd > character) && (*(lineEnd-1) == '\r'))
+			lineEnd--;
+		lineNumber++;
+
+		// split line into fields (bedGraph files may be separated by spaces)
+		vector< TStringView > fields;
+		while (character < lineEnd)
+		{
+			const char *fieldEnd = character;
+			while ((fieldEnd < lineEnd) && (*fieldEnd != '\t') && (!bedGraph || (*fieldEnd != ' ')))
+				fieldEnd++;
+			fields.push_back(TStringView(character, fieldEnd - character));
+			character = fieldEnd + 1;
+		}
+		character = nextLine;
+
+		// skip empty lines, comments and track definitions
+		if (fields.empty() || (fields[0].characters[0] == '#') || (bedGraph && ((fields[0] == "track") || (fields[0] == "browser"))))
+			continue;
+
+		TCountTableEntry entry;
+		unsigned int end = 0;
+		bool valid;
+		if (bedGraph)
+		{
+			valid = (fields.size() >= 4) && parseUnsignedInteger(fields[1], entry.position) && parseUnsignedInteger(fields[2], end) && (entry.position < end) && parseFloat(fields[3], entry.reads);
+			if (valid)
+			{
+				entry.strand = (entry.reads < 0) ? STRAND_MINUS : STRAND_PLUS;
+				entry.reads = fabs(entry.reads);
+				entry.AAtPosition10 = false;
+			}
+		}
+		else
+		{
+			valid = (fields.size() >= 5) && (fields[1].length == 1) && ((fields[1].characters[0] == '+') || (fields[1].characters[0] == '-')) && parseUnsignedInteger(fields[2], entry.position) && (entry.position > 0) && parseFloat(fields[3], entry.reads) && (entry.reads >= 0) && ((fields[4] == "0") || (fields[4] == "1"));
+			if (!valid && firstRow)
+			{
+				// a header must name the five columns, otherwise the file is likely not a count table at all, e.g., an output file of pingpongpro
+				unsigned int number;
+				if ((fields.size() < 5) || (fields[1] == "+") || (fields[1] == "-") || parseUnsignedInteger(fields[2], number))
+				{
+					cerr << "Count table \"" << fileName << "\" starts with neither a header nor a row with the columns contig, strand, position, reads and A at position 10." << endl;
+					closeMappedFile(mappedFile);
+					return 1;
+				}
+				firstRow = false;
+				continue; // header line
+			}
+			firstRow = false;
+			if (valid)
+			{
+				entry.strand = (fields[1].characters[0] == '-') ? STRAND_MINUS : STRAND_PLUS;
+				entry.AAtPosition10 = (fields[4] == "1");
+				entry.position--; // convert to 0-based coordinates
+				end = entry.position + 1;
+			}
+		}
+		if (!valid)
+		{
+			cerr << "Malformed line " << lineNumber << " in count table \"" << fileName << "\"." << endl;
+			closeMappedFile(mappedFile);
+			return 1;
+		}
+		if (entry.reads == 0)
+			continue;
+
+		entry.contig = internString(contigNames, fields[0].characters, fields[0].length);
+		if (entry.contig == length(bamNameStore)) // the contig was not found in the name store
+			appendValue(bamNameStore, CharString(string(fields[0].characters, fields[0].length)));
+		if (readStacks == NULL)
+			continue;
+
+		// stacks on the - strand are stored at the position after the 5' end (see <countAlignment>)
+		unsigned int shift = (entry.strand == STRAND_MINUS) ? 1 : 0;
+		for (unsigned int position = entry.position; position < end; position++)
+		{
+			TCountTableEntry positionEntry = entry;
+			positionEntry.position = position + shift;
+			entries.push_back(positionEntry);
+		}
+	}
+	closeMappedFile(mappedFile);
+
+	// append the stacks in order, so that every insertion takes constant time (see <addToStackStore>)
+	sort(entries.begin(), entries.end(), compareCountTableEntries);
+	TReadStacksPerContig *readStacksPerContig = NULL;
+	for (vector< TCountTableEntry >::iterator entry = entries.begin(); entry != entries.end(); ++entry)
+	{
+		if ((entry == entries.begin()) || (entry->strand != (entry-1)->strand) || (entry->contig != (entry-1)->contig))
+			readStacksPerContig = &getContigStacks(*readStacks, entry->strand, entry->contig);
+		addToStackStore(*readStacksPerContig, entry->position, entry->reads, entry->AAtPosition10);
+		totalReadCount += entry->reads;
+	}
+	return 0;
+}
+
+// function to check whether a file is in CRAM format
+// Input parameters:
+//	fileName: the file to check
+// Return value: true, if the file starts with the magic number of CRAM files; false otherwise
+bool isCramFile(const char *fileName)
+{
+	char magic[4];
+	ifstream file(fileName, ios_base::in | ios_base::binary);
+	return file.read(magic, sizeof(magic)) && (memcmp(magic, "CRAM", sizeof(magic)) == 0);
+}
+
+#ifdef PINGPONGPRO_BLOCK_READER
+// function to read the number of mapped reads per contig from the index of a BAM file (.bai)
+// The number is taken from the pseudo-bin, which samtools index adds to every contig.
+// Input parameters:
+//	fileName: the BAM file; the index is looked for at <fileName>.bai and with the extension replaced by .bai
+// Output parameters:
+//	mappedReads: the number of mapped reads of every contig
+// Return value: 1, if there is no index or it cannot be read; 0 otherwise
+int readBamIndex(const string &fileName, vector< uint64_t > &mappedReads)
+{
+	TMappedFile index;
+	if ((openMappedFile((fileName + ".bai").c_str(), index) != 0) &&
+	    ((fileName.size() < 4) || (openMappedFile((fileName.substr(0, fileName.size() - 4) + ".bai").c_str(), index) != 0)))
+		return 1;
+
+	const char *data = index.data;
+	const char *end = index.data + index.size;
+	bool valid = (index.size >= 8) && (memcmp(data, "BAI\1", 4) == 0);
+	int32_t contigCount = valid ? readInt32(data + 4) : 0;
+	data += 8;
+	mappedReads.assign(max(contigCount, 0), 0);
+	for (int32_t contig = 0; (contig < contigCount) && valid; contig++)
+	{
+		valid = (end - data >= 4);
+		int32_t binCount = valid ? readInt32(data) : 0;
+		data += 4;
+		for (int32_t bin = 0; (bin < binCount) && valid; bin++)
+		{
+			valid = (end - data >= 8);
+			uint32_t binNumber = valid ? static_cast<uint32_t>(readInt32(data)) : 0;
+			int32_t chunkCount = valid ? readInt32(data + 4) : 0;
+			data += 8;
+			valid = valid && (chunkCount >= 0) && (end - data >= 16 * static_cast<int64_t>(chunkCount));
+			if (valid && (binNumber == 37450) && (chunkCount == 2)) // pseudo-bin: the second chunk holds the number of mapped and unmapped reads
+				mappedReads[contig] = readUInt64(data + 16);
+			data += 16 * static_cast<int64_t>(chunkCount);
+		}
+		valid = valid && (end - data >= 4);
+		int32_t intervalCount = valid ? readInt32(data) : 0;
+		data += 4;
+		valid = valid && (intervalCount >= 0) && (end - data >= 8 * static_cast<int64_t>(intervalCount));
+		data += 8 * static_cast<int64_t>(intervalCount);
+	}
+	closeMappedFile(index);
+	return valid ? 0 : 1;
+}
+
+// function to read the names and lengths of the contigs from the header of a BAM file
+// Input parameters:
+//	fileName: the BAM file
+// Output parameters:
+//	contigs: the contigs in the order of the header with <name> and <length> set
+// Return value: 1, if the file is not a BAM file or cannot be read; 0 otherwise
+int readBamContigLengths(const string &fileName, vector< TContigPlan > &contigs)
+{
+	gzFile bamFile = gzopen(fileName.c_str(), "rb");
+	if (bamFile == NULL)
+		return 1;
+	char header[8];
+	bool valid = (gzread(bamFile, header, sizeof(header)) == sizeof(header)) && (memcmp(header, "BAM\1", 4) == 0);
+	valid = valid && (gzseek(bamFile, readInt32(header + 4), SEEK_CUR) >= 0); // skip SAM header text
+	char field[4];
+	valid = valid && (gzread(bamFile, field, sizeof(field)) == sizeof(field));
+	int32_t contigCount = valid ? readInt32(field) : 0;
+	for (int32_t contig = 0; (contig < contigCount) && valid; contig++)
+	{
+		valid = gzread(bamFile, field, sizeof(field)) == sizeof(field);
+		int32_t nameLength = valid ? readInt32(field) : 0;
+		string name(max(nameLength, 0), '\0');
+		valid = valid && (nameLength > 0) && (gzread(bamFile, &name[0], nameLength) == nameLength) && (gzread(bamFile, field, sizeof(field)) == sizeof(field));
+		if (valid)
+		{
+			contigs.push_back(TContigPlan());
+			contigs.back().id = contig;
+			contigs.back().name = name.substr(0, nameLength - 1); // the name is terminated by NUL
+			contigs.back().length = readInt32(field);
+		}
+	}
+	gzclose(bamFile);
+	return valid ? 0 : 1;
+}
+#endif
+
+// function to compare contigs by their estimated memory consumption, largest first
+inline bool compareContigPlansByMemory(const TContigPlan &contig1, const TContigPlan &contig2)
+{
+	return contig1.memory > contig2.memory;
+}
+
+// function to look up a store given with --stack-store
+// Input parameters:
+//	name: the name of the store (see <STACK_STORE_NAMES>)
+// Output parameters:
+//	store: the store; unchanged, if the name is not the name of a store
+// Return value: false, if the name is not the name of a store (e.g., "auto"); true otherwise
+bool parseStackStoreName(const string &name, TStackStoreType &store)
+{
+	for (unsigned int type = stackStoreMap; type <= stackStoreCompressed; type++)
+		if (name == STACK_STORE_NAMES[type])
+		{
+			store = static_cast<TStackStoreType>(type);
+			return true;
+		}
+	return false;
+}
+
+// This function plans the analysis of a sample before its input files are read.
+// The number of mapped reads and the length of every contig are taken from the BAM indices and headers to estimate the number of stacks
+// (at most one per strand and position) and the number of ping-pong signatures, which depends on the density of stacks.
+// The density of the stacks decides, which store the stacks of a contig are kept in, unless a store is given with --stack-store:
+// the dense store, if it is smaller than the flat store, and the flat store otherwise (the input files are sorted, since they are indexed).
+// From these, the peak memory consumption, the size of the tiles of <countStacksByGroup> and the number of threads that can be kept busy are derived.
+// Input parameters:
+//	inputFiles: the input files of the sample
+//	options: the options from the command line
+//	threads: the number of threads available to the sample
+// Output parameters:
+//	plan: the plan; <available> is false, if not all input files are BAM files with an index
+void planRun(const TInputFiles &inputFiles, const AppOptions &options, unsigned int threads, TRunPlan &plan)
+{
+	plan = TRunPlan();
+	#ifdef PINGPONGPRO_BLOCK_READER
+	for (TInputFiles::const_iterator inputFile = inputFiles.begin(); inputFile != inputFiles.end(); ++inputFile)
+	{
+		vector< TContigPlan > contigs;
+		vector< uint64_t > mappedReads;
+		if ((readBamContigLengths(toCString(*inputFile), contigs) != 0) || (readBamIndex(toCString(*inputFile), mappedReads) != 0) || (mappedReads.size() != contigs.size()))
+			return;
+		if (inputFile == inputFiles.begin())
+			plan.contigs = contigs;
+		else if (contigs.size() != plan.contigs.size())
+			return; // the headers differ, which is reported when the files are read
+		for (unsigned int contig = 0; contig < plan.contigs.size(); contig++)
+			plan.contigs[contig].mappedReads += mappedReads[contig];
+	}
+	plan.available = !inputFiles.empty();
+
+	// the signatures with arbitrary overlaps are only kept in memory, if they are needed (see <analyzeSample>)
+	bool keepAllSignatures = options.signatureIndex || (options.transposonFiles.size() > 0) || (options.predictTransposonsRange > 0);
+	double totalStacks = 0;
+	double totalMemory = 0;
+	for (vector< TContigPlan >::iterator contig = plan.contigs.begin(); contig != plan.contigs.end(); ++contig)
+	{
+		contig->stacks = contig->mappedReads * STACKS_PER_MAPPED_READ;
+		if (contig->length > 0)
+			contig->stacks = min(contig->stacks, 2.0 * contig->length);
+		// every stack on the + strand forms a signature with every stack on the - strand in the range of the overlaps
+		double stacksPerStrandAndPosition = (contig->length > 0) ? contig->stacks / 2 / contig->length : 1;
+		contig->signatures = contig->stacks / 2 * stacksPerStrandAndPosition * (keepAllSignatures ? ARBITRARY_OVERLAP_COUNT : 1);
+		double denseMemory = 2.0 * contig->length * BYTES_PER_DENSE_SLOT;
+		if (!parseStackStoreName(options.stackStore, contig->store))
+			contig->store = ((contig->length > 0) && (denseMemory < contig->stacks * BYTES_PER_STACK[stackStoreFlat])) ? stackStoreDense : stackStoreFlat;
+		contig->memory = ((contig->store == stackStoreDense) ? denseMemory : contig->stacks * BYTES_PER_STACK[contig->store]) + contig->signatures * BYTES_PER_SIGNATURE;
+		totalStacks += contig->stacks;
+		totalMemory += contig->memory;
+	}
+	stable_sort(plan.contigs.begin(), plan.contigs.end(), compareContigPlansByMemory);
+
+	// make the tiles small enough that every thread gets several tiles
+	plan.stacksPerTile = static_cast<unsigned int>(max< double >(MIN_STACKS_PER_TILE, min< double >(STACKS_PER_TILE, totalStacks / 2 / (threads * TILES_PER_THREAD))));
+	plan.threads = max(1.0, min(static_cast<double>(threads), ceil(totalStacks / 2 / plan.stacksPerTile)));
+
+	// all stacks are held in memory after reading and the signatures pile up, while the stacks are freed contig by contig;
+	// in addition, every tile in flight holds a table of grouped stack counts
+	plan.peakMemory = totalMemory + plan.threads * TILES_PER_THREAD * ARBITRARY_OVERLAP_COUNT * HEIGHT_SCORE_BINS * 2 * 2 * sizeof(float);
+	#endif
+}
+
+// function to print a plan calculated by <planRun> to stderr
+// Input parameters:
+//	plan: the plan to print
+//	verbosity: the plan is printed, if the verbosity level is >= INFO
+void printRunPlan(const TRunPlan &plan, unsigned int verbosity)
+{
+	if ((verbosity < 3) || !plan.available)
+		return;
+
+	const unsigned int MAX_PRINTED_CONTIGS = 10;
+	cerr << "Run plan (from BAM index):" << endl;
+	cerr << "  contig\tlength\tmapped reads\testimated stacks\tstacks per nt\tstack store\testimated memory (MB)" << endl;
+	for (unsigned int contig = 0; (contig < plan.contigs.size()) && (contig < MAX_PRINTED_CONTIGS); contig++)
+		cerr << "  "
+		     << plan.contigs[contig].name << '\t'
+		     << plan.contigs[contig].length << '\t'
+		     << plan.contigs[contig].mappedReads << '\t'
+		     << static_cast<uint64_t>(plan.contigs[contig].stacks) << '\t'
+		     << ((plan.contigs[contig].length > 0) ? plan.contigs[contig].stacks / plan.contigs[contig].length : 0) << '\t'
+		     << STACK_STORE_NAMES[plan.contigs[contig].store] << '\t'
+		     << (plan.contigs[contig].memory >> 20) << endl;
+	if (plan.contigs.size() > MAX_PRINTED_CONTIGS)
+		cerr << "  ... and " << (plan.contigs.size() - MAX_PRINTED_CONTIGS) << " smaller contigs" << endl;
+	unsigned int contigsPerStore[stackStoreCompressed + 1] = { 0 };
+	for (vector< TContigPlan >::const_iterator contig = plan.contigs.begin(); contig != plan.contigs.end(); ++contig)
+		contigsPerStore[contig->store]++;
+	cerr << "  stack stores:";
+	for (unsigned int store = stackStoreMap; store <= stackStoreCompressed; store++)
+		if (contigsPerStore[store] > 0)
+			cerr << ' ' << STACK_STORE_NAMES[store] << " for " << contigsPerStore[store] << " contigs";
+	cerr << endl;
+	cerr << "  predicted peak memory: " << ((plan.peakMemory + (1 << 20) - 1) >> 20) << " MB" << endl;
+	cerr << "  threads for grouping stacks: " << plan.threads << ", tile size: " << plan.stacksPerTile << " stacks" << endl;
+}
+
+// function to choose the stores, in which the read stacks of the contigs are kept (see <TReadStacksPerContig>)
+// Input parameters:
+//	options: the store given with --stack-store; if it is "auto", the stores are taken from the plan
+//	plan: if not NULL and available, the stores chosen for the contigs by <planRun>; contigs which are not planned are kept in map stores,
+//	      which do not depend on the order of the input files
+// Output parameters:
+//	stores: the store of every contig
+void selectStackStores(const AppOptions &options, const TRunPlan *plan, TStackStoreSelection &stores)
+{
+	stores = TStackStoreSelection();
+	if (parseStackStoreName(options.stackStore, stores.defaultType) || (plan == NULL) || !plan->available)
+		return;
+	for (vector< TContigPlan >::const_iterator contig = plan->contigs.begin(); contig != plan->contigs.end(); ++contig)
+	{
+		if (contig->id >= stores.contigs.size())
+			stores.contigs.resize(contig->id + 1, stores.defaultType);
+		stores.contigs[contig->id] = contig->store;
+	}
+}
+
+// function to write a distribution of the ingestion metrics as a JSON object, which maps the lower bound of every non-empty bin to its count
+// Input parameters:
+//	bins: the counts of the bins; the last bin holds all larger values, which is marked by a trailing "+" in its key
+//	binCount: the number of <bins>
+//	powersOfTwo: whether bin i holds the values from 2^i to 2^(i+1)-1 rather than the value i
+// Output parameters:
+//	jsonFile: the stream to write the object to
+void writeMetricsDistribution(ostream &jsonFile, const uint64_t *bins, unsigned int binCount, bool powersOfTwo)
+{
+	jsonFile << "{";
+	bool first = true;
+	for (unsigned int bin = 0; bin < binCount; bin++)
+	{
+		if (bins[bin] == 0)
+			continue;
+		jsonFile << (first ? "" : ", ") << "\"" << (powersOfTwo ? (static_cast<uint64_t>(1) << bin) : bin) << ((bin == binCount - 1) ? "+" : "") << "\": " << bins[bin];
+		first = false;
+	}
+	jsonFile << "}";
+}
+
+// This function writes the ingestion metrics collected by <countReadsInSample> to the file ingestion_metrics.json.
+// Input parameters:
+//	metrics: the metrics to write
+// Input/output parameters:
+//	sink: the output sink to write the file to
+void writeIngestMetricsFile(const TIngestMetrics &metrics, TOutputSink &sink)
+{
+	TOutputFile outputFile;
+	if (openOutputFile(sink, "ingestion_metrics.json", outputFile) != 0)
+	{
+		cerr << "Failed to create file \"" << outputPath(sink, "ingestion_metrics.json") << "\"." << endl;
+		return;
+	}
+	ostream &jsonFile = *outputFile.stream;
+
+	uint64_t passedLengthFilter = metrics.kept + metrics.filteredByMultiHits;
+	jsonFile << fixed << setprecision(4)
+		<< "{" << endl
+		<< "\t\"records\": " << metrics.records << "," << endl
+		<< "\t\"kept\": " << metrics.kept << "," << endl
+		<< "\t\"dropped\": {\"unmapped\": " << metrics.unmapped << ", \"length\": " << metrics.filteredByLength << ", \"multiHits\": " << metrics.filteredByMultiHits << "}," << endl
+		<< "\t\"alignmentLengths\": ";
+	writeMetricsDistribution(jsonFile, metrics.alignmentLengths, METRICS_LENGTH_BINS, false);
+	jsonFile << "," << endl << "\t\"multiHits\": ";
+	writeMetricsDistribution(jsonFile, metrics.multiHits, METRICS_MULTI_HIT_BINS, false);
+	jsonFile << "," << endl << "\t\"collapsedReads\": ";
+	writeMetricsDistribution(jsonFile, metrics.collapsedReads, METRICS_COLLAPSED_BINS, true);
+	jsonFile << "," << endl
+		<< "\t\"softClipped\": {"
+		<< "\"5'\": " << metrics.softClippedAt5PrimeEnd << ", \"3'\": " << metrics.softClippedAt3PrimeEnd
+		<< ", \"5'Rate\": " << ((passedLengthFilter > 0) ? 1.0 * metrics.softClippedAt5PrimeEnd / passedLengthFilter : 0)
+		<< ", \"3'Rate\": " << ((passedLengthFilter > 0) ? 1.0 * metrics.softClippedAt3PrimeEnd / passedLengthFilter : 0)
+		<< "}," << endl
+		<< "\t\"strands\": {" << endl;
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		jsonFile
+			<< "\t\t\"" << ((strand == STRAND_PLUS) ? '+' : '-') << "\": {"
+			<< "\"records\": " << metrics.keptRecords[strand] << ", \"reads\": " << metrics.keptReads[strand]
+			<< ", \"AAtPosition10Records\": " << metrics.AAtPosition10Records[strand] << ", \"AAtPosition10Reads\": " << metrics.AAtPosition10Reads[strand]
+			<< ", \"AAtPosition10Rate\": " << ((metrics.keptReads[strand] > 0) ? 1.0 * metrics.AAtPosition10Reads[strand] / metrics.keptReads[strand] : 0)
+			<< "}" << ((strand == STRAND_PLUS) ? "," : "") << endl;
+	jsonFile << "\t}" << endl << "}" << endl;
+
+	closeOutputFile(outputFile);
+}
+
+// This function counts the reads in all SAM/BAM/CRAM files of a sample.
+// Input parameters:
+//	inputFiles: the SAM/BAM/CRAM files and count tables of the sample
+//	options: the options from the command line
+//	verbosity: whether to print progress messages to stderr (see <stopwatch>)
+//	threads: the number of threads to decompress BAM files and to decode CRAM files (see <countReadsInBgzfFile> and <countReadsInCramFile>)
+//	statusFile: if not empty, the file to write the progress of reading the input files to (see <reportIngestProgress>)
+// Input/output parameters:
+//	readStacks: stacks of reads that were found in the input files, which are kept in the stores chosen by the caller (see <selectStackStores>)
+// Output parameters:
+//	threePrimeStacks: if not NULL, stacks of the 3' ends of the reads (see <countAlignment>), which are kept in the same stores as <readStacks>
+//	bamNameStore: mapping of numeric contig IDs to human-readable names as found in the @SQ header lines of the input files
+//	totalReadCount: the total number of reads that were not discarded
+//	metrics: if not NULL, counters of the records of the SAM/BAM/CRAM files (count tables are not counted)
+// Return value: 1, if an input file could not be read or if the headers of the input files differ; 0 otherwise
+int countReadsInSample(const TInputFiles &inputFiles, const AppOptions &options, unsigned int verbosity, unsigned int threads, const string &statusFile, TReadStacksPerGenome &readStacks, TReadStacksPerGenome *threePrimeStacks, TNameStore &bamNameStore, double &totalReadCount, TIngestMetrics *metrics)
+{
+	// report the progress of reading the files with --progress and --status-file
+	TIngestProgress progress;
+	progress.messages = options.progressInterval > 0;
+	progress.statusFile = statusFile;
+	if (progress.messages || !progress.statusFile.empty())
+		progress.interval = (options.progressInterval > 0) ? options.progressInterval : STATUS_FILE_INTERVAL;
+	vector< uint64_t > fileSizes(inputFiles.size(), 0);
+	for (unsigned int i = 0; i < inputFiles.size(); i++)
+	{
+		struct stat fileStats;
+		if (stat(toCString(inputFiles[i]), &fileStats) == 0)
+			fileSizes[i] = fileStats.st_size;
+		progress.totalBytes += fileSizes[i];
+	}
+	progress.start = progress.lastReport = chrono::steady_clock::now();
+
+	if (threePrimeStacks != NULL)
+		threePrimeStacks->stores = readStacks.stores;
+
+	// SAM/BAM/CRAM files are read before count tables, because the contigs of their headers are referred to by numeric IDs and must come first in the name store,
+	// whereas count tables refer to contigs by name and append those missing (see <mergeHeaderNameStore>)
+	vector< unsigned int > fileOrder;
+	bool bedGraph;
+	for (unsigned int countTables = 0; countTables <= 1; countTables++)
+		for (unsigned int i = 0; i < inputFiles.size(); i++)
+			if (isCountTable(toCString(inputFiles[i]), bedGraph) == (countTables == 1))
+				fileOrder.push_back(i);
+
+	for (vector< unsigned int >::iterator file = fileOrder.begin(); file != fileOrder.end(); ++file)
+	{
+		TInputFiles::const_iterator inputFile = inputFiles.begin() + *file;
+		stopwatch((string("  ") + toCString(*inputFile)).c_str(), verbosity);
+		if (file != fileOrder.begin())
+			progress.bytesDone += fileSizes[*(file - 1)];
+		progress.fileName = toCString(*inputFile);
+		progress.lineOpen = verbosity >= 3;
+		progress.bytesConsumed = 0;
+		progress.nameStore = NULL;
+		progress.contig = -1;
+
+		// count tables are loaded without further ado
+		if (isCountTable(toCString(*inputFile), bedGraph))
+		{
+			if (threePrimeStacks != NULL)
+			{
+				cerr << "Failed to read input file " << *inputFile << ": count tables lack the 3' ends of the reads, which are needed for the requested distance histograms" << endl;
+				return 1;
+			}
+			if (countReadsInCountTable(toCString(*inputFile), bedGraph, &readStacks, bamNameStore, totalReadCount) != 0)
+				return 1;
+			stopwatch(verbosity);
+			continue;
+		}
+
+		// CRAM files are not supported by SeqAn
+		if (isCramFile(toCString(*inputFile)))
+		{
+			#ifdef PINGPONGPRO_HTSLIB
+			if (options.referenceFile.empty())
+			{
+				cerr << "A reference genome (-r) is needed to read CRAM file: " << *inputFile << endl;
+				return 1;
+			}
+			TNameStore fileNameStore;
+			if (countReadsInCramFile(toCString(*inputFile), options.referenceFile, readStacks, threePrimeStacks, options.minAlignmentLength, options.maxAlignmentLength, options.countMultiHits, threads, fileNameStore, totalReadCount, progress) != 0)
+				return 1;
+			if (!mergeHeaderNameStore(bamNameStore, fileNameStore))
+			{
+				cerr << "@SQ header lines of '" << *inputFile << "' differ from those of previous input files" << endl;
+				return 1;
+			}
+			stopwatch(verbosity);
+			continue;
+			#else
+			cerr << "Failed to read input file " << *inputFile << ": CRAM files are only supported, if the program is compiled with htslib" << endl;
+			return 1;
+			#endif
+		}
+
+		#ifdef PINGPONGPRO_BLOCK_READER
+		// read BAM files without SeqAn, unless told otherwise
+		if (options.blockReader && isBgzfFile(toCString(*inputFile)))
+		{
+			TInputCounters counters;
+			TNameStore fileNameStore;
+			int result = countReadsInBgzfFile(toCString(*inputFile), readStacks, threePrimeStacks, options.minAlignmentLength, options.maxAlignmentLength, options.countMultiHits, threads, fileNameStore, totalReadCount, counters, progress);
+			if (result == 1)
+				return 1;
+			if (result == 0) // otherwise, the file is not a BAM file, but a compressed SAM file, which is left to SeqAn
+			{
+				if (!mergeHeaderNameStore(bamNameStore, fileNameStore))
+				{
+					cerr << "@SQ header lines of '" << *inputFile << "' differ from those of previous input files" << endl;
+					return 1;
+				}
+				stopwatch(verbosity);
+				printInputCounters(counters, verbosity);
+				continue;
+			}
+		}
+		#endif
+
+		// open SAM/BAM file
+		BamStream bamFile(toCString(*inputFile));
+		if (!isGood(bamFile))
+		{
+			cerr << "Failed to open input file: " << *inputFile << endl;
+			return 1;
+		}
+
+		// for every position in the genome, count the number of reads that start at a given position
+		if (countReadsInBamFile(bamFile, readStacks, threePrimeStacks, options.minAlignmentLength, options.maxAlignmentLength, options.countMultiHits, totalReadCount, progress) != 0)
+			return 1;
+
+		// remember @SQ header lines from BAM file for mapping of contig IDs to human-readable names
+		if (!mergeHeaderNameStore(bamNameStore, nameStore(bamFile.bamIOContext))) // if multiple BAM files are given, check if headers are identical
+		{
+			cerr << "@SQ header lines of '" << *inputFile << "' differ from those of previous input files" << endl;
+			return 1;
+		}
+
+		// close SAM/BAM file
+		close(bamFile);
+
+		stopwatch(verbosity);
+	}
+
+	freezeReadStacks(readStacks);
+	if (threePrimeStacks != NULL)
+		freezeReadStacks(*threePrimeStacks);
+
+	if (progress.interval > 0)
+	{
+		progress.bytesDone = progress.totalBytes;
+		progress.bytesConsumed = 0;
+		progress.lineOpen = false;
+		reportIngestProgress(progress, "analyzing");
+	}
+	if (metrics != NULL)
+		*metrics = progress.metrics;
+	return 0;
+}
+
+// This function reads the transposon files given on the command-line.
+// Input parameters:
+//	options: the options from the command line
+// Input/output parameters:
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+//	              the name store is extended by names that it does not contain, but that are used in the transposon files
+// Output parameters:
+//	transposons: the transposons read from the files, sorted by genomic position
+// Return value: 1, if a transposon file could not be read; 0 otherwise
+int loadTransposons(const AppOptions &options, TTransposonTable &transposons, TNameStore &bamNameStore)
+{
+	if (options.verbosity >= 3)
+		cerr << "Loading transposon coordinates" << endl;
+	if (!options.annotationCache.empty())
+	{
+		#if defined(WIN32) || defined(_WIN32)
+		CreateDirectory(options.annotationCache.c_str(), NULL);
+		#else
+		mkdir(options.annotationCache.c_str(), 0777);
+		#endif
+	}
+	for (TInputFiles::const_iterator transposonFile = options.transposonFiles.begin(); transposonFile != options.transposonFiles.end(); ++transposonFile)
+	{
+		stopwatch((string("  ") + toCString(*transposonFile)).c_str(), options.verbosity);
+
+		// determine type of input file
+		TFileFormat fileFormat;
+		if (_compareExtension(toCString(*transposonFile), ".bed"))
+			fileFormat = fileFormatBED;
+		else if (_compareExtension(toCString(*transposonFile), ".csv"))
+			fileFormat = fileFormatCSV;
+		else if (_compareExtension(toCString(*transposonFile), ".gff"))
+			fileFormat = fileFormatGFF;
+		else if (_compareExtension(toCString(*transposonFile), ".gtf"))
+			fileFormat = fileFormatGTF;
+		else
+			fileFormat = fileFormatTSV;
+
+		// try to load the transposons from the cache
+		TTransposonTable fileTransposons;
+		string cacheKey, cacheFile;
+		if (!options.annotationCache.empty())
+			if (getAnnotationCacheFile(options.annotationCache, toCString(*transposonFile), fileFormat, options.transposonAttribute, options.transposonFamilyAttribute, cacheKey, cacheFile) != 0)
+				cacheFile.clear();
+
+		if (cacheFile.empty() || (readAnnotationCache(cacheFile, cacheKey, fileTransposons, bamNameStore) != 0))
+		{
+			// try to open file
+			TMappedFile mappedFile;
+			if (openMappedFile(toCString(*transposonFile), mappedFile) != 0)
+			{
+				cerr << "Failed to open transposon file \"" << (*transposonFile) << "\"." << endl;
+				return 1;
+			}
+
+			readTransposonsFromFile(mappedFile, fileFormat, options.transposonAttribute, options.transposonFamilyAttribute, fileTransposons, bamNameStore);
+			closeMappedFile(mappedFile);
+
+			// sort transposons by genomic position
+			sortTransposonTable(fileTransposons);
+
+			if (!cacheFile.empty() && (writeAnnotationCache(cacheFile, cacheKey, fileTransposons, bamNameStore) != 0))
+				cerr << "Failed to write annotation cache file \"" << cacheFile << "\"." << endl;
+		}
+		else if (options.verbosity >= 3)
+		{
+			cerr << "(cached) ";
+		}
+
+		appendTransposonTable(transposons, fileTransposons);
+		stopwatch(options.verbosity);
+	}
+
+	// sort transposons of all files by genomic position
+	if (options.transposonFiles.size() > 1)
+		sortTransposonTable(transposons);
+	return 0;
+}
+
+// function to create an output directory
+// Input parameters:
+//	directory: the directory to create (with trailing path delimiter); nothing is done for an empty string
+// Return value: 1, if the directory does not exist and could not be created; 0 otherwise
+int createOutputDirectory(const string &directory)
+{
+	if (directory.empty())
+		return 0;
+	#if defined(WIN32) || defined(_WIN32)
+	CreateDirectory(directory.c_str(), NULL);
+	if (GetFileAttributes(directory.c_str()) == INVALID_FILE_ATTRIBUTES)
+	#else
+	mkdir(directory.c_str(), 0777);
+	struct stat directoryStats;
+	if ((stat(directory.c_str(), &directoryStats) != 0) || !S_ISDIR(directoryStats.st_mode))
+	#endif
+	{
+		cerr << "Failed to open output directory: " << directory << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// This function detects ping-pong signatures in the read stacks of a sample and checks transposons for ping-pong activity.
+// All output files of the sample are written by this function.
+// Input parameters:
+//	bamNameStore: mapping of numeric contig IDs to human-readable names
+//	totalReadCount: the total number of reads of the sample
+//	transposons: the transposons to check for ping-pong activity (may be empty)
+//	options: the options from the command line
+//	verbosity: whether to print progress messages to stderr (see <stopwatch>)
+//	threads: the number of threads to group the read stacks (see <countStacksByGroup>) and to format output files (see <writeChunksInParallel>)
+//	plan: if not NULL, the number of threads and the size of the tiles to group the read stacks are taken from the plan (see <planRun>)
+// Input/output parameters:
+//	readStacks: the read stacks as found by the function <countReadsInSample>; the variable is emptied to conserve memory
+//	sink: the output sink to write the output files to
+// Output parameters:
+//	transposonScores: the p- and q-values of the <transposons>
+//	deferredScripts: if not NULL, R scripts for plots are not executed, but appended to this list (see <plotHistogram>)
+void analyzeSample(TReadStacksPerGenome &readStacks, const TNameStore &bamNameStore, const double totalReadCount, const TTransposonTable &transposons, const AppOptions &options, TOutputSink &sink, unsigned int verbosity, unsigned int threads, const TRunPlan *plan, TTransposonScores &transposonScores, vector< string > *deferredScripts)
+{
+	stopwatch("Binning stacks", verbosity);
+	THeightScoreMap heightScoreMap;
+	mapHeightsToScores(readStacks, heightScoreMap);
+	TGroupedStackCountsByOverlap groupedStackCountsByOverlap;
+	TPingPongSignaturesByOverlap pingPongSignaturesByOverlap;
+	TActivityTracks activityTracks(options.activityWindows.begin(), options.activityWindows.end());
+	vector< unsigned int > collapsedBins;
+	// the signatures with arbitrary overlaps and the signatures with low stacks are only needed to score transposons and for the signature index
+	bool keepAllSignatures = options.signatureIndex || (transposons.start.size() > 0) || (options.predictTransposonsRange > 0);
+	bool planned = (plan != NULL) && plan->available;
+	countStacksByGroup(readStacks, heightScoreMap, groupedStackCountsByOverlap, pingPongSignaturesByOverlap, activityTracks.empty() ? NULL : &activityTracks, keepAllSignatures, keepAllSignatures ? 0 : options.minStackHeight, planned ? min(threads, plan->threads) : threads, planned ? plan->stacksPerTile : STACKS_PER_TILE);
+	collapseBins(groupedStackCountsByOverlap, collapsedBins);
+	stopwatch(verbosity);
+
+	stopwatch("Calculating FDR for putative ping-pong signatures", verbosity);
+	TGroupedStackCountsByOverlap fdrs;
+	calculateFDRs(groupedStackCountsByOverlap, fdrs);
+	TFDRTable fdrTable;
+	buildFDRTable(collapsedBins, fdrs, fdrTable);
+	stopwatch(verbosity);
+
+	if (!activityTracks.empty())
+	{
+		stopwatch("Writing ping-pong activity tracks to file", verbosity);
+		for (TActivityTracks::iterator activityTrack = activityTracks.begin(); activityTrack != activityTracks.end(); ++activityTrack)
+			writeActivityTrackToFile(*activityTrack, fdrTable, bamNameStore, sink);
+		activityTracks.clear();
+		stopwatch(verbosity);
+	}
+
+	if (options.plot)
+	{
+		stopwatch("Rendering plots for z-scores of ping-pong signatures", verbosity);
+		generateGroupedStackCountsPlot(groupedStackCountsByOverlap, sink, deferredScripts);
+		stopwatch(verbosity);
+	}
+	groupedStackCountsByOverlap.clear();
+
+	stopwatch("Writing ping-pong signatures to file", verbosity);
+	writePingPongSignaturesToFile(pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP], fdrTable, bamNameStore, options.minStackHeight, options.maxFDR, options.topK, options.browserTracks, sink, threads);
+	stopwatch(verbosity);
+	if (options.signatureIndex)
+	{
+		stopwatch("Writing signature index to file", verbosity);
+		writeSignatureIndexFile(pingPongSignaturesByOverlap, fdrTable, bamNameStore, options.minStackHeight, sink, "ping-pong_signatures.ppidx");
+		stopwatch(verbosity);
+	}
+
+	if (transposons.start.size() > 0)
+	{
+		stopwatch("Checking input transposons for ping-pong activity", verbosity);
+		TTransposonScores familyScores;
+		findSuppressedTransposons(pingPongSignaturesByOverlap, fdrTable, transposons, transposonScores, options.transposonFamilies ? &familyScores : NULL);
+		stopwatch(verbosity);
+		stopwatch("Writing input transposons to file", verbosity);
+		writeTransposonsToFile(transposons, transposonScores, bamNameStore, options.browserTracks, sink, "transposons", totalReadCount, threads);
+		if (options.transposonFamilies)
+			writeTransposonFamiliesToFile(transposons, familyScores, sink, "transposon_families", totalReadCount);
+		stopwatch(verbosity);
+		if (options.plot)
+		{
+			stopwatch("Rendering plots for z-scores of input transposons", verbosity);
+			generateTransposonsPlot(transposons, transposonScores, sink, "transposons_z-scores", deferredScripts);
+			stopwatch(verbosity);
+		}
+	}
+
+	if (options.predictTransposonsRange > 0)
+	{
+		stopwatch("Predicting transposons based on ping-pong activity", verbosity);
+		TTransposonTable putativeTransposons;
+		TTransposonScores putativeTransposonScores;
+		predictSuppressedTransposons(pingPongSignaturesByOverlap, fdrTable, putativeTransposons, putativeTransposonScores, bamNameStore, options.predictTransposonsRange);
+		stopwatch(verbosity);
+		stopwatch("Writing predicted transposons to file", verbosity);
+		writeTransposonsToFile(putativeTransposons, putativeTransposonScores, bamNameStore, options.browserTracks, sink, "predicted_transposons", totalReadCount, threads);
+		stopwatch(verbosity);
+		if (options.plot)
+		{
+			stopwatch("Rendering plots for z-scores of predicted transposons", verbosity);
+			generateTransposonsPlot(putativeTransposons, putativeTransposonScores, sink, "predicted_transposons_z-scores", deferredScripts);
+			stopwatch(verbosity);
+		}
+
+	}
+}
+
+// function to read the names of the contigs from the header of an input file
+// Input parameters:
+//	fileName: the SAM/BAM/CRAM file or count table
+//	options: the options from the command line
+// Output parameters:
+//	nameStore: the names of the contigs
+//	           for count tables, which have no header, the contigs used in the table are appended, unless they are in the name store already
+// Return value: 1, if the file could not be read; 0 otherwise
+int readContigNames(const char *fileName, const AppOptions &options, TNameStore &nameStore)
+{
+	bool bedGraph;
+	if (isCountTable(fileName, bedGraph))
+	{
+		double totalReadCount = 0;
+		return countReadsInCountTable(fileName, bedGraph, NULL, nameStore, totalReadCount);
+	}
+	else if (isCramFile(fileName))
+	{
+		#ifdef PINGPONGPRO_HTSLIB
+		samFile *cramFile = sam_open(fileName, "r");
+		if ((cramFile != NULL) && !options.referenceFile.empty())
+			hts_set_fai_filename(cramFile, options.referenceFile.c_str());
+		bam_hdr_t *header = (cramFile != NULL) ? sam_hdr_read(cramFile) : NULL;
+		if (header != NULL)
+			for (int32_t contig = 0; contig < header->n_targets; contig++)
+				appendValue(nameStore, CharString(header->target_name[contig]));
+		if (header != NULL)
+			bam_hdr_destroy(header);
+		if (cramFile != NULL)
+			sam_close(cramFile);
+		if (header != NULL)
+			return 0;
+		#else
+		(void)options; // the reference genome is only needed to decode CRAM files with htslib
+		#endif
+		cerr << "Failed to open input file: " << fileName << endl;
+		return 1;
+	}
+	else
+	{
+		BamStream bamFile(fileName);
+		if (!isGood(bamFile))
+		{
+			cerr << "Failed to open input file: " << fileName << endl;
+			return 1;
+		}
+		nameStore = seqan::nameStore(bamFile.bamIOContext);
+		close(bamFile);
+		return 0;
+	}
+}
+
+// function to reserve memory from a <TMemoryBudget>
+// The function blocks until enough memory is available. A request that exceeds the entire budget is granted
+// as soon as no other memory is reserved, so that oversized samples are processed alone rather than never.
+// Input parameters:
+//	bytes: the amount of memory to reserve
+// Input/output parameters:
+//	budget: the budget to reserve the memory from
+void reserveMemory(TMemoryBudget &budget, uint64_t bytes)
+{
+	unique_lock< mutex > lock(budget.lock);
+	if (budget.limit == 0)
+		return; // unlimited
+	while ((budget.reserved > 0) && (budget.reserved + bytes > budget.limit))
+		budget.memoryReleased.wait(lock);
+	budget.reserved += bytes;
+}
+
+// function to return memory reserved with <reserveMemory> to the budget
+void releaseMemory(TMemoryBudget &budget, uint64_t bytes)
+{
+	lock_guard< mutex > lock(budget.lock);
+	if (budget.limit == 0)
+		return;
+	budget.reserved -= bytes;
+	budget.memoryReleased.notify_all();
+}
+
+// function to read a manifest file for batch mode
+// Every line of the file describes a sample with the following tab-separated columns:
+//	1. the name of the sample
+//	2. a comma-separated list of SAM/BAM/CRAM files
+//	3. (optional) the output directory of the sample; by default, a sub-directory named after the sample is created in the output directory
+// Empty lines and lines starting with # are ignored.
+// Input parameters:
+//	manifestFile: the file to read
+//	output: the output directory given on the command-line
+// Output parameters:
+//	samples: the samples read from the file
+// Return value: 1, if the file could not be read or is malformed; 0 otherwise
+int readBatchManifest(const string &manifestFile, const string &output, vector< TBatchSample > &samples)
+{
+	ifstream manifest(manifestFile.c_str());
+	if (manifest.fail())
+	{
+		cerr << "Failed to open manifest file \"" << manifestFile << "\"." << endl;
+		return 1;
+	}
+
+	string line;
+	unsigned int lineNumber = 0;
+	while (getline(manifest, line))
+	{
+		lineNumber++;
+		if (!line.empty() && (line[line.size()-1] == '\r'))
+			line.erase(line.size()-1);
+		if (line.empty() || (line[0] == '#'))
+			continue;
+
+		// split line into columns
+		vector< string > columns;
+		stringstream lineStream(line);
+		string column;
+		while (getline(lineStream, column, '\t'))
+			columns.push_back(column);
+		if ((columns.size() < 2) || columns[0].empty() || columns[1].empty())
+		{
+			cerr << "Malformed line " << lineNumber << " in manifest file \"" << manifestFile << "\"." << endl;
+			return 1;
+		}
+
+		TBatchSample sample;
+		sample.name = columns[0];
+		stringstream inputFiles(columns[1]);
+		string inputFile;
+		while (getline(inputFiles, inputFile, ','))
+			if (!inputFile.empty())
+				sample.inputFiles.push_back(inputFile);
+		if (sample.inputFiles.empty())
+		{
+			cerr << "Sample '" << sample.name << "' in line " << lineNumber << " of manifest file \"" << manifestFile << "\" has no input files." << endl;
+			return 1;
+		}
+		if ((columns.size() >= 3) && !columns[2].empty())
+			sample.output = columns[2];
+		else
+			sample.output = output + sample.name;
+		if (sample.output[sample.output.size()-1] != PATH_DELIMITER)
+			sample.output += PATH_DELIMITER;
+
+		// estimate the memory needed to process the sample from the size of its input files
+		sample.estimatedMemory = 0;
+		for (TInputFiles::iterator inputFile = sample.inputFiles.begin(); inputFile != sample.inputFiles.end(); ++inputFile)
+		{
+			struct stat fileStats;
+			if (stat(toCString(*inputFile), &fileStats) == 0)
+				sample.estimatedMemory += static_cast<uint64_t>(fileStats.st_size * BATCH_MEMORY_PER_INPUT_BYTE);
+		}
+
+		samples.push_back(sample);
+	}
+	return 0;
+}
+
+// function to sort samples by the memory they are estimated to need, in descending order
+// processing the largest samples first keeps all worker threads busy until the end
+inline bool compareSamplesByEstimatedMemory(const TBatchSample *sample1, const TBatchSample *sample2)
+{
+	return sample1->estimatedMemory > sample2->estimatedMemory;
+}
+
+// This function processes a single sample in batch mode. It is executed by the worker threads of <runBatch>.
+// Input parameters:
+//	referenceNameStore: the @SQ header lines of the first SAM/BAM file, which all SAM/BAM files must share, followed by the contigs only used by count tables
+//	bamNameStore: the reference name store extended by the contigs of the transposon files
+//	transposons: the transposons to check for ping-pong activity (may be empty)
+//	options: the options from the command line
+//	threads: the number of threads to read and analyze the sample with, such that the samples running concurrently share all threads
+// Input/output parameters:
+//	sample: the sample to process; the results are stored in the sample
+//	memoryBudget: the memory needed by the sample is reserved from this budget while the sample is processed
+//	outputLock: mutex to serialize messages to stderr and the list of <deferredScripts>
+//	deferredScripts: R scripts of plots are appended to this list
+void processBatchSample(TBatchSample *sample, const TNameStore *referenceNameStore, const TNameStore *bamNameStore, const TTransposonTable *transposons, const AppOptions *options, unsigned int threads, TMemoryBudget *memoryBudget, mutex *outputLock, vector< string > *deferredScripts)
+{
+	reserveMemory(*memoryBudget, sample->estimatedMemory);
+	time_t startTime = time(NULL);
+	traceBegin("sample", sample->name);
+
+	TReadStacksPerGenome readStacks;
+	readStacks.stores = sample->stackStores;
+	TReadStacksPerGenome threePrimeStacks;
+	bool threePrimeEnds = needsThreePrimeStacks(options->distanceHistograms) && !options->qcOnly;
+	TNameStore sampleNameStore = *referenceNameStore; // count tables refer to contigs by name
+	double totalReadCount = 0;
+	TIngestMetrics metrics;
+	string statusFile = options->statusFile.empty() ? "" : options->statusFile + "." + sample->name; // samples are read concurrently, so each reports to its own file
+	if (countReadsInSample(sample->inputFiles, *options, 0, threads, statusFile, readStacks, threePrimeEnds ? &threePrimeStacks : NULL, sampleNameStore, totalReadCount, &metrics) != 0)
+	{
+		sample->failed = true;
+	}
+	else if (!nameStoresEqual(sampleNameStore, *referenceNameStore))
+	{
+		lock_guard< mutex > lock(*outputLock);
+		cerr << "@SQ header lines of sample '" << sample->name << "' differ from those of previous samples" << endl;
+		sample->failed = true;
+	}
+	else if (options->qcOnly)
+	{
+		sample->totalReadCount = totalReadCount;
+		calculatePingPongQC(readStacks, sample->qc);
+	}
+	else if (createOutputDirectory(sample->output) != 0)
+	{
+		sample->failed = true;
+	}
+	else
+	{
+		vector< string > sampleScripts;
+		TOutputSink sink(sample->output);
+		sample->totalReadCount = totalReadCount;
+		writeIngestMetricsFile(metrics, sink);
+		analyzeDistances(readStacks, threePrimeEnds ? &threePrimeStacks : NULL, *options, sink, 0);
+		analyzeSample(readStacks, *bamNameStore, totalReadCount, *transposons, *options, sink, 0, threads, &sample->plan, sample->transposonScores, &sampleScripts);
+
+		lock_guard< mutex > lock(*outputLock);
+		deferredScripts->insert(deferredScripts->end(), sampleScripts.begin(), sampleScripts.end());
+		if (options->verbosity >= 3)
+			cerr << "  " << sample->name << " ... done (" << (time(NULL) - startTime) << " seconds)" << endl;
+	}
+
+	// free memory before other samples are started
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+	{
+		readStacks[strand].clear();
+		threePrimeStacks[strand].clear();
+	}
+	releaseMemory(*memoryBudget, sample->estimatedMemory);
+	traceEnd();
+}
+
+// Function to write a matrix with the normalized ping-pong reads of every transposon (rows) in every sample (columns).
+// Input parameters:
+//	transposons: the transposons that were checked for ping-pong activity
+//	samples: the samples processed in batch mode
+//	bamNameStore: a mapping of numeric contig IDs to human readable names
+//	fileName: the name of the file within the <sink> to write the matrix to
+// Input/output parameters:
+//	sink: the output sink to write the file to
+void writeTransposonMatrixToFile(const TTransposonTable &transposons, const vector< TBatchSample > &samples, const TNameStore &bamNameStore, TOutputSink &sink, const string &fileName)
+{
+	TOutputFile outputFile;
+	if (openOutputFile(sink, fileName, outputFile) != 0)
+	{
+		cerr << "Failed to create transposon matrix file" << endl;
+		return;
+	}
+	ostream &matrix = *outputFile.stream;
+	matrix.setf(ios::scientific, ios::floatfield);
+
+	matrix << "identifier\tstrand\tcontig\tstart\tend";
+	for (vector< TBatchSample >::const_iterator sample = samples.begin(); sample != samples.end(); ++sample)
+		matrix << '\t' << sample->name;
+	matrix << endl;
+
+	for (map< unsigned int, TRowRange >::const_iterator contig = transposons.contigs.begin(); contig != transposons.contigs.end(); ++contig)
+		for (unsigned int transposon = contig->second.begin; transposon < contig->second.end; transposon++)
+		{
+			writeInternedString(matrix, transposons.identifiers, transposons.identifier[transposon]) << '\t'
+				<< ((transposons.strand[transposon] == STRAND_PLUS) ? '+' : '-') << '\t'
+				<< bamNameStore[contig->first] << '\t'
+				<< transposons.start[transposon] << '\t'
+				<< transposons.end[transposon];
+			for (vector< TBatchSample >::const_iterator sample = samples.begin(); sample != samples.end(); ++sample)
+			{
+				if (sample->failed)
+					matrix << "\tNA";
+				else
+					matrix << '\t' << sample->transposonScores.histograms[transposon * ARBITRARY_OVERLAP_COUNT + PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] / ((static_cast<float>(transposons.end[transposon]) - transposons.start[transposon])/1000) / (sample->totalReadCount/1000000);
+			}
+			matrix << endl;
+		}
+
+	closeOutputFile(outputFile);
+}
+
+// This function analyzes many samples listed in a manifest file in a single process.
+// The transposon files are loaded only once and the samples are distributed over a pool of worker threads.
+// Input parameters:
+//	options: the options from the command line
+// Return value: 1, if any of the samples could not be processed; 0 otherwise
+int runBatch(const AppOptions &options)
+{
+	vector< TBatchSample > samples;
+	if (readBatchManifest(options.batchManifest, toCString(options.output), samples) != 0)
+		return 1;
+	if (samples.empty())
+	{
+		cerr << "No samples found in manifest file \"" << options.batchManifest << "\"." << endl;
+		return 1;
+	}
+
+	// all samples must be aligned to the same reference, so the contig names are taken from the header of the first SAM/BAM/CRAM file,
+	// followed by the contigs that are only used by count tables
+	TNameStore referenceNameStore;
+	bool foundHeader = false;
+	bool bedGraph;
+	for (vector< TBatchSample >::iterator sample = samples.begin(); (sample != samples.end()) && !foundHeader; ++sample)
+		for (TInputFiles::iterator inputFile = sample->inputFiles.begin(); (inputFile != sample->inputFiles.end()) && !foundHeader; ++inputFile)
+			if (!isCountTable(toCString(*inputFile), bedGraph))
+			{
+				if (readContigNames(toCString(*inputFile), options, referenceNameStore) != 0)
+					return 1;
+				foundHeader = true;
+			}
+	for (vector< TBatchSample >::iterator sample = samples.begin(); sample != samples.end(); ++sample)
+		for (TInputFiles::iterator inputFile = sample->inputFiles.begin(); inputFile != sample->inputFiles.end(); ++inputFile)
+			if (isCountTable(toCString(*inputFile), bedGraph))
+				if (readContigNames(toCString(*inputFile), options, referenceNameStore) != 0)
+					return 1;
+
+	// load transposons once for all samples
+	TNameStore bamNameStore = referenceNameStore;
+	TTransposonTable transposons;
+	if ((options.transposonFiles.size() > 0) && !options.qcOnly)
+		if (loadTransposons(options, transposons, bamNameStore) != 0)
+			return 1;
+
+	if (!options.qcOnly)
+		if (createOutputDirectory(toCString(options.output)) != 0)
+			return 1;
+
+	// process samples in parallel, largest first
+	// if there are fewer samples than threads, the threads are divided among the samples, such that all cores are kept busy
+	unsigned int concurrentSamples = min(static_cast<unsigned int>(samples.size()), options.threads);
+	unsigned int threadsPerSample = max(1u, options.threads / concurrentSamples);
+	if (options.verbosity >= 3)
+		cerr << "Processing " << samples.size() << " samples with " << options.threads << " threads (" << concurrentSamples << " samples at a time with " << threadsPerSample << " threads each)" << endl;
+	vector< TBatchSample * > schedule;
+	for (vector< TBatchSample >::iterator sample = samples.begin(); sample != samples.end(); ++sample)
+	{
+		// prefer the estimate based on the BAM indices over the one based on the file sizes
+		planRun(sample->inputFiles, options, threadsPerSample, sample->plan);
+		if (sample->plan.available)
+			sample->estimatedMemory = sample->plan.peakMemory;
+		selectStackStores(options, &sample->plan, sample->stackStores);
+		schedule.push_back(&(*sample));
+	}
+	stable_sort(schedule.begin(), schedule.end(), compareSamplesByEstimatedMemory);
+	TMemoryBudget memoryBudget(static_cast<uint64_t>(options.maxMemory) * 1024 * 1024);
+	mutex outputLock;
+	vector< string > deferredScripts;
+	TThreadPool pool;
+	startThreadPool(pool, concurrentSamples);
+	for (vector< TBatchSample * >::iterator sample = schedule.begin(); sample != schedule.end(); ++sample)
+		submitTask(pool, bind(processBatchSample, *sample, &referenceNameStore, &bamNameStore, &transposons, &options, threadsPerSample, &memoryBudget, &outputLock, &deferredScripts));
+	waitForTasks(pool);
+	stopThreadPool(pool);
+
+	// render all plots with a single invocation of Rscript
+	if (options.plot)
+	{
+		stopwatch("Rendering plots", options.verbosity);
+		runRScripts(deferredScripts);
+		stopwatch(options.verbosity);
+	}
+
+	if (transposons.start.size() > 0)
+	{
+		stopwatch("Writing transposon matrix to file", options.verbosity);
+		TOutputSink sink(toCString(options.output));
+		writeTransposonMatrixToFile(transposons, samples, bamNameStore, sink, "transposon_matrix.tsv");
+		stopwatch(options.verbosity);
+	}
+
+	for (vector< TBatchSample >::iterator sample = samples.begin(); sample != samples.end(); ++sample)
+		if (sample->failed)
+		{
+			cerr << "Failed to process sample '" << sample->name << "'" << endl;
+			return 1;
+		}
+
+	if (options.qcOnly)
+	{
+		writePingPongQCHeader(cout);
+		for (vector< TBatchSample >::iterator sample = samples.begin(); sample != samples.end(); ++sample)
+			writePingPongQC(cout, sample->name, sample->totalReadCount, sample->qc);
+	}
+	return 0;
+}
+
+// function to calculate the prefix sums of a <TSignatureIndexPerContig> after the signatures have been added
+// Input/output parameters:
+//	index: the index whose <positions>, <fdr>, <readsOnPlusStrand> and <readsOnMinusStrand> have been filled
+void finalizeSignatureIndex(TSignatureIndexPerContig &index)
+{
+	// sort signatures by position, unless they are sorted already
+	bool sorted = true;
+	for (unsigned int i = 1; (i < index.positions.size()) && sorted; i++)
+		sorted = index.positions[i-1] <= index.positions[i];
+	if (!sorted)
+	{
+		vector< unsigned int > permutation(index.positions.size());
+		for (unsigned int i = 0; i < permutation.size(); i++)
+			permutation[i] = i;
+		stable_sort(permutation.begin(), permutation.end(), TComparePositions(index.positions));
+		permuteColumn(index.positions, permutation);
+		permuteColumn(index.fdr, permutation);
+		permuteColumn(index.readsOnPlusStrand, permutation);
+		permuteColumn(index.readsOnMinusStrand, permutation);
+	}
+
+	index.scorePrefixSums.resize(index.positions.size() + 1);
+	index.readsOnPlusStrandPrefixSums.resize(index.positions.size() + 1);
+	index.readsOnMinusStrandPrefixSums.resize(index.positions.size() + 1);
+	index.scorePrefixSums[0] = index.readsOnPlusStrandPrefixSums[0] = index.readsOnMinusStrandPrefixSums[0] = 0;
+	for (unsigned int i = 0; i < index.positions.size(); i++)
+	{
+		index.scorePrefixSums[i+1] = index.scorePrefixSums[i] + (index.readsOnPlusStrand[i] + index.readsOnMinusStrand[i]) * (1 - index.fdr[i]);
+		index.readsOnPlusStrandPrefixSums[i+1] = index.readsOnPlusStrandPrefixSums[i] + index.readsOnPlusStrand[i];
+		index.readsOnMinusStrandPrefixSums[i+1] = index.readsOnMinusStrandPrefixSums[i] + index.readsOnMinusStrand[i];
+	}
+}
+
+// type to access a signature index file written by the function <writeSignatureIndexFile>
+struct TSignatureIndexFile
+{
+	TMappedFile mappedFile;
+	const TSignatureIndexFileHeader *header;
+	const TSignatureIndexFileContig *directory;
+	map< string, unsigned int > contigs; // maps the names of the contigs to the elements of <directory>
+
+	TSignatureIndexFile():
+		header(NULL), directory(NULL)
+	{
+	}
+};
+
+// function to check whether a file is a signature index file
+// Input parameters:
+//	mappedFile: the contents of the file
+// Return value: true, if the file starts with <SIGNATURE_INDEX_MAGIC>; false otherwise
+inline bool isSignatureIndexFile(const TMappedFile &mappedFile)
+{
+	return (mappedFile.size >= sizeof(SIGNATURE_INDEX_MAGIC)) && (memcmp(mappedFile.data, SIGNATURE_INDEX_MAGIC, sizeof(SIGNATURE_INDEX_MAGIC)) == 0);
+}
+
+// function to release a signature index file opened with <openSignatureIndexFile>
+void closeSignatureIndexFile(TSignatureIndexFile &indexFile)
+{
+	closeMappedFile(indexFile.mappedFile);
+	indexFile.header = NULL;
+	indexFile.directory = NULL;
+	indexFile.contigs.clear();
+}
+
+// This function validates the header and the directory of contigs of a signature index file and maps the names of the contigs to the directory.
+// Input/output parameters:
+//	indexFile: the index file, whose <mappedFile> holds the contents of the file; <header>, <directory> and <contigs> are set
+// Return value: false, if the file is invalid or incomplete; true otherwise
+bool readSignatureIndexDirectory(TSignatureIndexFile &indexFile)
+{
+	indexFile.header = reinterpret_cast<const TSignatureIndexFileHeader *>(indexFile.mappedFile.data);
+	bool valid = (indexFile.mappedFile.size >= sizeof(TSignatureIndexFileHeader)) && isSignatureIndexFile(indexFile.mappedFile) &&
+		(indexFile.header->byteOrder == ANNOTATION_CACHE_BYTE_ORDER) &&
+		(indexFile.header->fileSize == indexFile.mappedFile.size) &&
+		(indexFile.header->blockSize > 0) && (indexFile.header->blockSize <= numeric_limits< uint32_t >::max()) && // larger blocks would overflow the block arithmetic of queries
+		(indexFile.header->contigCount <= (indexFile.mappedFile.size - sizeof(TSignatureIndexFileHeader)) / sizeof(TSignatureIndexFileContig));
+	if (valid)
+	{
+		indexFile.directory = reinterpret_cast<const TSignatureIndexFileContig *>(indexFile.mappedFile.data + sizeof(TSignatureIndexFileHeader));
+		for (unsigned int i = 0; (i < indexFile.header->contigCount) && valid; i++)
+		{
+			// the sizes are compared by division, such that huge counts in a corrupt file cannot overflow the checks
+			const TSignatureIndexFileContig &contig = indexFile.directory[i];
+			uint64_t fileSize = indexFile.mappedFile.size;
+			valid = (contig.nameOffset <= fileSize) && (contig.nameLength <= fileSize - contig.nameOffset);
+			for (unsigned int overlap = 0; (overlap < ARBITRARY_OVERLAP_COUNT) && valid; overlap++)
+			{
+				uint64_t signatureCount = contig.signatureCount[overlap];
+				valid =
+					(contig.signatureOffset[overlap] <= contig.blockOffset[overlap]) &&
+					(signatureCount <= (contig.blockOffset[overlap] - contig.signatureOffset[overlap]) / sizeof(TSignatureIndexFileRecord)) &&
+					(contig.blockOffset[overlap] <= fileSize) &&
+					(signatureCount / indexFile.header->blockSize + ((signatureCount % indexFile.header->blockSize != 0) ? 1 : 0) + 1 <= (fileSize - contig.blockOffset[overlap]) / sizeof(TSignatureIndexFileBlock));
+			}
+			if (valid)
+				indexFile.contigs[string(indexFile.mappedFile.data + contig.nameOffset, contig.nameLength)] = i;
+		}
+	}
+	return valid;
+}
+
+// This function maps a signature index file written by the function <writeSignatureIndexFile> into memory.
+// Only the directory of contigs is read; signatures are read on demand by queries.
+// Input parameters:
+//	fileName: the path of the index file
+// Output parameters:
+//	indexFile: the opened index file
+// Return value: 1, if the file could not be opened or is invalid; 0 otherwise
+int openSignatureIndexFile(const string &fileName, TSignatureIndexFile &indexFile)
+{
+	if (openMappedFile(fileName.c_str(), indexFile.mappedFile) != 0)
+	{
+		cerr << "Failed to open signature index file \"" << fileName << "\"." << endl;
+		return 1;
+	}
+	#if !defined(WIN32) && !defined(_WIN32)
+	if (indexFile.mappedFile.data != NULL)
+		madvise(const_cast<char *>(indexFile.mappedFile.data), indexFile.mappedFile.size, MADV_RANDOM); // queries jump around in the file
+	#endif
+
+	if (!readSignatureIndexDirectory(indexFile))
+	{
+		cerr << "Signature index file \"" << fileName << "\" is invalid or incomplete." << endl;
+		closeSignatureIndexFile(indexFile);
+		return 1;
+	}
+	return 0;
+}
+
+// function to get the signatures and the block index of a contig of a signature index file
+// Input parameters:
+//	indexFile: the index file
+//	contig: the element of the directory of <indexFile>
+//	overlap: the overlap of the signatures between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Output parameters:
+//	records: the signatures
+//	blocks: the block index
+// Return value: the number of signatures
+inline uint64_t getSignatureIndexFileSection(const TSignatureIndexFile &indexFile, unsigned int contig, int overlap, const TSignatureIndexFileRecord *&records, const TSignatureIndexFileBlock *&blocks)
+{
+	const TSignatureIndexFileContig &entry = indexFile.directory[contig];
+	records = reinterpret_cast<const TSignatureIndexFileRecord *>(indexFile.mappedFile.data + entry.signatureOffset[overlap - MIN_ARBITRARY_OVERLAP]);
+	blocks = reinterpret_cast<const TSignatureIndexFileBlock *>(indexFile.mappedFile.data + entry.blockOffset[overlap - MIN_ARBITRARY_OVERLAP]);
+	return entry.signatureCount[overlap - MIN_ARBITRARY_OVERLAP];
+}
+
+// function to find the first signature at or after a given position in a section of a signature index file
+// the block index is searched first, such that only a single block of signatures is touched
+// Input parameters:
+//	records, blocks, count: the section as returned by <getSignatureIndexFileSection>
+//	blockSize: the number of signatures per block
+//	position: the position to search for
+// Return value: the number of the first signature with a position not less than <position>
+uint64_t findSignatureInIndexFile(const TSignatureIndexFileRecord *records, const TSignatureIndexFileBlock *blocks, uint64_t count, uint64_t blockSize, unsigned int position)
+{
+	// find the last block whose first signature precedes <position>
+	uint64_t lowerBlock = 0, upperBlock = (count + blockSize - 1) / blockSize; // the sentinel is never less than <position>
+	while (lowerBlock < upperBlock)
+	{
+		uint64_t middleBlock = lowerBlock + (upperBlock - lowerBlock) / 2;
+		if (blocks[middleBlock].firstPosition < position)
+			lowerBlock = middleBlock + 1;
+		else
+			upperBlock = middleBlock;
+	}
+	if (lowerBlock == 0)
+		return 0;
+
+	// search the signatures of that block
+	uint64_t lower = (lowerBlock - 1) * blockSize, upper = min(lowerBlock * blockSize, count);
+	while (lower < upper)
+	{
+		uint64_t middle = lower + (upper - lower) / 2;
+		if (records[middle].position < position)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+// function to sum up the scores and reads of the signatures that precede a given signature in a section of a signature index file
+// Input parameters:
+//	records, blocks: the section as returned by <getSignatureIndexFileSection>
+//	blockSize: the number of signatures per block
+//	signature: the number of the signature
+// Return value: the sums of the scores and reads of the signatures 0..<signature>-1 (the number of signatures is left 0)
+TRegionSummary sumSignaturesInIndexFile(const TSignatureIndexFileRecord *records, const TSignatureIndexFileBlock *blocks, uint64_t blockSize, uint64_t signature)
+{
+	TRegionSummary sums;
+	uint64_t block = signature / blockSize;
+	sums.score = blocks[block].scorePrefixSum;
+	sums.readsOnPlusStrand = blocks[block].readsOnPlusStrandPrefixSum;
+	sums.readsOnMinusStrand = blocks[block].readsOnMinusStrandPrefixSum;
+	for (uint64_t i = block * blockSize; i < signature; i++)
+	{
+		sums.score += signatureScore(records[i].readsOnPlusStrand, records[i].readsOnMinusStrand, records[i].fdr);
+		sums.readsOnPlusStrand += records[i].readsOnPlusStrand;
+		sums.readsOnMinusStrand += records[i].readsOnMinusStrand;
+	}
+	return sums;
+}
+
+// function to find the signatures of a signature index file within a region
+// Input parameters:
+//	indexFile: the index file to query
+//	contig: the name of the contig of the region
+//	start, end: the region (0-based, half-open)
+//	overlap: the overlap of the signatures between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Output parameters:
+//	signatures: the signatures of the contig with the given overlap, NULL if there are none
+//	first, last: the signatures in the region are <first> to <last>-1
+void findSignaturesInRegion(const TSignatureIndexFile &indexFile, const string &contig, unsigned int start, unsigned int end, int overlap, const TSignatureIndexFileRecord *&signatures, uint64_t &first, uint64_t &last)
+{
+	signatures = NULL;
+	first = last = 0;
+	map< string, unsigned int >::const_iterator contigIndex = indexFile.contigs.find(contig);
+	if ((contigIndex == indexFile.contigs.end()) || (overlap < MIN_ARBITRARY_OVERLAP) || (overlap > MAX_ARBITRARY_OVERLAP) || (start >= end))
+		return;
+	const TSignatureIndexFileBlock *blocks;
+	uint64_t count = getSignatureIndexFileSection(indexFile, contigIndex->second, overlap, signatures, blocks);
+	first = findSignatureInIndexFile(signatures, blocks, count, indexFile.header->blockSize, start);
+	last = findSignatureInIndexFile(signatures, blocks, count, indexFile.header->blockSize, end);
+}
+
+// function to summarize the signatures of a signature index file within a region
+// Input parameters:
+//	indexFile: the index file to query
+//	contig: the name of the contig of the region
+//	start, end: the region (0-based, half-open)
+//	overlap: the overlap of the signatures between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Return value: the number of signatures in the region and the sums of their scores and reads
+TRegionSummary querySignatureIndexFile(const TSignatureIndexFile &indexFile, const string &contig, unsigned int start, unsigned int end, int overlap)
+{
+	TRegionSummary summary;
+	const TSignatureIndexFileRecord *signatures;
+	uint64_t first, last;
+	findSignaturesInRegion(indexFile, contig, start, end, overlap, signatures, first, last);
+	if (signatures != NULL)
+	{
+		const TSignatureIndexFileBlock *blocks = reinterpret_cast<const TSignatureIndexFileBlock *>(indexFile.mappedFile.data + indexFile.directory[indexFile.contigs.find(contig)->second].blockOffset[overlap - MIN_ARBITRARY_OVERLAP]);
+		TRegionSummary sumsBefore = sumSignaturesInIndexFile(signatures, blocks, indexFile.header->blockSize, first);
+		TRegionSummary sumsUntil = sumSignaturesInIndexFile(signatures, blocks, indexFile.header->blockSize, last);
+		summary.signatures = last - first;
+		summary.score = sumsUntil.score - sumsBefore.score;
+		summary.readsOnPlusStrand = sumsUntil.readsOnPlusStrand - sumsBefore.readsOnPlusStrand;
+		summary.readsOnMinusStrand = sumsUntil.readsOnMinusStrand - sumsBefore.readsOnMinusStrand;
+	}
+	return summary;
+}
+
+// function to load all signatures of a signature index file into a <TSignatureIndex>
+// Input parameters:
+//	fileName: the index file to load
+// Output parameters:
+//	index: the index of the signatures
+// Return value: 1, if the file could not be read; 0 otherwise
+int readSignatureIndexFromIndexFile(const string &fileName, TSignatureIndex &index)
+{
+	TSignatureIndexFile indexFile;
+	if (openSignatureIndexFile(fileName, indexFile) != 0)
+		return 1;
+	for (map< string, unsigned int >::iterator contig = indexFile.contigs.begin(); contig != indexFile.contigs.end(); ++contig)
+	{
+		vector< TSignatureIndexPerContig > &signaturesByOverlap = index[contig->first];
+		signaturesByOverlap.resize(ARBITRARY_OVERLAP_COUNT);
+		for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+		{
+			const TSignatureIndexFileRecord *records;
+			const TSignatureIndexFileBlock *blocks;
+			uint64_t count = getSignatureIndexFileSection(indexFile, contig->second, overlap, records, blocks);
+			TSignatureIndexPerContig &signatures = signaturesByOverlap[overlap - MIN_ARBITRARY_OVERLAP];
+			for (uint64_t i = 0; i < count; i++)
+			{
+				signatures.positions.push_back(records[i].position);
+				signatures.fdr.push_back(records[i].fdr);
+				signatures.readsOnPlusStrand.push_back(records[i].readsOnPlusStrand);
+				signatures.readsOnMinusStrand.push_back(records[i].readsOnMinusStrand);
+			}
+			finalizeSignatureIndex(signatures);
+		}
+	}
+	closeSignatureIndexFile(indexFile);
+	return 0;
+}
+
+// This function loads ping-pong signatures from a TSV file written by the function <writePingPongSignaturesToFile> into an index.
+// The TSV file holds only signatures with an overlap of <PING_PONG_OVERLAP> nt.
+// Signature index files written by the function <writeSignatureIndexFile> are recognized and loaded with all overlaps.
+// Input parameters:
+//	fileName: the TSV file to load
+// Output parameters:
+//	index: the index of the signatures
+//	allOverlaps: true, if the index holds the signatures of all overlaps; false, if only those with an overlap of <PING_PONG_OVERLAP> nt
+// Return value: 1, if the file could not be read; 0 otherwise
+int readSignatureIndexFromFile(const string &fileName, TSignatureIndex &index, bool &allOverlaps)
+{
+	TMappedFile mappedFile;
+	if (openMappedFile(fileName.c_str(), mappedFile) != 0)
+	{
+		cerr << "Failed to open signature file \"" << fileName << "\"." << endl;
+		return 1;
+	}
+	allOverlaps = isSignatureIndexFile(mappedFile);
+	if (allOverlaps)
+	{
+		closeMappedFile(mappedFile);
+		return readSignatureIndexFromIndexFile(fileName, index);
+	}
+
+	// the columns are identified by the header line
+	int contigField = -1, positionField = -1, fdrField = -1, readsOnPlusStrandField = -1, readsOnMinusStrandField = -1;
+
+	const char *character = mappedFile.data;
+	const char *fileEnd = mappedFile.data + mappedFile.size;
+	bool header = true;
+	unsigned int lineNumber = 0;
+	while (character < fileEnd)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(character, '\n', fileEnd - character));
+		if (lineEnd == NULL)
+			lineEnd = fileEnd;
+		const char *nextLine = lineEnd + 1;
+		if ((lineEnd > character) && (*(lineEnd-1) == '\r'))
+			lineEnd--;
+		lineNumber++;
+
+		// split line into fields
+		vector< TStringView > fields;
+		while (character <= lineEnd)
+		{
+			const char *fieldEnd = static_cast<const char *>(memchr(character, '\t', lineEnd - character));
+			if (fieldEnd == NULL)
+				fieldEnd = lineEnd;
+			fields.push_back(TStringView(character, fieldEnd - character));
+			character = fieldEnd + 1;
+		}
+		character = nextLine;
+
+		if (header)
+		{
+			for (unsigned int i = 0; i < fields.size(); i++)
+			{
+				if (fields[i] == "contig")
+					contigField = i;
+				else if (fields[i] == "position")
+					positionField = i;
+				else if (fields[i] == "FDR")
+					fdrField = i;
+				else if (fields[i] == "stackHeightOnPlusStrand")
+					readsOnPlusStrandField = i;
+				else if (fields[i] == "stackHeightOnMinusStrand")
+					readsOnMinusStrandField = i;
+			}
+			if ((contigField < 0) || (positionField < 0) || (fdrField < 0) || (readsOnPlusStrandField < 0) || (readsOnMinusStrandField < 0))
+			{
+				cerr << "Signature file \"" << fileName << "\" lacks mandatory columns." << endl;
+				closeMappedFile(mappedFile);
+				return 1;
+			}
+			header = false;
+			continue;
+		}
+		if ((fields.size() == 1) && (fields[0].length == 0))
+			continue; // skip empty lines
+
+		unsigned int position;
+		float fdr, readsOnPlusStrand, readsOnMinusStrand;
+		if ((static_cast<int>(fields.size()) <= max(max(max(contigField, positionField), fdrField), max(readsOnPlusStrandField, readsOnMinusStrandField))) ||
+		    !parseUnsignedInteger(fields[positionField], position) ||
+		    !parseFloat(fields[fdrField], fdr) ||
+		    !parseFloat(fields[readsOnPlusStrandField], readsOnPlusStrand) ||
+		    !parseFloat(fields[readsOnMinusStrandField], readsOnMinusStrand))
+		{
+			cerr << "Malformed line " << lineNumber << " in signature file \"" << fileName << "\"." << endl;
+			closeMappedFile(mappedFile);
+			return 1;
+		}
+
+		vector< TSignatureIndexPerContig > &contig = index[string(fields[contigField].characters, fields[contigField].length)];
+		if (contig.empty())
+			contig.resize(ARBITRARY_OVERLAP_COUNT);
+		TSignatureIndexPerContig &signatures = contig[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP];
+		signatures.positions.push_back(position);
+		signatures.fdr.push_back(fdr);
+		signatures.readsOnPlusStrand.push_back(readsOnPlusStrand);
+		signatures.readsOnMinusStrand.push_back(readsOnMinusStrand);
+	}
+	closeMappedFile(mappedFile);
+
+	for (TSignatureIndex::iterator contig = index.begin(); contig != index.end(); ++contig)
+		for (vector< TSignatureIndexPerContig >::iterator signatures = contig->second.begin(); signatures != contig->second.end(); ++signatures)
+			finalizeSignatureIndex(*signatures);
+	return 0;
+}
+
+// function to find the signatures of an index within a region
+// Input parameters:
+//	index: the index to query
+//	contig: the name of the contig of the region
+//	start, end: the region (0-based, half-open)
+//	overlap: the overlap of the signatures between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Output parameters:
+//	signatures: the signatures of the contig with the given overlap, NULL if there are none
+//	first, last: the signatures in the region are <first> to <last>-1
+void findSignaturesInRegion(const TSignatureIndex &index, const string &contig, unsigned int start, unsigned int end, int overlap, const TSignatureIndexPerContig *&signatures, unsigned int &first, unsigned int &last)
+{
+	signatures = NULL;
+	first = last = 0;
+	TSignatureIndex::const_iterator contigIndex = index.find(contig);
+	if ((contigIndex == index.end()) || (overlap < MIN_ARBITRARY_OVERLAP) || (overlap > MAX_ARBITRARY_OVERLAP) || (start >= end))
+		return;
+	signatures = &contigIndex->second[overlap - MIN_ARBITRARY_OVERLAP];
+	first = lower_bound(signatures->positions.begin(), signatures->positions.end(), start) - signatures->positions.begin();
+	last = lower_bound(signatures->positions.begin() + first, signatures->positions.end(), end) - signatures->positions.begin();
+}
+
+// function to summarize the signatures of an index within a region
+// Input parameters:
+//	index: the index to query
+//	contig: the name of the contig of the region
+//	start, end: the region (0-based, half-open)
+//	overlap: the overlap of the signatures between <MIN_ARBITRARY_OVERLAP> and <MAX_ARBITRARY_OVERLAP>
+// Return value: the number of signatures in the region and the sums of their scores and reads
+TRegionSummary querySignatureIndex(const TSignatureIndex &index, const string &contig, unsigned int start, unsigned int end, int overlap)
+{
+	TRegionSummary summary;
+	const TSignatureIndexPerContig *signatures;
+	unsigned int first, last;
+	findSignaturesInRegion(index, contig, start, end, overlap, signatures, first, last);
+	if (signatures != NULL)
+	{
+		summary.signatures = last - first;
+		summary.score = signatures->scorePrefixSums[last] - signatures->scorePrefixSums[first];
+		summary.readsOnPlusStrand = signatures->readsOnPlusStrandPrefixSums[last] - signatures->readsOnPlusStrandPrefixSums[first];
+		summary.readsOnMinusStrand = signatures->readsOnMinusStrandPrefixSums[last] - signatures->readsOnMinusStrandPrefixSums[first];
+	}
+	return summary;
+}
+
+// function to parse command-line arguments of the "serve" command
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Output parameters:
+//	options: parsed options
+// Return value: status code about whether the command-line could be parsed
+ArgumentParser::ParseResult parseServeCommandLine(TServeOptions &options, int argc, char const ** argv)
+{
+	ArgumentParser parser("pingpongpro serve");
+
+	addUsageLine(parser, "-S \\fISOCKET\\fP -s \\fINAME\\fP=\\fIPATH\\fP [-s \\fINAME\\fP=\\fIPATH\\fP ...]");
+	setShortDescription(parser, "Answer region queries about ping-pong signatures");
+	addDescription(parser, "Loads the ping-pong signatures of one or more samples into memory and answers queries on a Unix domain socket. Every request is a single line; every response starts with a line \"OK \\fIN\\fP\" followed by \\fIN\\fP lines, or consists of a single line \"ERROR \\fIMESSAGE\\fP\". Regions are 0-based and half-open. The following requests are understood:");
+	addDescription(parser, "SAMPLES - list the names of the loaded samples.");
+	addDescription(parser, "QUERY \\fISAMPLE\\fP|* \\fICONTIG\\fP \\fISTART\\fP \\fIEND\\fP [\\fIOVERLAP\\fP] - number of signatures, sum of scores and reads on the + and - strand in the region for every requested sample.");
+	addDescription(parser, "ACTIVITY \\fISAMPLE\\fP|* \\fICONTIG\\fP \\fISTART\\fP \\fIEND\\fP - sum of scores for every overlap and the p-value of ping-pong activity in the region.");
+	addDescription(parser, "SIGNATURES \\fISAMPLE\\fP \\fICONTIG\\fP \\fISTART\\fP \\fIEND\\fP [\\fIOVERLAP\\fP] - position, FDR and stack heights of every signature in the region.");
+	addDescription(parser, "QUIT - close the connection. SHUTDOWN - stop the server.");
+	addDescription(parser, "Overlaps other than 10 nt and ACTIVITY require the signatures of all overlaps, which are only available, if a sample is loaded from a signature index file written by pingpongpro with the option -x. A ping-pong_signatures.tsv file holds only the signatures with an overlap of 10 nt.");
+	setVersion(parser, "1.0");
+	setDate(parser, "Apr 2014");
+
+	addOption(parser, ArgParseOption("S", "socket", "Path of the Unix domain socket to listen on.", ArgParseArgument::STRING, "SOCKET"));
+	setRequired(parser, "socket");
+	addOption(parser, ArgParseOption("s", "sample", "Load the signatures of sample \\fINAME\\fP from \\fIPATH\\fP, which is a signature file or an output directory of pingpongpro.", ArgParseArgument::STRING, "NAME=PATH", true));
+	setRequired(parser, "sample");
+	addOption(parser, ArgParseOption("j", "threads", "Number of requests to process in parallel. Idle connections do not occupy a thread.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "threads", 4);
+	setMinValue(parser, "threads", "1");
+	addOption(parser, ArgParseOption("v", "verbose", "Print messages about the current progress to stderr. Default: \\fIoff\\fP."));
+
+	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
+	if (parserResult != ArgumentParser::PARSE_OK)
+		return parserResult;
+
+	getOptionValue(options.socket, parser, "socket");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "sample"); i++)
+	{
+		string sample;
+		getOptionValue(sample, parser, "sample", i);
+		size_t separator = sample.find('=');
+		if ((separator == string::npos) || (separator == 0) || (separator == sample.size() - 1))
+		{
+			cerr << getAppName(parser) << ": invalid sample \"" << sample << "\", expected NAME=PATH" << endl;
+			return ArgumentParser::PARSE_ERROR;
+		}
+		options.sampleNames.push_back(sample.substr(0, separator));
+		options.samplePaths.push_back(sample.substr(separator + 1));
+	}
+	getOptionValue(options.threads, parser, "threads");
+	options.verbosity = isSet(parser, "verbose") ? 3 : 0;
+
+	return parserResult;
+}
+
+// function to find the file with ping-pong signatures of a sample
+// Input parameters:
+//	path: a signature file or an output directory of pingpongpro
+//	indexOnly: if set to true, only a signature index file is considered; otherwise the signature index file is preferred over the TSV file
+// Return value: the path to the signature file
+string findSignatureFile(const string &path, bool indexOnly = false)
+{
+	struct stat fileStats;
+	if ((stat(path.c_str(), &fileStats) == 0) && S_ISDIR(fileStats.st_mode))
+	{
+		string directory = path + ((path[path.size()-1] != PATH_DELIMITER) ? string(1, PATH_DELIMITER) : string());
+		if (indexOnly || (stat((directory + "ping-pong_signatures.ppidx").c_str(), &fileStats) == 0))
+			return directory + "ping-pong_signatures.ppidx";
+		return directory + "ping-pong_signatures.tsv";
+	}
+	return path;
+}
+
+// function to parse command-line arguments of the "query" command
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Output parameters:
+//	options: parsed options
+// Return value: status code about whether the command-line could be parsed
+ArgumentParser::ParseResult parseQueryCommandLine(TQueryOptions &options, int argc, char const ** argv)
+{
+	ArgumentParser parser("pingpongpro query");
+
+	addUsageLine(parser, "-x \\fIINDEX\\fP -r \\fIREGION\\fP [-r \\fIREGION\\fP ...]");
+	setShortDescription(parser, "Query ping-pong signatures by region");
+	addDescription(parser, "Reads the ping-pong signatures in the given regions from a signature index file written by pingpongpro with the option -x. Only the parts of the index file covering the regions are read. For every region, the number of signatures, the sum of their scores ((stack height on + strand + stack height on - strand) * (1 - FDR)) and the sums of the stack heights are written to stdout, or the signatures themselves, if -S is given.");
+	setVersion(parser, "1.0");
+	setDate(parser, "Apr 2014");
+
+	addOption(parser, ArgParseOption("x", "index", "Signature index file (ping-pong_signatures.ppidx) or output directory of pingpongpro.", ArgParseArgument::STRING, "INDEX"));
+	setRequired(parser, "index");
+	addOption(parser, ArgParseOption("r", "region", "Region in the form \\fICONTIG\\fP:\\fISTART\\fP-\\fIEND\\fP (0-based, half-open) or \\fICONTIG\\fP for the entire contig.", ArgParseArgument::STRING, "REGION", true));
+	setRequired(parser, "region");
+	addOption(parser, ArgParseOption("O", "overlap", "Query signatures with an overlap of \\fINUMBER\\fP nucleotides.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "overlap", PING_PONG_OVERLAP);
+	setMinValue(parser, "overlap", "3");
+	setMaxValue(parser, "overlap", "23");
+	addOption(parser, ArgParseOption("S", "signatures", "Write the signatures in the regions instead of a summary. Default: \\fIoff\\fP."));
+
+	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
+	if (parserResult != ArgumentParser::PARSE_OK)
+		return parserResult;
+
+	getOptionValue(options.indexFile, parser, "index");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "region"); i++)
+	{
+		string region;
+		getOptionValue(region, parser, "region", i);
+		TQueryRegion queryRegion;
+		size_t colon = region.rfind(':');
+		size_t dash = (colon != string::npos) ? region.find('-', colon) : string::npos;
+		if (colon == string::npos)
+		{
+			queryRegion.contig = region;
+		}
+		else if ((dash == string::npos) ||
+		         !parseUnsignedInteger(TStringView(region.c_str() + colon + 1, dash - colon - 1), queryRegion.start) ||
+		         !parseUnsignedInteger(TStringView(region.c_str() + dash + 1, region.size() - dash - 1), queryRegion.end) ||
+		         (queryRegion.start >= queryRegion.end))
+		{
+			cerr << getAppName(parser) << ": invalid region \"" << region << "\", expected CONTIG:START-END" << endl;
+			return ArgumentParser::PARSE_ERROR;
+		}
+		else
+		{
+			queryRegion.contig = region.substr(0, colon);
+		}
+		options.regions.push_back(queryRegion);
+	}
+	getOptionValue(options.overlap, parser, "overlap");
+	options.signatures = isSet(parser, "signatures");
+
+	return parserResult;
+}
+
+// This function implements the "query" command: it writes the ping-pong signatures in regions of a signature index file to stdout.
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Return value: 1, if the index file could not be read; 0 otherwise
+int runQuery(int argc, char const ** argv)
+{
+	TQueryOptions options;
+	if (parseQueryCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
+		return 1;
+
+	TSignatureIndexFile indexFile;
+	if (openSignatureIndexFile(findSignatureFile(options.indexFile, true), indexFile) != 0)
+		return 1;
+
+	cout.setf(ios::scientific, ios::floatfield);
+	if (options.signatures)
+		cout << "contig\tposition\tFDR\tstackHeightOnPlusStrand\tstackHeightOnMinusStrand\n";
+	else
+		cout << "contig\tstart\tend\tsignatures\tscore\tstackHeightOnPlusStrand\tstackHeightOnMinusStrand\n";
+	for (vector< TQueryRegion >::iterator region = options.regions.begin(); region != options.regions.end(); ++region)
+	{
+		if (options.signatures)
+		{
+			const TSignatureIndexFileRecord *signatures;
+			uint64_t first, last;
+			findSignaturesInRegion(indexFile, region->contig, region->start, region->end, options.overlap, signatures, first, last);
+			for (uint64_t i = first; i < last; i++)
+				cout << region->contig << '\t' << signatures[i].position << '\t' << signatures[i].fdr << '\t' << signatures[i].readsOnPlusStrand << '\t' << signatures[i].readsOnMinusStrand << '\n';
+		}
+		else
+		{
+			TRegionSummary summary = querySignatureIndexFile(indexFile, region->contig, region->start, region->end, options.overlap);
+			cout << region->contig << '\t' << region->start << '\t' << region->end << '\t' << summary.signatures << '\t' << summary.score << '\t' << summary.readsOnPlusStrand << '\t' << summary.readsOnMinusStrand << '\n';
+		}
+	}
+	cout.flush();
+	closeSignatureIndexFile(indexFile);
+	return 0;
+}
+
+// This function processes a single request of the query server.
+// Input parameters:
+//	request: the request line without the trailing line feed
+//	sampleNames: the names of the loaded samples
+//	sampleIndexes: the signature indexes of the loaded samples
+//	sampleOverlaps: for every sample, whether its index holds the signatures of all overlaps (see <readSignatureIndexFromFile>)
+// Output parameters:
+//	response: the response to send to the client
+// Return value: 1, if the connection shall be closed; 2, if the server shall be stopped; 0 otherwise
+int processServerRequest(const string &request, const vector< string > &sampleNames, const vector< TSignatureIndex > &sampleIndexes, const vector< bool > &sampleOverlaps, string &response)
+{
+	stringstream requestStream(request);
+	string command, sample, contig;
+	requestStream >> command;
+
+	if (command == "QUIT")
+		return 1;
+	if (command == "SHUTDOWN")
+		return 2;
+
+	stringstream responseStream;
+	responseStream.setf(ios::scientific, ios::floatfield);
+	if (command == "SAMPLES")
+	{
+		responseStream << "OK " << sampleNames.size() << '\n';
+		for (unsigned int i = 0; i < sampleNames.size(); i++)
+			responseStream << sampleNames[i] << '\n';
+	}
+	else if ((command == "QUERY") || (command == "ACTIVITY") || (command == "SIGNATURES"))
+	{
+		// the positions are read as signed numbers, such that negative positions are rejected rather than wrapped around,
+		// and the optional overlap must be a number, if it is given
+		int64_t regionStart, regionEnd;
+		int overlap = PING_PONG_OVERLAP;
+		string extraToken;
+		bool wellFormed = static_cast<bool>(requestStream >> sample >> contig >> regionStart >> regionEnd);
+		if (wellFormed && !(requestStream >> ws).eof())
+			wellFormed = (requestStream >> overlap) && !(requestStream >> extraToken);
+		if (!wellFormed)
+		{
+			response = "ERROR malformed request\n";
+			return 0;
+		}
+		if ((regionStart < 0) || (regionStart > regionEnd) || (regionEnd > numeric_limits< unsigned int >::max()))
+		{
+			response = "ERROR invalid region\n";
+			return 0;
+		}
+		unsigned int start = regionStart, end = regionEnd;
+		if ((overlap < MIN_ARBITRARY_OVERLAP) || (overlap > MAX_ARBITRARY_OVERLAP))
+		{
+			response = "ERROR invalid overlap\n";
+			return 0;
+		}
+
+		// find the requested samples
+		vector< unsigned int > samples;
+		for (unsigned int i = 0; i < sampleNames.size(); i++)
+			if ((sample == "*") || (sample == sampleNames[i]))
+				samples.push_back(i);
+		if (samples.empty() || ((command == "SIGNATURES") && (samples.size() > 1)))
+		{
+			response = "ERROR unknown sample\n";
+			return 0;
+		}
+
+		// signatures of arbitrary overlaps are only known, if the sample was loaded from a signature index file
+		if ((command == "ACTIVITY") || (overlap != PING_PONG_OVERLAP))
+			for (unsigned int i = 0; i < samples.size(); i++)
+				if (!sampleOverlaps[samples[i]])
+				{
+					response = "ERROR sample " + sampleNames[samples[i]] + " lacks signatures of arbitrary overlaps\n";
+					return 0;
+				}
+
+		if (command == "QUERY")
+		{
+			responseStream << "OK " << samples.size() << '\n';
+			for (unsigned int i = 0; i < samples.size(); i++)
+			{
+				TRegionSummary summary = querySignatureIndex(sampleIndexes[samples[i]], contig, start, end, overlap);
+				responseStream << sampleNames[samples[i]] << '\t' << summary.signatures << '\t' << summary.score << '\t' << summary.readsOnPlusStrand << '\t' << summary.readsOnMinusStrand << '\n';
+			}
+		}
+		else if (command == "ACTIVITY")
+		{
+			responseStream << "OK " << samples.size() << '\n';
+			for (unsigned int i = 0; i < samples.size(); i++)
+			{
+				float histogram[ARBITRARY_OVERLAP_COUNT];
+				for (unsigned int j = 0; j < ARBITRARY_OVERLAP_COUNT; j++)
+					histogram[j] = querySignatureIndex(sampleIndexes[samples[i]], contig, start, end, j + MIN_ARBITRARY_OVERLAP).score;
+				responseStream << sampleNames[samples[i]];
+				for (unsigned int j = 0; j < ARBITRARY_OVERLAP_COUNT; j++)
+					responseStream << '\t' << histogram[j];
+				responseStream << '\t' << calculatePValueOfHistogram(histogram) << '\n';
+			}
+		}
+		else /*if (command == "SIGNATURES")*/
+		{
+			const TSignatureIndexPerContig *signatures;
+			unsigned int first, last;
+			findSignaturesInRegion(sampleIndexes[samples[0]], contig, start, end, overlap, signatures, first, last);
+			responseStream << "OK " << (last - first) << '\n';
+			for (unsigned int i = first; i < last; i++)
+				responseStream << contig << '\t' << signatures->positions[i] << '\t' << signatures->fdr[i] << '\t' << signatures->readsOnPlusStrand[i] << '\t' << signatures->readsOnMinusStrand[i] << '\n';
+		}
+	}
+	else
+	{
+		responseStream << "ERROR unknown command\n";
+	}
+	response = responseStream.str();
+	return 0;
+}
+
+#if !defined(WIN32) && !defined(_WIN32)
+// This function processes the complete requests a client of the query server has sent so far.
+// It is executed by the worker threads of <runServer>, which does not poll the connection, while it is busy.
+// Input parameters:
+//	requests: one or more requests, each terminated by a line feed
+//	sampleNames, sampleIndexes, sampleOverlaps: the loaded samples (see <processServerRequest>)
+// Input/output parameters:
+//	connection: the connection of the client, which is marked as no longer busy at the end
+//	state: the state of the server, which is told to stop, when a client requests to stop the server
+void serveRequests(TServerConnection *connection, const string &requests, const vector< string > *sampleNames, const vector< TSignatureIndex > *sampleIndexes, const vector< bool > *sampleOverlaps, TServerState *state)
+{
+	bool open = true;
+	bool stopping = false;
+	size_t lineStart = 0, lineEnd;
+	while (open && ((lineEnd = requests.find('\n', lineStart)) != string::npos))
+	{
+		string request = requests.substr(lineStart, lineEnd - lineStart);
+		if (!request.empty() && (request[request.size()-1] == '\r'))
+			request.erase(request.size()-1);
+		lineStart = lineEnd + 1;
+
+		string response;
+		int status = processServerRequest(request, *sampleNames, *sampleIndexes, *sampleOverlaps, response);
+		if (status == 2)
+			stopping = true;
+		if (status != 0)
+		{
+			open = false;
 			break;
-	}
+		}
 
-	unsigned int fieldNumber = 1; // index of the column that is currently being read from the input file
-	string fieldValue = ""; // every column in the input file is first read into this variable
+		// send the entire response (the socket has a send timeout, see <runServer>)
+		size_t sent = 0;
+		while (sent < response.size())
+		{
+			ssize_t bytes = send(connection->socket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+			if (bytes <= 0)
+			{
+				open = false;
+				break;
+			}
+			sent += bytes;
+		}
+	}
 
-	// when a field has been fully read, it is assigned to one of the following transposon attributes:
-	string transposonIdentifier = "";
-	int transposonStrand = -1;
-	int transposonContig = -1;
-	int transposonStart = -1;
-	int transposonEnd = -1;
+	// hand the connection back to the event loop
+	{
+		lock_guard< mutex > lock(state->lock);
+		connection->busy = false;
+		connection->closing = connection->closing || !open;
+		state->stopping = state->stopping || stopping;
+	}
+	char wakeup = 0;
+	if (write(state->wakeupPipe[1], &wakeup, 1) < 0)
+	{
+		// the pipe is full, so the event loop is going to wake up anyway
+	}
+}
+#endif
 
-	bool newLine = false; // set to true, when a line-feed is read
-	bool quotesOpen = false; // in CSV files, keeps track of opening and closing double-quotes
+// This function implements the "serve" command: it loads the signatures of samples and answers queries on a Unix domain socket.
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Return value: 1, if the server could not be started; 0 otherwise
+int runServer(int argc, char const ** argv)
+{
+	TServeOptions options;
+	if (parseServeCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
+		return 1;
 
-	// read the transposon file character by character
-	while (transposonFile.good())
+	#if defined(WIN32) || defined(_WIN32)
+	cerr << "The query server is not supported on this platform" << endl;
+	return 1;
+	#else
+	// load the signatures of all samples
+	vector< TSignatureIndex > sampleIndexes(options.sampleNames.size());
+	vector< bool > sampleOverlaps(options.sampleNames.size());
+	if (options.verbosity >= 3)
+		cerr << "Loading ping-pong signatures" << endl;
+	for (unsigned int i = 0; i < options.sampleNames.size(); i++)
 	{
-		char character = transposonFile.get();
+		stopwatch("  " + options.sampleNames[i], options.verbosity);
+		bool allOverlaps;
+		if (readSignatureIndexFromFile(findSignatureFile(options.samplePaths[i]), sampleIndexes[i], allOverlaps) != 0)
+			return 1;
+		sampleOverlaps[i] = allOverlaps;
+		stopwatch(options.verbosity);
+	}
 
-		if (!transposonFile.good())
-			character = '\n'; // make sure the last line is processed, even if it does not end on a line feed
+	// listen on the socket
+	int listeningSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if ((listeningSocket < 0) || (options.socket.size() >= sizeof(address.sun_path)))
+	{
+		cerr << "Failed to create socket \"" << options.socket << "\"." << endl;
+		return 1;
+	}
+	strcpy(address.sun_path, options.socket.c_str());
+	unlink(options.socket.c_str()); // remove stale socket of a previous server
+	if ((bind(listeningSocket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) || (listen(listeningSocket, SOMAXCONN) != 0))
+	{
+		cerr << "Failed to listen on socket \"" << options.socket << "\"." << endl;
+		close(listeningSocket);
+		return 1;
+	}
+	if (options.verbosity >= 3)
+		cerr << "Listening on " << options.socket << endl;
 
-		if (character == '\n')
-		{
-			newLine = true;
-			character = delimiter; // when we encounter a new line, we basically do the same as when we encounter a delimiter
-		}
-		else if ((delimiter == ' ') && (character == '\t')) // when delimiter is set to a blank, then treat any white-space (i.e., ' ' and '\t') as a delimiter
-		{
-			character = ' ';
-		}
+	TServerState state;
+	if ((fcntl(listeningSocket, F_SETFL, O_NONBLOCK) != 0) || (pipe(state.wakeupPipe) != 0) || (fcntl(state.wakeupPipe[0], F_SETFL, O_NONBLOCK) != 0) || (fcntl(state.wakeupPipe[1], F_SETFL, O_NONBLOCK) != 0))
+	{
+		cerr << "Failed to create pipe for the event loop" << endl;
+		close(listeningSocket);
+		return 1;
+	}
 
-		if ((character == delimiter) && !((fileFormat == fileFormatCSV) && quotesOpen)) // encountered delimiter character => assign current field to appropriate transposon attribute and then, begin a new field
+	// Wait for requests on all idle connections and hand complete requests to the worker threads, until a client requests to stop the server.
+	// Idle clients do not occupy a worker thread, so any number of clients may stay connected.
+	TThreadPool pool;
+	startThreadPool(pool, options.threads);
+	map< int, TServerConnection > connections;
+	vector< struct pollfd > descriptors;
+	char chunk[65536];
+	int result = 0;
+	while (true)
+	{
+		// close the connections that are done and find those to poll
+		descriptors.resize(2);
+		descriptors[0].fd = listeningSocket;
+		descriptors[1].fd = state.wakeupPipe[0];
 		{
-			if (!fieldValue.empty() || newLine)
+			lock_guard< mutex > lock(state.lock);
+			if (state.stopping)
+				break;
+			for (map< int, TServerConnection >::iterator connection = connections.begin(); connection != connections.end();)
 			{
-				if (fieldNumber == identifierField)
-				{
-					transposonIdentifier = fieldValue;
-				}
-				else if (fieldNumber == strandField)
-				{
-					if (fieldValue == "+")
-						transposonStrand = STRAND_PLUS;
-					else if (fieldValue == "-")
-						transposonStrand = STRAND_MINUS;
-				}
-				else if (fieldNumber == contigField)
-				{
-					for (unsigned int i = 0; (transposonContig == -1) && (i < length(bamNameStore)); i++)
-						if (bamNameStore[i] == fieldValue)
-							transposonContig = i;
-
-					if (transposonContig == -1) // the contig was not found in the name store
-					{
-						// add a new element to the name store
-						appendValue(bamNameStore, fieldValue);
-						transposonContig = length(bamNameStore) - 1;
-					}
-				}
-				else if (fieldNumber == startField)
+				if (connection->second.busy)
 				{
-					transposonStart = atoi(fieldValue.c_str());
-					if ((transposonStart == 0) && (fieldValue != "0")) // a conversion error occurred
-					{
-						transposonStart = -1;
-					}
-					else
-					{
-						transposonStart -= offset; // shift coordinate, in case the file format starts counting at 1 instead of 0
-					}
+					++connection;
+					continue;
 				}
-				else if (fieldNumber == endField)
+				if (connection->second.closing)
 				{
-					transposonEnd = atoi(fieldValue.c_str());
-					if ((transposonEnd == 0) && (fieldValue != "0")) // a conversion error occurred
-					{
-						transposonEnd = -1;
-					}
-					else
-					{
-						transposonEnd = transposonEnd - offset + halfOpenOrClosed; // shift coordinate, in case the file format starts counting at 1 instead of 0 or if the format is closed instead of half open
-					}
+					close(connection->first);
+					connections.erase(connection++);
+					continue;
 				}
+				struct pollfd descriptor;
+				descriptor.fd = connection->first;
+				descriptors.push_back(descriptor);
+				++connection;
+			}
+		}
+		for (vector< struct pollfd >::iterator descriptor = descriptors.begin(); descriptor != descriptors.end(); ++descriptor)
+		{
+			descriptor->events = POLLIN;
+			descriptor->revents = 0;
+		}
+		if (poll(&descriptors[0], descriptors.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "Failed to wait for requests" << endl;
+			result = 1;
+			break;
+		}
 
-				if (newLine)
-				{
-					// skip lines that could not be parsed
-					if ((transposonStrand >= 0) && (transposonContig >= 0) && (transposonStart >= 0) && (transposonEnd >= 0) && !transposonIdentifier.empty())
-						transposons[transposonContig].push_back(TTransposon(transposonIdentifier, transposonStrand, transposonStart, transposonEnd));
-
-					// reset fields
-					newLine = false;
-					transposonStrand = transposonContig = transposonStart = transposonEnd = -1;
-					transposonIdentifier.clear();
-					fieldNumber = 1;
-				}
-				else
-				{
-					fieldNumber++;
-				}
+		// workers wake up the loop, when they are done with a connection
+		if (descriptors[1].revents != 0)
+			while (read(state.wakeupPipe[0], chunk, sizeof(chunk)) > 0);
 
-				fieldValue = "";
+		// accept a new client
+		if (descriptors[0].revents != 0)
+		{
+			int connection = accept(listeningSocket, NULL, NULL);
+			if (connection >= 0)
+			{
+				struct timeval timeout;
+				timeout.tv_sec = SERVER_SEND_TIMEOUT;
+				timeout.tv_usec = 0;
+				setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+				connections[connection].socket = connection;
+			}
+			else if ((errno != EINTR) && (errno != EAGAIN) && (errno != ECONNABORTED))
+			{
+				cerr << "Failed to accept connection" << endl;
+				result = 1;
+				break;
 			}
 		}
-		else
+
+		// read from the clients and hand complete requests to the worker threads
+		for (vector< struct pollfd >::iterator descriptor = descriptors.begin() + 2; descriptor != descriptors.end(); ++descriptor)
 		{
-			if (!((character == '\r') && (transposonFile.peek() == '\n'))) // skip carriage-returns, if the next character is a line feed
+			if (descriptor->revents == 0)
+				continue;
+			TServerConnection &connection = connections[descriptor->fd];
+			ssize_t received = recv(connection.socket, chunk, sizeof(chunk), 0);
+			if (received <= 0)
 			{
-				if ((fileFormat == fileFormatCSV) && (character == '"')) // in the CSV format, fields may be enclosed by double-quotes
-				                                                         // we need to keep track of whether all opening quotes have a closing counterpart
-				{
-					if (!fieldValue.empty() && !quotesOpen)
-						fieldValue += character; // two consecutive double-quotes are collapsed to one
-					quotesOpen = !quotesOpen;
-				}
-				else
+				connection.closing = true;
+				continue;
+			}
+			connection.buffer.append(chunk, received);
+			size_t requestsEnd = connection.buffer.rfind('\n');
+			if (requestsEnd != string::npos)
+			{
+				string requests = connection.buffer.substr(0, requestsEnd + 1);
+				connection.buffer.erase(0, requestsEnd + 1);
+				lock_guard< mutex > lock(state.lock);
+				connection.busy = true;
+				submitTask(pool, bind(serveRequests, &connection, requests, &options.sampleNames, &sampleIndexes, &sampleOverlaps, &state));
+			}
+			else if (connection.buffer.size() > MAX_SERVER_REQUEST_LENGTH)
+			{
+				const char *error = "ERROR request too long\n";
+				if (send(connection.socket, error, strlen(error), MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
 				{
-					fieldValue += character;
+					// the connection is closed anyway
 				}
+				connection.closing = true;
 			}
 		}
 	}
 
-	// sort transposons by genomic position
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
-		contig->second.sort();
+	// close all connections before waiting for the worker threads, such that no worker stays blocked in sending a response
+	{
+		lock_guard< mutex > lock(state.lock);
+		for (map< int, TServerConnection >::iterator connection = connections.begin(); connection != connections.end(); ++connection)
+			shutdown(connection->first, SHUT_RDWR);
+	}
+	stopThreadPool(pool);
+	for (map< int, TServerConnection >::iterator connection = connections.begin(); connection != connections.end(); ++connection)
+		close(connection->first);
+	close(state.wakeupPipe[0]);
+	close(state.wakeupPipe[1]);
+	close(listeningSocket);
+	unlink(options.socket.c_str());
+	return result;
+	#endif
 }
 
-// Function to sort list of Transposons by p-value for multiple testing correction using Benjamini-Hochberg procedure.
-// The function is used by list::sort to compare which of two TTransposon objects is lower, based on their pValue attribute.
+// the dense store is skipped by the benchmark, if it would need more memory than this
+const double MAX_DENSE_BENCHMARK_BYTES = 4.0 * 1024 * 1024 * 1024;
+
+// This function measures the speed and memory consumption of a type of stack store (see <TStackStoreType>).
+// The events are added to one store per strand and contig, the stores are frozen and the stacks on the + strand are swept,
+// while the stacks on the - strand in the range of the arbitrary overlaps are probed by a window, like in <countStacksByGroup>.
 // Input parameters:
-// 	transposon1, transposon2: the transposons to compare
-// Return value: true, if transposon1 has a lower genomic coordinate than transposon2; false otherwise
-inline bool compareTransposonsByPValue(const TTransposonsPerContig::iterator &transposon1, const TTransposonsPerContig::iterator &transposon2)
+//	events: the reads to add to the stores
+//	contigCount: the number of contigs referred to by the events
+// Output parameters:
+//	result: the measurements
+template <typename TStore>
+void benchmarkStackStore(const vector< TStackEvent > &events, unsigned int contigCount, TStackStoreBenchmark &result)
+{
+	vector< TStore > stores[2];
+	stores[STRAND_PLUS].resize(contigCount);
+	stores[STRAND_MINUS].resize(contigCount);
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (vector< TStackEvent >::const_iterator event = events.begin(); event != events.end(); ++event)
+		addToStackStore(stores[event->strand][event->contig], event->position, event->reads, event->AAtPosition10);
+	result.ingestSeconds = secondsSince(start);
+
+	start = chrono::steady_clock::now();
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (typename vector< TStore >::iterator store = stores[strand].begin(); store != stores[strand].end(); ++store)
+			freezeStackStore(*store);
+	result.freezeSeconds = secondsSince(start);
+
+	start = chrono::steady_clock::now();
+	result.pairs.assign(ARBITRARY_OVERLAP_COUNT, 0);
+	for (unsigned int contig = 0; contig < contigCount; contig++)
+	{
+		typename TStore::TCursor window = beginStacks(stores[STRAND_MINUS][contig]);
+		for (typename TStore::TCursor stackOnPlusStrand = beginStacks(stores[STRAND_PLUS][contig]); !atEndOfStacks(stackOnPlusStrand); nextStack(stackOnPlusStrand))
+		{
+			advanceStackCursor(window, static_cast<int64_t>(stackPosition(stackOnPlusStrand)) + MIN_ARBITRARY_OVERLAP);
+			for (typename TStore::TCursor stackOnMinusStrand = window; !atEndOfStacks(stackOnMinusStrand) && (stackPosition(stackOnMinusStrand) <= stackPosition(stackOnPlusStrand) + MAX_ARBITRARY_OVERLAP); nextStack(stackOnMinusStrand))
+				result.pairs[stackPosition(stackOnMinusStrand) - stackPosition(stackOnPlusStrand) - MIN_ARBITRARY_OVERLAP] += (stackValue(stackOnPlusStrand).reads > 0) && (stackValue(stackOnMinusStrand).reads > 0);
+		}
+	}
+	result.sweepSeconds = secondsSince(start);
+
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (typename vector< TStore >::iterator store = stores[strand].begin(); store != stores[strand].end(); ++store)
+		{
+			for (typename TStore::TCursor stack = beginStacks(*store); !atEndOfStacks(stack); nextStack(stack))
+				result.stacks++;
+			result.bytes += stackStoreBytes(*store);
+		}
+}
+
+// function to sort the events of the benchmark by contig and position
+inline bool compareStackEventsByPosition(const TStackEvent &event1, const TStackEvent &event2)
 {
-	return transposon1->pValue < transposon2->pValue;
+	return (event1.contig < event2.contig) || ((event1.contig == event2.contig) && (event1.position < event2.position));
 }
 
-// This function checks given transposons for ping-pong activity.
-// A transposon is assumed to be suppressed by ping-pong activity, if there are significantly more ping-pong signatures within its region
-// than there are arbitrary signatures.
+// This function generates a synthetic piRNA library for the benchmark.
+// The reads are clustered like piRNAs and a part of them has a ping-pong partner on the opposite strand.
+// The reads are sorted by position, like in a coordinate-sorted BAM file.
 // Input parameters:
-//	pingPongSignaturesByOverlap: the ping-pong signtures found by function <countStacksByGroup>
-// Input/output parameters
-//	transposons: a list of transposons to check for ping-pong activity
-//	             every transposon is assigned a p-value and a q-value indicating the statistical significance of ping-pong activity
-void findSuppressedTransposons(TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, TTransposonsPerGenome &transposons)
+//	reads: the number of reads to generate
+// Output parameters:
+//	events: the generated reads
+//	contigCount: the number of contigs of the library
+void generateSyntheticStackEvents(unsigned int reads, vector< TStackEvent > &events, unsigned int &contigCount)
 {
-	// slide over the genome and calculate a z-score for every transposon overlapping the current position
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
+	const unsigned int CONTIG_LENGTH = 20000000;
+	const unsigned int CLUSTERS_PER_CONTIG = 2000;
+	const unsigned int CLUSTER_LENGTH = 5000;
+	const unsigned int READ_LENGTH = 26;
+	contigCount = 4;
+
+	uint64_t state = 88172645463325252ULL; // xorshift generator, such that the library is the same on all platforms
+	events.reserve(reads);
+	while (events.size() < reads)
 	{
-		// for every overlap we need to keep track of the iterator that points to the ping-pong signature where we are currently at
-		vector< TPingPongSignaturesPerContig::iterator > positionByOverlap(pingPongSignaturesByOverlap.size());
-		for (unsigned int overlap = 0; overlap < pingPongSignaturesByOverlap.size(); overlap++)
-			if (pingPongSignaturesByOverlap[overlap].find(contig->first) != pingPongSignaturesByOverlap[overlap].end())
-				positionByOverlap[overlap] = pingPongSignaturesByOverlap[overlap][contig->first].begin();
-			else
-				positionByOverlap[overlap] = pingPongSignaturesByOverlap[overlap][contig->first].end(); // there are no ping-pong stacks for the given contig and overlap
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		unsigned int contig = state % contigCount;
+		unsigned int cluster = (state >> 8) % CLUSTERS_PER_CONTIG;
+		unsigned int leftmost = cluster * (CONTIG_LENGTH / CLUSTERS_PER_CONTIG) + (state >> 24) % CLUSTER_LENGTH;
+		bool reverse = (state >> 48) & 1;
+		bool AAtPosition10 = ((state >> 49) & 3) == 0;
+		events.push_back(TStackEvent(contig, reverse ? STRAND_MINUS : STRAND_PLUS, reverse ? leftmost + READ_LENGTH : leftmost, 1, AAtPosition10));
+
+		// every third read has a ping-pong partner
+		if ((((state >> 52) % 3) == 0) && (events.size() < reads))
+			events.push_back(TStackEvent(contig, reverse ? STRAND_PLUS : STRAND_MINUS, reverse ? leftmost + READ_LENGTH - PING_PONG_OVERLAP : leftmost + PING_PONG_OVERLAP, 1, !AAtPosition10));
+	}
+	sort(events.begin(), events.end(), compareStackEventsByPosition);
+}
 
-		for (TTransposonsPerContig::iterator transposon = contig->second.begin(); transposon != contig->second.end(); ++transposon)
+// This function converts the stacks found in the input files of the benchmark into events,
+// such that the stores are filled in the same order and with the same amounts as by <countAlignment>.
+// Input parameters:
+//	readStacks: the stacks of reads found in the input files
+// Output parameters:
+//	events: one event per read (at most MAX_EVENTS_PER_STACK per stack), sorted by position
+//	contigCount: the number of contigs referred to by the events
+void convertStacksToEvents(const TReadStacksPerGenome &readStacks, vector< TStackEvent > &events, unsigned int &contigCount)
+{
+	const unsigned int MAX_EVENTS_PER_STACK = 1000;
+	contigCount = 0;
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::const_iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
 		{
-			// calculate score for transposon for each overlap
-			transposon->histogram.resize(positionByOverlap.size());
-			for (unsigned int overlap = 0; overlap < positionByOverlap.size(); overlap++)
+			if (contig->first >= contigCount)
+				contigCount = contig->first + 1;
+			for (TStackCursor stack = beginStacks(contig->second); !atEndOfStacks(stack); nextStack(stack))
 			{
-				// move iterator of ping-pong signature to start of current transposon
-				while ((positionByOverlap[overlap] != pingPongSignaturesByOverlap[overlap][contig->first].begin()) && (positionByOverlap[overlap]->position > transposon->start))
-					--(positionByOverlap[overlap]);
-				while ((positionByOverlap[overlap] != pingPongSignaturesByOverlap[overlap][contig->first].end()) && (positionByOverlap[overlap]->position < transposon->start))
-					++(positionByOverlap[overlap]);
+				// split the stack into reads of equal weight, such that the total number of reads is preserved
+				unsigned int reads = max(1.0f, min(floor(stackValue(stack).reads + 0.5f), static_cast<float>(MAX_EVENTS_PER_STACK)));
+				for (unsigned int read = 0; read < reads; read++)
+					events.push_back(TStackEvent(contig->first, strand, stackPosition(stack), stackValue(stack).reads / reads, stackValue(stack).AAtPosition10));
+			}
+		}
+	stable_sort(events.begin(), events.end(), compareStackEventsByPosition);
+}
 
-				// sum up the scores of all signatures (ping-pong or arbitrary) within the transposon region
-				float sumOfScores = 0;
-				if (positionByOverlap[overlap]->position >= transposon->start)
-				{
-					while ((positionByOverlap[overlap]->position <= transposon->end) && (positionByOverlap[overlap] != pingPongSignaturesByOverlap[overlap][contig->first].end()))
-					{
-						// sum up scores of all signatures (ping-pong or arbitrary) within the transposon region
-						sumOfScores += (positionByOverlap[overlap]->readsOnPlusStrand + positionByOverlap[overlap]->readsOnMinusStrand) * (1 - positionByOverlap[overlap]->fdr);
+// function to parse command-line arguments of the "benchmark" command
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Output parameters:
+//	options: parsed options
+// Return value: status code about whether the command-line could be parsed
+ArgumentParser::ParseResult parseBenchmarkCommandLine(TBenchmarkOptions &options, int argc, char const ** argv)
+{
+	ArgumentParser parser("pingpongpro benchmark");
 
-						// sum up the number of reads on each strand (for ping-pong overlaps only)
-						if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP == PING_PONG_OVERLAP)
-						{
-							transposon->readsOnPlusStrand += positionByOverlap[overlap]->readsOnPlusStrand;
-							transposon->readsOnMinusStrand += positionByOverlap[overlap]->readsOnMinusStrand;
-						}
+	addUsageLine(parser, "[-i \\fIPATH\\fP ...] [-n \\fINUMBER\\fP]");
+	setShortDescription(parser, "Compare the stores of read stacks");
+	addDescription(parser, "Fills every type of stack store (map, flat, dense, hash, compressed) with the reads of the given SAM/BAM/CRAM files, or with a synthetic piRNA library, if no input files are given. For every store, the number of stacks, the ingestion throughput in million reads per second, the time to freeze the store, the time to sweep the stacks and probe the stacks on the opposite strand in the range of overlaps, and the memory consumption per stack are written to stdout.");
+	setVersion(parser, "1.0");
+	setDate(parser, "Apr 2014");
 
-						++(positionByOverlap[overlap]);
-					}
-				}
+	addOption(parser, ArgParseOption("i", "input", "Input file(s) in SAM/BAM/CRAM format.", ArgParseArgument::INPUTFILE, "PATH", true));
+	setValidValues(parser, "input", "sam bam cram");
+	addOption(parser, ArgParseOption("r", "reference", "Reference genome in FASTA format. Required to decode CRAM files.", ArgParseArgument::INPUTFILE, "PATH"));
+	addOption(parser, ArgParseOption("n", "synthetic-reads", "Number of reads of the synthetic library.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "synthetic-reads", 2000000);
+	setMinValue(parser, "synthetic-reads", "1");
+	addOption(parser, ArgParseOption("l", "min-alignment-length", "Ignore alignments in the input file that are shorter than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "min-alignment-length", 24);
+	setMinValue(parser, "min-alignment-length", "1");
+	addOption(parser, ArgParseOption("L", "max-alignment-length", "Ignore alignments in the input file that are longer than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "max-alignment-length", 32);
+	setMinValue(parser, "max-alignment-length", "1");
 
-				transposon->histogram[overlap] = sumOfScores;
-			}
+	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
+	if (parserResult != ArgumentParser::PARSE_OK)
+		return parserResult;
+
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "input"); i++)
+	{
+		CharString inputFile;
+		getOptionValue(inputFile, parser, "input", i);
+		options.inputFiles.push_back(inputFile);
+	}
+	getOptionValue(options.referenceFile, parser, "reference");
+	getOptionValue(options.syntheticReads, parser, "synthetic-reads");
+	getOptionValue(options.minAlignmentLength, parser, "min-alignment-length");
+	getOptionValue(options.maxAlignmentLength, parser, "max-alignment-length");
+	if (options.minAlignmentLength > options.maxAlignmentLength)
+	{
+		cerr << getAppName(parser) << ": minimum alignment length must not be greater than maximum alignment length" << endl;
+		return ArgumentParser::PARSE_ERROR;
+	}
 
-			// calculate mean transposon score of all arbitrary overlaps
-			float meanOfArbitraryOverlaps = 0;
-			for (unsigned int overlap = 0; overlap < transposon->histogram.size(); overlap++)
-				if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP != PING_PONG_OVERLAP) // ignore ping-pong overlaps in the mean calculation, since they would skew the result
-					meanOfArbitraryOverlaps += transposon->histogram[overlap];
-			meanOfArbitraryOverlaps = meanOfArbitraryOverlaps / (positionByOverlap.size() - 1 /* minus the one bin for ping-pong overlaps */);
+	return parserResult;
+}
 
-			if ((meanOfArbitraryOverlaps == 0) && (transposon->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] == 0)) // there are no ping-pong signatures in the region of the transposon
-			{
-				transposon->pValue = 1;
-			}
-			else
-			{
-				// calculate standard deviation of transposon score of all arbitrary overlaps
-				float stdDevOfArbitraryOverlaps = 0;
-				for (unsigned int overlap = 0; overlap < positionByOverlap.size(); overlap++)
-					if (static_cast<int>(overlap) + MIN_ARBITRARY_OVERLAP != PING_PONG_OVERLAP) // ignore ping-pong stacks, since they would skew the result
-						stdDevOfArbitraryOverlaps += pow(transposon->histogram[overlap] - meanOfArbitraryOverlaps, 2);
-				stdDevOfArbitraryOverlaps = sqrt(1.0 / (transposon->histogram.size() - 1 - 1 /* minus 1 for corrected sample STDDEV */) * stdDevOfArbitraryOverlaps);
-				if (stdDevOfArbitraryOverlaps <= MIN_STANDARD_DEVIATION)
-					stdDevOfArbitraryOverlaps = MIN_STANDARD_DEVIATION; // prevent division by 0, in case the STDDEV is 0
+// This function implements the "benchmark" command: it compares the stores of read stacks (see <TStackStoreType>).
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Return value: 1, if the input files could not be read or if the stores disagree; 0 otherwise
+int runBenchmark(int argc, char const ** argv)
+{
+	TBenchmarkOptions options;
+	if (parseBenchmarkCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
+		return 1;
 
-				// calculate significance of transposon score of ping-pong overlap vs. arbitrary overlaps
-				double zValue = (transposon->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] - meanOfArbitraryOverlaps) / stdDevOfArbitraryOverlaps;
-				double pValue = 0;
-				for (double x = zValue; x <= zValue + APPROXIMATION_RANGE; x += APPROXIMATION_ACCURACY)
-					pValue += APPROXIMATION_ACCURACY * 1/sqrt(2*M_PI)*exp(-0.5*x*x);
+	// collect the reads to add to the stores
+	vector< TStackEvent > events;
+	unsigned int contigCount = 0;
+	if (options.inputFiles.empty())
+	{
+		generateSyntheticStackEvents(options.syntheticReads, events, contigCount);
+	}
+	else
+	{
+		AppOptions readOptions = AppOptions();
+		readOptions.minAlignmentLength = options.minAlignmentLength;
+		readOptions.maxAlignmentLength = options.maxAlignmentLength;
+		readOptions.countMultiHits = multiHitsWeighted;
+		readOptions.referenceFile = options.referenceFile;
+		readOptions.blockReader = true;
+		TReadStacksPerGenome readStacks;
+		TNameStore bamNameStore;
+		double totalReadCount = 0;
+		if (countReadsInSample(options.inputFiles, readOptions, 0, 1, "", readStacks, NULL, bamNameStore, totalReadCount, NULL) != 0)
+			return 1;
+		convertStacksToEvents(readStacks, events, contigCount);
+	}
 
-				transposon->pValue = pValue;
-			}
+	// the dense store needs one slot per position between the first and the last stack of every contig
+	vector< unsigned int > firstPosition(contigCount, UINT_MAX), lastPosition(contigCount, 0);
+	for (vector< TStackEvent >::iterator event = events.begin(); event != events.end(); ++event)
+	{
+		firstPosition[event->contig] = min(firstPosition[event->contig], event->position);
+		lastPosition[event->contig] = max(lastPosition[event->contig], event->position);
+	}
+	double denseBytes = 0;
+	for (unsigned int contig = 0; contig < contigCount; contig++)
+		if (firstPosition[contig] <= lastPosition[contig])
+			denseBytes += 2.0 * (lastPosition[contig] - firstPosition[contig] + 1) * sizeof(TReadStack);
+
+	TStackStoreBenchmark results[stackStoreCompressed + 1];
+	benchmarkStackStore<TMapStackStore>(events, contigCount, results[stackStoreMap]);
+	benchmarkStackStore<TFlatStackStore>(events, contigCount, results[stackStoreFlat]);
+	if (denseBytes <= MAX_DENSE_BENCHMARK_BYTES)
+		benchmarkStackStore<TDenseStackStore>(events, contigCount, results[stackStoreDense]);
+	benchmarkStackStore<THashStackStore>(events, contigCount, results[stackStoreHash]);
+	benchmarkStackStore<TCompressedStackStore>(events, contigCount, results[stackStoreCompressed]);
+
+	cout.setf(ios::fixed, ios::floatfield);
+	cout.precision(3);
+	cout << "store\tstacks\tingestMillionReadsPerSecond\tfreezeSeconds\tsweepSeconds\tbytesPerStack\n";
+	int result = 0;
+	for (unsigned int store = stackStoreMap; store <= stackStoreCompressed; store++)
+	{
+		if ((store == stackStoreDense) && (denseBytes > MAX_DENSE_BENCHMARK_BYTES))
+		{
+			cout << STACK_STORE_NAMES[store] << "\tNA\tNA\tNA\tNA\tNA\n";
+			continue;
+		}
+		const TStackStoreBenchmark &benchmark = results[store];
+		cout << STACK_STORE_NAMES[store] << '\t' << static_cast<uint64_t>(benchmark.stacks) << '\t'
+		     << ((benchmark.ingestSeconds > 0) ? events.size() / benchmark.ingestSeconds / 1e6 : 0) << '\t'
+		     << benchmark.freezeSeconds << '\t' << benchmark.sweepSeconds << '\t'
+		     << ((benchmark.stacks > 0) ? benchmark.bytes / benchmark.stacks : 0) << '\n';
+		if ((benchmark.stacks != results[stackStoreMap].stacks) || (benchmark.pairs != results[stackStoreMap].pairs))
+		{
+			cerr << "Store \"" << STACK_STORE_NAMES[store] << "\" disagrees with store \"" << STACK_STORE_NAMES[stackStoreMap] << "\"." << endl;
+			result = 1;
 		}
 	}
+	return result;
+}
 
-	// sort transposons by p-value for multiple testing-correction with Benjamini-Hochberg procedure (FDR)
-	list< TTransposonsPerContig::iterator > transposonsSortedByPValue;
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
-		for (TTransposonsPerContig::iterator transposon = contig->second.begin(); transposon != contig->second.end(); ++transposon)
-			transposonsSortedByPValue.push_back(transposon);
-	transposonsSortedByPValue.sort(compareTransposonsByPValue);
+// This function parses the options of the "verify" command.
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Output parameters:
+//	options: the options given on the command-line
+// Return value: the result of parsing the command-line
+ArgumentParser::ParseResult parseVerifyCommandLine(TVerifyOptions &options, int argc, char const ** argv)
+{
+	ArgumentParser parser("pingpongpro verify");
 
-	unsigned i = 1;
-	float previousPValue = 1;
-	float previousQValue = 1;
-	list< TTransposonsPerContig::iterator >::reverse_iterator transposon = transposonsSortedByPValue.rbegin();
-	while (transposon != transposonsSortedByPValue.rend())
+	addUsageLine(parser, "-i \\fIPATH\\fP [-i \\fIPATH\\fP ...] [-t \\fIPATH\\fP ...] [-w \\fISIZE\\fP ...] [-D \\fISPEC\\fP ...] [-x] [-j \\fITHREADS\\fP] [-A \\fITOLERANCE\\fP] [-E \\fITOLERANCE\\fP]");
+	setShortDescription(parser, "Check that the optimized code paths give the same results as the legacy ones");
+	addDescription(parser, "Analyzes the given SAM/BAM/CRAM files or count tables twice: with a reference configuration, which uses the legacy code paths (SeqAn reader, stacks in a map, one thread sweeping each contig in a single tile), and with a candidate configuration, which uses the optimized code paths (block reader, stack stores chosen by the run planner, parallel tiles and parallel formatting of the output files with the given number of threads). In addition, the read stacks are passed through every alternative stack store (flat, dense, hash, compressed). The read stacks, the ping-pong signatures, the transposons, the activity tracks, the distance histograms and the signature index of both configurations are compared by a sorted merge, where numbers are considered equal, if they differ by at most the absolute tolerance plus the relative tolerance times the larger number. The first divergences of every comparison are printed to stderr and a summary of every comparison is written to stdout. The exit code is 1, if there are divergences.");
+	setVersion(parser, "1.0");
+	setDate(parser, "Apr 2014");
+
+	addOption(parser, ArgParseOption("i", "input", "Input file(s) in SAM/BAM/CRAM format or tables of the number of reads per 5' end in TSV or bedGraph format (see \\fBpingpongpro --help\\fP).", ArgParseArgument::INPUTFILE, "PATH", true));
+	setValidValues(parser, "input", ".bam .sam .cram .tsv .bedGraph .bg");
+	setRequired(parser, "input");
+	addOption(parser, ArgParseOption("r", "reference", "Reference genome in FASTA format. Required to decode CRAM files.", ArgParseArgument::INPUTFILE, "PATH"));
+	addOption(parser, ArgParseOption("t", "transposons", "Check the transposons given in the file \\fIPATH\\fP for ping-pong activity in both configurations.", ArgParseArgument::INPUTFILE, "PATH", true));
+	addOption(parser, ArgParseOption("a", "attribute", "For transposon files in GFF/GTF format, use the value of the attribute \\fIKEY\\fP in column 9 as identifier of a transposon.", ArgParseArgument::STRING, "KEY"));
+	addOption(parser, ArgParseOption("F", "families", "Also compare the ping-pong activity of transposon families (requires -t)."));
+	addOption(parser, ArgParseOption("f", "family-attribute", "For transposon files in GFF/GTF format, use the value of the attribute \\fIKEY\\fP in column 9 as family of a transposon.", ArgParseArgument::STRING, "KEY"));
+	addOption(parser, ArgParseOption("T", "predict-transposons", "Also compare the transposons predicted from ping-pong signatures within a range of \\fIRANGE\\fP.", ArgParseArgument::INTEGER, "RANGE"));
+	addOption(parser, ArgParseOption("w", "activity-window", "Also compare the tracks of ping-pong activity in windows of \\fISIZE\\fP nt. The option may be given multiple times for different window sizes.", ArgParseArgument::INTEGER, "SIZE", true));
+	addOption(parser, ArgParseOption("D", "distance-histogram", "Also compare the histogram of the distances between read stacks given by \\fISPEC\\fP (see \\fBpingpongpro --help\\fP). The option may be given multiple times.", ArgParseArgument::STRING, "SPEC", true));
+	addOption(parser, ArgParseOption("x", "signature-index", "Also compare the signatures of all overlaps in the signature index files."));
+	addOption(parser, ArgParseOption("s", "min-stack-height", "Omit stacks with fewer than the specified number of reads from the output.", ArgParseArgument::INTEGER, "NUMBER_OF_READS"));
+	setDefaultValue(parser, "min-stack-height", 0);
+	addOption(parser, ArgParseOption("l", "min-alignment-length", "Ignore alignments in the input file that are shorter than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "min-alignment-length", 24);
+	setMinValue(parser, "min-alignment-length", "1");
+	addOption(parser, ArgParseOption("L", "max-alignment-length", "Ignore alignments in the input file that are longer than the specified length.", ArgParseArgument::INTEGER, "LENGTH"));
+	setDefaultValue(parser, "max-alignment-length", 32);
+	setMinValue(parser, "max-alignment-length", "1");
+	addOption(parser, ArgParseOption("m", "multi-hits", "How to count multi-mapping reads.", ArgParseArgument::STRING, "METHOD"));
+	setDefaultValue(parser, "multi-hits", "weighted");
+	setValidValues(parser, "multi-hits", "unique discard weighted");
+	addOption(parser, ArgParseOption("j", "threads", "Number of worker threads of the candidate configuration.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "threads", 4);
+	setMinValue(parser, "threads", "1");
+	addOption(parser, ArgParseOption("g", "stacks-per-tile", "Split the contigs into tiles of \\fINUMBER\\fP stacks in the candidate configuration. Small tiles check the seams between tiles. Default: as planned from the BAM index.", ArgParseArgument::INTEGER, "NUMBER"));
+	setMinValue(parser, "stacks-per-tile", "1");
+	addOption(parser, ArgParseOption("K", "stack-store", "How to keep the read stacks in memory in the candidate configuration (see \\fBpingpongpro --help\\fP).", ArgParseArgument::STRING, "STORE"));
+	setDefaultValue(parser, "stack-store", "auto");
+	setValidValues(parser, "stack-store", "auto map flat dense hash compressed");
+	addOption(parser, ArgParseOption("A", "absolute-tolerance", "Numbers which differ by at most \\fITOLERANCE\\fP (plus the relative tolerance) are considered equal.", ArgParseArgument::DOUBLE, "TOLERANCE"));
+	setDefaultValue(parser, "absolute-tolerance", 1e-9);
+	setMinValue(parser, "absolute-tolerance", "0");
+	addOption(parser, ArgParseOption("E", "relative-tolerance", "Numbers which differ by at most \\fITOLERANCE\\fP times the larger number (plus the absolute tolerance) are considered equal. The numbers in the output files have 7 significant digits.", ArgParseArgument::DOUBLE, "TOLERANCE"));
+	setDefaultValue(parser, "relative-tolerance", 1e-5);
+	setMinValue(parser, "relative-tolerance", "0");
+	addOption(parser, ArgParseOption("n", "max-divergences", "Print at most \\fINUMBER\\fP divergences per comparison.", ArgParseArgument::INTEGER, "NUMBER"));
+	setDefaultValue(parser, "max-divergences", 10);
+	addOption(parser, ArgParseOption("v", "verbose", "Print messages about the current progress to stderr. Default: \\fIoff\\fP."));
+
+	ArgumentParser::ParseResult parserResult = parse(parser, argc, argv);
+	if (parserResult != ArgumentParser::PARSE_OK)
+		return parserResult;
+
+	// the options, which are not given on the command-line, are set like the defaults of the analysis, except that no plots and browser tracks are made
+	AppOptions &analysis = options.analysis;
+	analysis = AppOptions();
+	analysis.maxFDR = 1;
+	analysis.topK = 0;
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "input"); i++)
+	{
+		CharString inputFile;
+		getOptionValue(inputFile, parser, "input", i);
+		analysis.inputFiles.push_back(inputFile);
+	}
+	getOptionValue(analysis.referenceFile, parser, "reference");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "transposons"); i++)
+	{
+		CharString transposonFile;
+		getOptionValue(transposonFile, parser, "transposons", i);
+		analysis.transposonFiles.push_back(transposonFile);
+	}
+	getOptionValue(analysis.transposonAttribute, parser, "attribute");
+	analysis.transposonFamilies = isSet(parser, "families");
+	getOptionValue(analysis.transposonFamilyAttribute, parser, "family-attribute");
+	analysis.predictTransposonsRange = 0;
+	getOptionValue(analysis.predictTransposonsRange, parser, "predict-transposons");
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "activity-window"); i++)
 	{
-		if (((*transposon)->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP]) / ((*transposon)->readsOnPlusStrand + (*transposon)->readsOnMinusStrand) < 0.2) // more than 80% of reads were discarded => this is probably a false positive
+		unsigned int windowSize;
+		getOptionValue(windowSize, parser, "activity-window", i);
+		if (windowSize == 0)
 		{
-			(*transposon)->qValue = 1;
+			cerr << getAppName(parser) << ": window size of activity track must be greater than 0" << endl;
+			return ArgumentParser::PARSE_ERROR;
 		}
-		else if ((*transposon)->pValue == previousPValue)
+		analysis.activityWindows.push_back(windowSize);
+	}
+	for (unsigned int i = 0; i < getOptionValueCount(parser, "distance-histogram"); i++)
+	{
+		string spec;
+		getOptionValue(spec, parser, "distance-histogram", i);
+		if (parseDistanceHistogramSpec(spec, analysis.distanceHistograms) != 0)
 		{
-			// If two transposons have the same p-value, re-use the previously calculated q-value.
-			// This is pretty unlikely, but ensures that two transposons with the same p-value also
-			// get the same q-value.
-			(*transposon)->qValue = previousQValue;
+			cerr << getAppName(parser) << ": invalid distance histogram '" << spec << "', expected RELATION:END:MIN:MAX, e.g., same:3:-5:30" << endl;
+			return ArgumentParser::PARSE_ERROR;
 		}
-		else
-		{
-			(*transposon)->qValue = (*transposon)->pValue * transposonsSortedByPValue.size() / i;
-			if ((*transposon)->qValue > 1)
-				(*transposon)->qValue = 1;
+	}
+	analysis.signatureIndex = isSet(parser, "signature-index");
+	getOptionValue(analysis.minStackHeight, parser, "min-stack-height");
+	getOptionValue(analysis.minAlignmentLength, parser, "min-alignment-length");
+	getOptionValue(analysis.maxAlignmentLength, parser, "max-alignment-length");
+	if (analysis.minAlignmentLength > analysis.maxAlignmentLength)
+	{
+		cerr << getAppName(parser) << ": minimum alignment length must not be greater than maximum alignment length" << endl;
+		return ArgumentParser::PARSE_ERROR;
+	}
+	string countMultiHits;
+	getOptionValue(countMultiHits, parser, "multi-hits");
+	if (countMultiHits == "unique")
+		analysis.countMultiHits = multiHitsUnique;
+	else if (countMultiHits == "discard")
+		analysis.countMultiHits = multiHitsDiscard;
+	else
+		analysis.countMultiHits = multiHitsWeighted;
+	getOptionValue(analysis.threads, parser, "threads");
+	getOptionValue(analysis.stackStore, parser, "stack-store");
+	analysis.verbosity = isSet(parser, "verbose") ? 3 : 0;
 
-			previousPValue = (*transposon)->pValue;
-			previousQValue = (*transposon)->qValue;
-		}
+	options.stacksPerTile = 0;
+	getOptionValue(options.stacksPerTile, parser, "stacks-per-tile");
+	getOptionValue(options.absoluteTolerance, parser, "absolute-tolerance");
+	getOptionValue(options.relativeTolerance, parser, "relative-tolerance");
+	getOptionValue(options.maxDivergences, parser, "max-divergences");
 
-		++transposon;
-		i++;
-	}
+	return parserResult;
 }
 
-// Similar to the function <findSuppressedTransposons>, this function transposons for ping-pong activity.
-// In contrast to <findSuppressedTransposons>, this function does not take transposons as an input argument,
-// but tries to find transposons automatically based on where there is a lot of ping-pong activity.
+// function to print a divergence found by the "verify" command to stderr, unless enough divergences of the comparison were printed
+// Input parameters:
+//	message: a description of the divergence
+//	options: the number of divergences to print per comparison
+// Input/output parameters:
+//	comparison: the comparison in which the divergence was found
+void reportVerifyDivergence(const string &message, const TVerifyOptions &options, TVerifyComparison &comparison)
+{
+	if (comparison.printed < options.maxDivergences)
+		cerr << comparison.name << ": " << message << endl;
+	comparison.printed++;
+}
+
+// function to compare a number of the candidate configuration of the "verify" command with the number of the reference configuration
+// Input parameters:
+//	reference, candidate: the numbers to compare
+//	options: the tolerances
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+// Return value: true, if the numbers are equal within the tolerances; false otherwise
+bool compareVerifiedValues(double reference, double candidate, const TVerifyOptions &options, TVerifyComparison &comparison)
+{
+	comparison.values++;
+	if ((reference == candidate) || (std::isnan(reference) && std::isnan(candidate)))
+		return true;
+
+	double magnitude = max(fabs(reference), fabs(candidate));
+	double absoluteDifference = fabs(reference - candidate);
+	if (std::isnan(absoluteDifference))
+		absoluteDifference = numeric_limits< double >::infinity(); // only one of the numbers is NaN or both are infinite with opposite signs
+	comparison.maxAbsoluteDifference = max(comparison.maxAbsoluteDifference, absoluteDifference);
+	comparison.maxRelativeDifference = max(comparison.maxRelativeDifference, (magnitude > 0) ? absoluteDifference / magnitude : absoluteDifference);
+	if (absoluteDifference <= options.absoluteTolerance + options.relativeTolerance * magnitude)
+		return true;
+
+	comparison.divergentValues++;
+	return false;
+}
+
+// function to describe the strand and contig of read stacks in the messages of the "verify" command
+string describeStackLocation(unsigned int strand, unsigned int contig, const TNameStore &nameStore)
+{
+	stringstream location;
+	location << ((strand == STRAND_PLUS) ? '+' : '-') << ' ';
+	if (contig < length(nameStore))
+		location << nameStore[contig];
+	else
+		location << contig;
+	return location.str();
+}
+
+// This function compares the read stacks of a contig and strand of the reference configuration of the "verify" command
+// with those of the candidate configuration by a sorted merge of the positions of the stacks.
 // Input parameters:
-//	pingPongSignaturesByOverlap: the ping-pong signtures found by function <countStacksByGroup>
-//      bamNameStore: a mapping of numeric contig IDs to human readable names
-//	range: ping-pong signatures that are this close to one another are considered to belong to the same transposon
-// Output parameters:
-//	putativeTransposons: putative transposons that were found by the function, with p- and q-values
-void predictSuppressedTransposons(TPingPongSignaturesByOverlap &pingPongSignaturesByOverlap, TTransposonsPerGenome &putativeTransposons, TNameStore &bamNameStore, unsigned int range)
+//	reference: cursor to the first stack of the reference configuration
+//	candidate: cursor to the first stack of the candidate configuration (see <beginStacks>)
+//	location: the strand and contig of the stacks (see <describeStackLocation>)
+//	options: the tolerances and the number of divergences to print
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+template <typename TCursor>
+void compareStackCursors(TStackCursor reference, TCursor candidate, const string &location, const TVerifyOptions &options, TVerifyComparison &comparison)
 {
-	// define a putative transposon around every ping-pong signature
-	for (TPingPongSignaturesPerGenome::iterator contig = pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP].begin(); contig != pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP].end() && contig->second.size() > 0; ++contig)
+	while (!atEndOfStacks(reference) || !atEndOfStacks(candidate))
 	{
-		unsigned int putativeTransposonStart = contig->second.begin()->position;
-		unsigned int putativeTransposonEnd = putativeTransposonStart + 1;
-		for (TPingPongSignaturesPerContig::iterator pingPongSignature = contig->second.begin(); pingPongSignature != contig->second.end(); ++pingPongSignature)
+		stringstream message;
+		if (atEndOfStacks(candidate) || (!atEndOfStacks(reference) && (stackPosition(reference) < stackPosition(candidate))))
 		{
-			if (putativeTransposonEnd + range >= pingPongSignature->position) // merge close-by windows
+			comparison.referenceRows++;
+			comparison.missingRows++;
+			message << location << ':' << stackPosition(reference) << ": stack of " << stackValue(reference).reads << " reads is missing in the candidate";
+			reportVerifyDivergence(message.str(), options, comparison);
+			nextStack(reference);
+		}
+		else if (atEndOfStacks(reference) || (stackPosition(candidate) < stackPosition(reference)))
+		{
+			comparison.candidateRows++;
+			comparison.extraRows++;
+			message << location << ':' << stackPosition(candidate) << ": stack of " << stackValue(candidate).reads << " reads is missing in the reference";
+			reportVerifyDivergence(message.str(), options, comparison);
+			nextStack(candidate);
+		}
+		else
+		{
+			comparison.referenceRows++;
+			comparison.candidateRows++;
+			const TReadStack &referenceStack = stackValue(reference);
+			const TReadStack &candidateStack = stackValue(candidate);
+			bool equal = compareVerifiedValues(referenceStack.reads, candidateStack.reads, options, comparison);
+			comparison.values++;
+			if (referenceStack.AAtPosition10 != candidateStack.AAtPosition10)
 			{
-				putativeTransposonEnd = pingPongSignature->position + 1;
+				comparison.divergentValues++;
+				equal = false;
 			}
-			else // the ping-pong signatures are so far apart, that they likely do not belong to the same transposon
+			if (!equal)
 			{
-				if (putativeTransposonStart + PREDICT_TRANSPOSONS_MIN_LENGTH < putativeTransposonEnd) // skip regions that are too short
-				{
-					// name putative transposon after genomic location
-					stringstream putativeTransposonIdentifier;
-					putativeTransposonIdentifier << bamNameStore[contig->first] << ":" << putativeTransposonStart << "-" << putativeTransposonEnd;
-
-					// add transposon to list
-					putativeTransposons[contig->first].push_back(TTransposon(putativeTransposonIdentifier.str(), STRAND_PLUS, putativeTransposonStart, putativeTransposonEnd));
-				}
-
-				// start a new region
-				putativeTransposonStart = pingPongSignature->position;
-				putativeTransposonEnd = putativeTransposonStart + 1;
+				message << location << ':' << stackPosition(reference) << ": " << referenceStack.reads << " reads" << (referenceStack.AAtPosition10 ? " with" : " without") << " A at position 10 in the reference, "
+					<< candidateStack.reads << " reads" << (candidateStack.AAtPosition10 ? " with" : " without") << " A at position 10 in the candidate";
+				reportVerifyDivergence(message.str(), options, comparison);
 			}
+			nextStack(reference);
+			nextStack(candidate);
 		}
 	}
-	// check putative transposons for ping-pong activity
-	findSuppressedTransposons(pingPongSignaturesByOverlap, putativeTransposons);
 }
 
-// Function to write transposons to a TSV file.
-// Input paramters:
-//	transposons: the transposons to write to the file
-//      bamNameStore: a mapping of numeric contig IDs to human readable names
-//	browserTracks: if set to true, then a BED file is generated in addition to the TSV file
-//	fileName: the name of the file that the transposons are written to, without the file extension
-//	totalReadCount: the total number of reads (as returned by countReadsInBamFile) for normalization
-void writeTransposonsToFile(TTransposonsPerGenome &transposons, TNameStore &bamNameStore, bool browserTracks, string fileName, const double totalReadCount)
+// This function compares all read stacks of the reference configuration of the "verify" command with those of the candidate configuration (see <compareStackCursors>).
+// Input parameters:
+//	reference, candidate: the read stacks of the two configurations
+//	nameStore: the names of the contigs for messages
+//	options: the tolerances and the number of divergences to print
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+void compareReadStacks(const TReadStacksPerGenome &reference, const TReadStacksPerGenome &candidate, const TNameStore &nameStore, const TVerifyOptions &options, TVerifyComparison &comparison)
 {
-	// open files to write transposon data to
-	ofstream transposonsTSV((fileName + ".tsv").c_str(), ios_base::out);
-	if (transposonsTSV.fail())
-	{
-		cerr << "Failed to create TSV file for transposons" << endl;
-		return;
-	}
-	ofstream transposonsBED;
-	if (browserTracks)
+	const TReadStacksPerContig noStacks;
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
 	{
-		transposonsBED.open((fileName + ".bed").c_str(), ios_base::out);
-		if (transposonsBED.fail())
+		TReadStacksPerStrand::const_iterator referenceContig = reference[strand].begin();
+		TReadStacksPerStrand::const_iterator candidateContig = candidate[strand].begin();
+		while ((referenceContig != reference[strand].end()) || (candidateContig != candidate[strand].end()))
 		{
-			cerr << "Failed to create browser track file for transposons" << endl;
-			return;
-		}
-	}
+			// merge the contigs of both configurations; a contig missing in one of them has no stacks
+			unsigned int contig;
+			if ((candidateContig == candidate[strand].end()) || ((referenceContig != reference[strand].end()) && (referenceContig->first < candidateContig->first)))
+				contig = referenceContig->first;
+			else
+				contig = candidateContig->first;
+			bool inReference = (referenceContig != reference[strand].end()) && (referenceContig->first == contig);
+			bool inCandidate = (candidateContig != candidate[strand].end()) && (candidateContig->first == contig);
 
-	// use scientific formatting for floating point numbers in the output files
-	transposonsTSV.setf(ios::scientific, ios::floatfield);
-	if (browserTracks)
-		transposonsBED.setf(ios::scientific, ios::floatfield);
+			compareStackCursors(beginStacks(inReference ? referenceContig->second : noStacks), beginStacks(inCandidate ? candidateContig->second : noStacks), describeStackLocation(strand, contig, nameStore), options, comparison);
 
-	// write file headers
-	transposonsTSV << "identifier\tstrand\tcontig\tstart\tend\tpValue\tqValue\tpingPongReads\tnormalizedPingPongReads\tdiscardedPingPongReads\tstrandRatio" << endl;
-	if (browserTracks)
-	{
-		// remove underscores (_) from fileName for the track name
-		stringReplace(fileName, "_", " ");
-		transposonsBED << "track name=\"" << fileName << "\" description=\"" << fileName << " shaded by ping-pong activity (1000 * (1 - q-value))\" useScore=1 visibility=dense" << endl;
+			if (inReference)
+				++referenceContig;
+			if (inCandidate)
+				++candidateContig;
+		}
 	}
+}
 
-	// write transposon data in TSV/BED format
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
-		for (TTransposonsPerContig::iterator transposon = contig->second.begin(); transposon != contig->second.end(); ++transposon)
+// This function passes the read stacks through a type of stack store (see <TStackStoreType>) and compares the stacks of the store with the original ones.
+// Input parameters:
+//	readStacks: the read stacks to add to the stores
+//	nameStore: the names of the contigs for messages
+//	options: the tolerances and the number of divergences to print
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+template <typename TStore>
+void verifyStackStore(const TReadStacksPerGenome &readStacks, const TNameStore &nameStore, const TVerifyOptions &options, TVerifyComparison &comparison)
+{
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::const_iterator contig = readStacks[strand].begin(); contig != readStacks[strand].end(); ++contig)
 		{
-			transposonsTSV
-				<< transposon->identifier << '\t'
-				<< ((transposon->strand == STRAND_PLUS) ? '+' : '-') << '\t'
-				<< bamNameStore[contig->first] << '\t'
-				<< transposon->start << '\t'
-				<< transposon->end << '\t'
-				<< transposon->pValue << '\t'
-				<< transposon->qValue << '\t'
-				<< transposon->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] << '\t'
-				<< transposon->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP] / ((static_cast<float>(transposon->end) - transposon->start)/1000) / (totalReadCount/1000000) << '\t'
-				<< ((transposon->readsOnPlusStrand+transposon->readsOnMinusStrand) - transposon->histogram[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP]) << '\t'
-				<< ((transposon->readsOnMinusStrand > 0) ? transposon->readsOnPlusStrand/transposon->readsOnMinusStrand : 1) << endl;
-			if (browserTracks)
-				transposonsBED
-					<< bamNameStore[contig->first] << '\t'
-					<< transposon->start << '\t'
-					<< transposon->end << '\t'
-					<< transposon->identifier << '\t'
-					<< static_cast<int>(round((1 - transposon->qValue) * 1000)) << '\t'
-					<< ((transposon->strand == STRAND_PLUS) ? '+' : '-') << endl;
+			TStore store;
+			for (TStackCursor stack = beginStacks(contig->second); !atEndOfStacks(stack); nextStack(stack))
+				addToStackStore(store, stackPosition(stack), stackValue(stack).reads, stackValue(stack).AAtPosition10);
+			freezeStackStore(store);
+			compareStackCursors(beginStacks(contig->second), beginStacks(store), describeStackLocation(strand, contig->first, nameStore), options, comparison);
 		}
+}
 
-	// close output files
-	transposonsTSV.close();
-	if (browserTracks)
-		transposonsBED.close();
+// function to split a line of an output file into its tab-separated fields
+// Input parameters:
+//	file: the stream to read the line from
+// Output parameters:
+//	fields: the fields of the line
+// Return value: false, if there are no more lines; true otherwise
+bool readVerifyRow(istream &file, vector< string > &fields)
+{
+	string line;
+	if (!getline(file, line))
+		return false;
+	fields.clear();
+	stringstream lineStream(line);
+	string field;
+	while (getline(lineStream, field, '\t'))
+		fields.push_back(field);
+	return true;
 }
 
-// generate plots that illustrate the statistical significance of ping-pong activity for a list of transposons
-// Input paramters:
-//	transposons: a list of transposons; a plot is generated for each of them
-//	fileName: name of the file that the plots are written to
-void generateTransposonsPlot(TTransposonsPerGenome &transposons, const string &fileName)
+// function to convert a field of an output file to a number
+// Return value: false, if the field is not a number; true otherwise
+bool parseVerifyNumber(const string &field, double &number)
 {
-	int transposonCount = 0;
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
-		transposonCount += contig->second.size();
+	if (field.empty())
+		return false;
+	char *end;
+	number = strtod(field.c_str(), &end);
+	return *end == '\0';
+}
 
-	THistograms histograms(transposonCount);
-	vector< string > plotTitles(transposonCount);
-	stringstream ss;
-	unsigned int i = 0;
-	for (TTransposonsPerGenome::iterator contig = transposons.begin(); contig != transposons.end(); ++contig)
-		for (TTransposonsPerContig::iterator transposon = contig->second.begin(); transposon != contig->second.end(); ++transposon)
-		{
-			histograms[i] = transposon->histogram;
-			ss
-				<< "z-scores of transposon " << transposon->identifier << endl
-				<< "(p-value for overlap of " << PING_PONG_OVERLAP << " nt = " << transposon->pValue << ")";
-			plotTitles[i] = ss.str();
-			ss.str("");
-			i++;
-		}
-	plotHistogram(fileName, plotTitles, histograms);
+// function to get the field of a row of an output file as an unsigned integer, which is used to order the rows by position
+inline uint64_t getVerifyRowPosition(const vector< string > &fields, int column)
+{
+	return ((column >= 0) && (static_cast<unsigned int>(column) < fields.size())) ? strtoull(fields[column].c_str(), NULL, 10) : 0;
 }
 
-// program entry point
-int main(int argc, char const ** argv)
+// function to compare the positions of the rows of two output files for the sorted merge of <compareOutputTables>
+// Input parameters:
+//	referenceRow, candidateRow: the rows to compare
+//	table: the columns of the position
+//	contigRanks: the order of the contigs in the output files
+// Return value: a negative number, if the reference row comes first; a positive number, if the candidate row comes first; 0, if the rows are at the same position
+int compareVerifyRowPositions(const vector< string > &referenceRow, const vector< string > &candidateRow, const TVerifyTable &table, const map< string, unsigned int > &contigRanks)
 {
-	// parse the command line options
-	AppOptions options;
-	if (parseCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
-		return 1;
+	if (table.contigColumn < 0)
+		return 0;
 
-	TReadStacksPerGenome readStacks; // stats about positions where reads on the minus strand overlap with the 5' ends of reads on the plus strand
+	// contigs, which are not in the header of the input files, come last
+	uint64_t position[2][3];
+	const vector< string > *rows[2] = { &referenceRow, &candidateRow };
+	for (unsigned int row = 0; row < 2; row++)
+	{
+		map< string, unsigned int >::const_iterator contigRank = contigRanks.end();
+		if (static_cast<unsigned int>(table.contigColumn) < rows[row]->size())
+			contigRank = contigRanks.find((*rows[row])[table.contigColumn]);
+		position[row][0] = (contigRank != contigRanks.end()) ? contigRank->second : contigRanks.size();
+		position[row][1] = getVerifyRowPosition(*rows[row], table.startColumn);
+		position[row][2] = getVerifyRowPosition(*rows[row], table.endColumn);
+	}
+	for (unsigned int key = 0; key < 3; key++)
+		if (position[0][key] != position[1][key])
+			return (position[0][key] < position[1][key]) ? -1 : 1;
+	return 0;
+}
 
-	TNameStore bamNameStore; // structure to store contig names
+// function to describe a row of an output file in the messages of the "verify" command by the fields up to its position
+string describeVerifyRow(const vector< string > &fields, const TVerifyTable &table)
+{
+	unsigned int lastField = max(0, max(table.contigColumn, max(table.startColumn, table.endColumn)));
+	string description;
+	for (unsigned int field = 0; (field <= lastField) && (field < fields.size()); field++)
+		description += ((field > 0) ? " " : "") + fields[field];
+	return description;
+}
 
-	double totalReadCount = 0;
+// This function compares an output file of the reference configuration of the "verify" command with the one of the candidate configuration.
+// The rows of both files are sorted by position and merged, such that rows missing in one of the files are found.
+// The fields of the rows found in both files are compared as numbers (within the tolerances), if they are numbers in both files, and as strings otherwise.
+// Input parameters:
+//	reference, candidate: the output sinks of the two configurations, which hold the files in memory
+//	table: the name of the file and the columns of the position of the rows
+//	contigRanks: the order of the contigs in the output files
+//	options: the tolerances and the number of divergences to print
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+void compareOutputTables(const TOutputSink &reference, const TOutputSink &candidate, const TVerifyTable &table, const map< string, unsigned int > &contigRanks, const TVerifyOptions &options, TVerifyComparison &comparison)
+{
+	map< string, string >::const_iterator referenceFile = reference.files.find(table.fileName);
+	map< string, string >::const_iterator candidateFile = candidate.files.find(table.fileName);
+	if ((referenceFile == reference.files.end()) || (candidateFile == candidate.files.end()))
+	{
+		comparison.missingRows += (referenceFile != reference.files.end()) ? 1 : 0;
+		comparison.extraRows += (candidateFile != candidate.files.end()) ? 1 : 0;
+		reportVerifyDivergence(string("file is missing in the ") + ((referenceFile == reference.files.end()) ? "reference" : "candidate"), options, comparison);
+		return;
+	}
+	istringstream referenceStream(referenceFile->second);
+	istringstream candidateStream(candidateFile->second);
 
-	// read all BAM/SAM files
-	if (options.verbosity >= 3)
-		cerr << "Counting reads in SAM/BAM files" << endl;
-	for(TInputFiles::iterator inputFile = options.inputFiles.begin(); inputFile != options.inputFiles.end(); ++inputFile)
+	vector< string > header, candidateHeader;
+	readVerifyRow(referenceStream, header);
+	readVerifyRow(candidateStream, candidateHeader);
+	if (header != candidateHeader)
 	{
-		stopwatch((string("  ") + toCString(*inputFile)).c_str(), options.verbosity);
+		comparison.divergentValues++;
+		reportVerifyDivergence("the headers differ", options, comparison);
+		return;
+	}
 
-		// open SAM/BAM file
-		BamStream bamFile(toCString(*inputFile));
-		if (!isGood(bamFile))
+	vector< string > referenceRow, candidateRow;
+	bool haveReferenceRow = readVerifyRow(referenceStream, referenceRow);
+	bool haveCandidateRow = readVerifyRow(candidateStream, candidateRow);
+	while (haveReferenceRow || haveCandidateRow)
+	{
+		int order;
+		if (!haveCandidateRow)
+			order = -1;
+		else if (!haveReferenceRow)
+			order = 1;
+		else
+			order = compareVerifyRowPositions(referenceRow, candidateRow, table, contigRanks);
+
+		if (order < 0)
 		{
-			cerr << "Failed to open input file: " << *inputFile << endl;
-			return 1;
+			comparison.referenceRows++;
+			comparison.missingRows++;
+			reportVerifyDivergence(describeVerifyRow(referenceRow, table) + ": row is missing in the candidate", options, comparison);
+			haveReferenceRow = readVerifyRow(referenceStream, referenceRow);
 		}
-
-		// for every position in the genome, count the number of reads that start at a given position
-		if (countReadsInBamFile(bamFile, readStacks, options.minAlignmentLength, options.maxAlignmentLength, options.countMultiHits, totalReadCount) != 0)
-			return 1;
-
-		// remember @SQ header lines from BAM file for mapping of contig IDs to human-readable names
-		if (length(bamNameStore) == 0)
+		else if (order > 0)
 		{
-			bamNameStore = nameStore(bamFile.bamIOContext);
+			comparison.candidateRows++;
+			comparison.extraRows++;
+			reportVerifyDivergence(describeVerifyRow(candidateRow, table) + ": row is missing in the reference", options, comparison);
+			haveCandidateRow = readVerifyRow(candidateStream, candidateRow);
 		}
 		else
 		{
-			// if multiple BAM files are given, check if headers are identical
-			TNameStore tempBamNameStore = nameStore(bamFile.bamIOContext);
-			bool nameStoresDiffer = false;
-			TNameStoreIterator bamNameStoreIterator = begin(bamNameStore);
-			TNameStoreIterator tempBamNameStoreIterator = begin(tempBamNameStore);
-			while ((bamNameStoreIterator != end(bamNameStore)) && (tempBamNameStoreIterator != end(tempBamNameStore)) && !nameStoresDiffer)
-			{
-				if (value(bamNameStoreIterator) != value(tempBamNameStoreIterator))
-					nameStoresDiffer = true;
-				++bamNameStoreIterator;
-				++tempBamNameStoreIterator;
-			}
-			if (nameStoresDiffer || (length(bamNameStore) != length(tempBamNameStore)))
+			comparison.referenceRows++;
+			comparison.candidateRows++;
+			for (unsigned int field = 0; field < max(referenceRow.size(), candidateRow.size()); field++)
 			{
-				cerr << "@SQ header lines of '" << *inputFile << "' differ from those of previous input files" << endl;
-				return 1;
+				string referenceField = (field < referenceRow.size()) ? referenceRow[field] : "";
+				string candidateField = (field < candidateRow.size()) ? candidateRow[field] : "";
+				double referenceValue, candidateValue;
+				bool equal;
+				if (parseVerifyNumber(referenceField, referenceValue) && parseVerifyNumber(candidateField, candidateValue))
+				{
+					equal = compareVerifiedValues(referenceValue, candidateValue, options, comparison);
+				}
+				else
+				{
+					comparison.values++;
+					equal = referenceField == candidateField;
+					if (!equal)
+						comparison.divergentValues++;
+				}
+				if (!equal)
+					reportVerifyDivergence(describeVerifyRow(referenceRow, table) + ": " + ((field < header.size()) ? header[field] : "extra field") + " is " + referenceField + " in the reference and " + candidateField + " in the candidate", options, comparison);
 			}
+			haveReferenceRow = readVerifyRow(referenceStream, referenceRow);
+			haveCandidateRow = readVerifyRow(candidateStream, candidateRow);
 		}
+	}
+}
 
-		// close SAM/BAM file
-		close(bamFile);
-
-		stopwatch(options.verbosity);
+// This function compares the signature index file of the reference configuration of the "verify" command with the one of the candidate configuration.
+// The signatures of every contig and overlap are merged by position and their FDRs and reads are compared within the tolerances.
+// Input parameters:
+//	reference, candidate: the output sinks of the two configurations, which hold the files in memory
+//	fileName: the name of the index file within the sinks
+//	options: the tolerances and the number of divergences to print
+// Input/output parameters:
+//	comparison: the statistics of the comparison, which are updated
+void compareSignatureIndexFiles(const TOutputSink &reference, const TOutputSink &candidate, const string &fileName, const TVerifyOptions &options, TVerifyComparison &comparison)
+{
+	map< string, string >::const_iterator referenceFile = reference.files.find(fileName);
+	map< string, string >::const_iterator candidateFile = candidate.files.find(fileName);
+	if ((referenceFile == reference.files.end()) || (candidateFile == candidate.files.end()))
+	{
+		comparison.missingRows += (referenceFile != reference.files.end()) ? 1 : 0;
+		comparison.extraRows += (candidateFile != candidate.files.end()) ? 1 : 0;
+		reportVerifyDivergence(string("file is missing in the ") + ((referenceFile == reference.files.end()) ? "reference" : "candidate"), options, comparison);
+		return;
 	}
 
-	// read transposons, if files are given
-	TTransposonsPerGenome transposons;
-	if (options.transposonFiles.size() > 0)
+	// the index files are held by the sinks, so they are not closed with <closeSignatureIndexFile>
+	TSignatureIndexFile indexFiles[2];
+	const string *contents[2] = { &referenceFile->second, &candidateFile->second };
+	for (unsigned int i = 0; i < 2; i++)
 	{
-		if (options.verbosity >= 3)
-			cerr << "Loading transposon coordinates" << endl;
-		for (TInputFiles::iterator transposonFile = options.transposonFiles.begin(); transposonFile != options.transposonFiles.end(); ++transposonFile)
+		indexFiles[i].mappedFile.data = contents[i]->data();
+		indexFiles[i].mappedFile.size = contents[i]->size();
+		if (!readSignatureIndexDirectory(indexFiles[i]))
 		{
-			stopwatch((string("  ") + toCString(*transposonFile)).c_str(), options.verbosity);
+			comparison.divergentValues++;
+			reportVerifyDivergence(string("file is invalid in the ") + ((i == 0) ? "reference" : "candidate"), options, comparison);
+			return;
+		}
+	}
 
-			// try to open file
-			ifstream fileStream(toCString(*transposonFile));
-			if (fileStream.fail())
+	// merge the contigs of both files; a contig missing in one of them has no signatures
+	map< string, unsigned int >::const_iterator referenceContig = indexFiles[0].contigs.begin();
+	map< string, unsigned int >::const_iterator candidateContig = indexFiles[1].contigs.begin();
+	while ((referenceContig != indexFiles[0].contigs.end()) || (candidateContig != indexFiles[1].contigs.end()))
+	{
+		string contig;
+		if ((candidateContig == indexFiles[1].contigs.end()) || ((referenceContig != indexFiles[0].contigs.end()) && (referenceContig->first < candidateContig->first)))
+			contig = referenceContig->first;
+		else
+			contig = candidateContig->first;
+		bool inReference = (referenceContig != indexFiles[0].contigs.end()) && (referenceContig->first == contig);
+		bool inCandidate = (candidateContig != indexFiles[1].contigs.end()) && (candidateContig->first == contig);
+
+		for (int overlap = MIN_ARBITRARY_OVERLAP; overlap <= MAX_ARBITRARY_OVERLAP; overlap++)
+		{
+			const TSignatureIndexFileRecord *referenceRecords = NULL, *candidateRecords = NULL;
+			const TSignatureIndexFileBlock *blocks;
+			uint64_t referenceCount = inReference ? getSignatureIndexFileSection(indexFiles[0], referenceContig->second, overlap, referenceRecords, blocks) : 0;
+			uint64_t candidateCount = inCandidate ? getSignatureIndexFileSection(indexFiles[1], candidateContig->second, overlap, candidateRecords, blocks) : 0;
+			uint64_t r = 0, c = 0;
+			while ((r < referenceCount) || (c < candidateCount))
 			{
-				cerr << "Failed to open transposon file \"" << (*transposonFile) << "\"." << endl;
-				return 1;
+				stringstream message;
+				if ((c == candidateCount) || ((r < referenceCount) && (referenceRecords[r].position < candidateRecords[c].position)))
+				{
+					comparison.referenceRows++;
+					comparison.missingRows++;
+					message << contig << ':' << referenceRecords[r].position << " (" << overlap << " nt): signature is missing in the candidate";
+					reportVerifyDivergence(message.str(), options, comparison);
+					r++;
+				}
+				else if ((r == referenceCount) || (candidateRecords[c].position < referenceRecords[r].position))
+				{
+					comparison.candidateRows++;
+					comparison.extraRows++;
+					message << contig << ':' << candidateRecords[c].position << " (" << overlap << " nt): signature is missing in the reference";
+					reportVerifyDivergence(message.str(), options, comparison);
+					c++;
+				}
+				else
+				{
+					comparison.referenceRows++;
+					comparison.candidateRows++;
+					const TSignatureIndexFileRecord &referenceRecord = referenceRecords[r];
+					const TSignatureIndexFileRecord &candidateRecord = candidateRecords[c];
+					bool equal = compareVerifiedValues(referenceRecord.fdr, candidateRecord.fdr, options, comparison);
+					equal = compareVerifiedValues(referenceRecord.readsOnPlusStrand, candidateRecord.readsOnPlusStrand, options, comparison) && equal;
+					equal = compareVerifiedValues(referenceRecord.readsOnMinusStrand, candidateRecord.readsOnMinusStrand, options, comparison) && equal;
+					if (!equal)
+					{
+						message << contig << ':' << referenceRecord.position << " (" << overlap << " nt): FDR " << referenceRecord.fdr << " with " << referenceRecord.readsOnPlusStrand << '/' << referenceRecord.readsOnMinusStrand << " reads in the reference, "
+							<< "FDR " << candidateRecord.fdr << " with " << candidateRecord.readsOnPlusStrand << '/' << candidateRecord.readsOnMinusStrand << " reads in the candidate";
+						reportVerifyDivergence(message.str(), options, comparison);
+					}
+					r++;
+					c++;
+				}
 			}
+		}
 
-			// determine type of input file
-			TFileFormat fileFormat;
-			if (_compareExtension(toCString(*transposonFile), ".bed"))
-				fileFormat = fileFormatBED;
-			else if (_compareExtension(toCString(*transposonFile), ".csv"))
-				fileFormat = fileFormatCSV;
-			else if (_compareExtension(toCString(*transposonFile), ".gff"))
-				fileFormat = fileFormatGFF;
-			else if (_compareExtension(toCString(*transposonFile), ".gtf"))
-				fileFormat = fileFormatGTF;
-			else
-				fileFormat = fileFormatTSV;
+		if (inReference)
+			++referenceContig;
+		if (inCandidate)
+			++candidateContig;
+	}
+}
 
-			readTransposonsFromFile(fileStream, fileFormat, transposons, bamNameStore);
-			fileStream.close();
-			stopwatch(options.verbosity);
-		}
+// This function implements the "verify" command: it checks that the optimized code paths give the same results as the legacy ones.
+// The input files are analyzed with a reference configuration, which uses the legacy code paths, and a candidate configuration, which uses the optimized ones,
+// and the read stacks and output files of both are compared (see <compareReadStacks>, <compareOutputTables> and <compareSignatureIndexFiles>).
+// Input parameters:
+//	argc: number of command-line arguments (without the program name)
+//	argv: array of command-line arguments (starting with the command name)
+// Return value: 1, if the input files could not be read or if the configurations disagree; 0 otherwise
+int runVerify(int argc, char const ** argv)
+{
+	TVerifyOptions options;
+	if (parseVerifyCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
+		return 1;
+	const AppOptions &analysis = options.analysis;
+	vector< TVerifyComparison > comparisons;
+
+	// the 3' ends of the reads are only collected, if a distance histogram needs them
+	bool threePrimeEnds = needsThreePrimeStacks(analysis.distanceHistograms);
+
+	// the reference configuration reads the input files with SeqAn and keeps the stacks in map stores
+	AppOptions referenceOptions = analysis;
+	referenceOptions.blockReader = false;
+	referenceOptions.stackStore = STACK_STORE_NAMES[stackStoreMap];
+	TReadStacksPerGenome referenceStacks;
+	selectStackStores(referenceOptions, NULL, referenceStacks.stores);
+	TReadStacksPerGenome referenceThreePrimeStacks;
+	TNameStore referenceNameStore;
+	double referenceReadCount = 0;
+	if (analysis.verbosity >= 3)
+		cerr << "Counting reads with the reference configuration" << endl;
+	if (countReadsInSample(analysis.inputFiles, referenceOptions, analysis.verbosity, 1, "", referenceStacks, threePrimeEnds ? &referenceThreePrimeStacks : NULL, referenceNameStore, referenceReadCount, NULL) != 0)
+		return 1;
+
+	// the candidate configuration reads BAM files with the block reader and keeps the stacks in the stores chosen by the run planner
+	AppOptions candidateOptions = analysis;
+	candidateOptions.blockReader = true;
+	TRunPlan candidatePlan;
+	planRun(analysis.inputFiles, candidateOptions, analysis.threads, candidatePlan);
+	TReadStacksPerGenome candidateStacks;
+	selectStackStores(candidateOptions, &candidatePlan, candidateStacks.stores);
+	TReadStacksPerGenome candidateThreePrimeStacks;
+	TNameStore candidateNameStore;
+	double candidateReadCount = 0;
+	if (analysis.verbosity >= 3)
+		cerr << "Counting reads with the candidate configuration" << endl;
+	if (countReadsInSample(analysis.inputFiles, candidateOptions, analysis.verbosity, analysis.threads, "", candidateStacks, threePrimeEnds ? &candidateThreePrimeStacks : NULL, candidateNameStore, candidateReadCount, NULL) != 0)
+		return 1;
+	if (!nameStoresEqual(referenceNameStore, candidateNameStore))
+	{
+		cerr << "The @SQ header lines read by the reference and the candidate configuration differ." << endl;
+		return 1;
 	}
 
-	// go to output directory
-	if (length(options.output) > 0)
+	stopwatch("Comparing read stacks", analysis.verbosity);
+	comparisons.push_back(TVerifyComparison("stacks (block reader)"));
+	if (!compareVerifiedValues(referenceReadCount, candidateReadCount, options, comparisons.back()))
 	{
-		#if defined(WIN32) || defined(_WIN32)
-		CreateDirectory(toCString(options.output), NULL);
-		if (SetCurrentDirectory(toCString(options.output)) == 0)
-		#else
-		mkdir(toCString(options.output), 0777);
-		if (chdir(toCString(options.output)) != 0)
-		#endif
+		stringstream message;
+		message << "total read count is " << referenceReadCount << " in the reference and " << candidateReadCount << " in the candidate";
+		reportVerifyDivergence(message.str(), options, comparisons.back());
+	}
+	compareReadStacks(referenceStacks, candidateStacks, referenceNameStore, options, comparisons.back());
+
+	// pass the stacks of the reference through the alternative stack stores
+	// the dense store needs one slot per position between the first and the last stack of a contig, so it is skipped for sparse contigs which would not fit into memory
+	double maxDenseBytes = 0;
+	for (unsigned int strand = STRAND_PLUS; strand <= STRAND_MINUS; ++strand)
+		for (TReadStacksPerStrand::iterator contig = referenceStacks[strand].begin(); contig != referenceStacks[strand].end(); ++contig)
 		{
-			cerr << "Failed to open output directory: " << options.output;
-			return 1;
+			TStackCursor stack = beginStacks(contig->second);
+			if (atEndOfStacks(stack))
+				continue;
+			unsigned int firstPosition = stackPosition(stack);
+			unsigned int lastPosition = firstPosition;
+			for (; !atEndOfStacks(stack); nextStack(stack))
+				lastPosition = stackPosition(stack);
+			maxDenseBytes = max(maxDenseBytes, 1.0 * (lastPosition - firstPosition + 1) * sizeof(TReadStack));
 		}
+	comparisons.push_back(TVerifyComparison("stacks (flat store)"));
+	verifyStackStore<TFlatStackStore>(referenceStacks, referenceNameStore, options, comparisons.back());
+	if (maxDenseBytes <= MAX_DENSE_BENCHMARK_BYTES)
+	{
+		comparisons.push_back(TVerifyComparison("stacks (dense store)"));
+		verifyStackStore<TDenseStackStore>(referenceStacks, referenceNameStore, options, comparisons.back());
 	}
+	else
+	{
+		cerr << "Skipping the dense store, because a contig would need " << static_cast<uint64_t>(maxDenseBytes / 1048576) << " MB." << endl;
+	}
+	comparisons.push_back(TVerifyComparison("stacks (hash store)"));
+	verifyStackStore<THashStackStore>(referenceStacks, referenceNameStore, options, comparisons.back());
+	comparisons.push_back(TVerifyComparison("stacks (compressed store)"));
+	verifyStackStore<TCompressedStackStore>(referenceStacks, referenceNameStore, options, comparisons.back());
+	stopwatch(analysis.verbosity);
+
+	// both configurations share the transposons
+	TNameStore bamNameStore = referenceNameStore;
+	TTransposonTable transposons;
+	if (analysis.transposonFiles.size() > 0)
+		if (loadTransposons(analysis, transposons, bamNameStore) != 0)
+			return 1;
 
-	stopwatch("Binning stacks", options.verbosity);
-	THeightScoreMap heightScoreMap;
-	mapHeightsToScores(readStacks, heightScoreMap);
-	TGroupedStackCountsByOverlap groupedStackCountsByOverlap;
-	TPingPongSignaturesByOverlap pingPongSignaturesByOverlap;
-	countStacksByGroup(readStacks, heightScoreMap, groupedStackCountsByOverlap, pingPongSignaturesByOverlap);
-	collapseBins(groupedStackCountsByOverlap, pingPongSignaturesByOverlap);
-	stopwatch(options.verbosity);
-
-	stopwatch("Calculating FDR for putative ping-pong signatures", options.verbosity);
-	calculateFDRs(groupedStackCountsByOverlap, pingPongSignaturesByOverlap);
-	stopwatch(options.verbosity);
+	// the reference configuration sweeps every contig in a single tile with one thread
+	if (analysis.verbosity >= 3)
+		cerr << "Analyzing the sample with the reference configuration" << endl;
+	TRunPlan referencePlan;
+	referencePlan.available = true;
+	referencePlan.threads = 1;
+	referencePlan.stacksPerTile = numeric_limits< unsigned int >::max();
+	TOutputSink referenceSink("", true);
+	analyzeDistances(referenceStacks, threePrimeEnds ? &referenceThreePrimeStacks : NULL, referenceOptions, referenceSink, analysis.verbosity);
+	TTransposonScores referenceScores;
+	analyzeSample(referenceStacks, bamNameStore, referenceReadCount, transposons, referenceOptions, referenceSink, analysis.verbosity, 1, &referencePlan, referenceScores, NULL);
+
+	// the candidate configuration splits the contigs into tiles, which are grouped in parallel, like the analysis
+	if (analysis.verbosity >= 3)
+		cerr << "Analyzing the sample with the candidate configuration" << endl;
+	if (options.stacksPerTile > 0)
+	{
+		candidatePlan.available = true;
+		candidatePlan.threads = analysis.threads;
+		candidatePlan.stacksPerTile = options.stacksPerTile;
+	}
+	TOutputSink candidateSink("", true);
+	analyzeDistances(candidateStacks, threePrimeEnds ? &candidateThreePrimeStacks : NULL, candidateOptions, candidateSink, analysis.verbosity);
+	TTransposonScores candidateScores;
+	analyzeSample(candidateStacks, bamNameStore, candidateReadCount, transposons, candidateOptions, candidateSink, analysis.verbosity, analysis.threads, &candidatePlan, candidateScores, NULL);
+
+	// compare the output files, which are sorted by the order of the contigs in the name store, except for the activity tracks, which are sorted by name
+	stopwatch("Comparing output files", analysis.verbosity);
+	map< string, unsigned int > contigRanks, contigNameRanks;
+	for (unsigned int contig = 0; contig < length(bamNameStore); contig++)
+		contigRanks[toCString(bamNameStore[contig])] = contig;
+	unsigned int rank = 0;
+	for (map< string, unsigned int >::iterator contig = contigRanks.begin(); contig != contigRanks.end(); ++contig)
+		contigNameRanks[contig->first] = rank++;
+	const TVerifyTable TABLES[] = {
+		{ "ping-pong_signatures.tsv", 0, 1, -1, false },
+		{ "transposons.tsv", 2, 3, 4, false },
+		{ "transposon_families.tsv", -1, -1, -1, false },
+		{ "predicted_transposons.tsv", 2, 3, 4, false },
+		{ "distance_histograms.tsv", -1, -1, -1, false }
+	};
+	vector< TVerifyTable > tables(TABLES, TABLES + sizeof(TABLES) / sizeof(TABLES[0]));
+	vector< string > activityTrackFileNames;
+	for (vector< unsigned int >::const_iterator windowSize = analysis.activityWindows.begin(); windowSize != analysis.activityWindows.end(); ++windowSize)
+	{
+		stringstream fileName;
+		fileName << "ping-pong_activity_" << *windowSize << "bp.bedGraph";
+		activityTrackFileNames.push_back(fileName.str());
+	}
+	for (vector< string >::iterator fileName = activityTrackFileNames.begin(); fileName != activityTrackFileNames.end(); ++fileName)
+	{
+		TVerifyTable table = { fileName->c_str(), 0, 1, 2, true };
+		tables.push_back(table);
+	}
+	for (vector< TVerifyTable >::iterator table = tables.begin(); table != tables.end(); ++table)
+	{
+		if ((referenceSink.files.count(table->fileName) == 0) && (candidateSink.files.count(table->fileName) == 0))
+			continue; // the file was not requested
+		comparisons.push_back(TVerifyComparison(table->fileName));
+		compareOutputTables(referenceSink, candidateSink, *table, table->contigsByName ? contigNameRanks : contigRanks, options, comparisons.back());
+	}
+	if (analysis.signatureIndex)
+	{
+		comparisons.push_back(TVerifyComparison("ping-pong_signatures.ppidx"));
+		compareSignatureIndexFiles(referenceSink, candidateSink, "ping-pong_signatures.ppidx", options, comparisons.back());
+	}
+	stopwatch(analysis.verbosity);
 
-	if (options.plot)
+	// print the summary of all comparisons
+	int result = 0;
+	cout << "comparison\treferenceRows\tcandidateRows\tmissingRows\textraRows\tvalues\tdivergentValues\tmaxAbsoluteDifference\tmaxRelativeDifference\n";
+	for (vector< TVerifyComparison >::iterator comparison = comparisons.begin(); comparison != comparisons.end(); ++comparison)
 	{
-		stopwatch("Rendering plots for z-scores of ping-pong signatures", options.verbosity);
-		generateGroupedStackCountsPlot(groupedStackCountsByOverlap);
-		stopwatch(options.verbosity);
+		cout << comparison->name << '\t' << comparison->referenceRows << '\t' << comparison->candidateRows << '\t'
+		     << comparison->missingRows << '\t' << comparison->extraRows << '\t' << comparison->values << '\t' << comparison->divergentValues << '\t'
+		     << comparison->maxAbsoluteDifference << '\t' << comparison->maxRelativeDifference << '\n';
+		if ((comparison->missingRows > 0) || (comparison->extraRows > 0) || (comparison->divergentValues > 0))
+			result = 1;
 	}
-	groupedStackCountsByOverlap.clear();
+	if (result != 0)
+		cerr << "The candidate configuration diverges from the reference configuration." << endl;
+	return result;
+}
+
+// This function analyzes the sample given on the command line.
+// Input parameters:
+//	options: the options from the command line
+// Return value: 1, if the sample could not be analyzed; 0 otherwise
+int runAnalysis(AppOptions &options)
+{
+	TReadStacksPerGenome readStacks; // stats about positions where reads on the minus strand overlap with the 5' ends of reads on the plus strand
 
-	stopwatch("Writing ping-pong signatures to file", options.verbosity);
-	writePingPongSignaturesToFile(pingPongSignaturesByOverlap[PING_PONG_OVERLAP - MIN_ARBITRARY_OVERLAP], bamNameStore, options.minStackHeight, options.browserTracks);
-	stopwatch(options.verbosity);
+	TNameStore bamNameStore; // structure to store contig names
 
-	if (options.transposonFiles.size() > 0)
+	double totalReadCount = 0;
+
+	// the 3' ends of the reads are only collected, if a distance histogram needs them
+	TReadStacksPerGenome threePrimeStacks;
+	bool threePrimeEnds = needsThreePrimeStacks(options.distanceHistograms) && !options.qcOnly;
+
+	// estimate the memory consumption from the BAM indices before reading the input files
+	TRunPlan plan;
+	planRun(options.inputFiles, options, options.threads, plan);
+	printRunPlan(plan, options.verbosity);
+	selectStackStores(options, &plan, readStacks.stores);
+	if (plan.available && (options.maxMemory > 0) && (plan.peakMemory > static_cast<uint64_t>(options.maxMemory) * 1024 * 1024))
 	{
-		stopwatch("Checking input transposons for ping-pong activity", options.verbosity);
-		findSuppressedTransposons(pingPongSignaturesByOverlap, transposons);
-		stopwatch(options.verbosity);
-		stopwatch("Writing input transposons to file", options.verbosity);
-		writeTransposonsToFile(transposons, bamNameStore, options.browserTracks, "transposons", totalReadCount);
-		stopwatch(options.verbosity);
-		if (options.plot)
-		{
-			stopwatch("Rendering plots for z-scores of input transposons", options.verbosity);
-			generateTransposonsPlot(transposons, "transposons_z-scores");
-			stopwatch(options.verbosity);
-		}
+		cerr << "The predicted peak memory consumption (" << ((plan.peakMemory + (1 << 20) - 1) >> 20) << " MB) exceeds the limit given by --max-memory (" << options.maxMemory << " MB)." << endl;
+		return 1;
 	}
 
-	if (options.predictTransposonsRange > 0)
+	// read all BAM/SAM files
+	if (options.verbosity >= 3)
+		cerr << "Counting reads in SAM/BAM/CRAM files" << endl;
+	TIngestMetrics metrics;
+	if (countReadsInSample(options.inputFiles, options, options.verbosity, options.threads, options.statusFile, readStacks, threePrimeEnds ? &threePrimeStacks : NULL, bamNameStore, totalReadCount, &metrics) != 0)
+		return 1;
+
+	// print the histogram of overlaps instead of analyzing the sample
+	if (options.qcOnly)
 	{
-		stopwatch("Predicting transposons based on ping-pong activity", options.verbosity);
-		TTransposonsPerGenome putativeTransposons;
-		predictSuppressedTransposons(pingPongSignaturesByOverlap, putativeTransposons, bamNameStore, options.predictTransposonsRange);
-		stopwatch(options.verbosity);
-		stopwatch("Writing predicted transposons to file", options.verbosity);
-		writeTransposonsToFile(putativeTransposons, bamNameStore, options.browserTracks, "predicted_transposons", totalReadCount);
+		stopwatch("Calculating histogram of overlaps", options.verbosity);
+		TPingPongQC qc;
+		calculatePingPongQC(readStacks, qc);
 		stopwatch(options.verbosity);
-		if (options.plot)
-		{
-			stopwatch("Rendering plots for z-scores of predicted transposons", options.verbosity);
-			generateTransposonsPlot(putativeTransposons, "predicted_transposons_z-scores");
-			stopwatch(options.verbosity);
-		}
-
+		string sample;
+		for (TInputFiles::iterator inputFile = options.inputFiles.begin(); inputFile != options.inputFiles.end(); ++inputFile)
+			sample += ((inputFile == options.inputFiles.begin()) ? "" : ",") + string(toCString(*inputFile));
+		writePingPongQCHeader(cout);
+		writePingPongQC(cout, sample, totalReadCount, qc);
+		return 0;
 	}
 
+	// read transposons, if files are given
+	TTransposonTable transposons;
+	if (options.transposonFiles.size() > 0)
+		if (loadTransposons(options, transposons, bamNameStore) != 0)
+			return 1;
+
+	// create output directory
+	if (createOutputDirectory(toCString(options.output)) != 0)
+		return 1;
+
+	TOutputSink sink(toCString(options.output));
+	writeIngestMetricsFile(metrics, sink);
+	analyzeDistances(readStacks, threePrimeEnds ? &threePrimeStacks : NULL, options, sink, options.verbosity);
+
+	TTransposonScores transposonScores;
+	analyzeSample(readStacks, bamNameStore, totalReadCount, transposons, options, sink, options.verbosity, options.threads, &plan, transposonScores, NULL);
+
 	return 0;
 }
+
+// program entry point
+int main(int argc, char const ** argv)
+{
+	// run sub-command, if given
+	if ((argc > 1) && (strcmp(argv[1], "serve") == 0))
+		return runServer(argc - 1, argv + 1);
+	if ((argc > 1) && (strcmp(argv[1], "query") == 0))
+		return runQuery(argc - 1, argv + 1);
+	if ((argc > 1) && (strcmp(argv[1], "benchmark") == 0))
+		return runBenchmark(argc - 1, argv + 1);
+	if ((argc > 1) && (strcmp(argv[1], "verify") == 0))
+		return runVerify(argc - 1, argv + 1);
+
+	// parse the command line options
+	AppOptions options;
+	if (parseCommandLine(options, argc, argv) != ArgumentParser::PARSE_OK)
+		return 1;
+	measureHardwareCounters = options.hardwareCounters;
+	if (!options.traceFile.empty())
+	{
+		traceRecorder.enabled = true;
+		traceRecorder.fileName = options.traceFile;
+		traceRecorder.start = chrono::steady_clock::now();
+		atexit(writeTraceFile);
+	}
+
+	int result = options.batchManifest.empty() ? runAnalysis(options) : runBatch(options);
+
+	// write the trace, after the threads of the analysis have terminated
+	if (traceRecorder.enabled)
+		writeTraceFile();
+	return result;
+}
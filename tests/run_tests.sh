@@ -0,0 +1,47 @@
+#!/bin/sh
+# Runs "pingpongpro verify" and "pingpongpro benchmark" on the fixtures in tests/data
+# and fails, if any of them exits with a non-zero code.
+# Usage: tests/run_tests.sh [PATH_TO_PINGPONGPRO]
+
+PINGPONGPRO="${1:-./pingpongpro}"
+DATA="$(dirname "$0")/data"
+LOG="$(mktemp)"
+trap 'rm -f "$LOG"' EXIT
+
+FAILURES=0
+
+# run_test NAME COMMAND...: runs the command and prints its output, if it fails
+run_test() {
+	NAME="$1"
+	shift
+	if "$@" > "$LOG" 2>&1; then
+		echo "PASS: $NAME"
+	else
+		echo "FAIL: $NAME (exit code $?)"
+		cat "$LOG"
+		FAILURES=$((FAILURES + 1))
+	fi
+}
+
+run_test "verify SAM file" \
+	"$PINGPONGPRO" verify -i "$DATA/tiny.sam" -j 2
+run_test "verify SAM file in small tiles with all outputs" \
+	"$PINGPONGPRO" verify -i "$DATA/tiny.sam" -t "$DATA/transposons.gtf" -a gene_id -F -f family_id -T 100 -w 100 -w 1000 -D opposite:5:3:23 -D same:3:-5:30 -x -g 8 -j 4
+run_test "verify count table" \
+	"$PINGPONGPRO" verify -i "$DATA/tiny.tsv" -t "$DATA/transposons.gtf" -a gene_id -w 100 -x -g 8 -j 2
+run_test "verify SAM file and count table" \
+	"$PINGPONGPRO" verify -i "$DATA/tiny.tsv" -i "$DATA/tiny.sam" -j 2
+for STORE in map flat dense hash compressed; do
+	run_test "verify $STORE store" \
+		"$PINGPONGPRO" verify -i "$DATA/tiny.sam" -K "$STORE" -j 2
+done
+run_test "benchmark SAM file" \
+	"$PINGPONGPRO" benchmark -i "$DATA/tiny.sam"
+run_test "benchmark synthetic library" \
+	"$PINGPONGPRO" benchmark -n 10000
+
+if [ "$FAILURES" -gt 0 ]; then
+	echo "$FAILURES test(s) failed"
+	exit 1
+fi
+echo "All tests passed"